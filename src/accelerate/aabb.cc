@@ -37,8 +37,8 @@ Aabb Aabb::surrouding_box(Aabb const &box0, Aabb const &box1) noexcept
 int Aabb::get_longest_axis_index() const noexcept
 {
   auto delta_x = maximum_.x - minimum_.x;
-  auto delta_y = maximum_.y - maximum_.y;
-  auto delta_z = maximum_.z - maximum_.z;
+  auto delta_y = maximum_.y - minimum_.y;
+  auto delta_z = maximum_.z - minimum_.z;
 
   return (delta_x < delta_y) ? ((delta_y < delta_z) ? 2 : 1)
                              : ((delta_x < delta_z) ? 2 : 0);
@@ -1,6 +1,8 @@
 #ifndef ACCELERATE_AABB_HH__
 #define ACCELERATE_AABB_HH__
 
+#include <cmath>
+
 #include "../gm/point.hh"
 
 namespace rt {
@@ -21,8 +23,43 @@ class Aabb {
 
   bool hit(Ray const &r, double tmin, double tmax) const;
 
+  /**
+   * The slab test with the reciprocal of ray direction precomputed
+   * (the ray is tested against many boxes in the BVH)
+   */
+  bool hit(gm::Point3F const &origin, gm::Vec3F const &inv_direction,
+           double tmin, double tmax) const noexcept
+  {
+    return clip(origin, inv_direction, tmin, tmax);
+  }
+
+  /**
+   * Clip [tmin, tmax] to the part of the ray inside the box
+   * \return false if the part is empty
+   */
+  bool clip(gm::Point3F const &origin, gm::Vec3F const &inv_direction,
+            double &tmin, double &tmax) const noexcept
+  {
+    for (int i = 0; i < 3; ++i) {
+      const double t0 = (minimum_[i] - origin[i]) * inv_direction[i];
+      const double t1 = (maximum_[i] - origin[i]) * inv_direction[i];
+      tmin = std::fmax(tmin, std::fmin(t0, t1));
+      tmax = std::fmin(tmax, std::fmax(t0, t1));
+    }
+    return tmin <= tmax;
+  }
+
   static Aabb surrouding_box(Aabb const &box0, Aabb const &box1) noexcept;
 
+  /**
+   * Linear interpolation of the corners, the box of a linear motion at t
+   */
+  static Aabb lerp(Aabb const &box0, Aabb const &box1, double t) noexcept
+  {
+    return {box0.minimum_ + (box1.minimum_ - box0.minimum_) * t,
+            box0.maximum_ + (box1.maximum_ - box0.maximum_) * t};
+  }
+
   int get_longest_axis_index() const noexcept;
  private:
   gm::Point3F minimum_;
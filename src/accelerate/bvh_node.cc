@@ -3,165 +3,376 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdio>
+#include <ostream>
+#include <string>
 
 #include "../rt/hit_record.hh"
+#include "../rt/stats.hh"
 #include "../shape/shape.hh"
-#include "../util/random.hh"
-
-using namespace util;
 
 namespace rt {
 
-static bool shape_box_compare(ShapeSPtr const &lhs, ShapeSPtr const &rhs,
-                              int i) noexcept
-{
+// The depth of stack used to traverse the BVH
+#define BVH_STACK_SIZE 64
+// The max number of shapes in a leaf
+#define BVH_MAX_LEAF_SIZE 4
+// The number of buckets of the binned SAH
+#define BVH_SAH_BUCKETS 12
+// The cost of traversing an interior node relative to intersecting a shape
+#define BVH_TRAVERSAL_COST 0.5
+// Below the depth the median split is used, it bounds the depth of tree by
+// the size of traversal stack
+#define BVH_MAX_SAH_DEPTH 32
+
+struct BvhTree::BuildItem {
+  ShapeSPtr shape;
   Aabb box0;
   Aabb box1;
+  gm::Point3F centroid;
+  // The index in the objects passed to the constructor
+  int object;
+};
 
-  if (!lhs->get_bounding_box(box0) || !rhs->get_bounding_box(box1)) {
-    fprintf(stderr, "No bounding box can be used for compareing!\n");
-    abort();
-  }
-  return box0.min()[i] < box1.min()[i];
+static inline double surface_area(Aabb const &box) noexcept
+{
+  const auto d = box.max() - box.min();
+  return 2 * (d.x * d.y + d.y * d.z + d.z * d.x);
 }
 
-inline static bool shape_box_x_compare(ShapeSPtr const &lhs,
-                                       ShapeSPtr const &rhs) noexcept
+// The box swept in the shutter(the union of the interpolated boxes)
+static inline double swept_area(Aabb const &box0, Aabb const &box1) noexcept
 {
-  return shape_box_compare(lhs, rhs, 0);
+  return surface_area(Aabb::surrouding_box(box0, box1));
 }
 
-inline static bool shape_box_y_compare(ShapeSPtr const &lhs,
-                                       ShapeSPtr const &rhs) noexcept
+static inline bool box_equal(Aabb const &a, Aabb const &b) noexcept
 {
-  return shape_box_compare(lhs, rhs, 1);
+  for (int i = 0; i < 3; ++i) {
+    if (a.min()[i] != b.min()[i] || a.max()[i] != b.max()[i]) return false;
+  }
+  return true;
 }
 
-inline static bool shape_box_z_compare(ShapeSPtr const &lhs,
-                                       ShapeSPtr const &rhs) noexcept
+BvhTree::BvhTree(std::vector<std::shared_ptr<Shape>> const &objects,
+                 double time0, double time1)
+  : time0_(time0)
+  , time1_(time1)
 {
-  return shape_box_compare(lhs, rhs, 2);
-}
+  if (objects.empty()) return;
 
-using CompareFunc = bool (*)(ShapeSPtr const &, ShapeSPtr const &);
+  std::vector<BuildItem> items(objects.size());
+  for (size_t i = 0; i < objects.size(); ++i) {
+    auto &item = items[i];
+    item.shape = objects[i];
+    item.object = (int)i;
+    if (!get_shape_bounds(*item.shape, item.box0, item.box1)) {
+      fprintf(stderr, "The shape in the BvhTree has no bounding box!\n");
+      abort();
+    }
+    has_motion_ = has_motion_ || !box_equal(item.box0, item.box1);
 
-static CompareFunc get_axis_comparator(int index) noexcept
-{
-  switch (index) {
-    case 0:
-      return shape_box_x_compare;
-    case 1:
-      return shape_box_y_compare;
-    case 2:
-      return shape_box_z_compare;
+    // The center of the box in the middle of the shutter
+    auto mid_box = Aabb::lerp(item.box0, item.box1, 0.5);
+    item.centroid = mid_box.min() + (mid_box.max() - mid_box.min()) / 2.;
   }
-  return nullptr;
+
+  nodes_.reserve(objects.size() * 2);
+  parents_.reserve(objects.size() * 2);
+  shapes_.reserve(objects.size());
+  leaf_of_object_.resize(objects.size());
+  build(items, 0, items.size(), -1, 0);
+  for (auto const &node : nodes_) area_cost_ += area_cost(node);
+  build_cost_ = sah_cost();
 }
 
-static bool bvh_is_leaf(BvhNode const *node) noexcept
+bool BvhTree::get_shape_bounds(Shape const &shape, Aabb &box0,
+                               Aabb &box1) const
 {
-  return node->shape != nullptr;
+  if (time1_ > time0_)
+    return shape.get_motion_bounds(time0_, time1_, box0, box1);
+  if (!shape.get_bounding_box(box0)) return false;
+  box1 = box0;
+  return true;
 }
 
-static BvhNode *
-build_bvh_subtree(std::vector<std::shared_ptr<Shape>> const &objects,
-                  size_t start, size_t end)
+int BvhTree::build(std::vector<BuildItem> &items, size_t begin, size_t end,
+                   int parent, int depth)
 {
-  auto scene = objects; // for std::sort()/std::partial_sort()
-
-  int axis_index = random_int(0, 2);
-  CompareFunc comparator = get_axis_comparator(axis_index);
-  assert(comparator);
-
-  auto obj_sz = end - start;
-  BvhNode *node = new BvhNode;
-  if (obj_sz == 1) {
-    node->right = node->left = new BvhNode(scene[start]);
-  } else if (obj_sz == 2) {
-    if (comparator(scene[start], scene[start+1])) {
-      node->left = new BvhNode(std::move(scene[start]));
-      node->right = new BvhNode(std::move(scene[start+1]));
-    } else {
-      node->left = new BvhNode(std::move(scene[start+1]));
-      node->right = new BvhNode(std::move(scene[start]));
+  assert(end > begin);
+  const int node_index = (int)nodes_.size();
+  nodes_.push_back({});
+  parents_.push_back(parent);
+
+  Aabb box0 = items[begin].box0;
+  Aabb box1 = items[begin].box1;
+  Aabb centroid_box(items[begin].centroid, items[begin].centroid);
+  for (size_t i = begin + 1; i < end; ++i) {
+    box0 = Aabb::surrouding_box(box0, items[i].box0);
+    box1 = Aabb::surrouding_box(box1, items[i].box1);
+    centroid_box = Aabb::surrouding_box(
+      centroid_box, Aabb(items[i].centroid, items[i].centroid));
+  }
+  nodes_[node_index].box0 = box0;
+  nodes_[node_index].box1 = box1;
+
+  const int axis = centroid_box.get_longest_axis_index();
+  size_t mid = end;
+  if (end - begin > 1 && depth < BVH_MAX_SAH_DEPTH)
+    mid = split_sah(items, begin, end, centroid_box, swept_area(box0, box1));
+
+  // Split at the median if the centroids can't be binned or the tree is too
+  // deep, the leaf can't be too large
+  if (mid == begin || (mid == end && end - begin > BVH_MAX_LEAF_SIZE)) {
+    mid = (begin + end) / 2;
+    std::nth_element(items.begin() + begin, items.begin() + mid,
+                     items.begin() + end,
+                     [axis](BuildItem const &a, BuildItem const &b) {
+                       return a.centroid[axis] < b.centroid[axis];
+                     });
+  }
+
+  if (mid == end) {
+    nodes_[node_index].index = (int)shapes_.size();
+    nodes_[node_index].count = (uint16_t)(end - begin);
+    for (size_t i = begin; i < end; ++i) {
+      shapes_.push_back(items[i].shape);
+      leaf_of_object_[items[i].object] = node_index;
     }
-  } else {
-    auto mid = start + obj_sz / 2;
-    std::partial_sort(scene.begin()+start, scene.begin()+mid, scene.begin()+end, comparator);
-    node->left = build_bvh_subtree(objects, start, mid);
-    node->right = build_bvh_subtree(objects, mid, end);
+    return node_index;
   }
 
-  Aabb bbox0;
-  Aabb bbox1;
-  if (!node->left->get_bounding_box(bbox0) ||
-      !node->right->get_bounding_box(bbox1))
+  assert(depth + 1 < BVH_STACK_SIZE);
+  build(items, begin, mid, node_index, depth + 1);
+  const int right = build(items, mid, end, node_index, depth + 1);
+  nodes_[node_index].index = right;
+  nodes_[node_index].axis = (uint8_t)axis;
+  return node_index;
+}
+
+/**
+ * Binned SAH along the longest axis of centroids
+ * \return The split position(the items are partitioned), end if a leaf is
+ *         cheaper, begin if the centroids can't be binned
+ * \see Wald. On fast Construction of SAH-based Bounding Volume Hierarchies.
+ *      2007
+ */
+size_t BvhTree::split_sah(std::vector<BuildItem> &items, size_t begin,
+                          size_t end, Aabb const &centroid_box,
+                          double node_area) const
+{
+  const int axis = centroid_box.get_longest_axis_index();
+  const double cmin = centroid_box.min()[axis];
+  const double extent = centroid_box.max()[axis] - cmin;
+  const auto n = end - begin;
+  if (!(extent > 0) || !(node_area > 0))
+    return n <= BVH_MAX_LEAF_SIZE ? end : begin;
+
+  struct Bucket {
+    int count = 0;
+    Aabb box0;
+    Aabb box1;
+  };
+  Bucket buckets[BVH_SAH_BUCKETS];
+  auto bucket_of = [&](BuildItem const &item) {
+    const auto b = BVH_SAH_BUCKETS * (item.centroid[axis] - cmin) / extent;
+    return std::min((int)b, BVH_SAH_BUCKETS - 1);
+  };
+  for (size_t i = begin; i < end; ++i) {
+    auto &bucket = buckets[bucket_of(items[i])];
+    auto const &item = items[i];
+    bucket.box0 =
+      bucket.count ? Aabb::surrouding_box(bucket.box0, item.box0) : item.box0;
+    bucket.box1 =
+      bucket.count ? Aabb::surrouding_box(bucket.box1, item.box1) : item.box1;
+    ++bucket.count;
+  }
+
+  // The cost of the left part of each split is swept from the left, the
+  // right part from the right
+  double right_cost[BVH_SAH_BUCKETS] = {0};
   {
-    fprintf(stderr,
-            "The left or right node of the BvhNode is no bounding box!\n");
-    abort();
+    int count = 0;
+    Aabb box0, box1;
+    for (int b = BVH_SAH_BUCKETS - 1; b > 0; --b) {
+      if (buckets[b].count) {
+        box0 = count ? Aabb::surrouding_box(box0, buckets[b].box0)
+                     : buckets[b].box0;
+        box1 = count ? Aabb::surrouding_box(box1, buckets[b].box1)
+                     : buckets[b].box1;
+        count += buckets[b].count;
+      }
+      right_cost[b] = count ? count * swept_area(box0, box1) : 0;
+    }
+  }
+
+  int best_split = -1;
+  double best_cost = gm::inf;
+  int count = 0;
+  Aabb box0, box1;
+  for (int b = 0; b < BVH_SAH_BUCKETS - 1; ++b) {
+    if (buckets[b].count) {
+      box0 = count ? Aabb::surrouding_box(box0, buckets[b].box0)
+                   : buckets[b].box0;
+      box1 = count ? Aabb::surrouding_box(box1, buckets[b].box1)
+                   : buckets[b].box1;
+      count += buckets[b].count;
+    }
+    if (count == 0 || count == (int)(end - begin)) continue;
+    const double cost = BVH_TRAVERSAL_COST +
+                        (count * swept_area(box0, box1) + right_cost[b + 1]) /
+                          node_area;
+    if (cost < best_cost) {
+      best_cost = cost;
+      best_split = b;
+    }
   }
 
-  node->box = Aabb::surrouding_box(bbox0, bbox1);
-  return node;
+  if (best_split < 0) return begin;
+  if (n <= BVH_MAX_LEAF_SIZE && (double)n <= best_cost) return end;
+
+  auto it = std::partition(items.begin() + begin, items.begin() + end,
+                           [&](BuildItem const &item) {
+                             return bucket_of(item) <= best_split;
+                           });
+  return (size_t)(it - items.begin());
 }
 
-BvhNode *build_bvh_tree(std::vector<std::shared_ptr<Shape>> const &objects)
+size_t BvhTree::refit(std::vector<int> const &objects)
 {
-  return build_bvh_subtree(objects, 0, objects.size());
+  size_t updated = 0;
+  for (const int object : objects) {
+    assert(object >= 0 && (size_t)object < leaf_of_object_.size());
+    int i = leaf_of_object_[object];
+
+    // The leaf is bounded by its shapes
+    auto &leaf = nodes_[i];
+    area_cost_ -= area_cost(leaf);
+    for (int k = leaf.index; k < leaf.index + leaf.count; ++k) {
+      Aabb box0, box1;
+      if (!get_shape_bounds(*shapes_[k], box0, box1)) {
+        fprintf(stderr, "The shape in the BvhTree has no bounding box!\n");
+        abort();
+      }
+      leaf.box0 = k > leaf.index ? Aabb::surrouding_box(leaf.box0, box0) : box0;
+      leaf.box1 = k > leaf.index ? Aabb::surrouding_box(leaf.box1, box1) : box1;
+      has_motion_ = has_motion_ || !box_equal(box0, box1);
+    }
+    area_cost_ += area_cost(leaf);
+    ++updated;
+
+    // The interior nodes are bounded by their children
+    for (i = parents_[i]; i >= 0; i = parents_[i]) {
+      auto &node = nodes_[i];
+      auto const &left = nodes_[i + 1];
+      auto const &right = nodes_[node.index];
+      area_cost_ -= area_cost(node);
+      node.box0 = Aabb::surrouding_box(left.box0, right.box0);
+      node.box1 = Aabb::surrouding_box(left.box1, right.box1);
+      area_cost_ += area_cost(node);
+      ++updated;
+    }
+  }
+  return updated;
 }
 
-bool BvhNode::hit(Ray const &ray, double tmin, double tmax,
-                  HitRecord &record) const
+double BvhTree::area_cost(BvhNode const &node) noexcept
 {
-  if (!box.hit(ray, tmin, tmax)) return false;
-
-  if (shape) return shape->hit(ray, tmin, tmax, record);
-  
-  auto is_left_hit = left->hit(ray, tmin, tmax, record);
-  auto is_right_hit =
-      right->hit(ray, tmin, is_left_hit ? record.t : tmax, record);
-  
-  return is_left_hit || is_right_hit;
+  const double c = node.is_leaf() ? node.count : BVH_TRAVERSAL_COST;
+  return swept_area(node.box0, node.box1) * c;
 }
 
-bool BvhNode::get_bounding_box(Aabb &bbox) const
+double BvhTree::sah_cost() const noexcept
 {
-  if (shape) return shape->get_bounding_box(bbox);
-  bbox = box;
-  return true;
+  if (nodes_.empty()) return 0;
+  const double root_area = swept_area(nodes_[0].box0, nodes_[0].box1);
+  return root_area > 0 ? area_cost_ / root_area : 0;
 }
 
-void destroy_bvh_tree(BvhNode *root) noexcept
+bool BvhTree::intersect(Ray const &ray, double tmin, double tmax,
+                        HitInfo &info) const
 {
-  if (root->left->shape && root->right->shape) {
-    delete root;
-    return;
+  if (nodes_.empty()) return false;
+
+  const auto origin = ray.origin();
+  const auto direction = ray.direction();
+  const gm::Vec3F inv_direction(1 / direction.x, 1 / direction.y,
+                                1 / direction.z);
+  // The interpolation parameter of the node boxes
+  double s = 0;
+  if (has_motion_) {
+    s = std::clamp((ray.time() - time0_) / (time1_ - time0_), 0., 1.);
   }
-  destroy_bvh_tree(root->left);
-  destroy_bvh_tree(root->right);
+
+  int stack[BVH_STACK_SIZE];
+  int top = 0;
+  stack[top++] = 0;
+  bool hit_anything = false;
+
+  while (top > 0) {
+    const int i = stack[--top];
+    auto const &node = nodes_[i];
+    RT_STATS_INC(STATS_BVH_NODES_VISITED);
+
+    const auto box = has_motion_ ? Aabb::lerp(node.box0, node.box1, s)
+                                 : node.box0;
+    if (!box.hit(origin, inv_direction, tmin, tmax)) continue;
+
+    if (node.is_leaf()) {
+      for (int k = node.index; k < node.index + node.count; ++k) {
+        if (shapes_[k]->intersect(ray, tmin, tmax, info)) {
+          hit_anything = true;
+          tmax = info.t;
+        }
+      }
+    } else if (direction[node.axis] < 0) {
+      // The right child is nearer, it is popped first
+      stack[top++] = i + 1;
+      stack[top++] = node.index;
+    } else {
+      stack[top++] = node.index;
+      stack[top++] = i + 1;
+    }
+  }
+  return hit_anything;
+}
+
+bool BvhTree::get_bounding_box(Aabb &output_box) const
+{
+  if (nodes_.empty()) return false;
+  output_box = Aabb::surrouding_box(nodes_[0].box0, nodes_[0].box1);
+  return true;
+}
+
+bool BvhTree::get_motion_bounds(double time0, double time1, Aabb &box0,
+                                Aabb &box1) const
+{
+  if (nodes_.empty()) return false;
+  // The bounds of other interval are not known
+  if (time0 != time0_ || time1 != time1_)
+    return Shape::get_motion_bounds(time0, time1, box0, box1);
+  box0 = nodes_[0].box0;
+  box1 = nodes_[0].box1;
+  return true;
 }
 
-static void print_bvhtree(std::ostream &os, BvhNode const *node)
+static void print_bvhtree(std::ostream &os, std::vector<BvhNode> const &nodes,
+                          int i, int depth)
 {
-  Aabb box = node->box;
-  os << "bbox: " << box.min() << ", " << box.max() << "\n";
-  os << node << " is ";
-  if (node->shape) {
-    os << "shape\n";
+  auto const &node = nodes[i];
+  os << std::string(depth * 2, ' ') << "bbox: " << node.box0.min() << ", "
+     << node.box0.max();
+  if (node.is_leaf()) {
+    os << " leaf(" << node.count << " shapes)\n";
     return;
   }
-  else
-    os << "bvh node\n";
-  os << "left: "; 
-  print_bvhtree(os, node->left);
-  os << "right: ";
-  print_bvhtree(os, node->right);
+  os << " bvh node\n";
+  print_bvhtree(os, nodes, i + 1, depth + 1);
+  print_bvhtree(os, nodes, node.index, depth + 1);
 }
 
 std::ostream &operator<<(std::ostream &os, BvhTree const &tree)
 {
-  print_bvhtree(os, tree.root());
+  if (!tree.nodes_.empty()) print_bvhtree(os, tree.nodes_, 0, 0);
   return os;
 }
 
@@ -1,6 +1,7 @@
 #ifndef ACCELERATE_BVH_NODE_HH__
 #define ACCELERATE_BVH_NODE_HH__
 
+#include <stdint.h>
 #include <memory>
 #include <vector>
 #include <iosfwd>
@@ -10,65 +11,101 @@
 
 namespace rt {
 
-class Shape;
+/**
+ * The node of the flattened BVH(depth-first order)
+ *
+ * box0 and box1 are the bounds at the open and close time of the shutter,
+ * the node bounds the shapes at time t by their interpolation
+ * (Aabb::lerp()), the static tree only uses box0.
+ */
+struct BvhNode {
+  Aabb box0;
+  Aabb box1;
+  // Interior node: the right child(the left one is the next node)
+  // Leaf: the first shape
+  int index = 0;
+  // The number of shapes, 0 if it is an interior node
+  uint16_t count = 0;
+  // The split axis, used to visit the near child first
+  uint8_t axis = 0;
+
+  bool is_leaf() const noexcept { return count > 0; }
+};
 
 /**
  * FIXME 是否继承Shape?
  * 在The next week中作者是继承了Shape接口类, 因为从结果来看, 最终我们
  * 终究是调用叶子节点(即Shape的实现类)的hit()等接口函数.
  */
-struct BvhNode {
-  BvhNode *left = nullptr;
-  BvhNode *right = nullptr;
-  ShapeSPtr shape = nullptr;
-  Aabb box{};
-  
-  BvhNode() = default;
-
-  explicit BvhNode(ShapeSPtr shape_)
-    : shape(std::move(shape_))
-    , box(shape->get_bounding_box())
-  {
-  }
-  
-  ~BvhNode() noexcept
-  {
-
-  }
-  bool hit(Ray const &ray, double tmin, double tmax, HitRecord &record) const;
-
-  bool get_bounding_box(Aabb &bbox) const;
-};
-
-BvhNode *build_bvh_tree(std::vector<std::shared_ptr<Shape>> const &objects);
-void destroy_bvh_tree(BvhNode *root) noexcept;
-
 class BvhTree : public Shape
 {
  public:
-  explicit BvhTree(std::vector<std::shared_ptr<Shape>> const &objects)
-  {
-    root_ = build_bvh_tree(objects);
-  }
-
-  ~BvhTree() noexcept { destroy_bvh_tree(root_); }
-  
-
-  bool hit(Ray const &ray, double tmin, double tmax, HitRecord &record) const override
-  {
-    return root_->hit(ray, tmin, tmax, record);
-  }
-
-  bool get_bounding_box(Aabb &output_box) const override
-  {
-    return root_->get_bounding_box(output_box);
-  }
+  /**
+   * \param time0 The open time of the shutter
+   * \param time1 The close time of the shutter, the tree is static if it is
+   *              not greater than \p time0
+   * The time of rays must be in [time0, time1], the shapes are bounded only
+   * in the shutter interval.
+   */
+  explicit BvhTree(std::vector<std::shared_ptr<Shape>> const &objects,
+                   double time0 = 0, double time1 = 0);
+
+  bool intersect(Ray const &ray, double tmin, double tmax, HitInfo &info) const override;
+  bool get_bounding_box(Aabb &output_box) const override;
+  bool get_motion_bounds(double time0, double time1, Aabb &box0,
+                         Aabb &box1) const override;
+
+  /**
+   * Update the bounds of the leaves containing the changed shapes and their
+   * ancestors(bottom-up), the topology is not changed.
+   * O(changed * depth)
+   * \param objects The indices of the changed shapes in the objects passed
+   *        to the constructor
+   * \return The number of nodes updated
+   */
+  size_t refit(std::vector<int> const &objects);
+
+  /**
+   * The cost of the tree by the surface area heuristic:
+   * sum(area(node) / area(root) * cost(node)), cost is the traversal cost of
+   * an interior node or the intersection cost of the shapes of a leaf.
+   * The refit tree gets worse when the shapes move far, it should be rebuilt
+   * when the cost is much more than build_cost().
+   * O(1), the sum is updated by refit().
+   */
+  double sah_cost() const noexcept;
+  // The sah_cost() after building
+  double build_cost() const noexcept { return build_cost_; }
+
+  std::vector<BvhNode> const &nodes() const noexcept { return nodes_; }
+  size_t size() const noexcept { return leaf_of_object_.size(); }
+  // Some shapes move in the shutter interval
+  bool has_motion() const noexcept { return has_motion_; }
 
-  BvhNode const *root() const noexcept { return root_; }
-  
   friend std::ostream &operator<<(std::ostream &os, BvhTree const &tree);
  private:
-  BvhNode *root_;
+  struct BuildItem;
+
+  int build(std::vector<BuildItem> &items, size_t begin, size_t end,
+            int parent, int depth);
+  size_t split_sah(std::vector<BuildItem> &items, size_t begin, size_t end,
+                   Aabb const &centroid_box, double node_area) const;
+  bool get_shape_bounds(Shape const &shape, Aabb &box0, Aabb &box1) const;
+  static double area_cost(BvhNode const &node) noexcept;
+
+  std::vector<BvhNode> nodes_;
+  // The parent of each node, -1 for the root
+  std::vector<int> parents_;
+  // The shapes of leaves are contiguous
+  std::vector<ShapeSPtr> shapes_;
+  // The leaf of each object(in the order of constructor)
+  std::vector<int> leaf_of_object_;
+  double time0_;
+  double time1_;
+  // sum(area(node) * cost(node))
+  double area_cost_ = 0;
+  double build_cost_ = 0;
+  bool has_motion_ = false;
 };
 
 } // namespace rt
@@ -0,0 +1,208 @@
+#ifndef GM_FAST_MATH_HH__
+#define GM_FAST_MATH_HH__
+
+#include <cmath>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Polynomial approximations of the libm functions used in the hot path
+ *
+ * They are inline and branch-free(the selections are conditional moves), so
+ * the loops calling them can be vectorized. The coefficients are the
+ * Chebyshev interpolants of the reduced functions.
+ * The maximum errors are measured in test/gm/fast_math_test.cc:
+ *   fast_sincos  |x| <= 1e5   absolute error < 1e-13
+ *   fast_atan2                absolute error < 2e-14
+ *   fast_acos    [-1, 1]      absolute error < 1e-13
+ *   fast_log     (0, 1]       absolute error < 5e-14
+ *                (0, inf)     relative error < 5e-14, x must be normal
+ */
+
+namespace gm {
+namespace detail {
+
+constexpr double fast_pi = 3.14159265358979323846;
+constexpr double fast_pi_2 = 1.57079632679489661923;
+constexpr double fast_pi_4 = 0.78539816339744830962;
+// pi / 2 = PIO2_HI + PIO2_LO, k * PIO2_HI is exact for |k| < 2^20
+constexpr double fast_pio2_hi = 1.57079632673412561417e+00;
+constexpr double fast_pio2_lo = 6.07710050650619224932e-11;
+constexpr double fast_ln2 = 0.69314718055994530942;
+constexpr double fast_sqrt2 = 1.41421356237309504880;
+// tan(pi / 8)
+constexpr double fast_tan_pi_8 = 0.41421356237309504880;
+
+// sin(r) / r, r^2 in [0, (pi / 4)^2]
+inline double sin_poly(double s) noexcept
+{
+  return 0.999999999999996 +
+         s * (-0.16666666666619617 +
+              s * (0.008333333324248059 +
+                   s * (-0.00019841263462905617 +
+                        s * (2.7555302378195561e-06 +
+                             s * -2.4758560823518061e-08))));
+}
+
+// cos(r), r^2 in [0, (pi / 4)^2]
+inline double cos_poly(double s) noexcept
+{
+  return 0.99999999999994449 +
+         s * (-0.49999999999353456 +
+              s * (0.041666666544215129 +
+                   s * (-0.0013888880407479558 +
+                        s * (2.4798931333764157e-05 +
+                             s * -2.7173601715785489e-07))));
+}
+
+// atan(t) / t, t^2 in [0, tan(pi / 8)^2]
+inline double atan_poly(double s) noexcept
+{
+  return 0.99999999999997324 +
+         s * (-0.33333333330839854 +
+              s * (0.19999999610087058 +
+                   s * (-0.14285690684434466 +
+                        s * (0.11110391416664697 +
+                             s * (-0.09078476357185479 +
+                                  s * (0.075643184868913818 +
+                                       s * (-0.058768295918915754 +
+                                            s * 0.030697933866256334)))))));
+}
+
+// asin(x) / x, x^2 in [0, 1 / 4]
+inline double asin_poly(double s) noexcept
+{
+  return 0.99999999999994793 +
+         s * (0.16666666670785904 +
+              s * (0.074999994617363092 +
+                   s * (0.044643129071823759 +
+                        s * (0.030375004421148332 +
+                             s * (0.02247310765378643 +
+                                  s * (0.016469504777342082 +
+                                       s * (0.018651402741670615 +
+                                            s * (-0.0028842687606811584 +
+                                                 s * 0.031969261169433598))))))));
+}
+
+// atanh(z) / z, z^2 in [0, ((sqrt(2) - 1) / (sqrt(2) + 1))^2]
+inline double atanh_poly(double s) noexcept
+{
+  return 0.99999999999997391 +
+         s * (0.33333333339723792 +
+              s * (0.19999997463031388 +
+                   s * (0.14286081488084895 +
+                        s * (0.1108718655374462 +
+                             s * 0.09803195775829901))));
+}
+
+} // namespace detail
+
+/**
+ * sin(x) and cos(x) with one range reduction
+ */
+inline void fast_sincos(double x, double &sin_x, double &cos_x) noexcept
+{
+  using namespace detail;
+  // x = k * pi / 2 + r, |r| <= pi / 4
+  const double k = std::floor(x * (1 / fast_pi_2) + 0.5);
+  const double r = (x - k * fast_pio2_hi) - k * fast_pio2_lo;
+  const double r2 = r * r;
+  const double sin_r = r * sin_poly(r2);
+  const double cos_r = cos_poly(r2);
+
+  const int64_t quadrant = (int64_t)k;
+  const bool swap = quadrant & 1;
+  const double s = swap ? cos_r : sin_r;
+  const double c = swap ? sin_r : cos_r;
+  sin_x = (quadrant & 2) ? -s : s;
+  cos_x = ((quadrant + 1) & 2) ? -c : c;
+}
+
+inline double fast_sin(double x) noexcept
+{
+  double s, c;
+  fast_sincos(x, s, c);
+  return s;
+}
+
+inline double fast_cos(double x) noexcept
+{
+  double s, c;
+  fast_sincos(x, s, c);
+  return c;
+}
+
+/**
+ * The angle of (x, y) in [-pi, pi], fast_atan2(0, 0) = 0
+ */
+inline double fast_atan2(double y, double x) noexcept
+{
+  using namespace detail;
+  const double ax = std::fabs(x);
+  const double ay = std::fabs(y);
+  const double max = ax > ay ? ax : ay;
+  const double min = ax > ay ? ay : ax;
+  double t = max > 0 ? min / max : 0;
+
+  // atan(t) = pi / 4 + atan((t - 1) / (t + 1))
+  const bool shift = t > fast_tan_pi_8;
+  t = shift ? (t - 1) / (t + 1) : t;
+  double angle = t * atan_poly(t * t) + (shift ? fast_pi_4 : 0);
+
+  angle = ay > ax ? fast_pi_2 - angle : angle;
+  angle = x < 0 ? fast_pi - angle : angle;
+  return y < 0 ? -angle : angle;
+}
+
+/**
+ * \param x It is clamped to [-1, 1]
+ */
+inline double fast_acos(double x) noexcept
+{
+  using namespace detail;
+  x = x < -1 ? -1 : (x > 1 ? 1 : x);
+  const double a = std::fabs(x);
+
+  // |x| <= 1/2: acos(a) = pi / 2 - asin(a)
+  // |x| > 1/2:  acos(a) = 2 * asin(sqrt((1 - a) / 2))
+  const bool small = a <= 0.5;
+  const double s = small ? a * a : (1 - a) / 2;
+  const double z = small ? a : std::sqrt(s);
+  const double asin_z = z * asin_poly(s);
+  const double acos_a = small ? fast_pi_2 - asin_z : 2 * asin_z;
+  return x < 0 ? fast_pi - acos_a : acos_a;
+}
+
+/**
+ * \param x Positive normal number(no check for 0, denormal, inf and NaN)
+ */
+inline double fast_log(double x) noexcept
+{
+  using namespace detail;
+  uint64_t bits;
+  memcpy(&bits, &x, sizeof bits);
+  // x = m * 2^e, m in [1, 2)
+  double e = double(int64_t(bits >> 52) - 1023);
+  bits = (bits & 0x000fffffffffffffull) | 0x3ff0000000000000ull;
+  double m;
+  memcpy(&m, &bits, sizeof m);
+
+  // m in [sqrt(2) / 2, sqrt(2))
+  const bool large = m > fast_sqrt2;
+  m = large ? m * 0.5 : m;
+  e = large ? e + 1 : e;
+
+  // log(m) = 2 * atanh((m - 1) / (m + 1))
+  const double z = (m - 1) / (m + 1);
+  return e * fast_ln2 + 2 * z * atanh_poly(z * z);
+}
+
+inline double pow5(double x) noexcept
+{
+  const double x2 = x * x;
+  return x2 * x2 * x;
+}
+
+} // namespace gm
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef IMG_HALF_HH__
+#define IMG_HALF_HH__
+
+#include <stdint.h>
+#include <string.h>
+
+namespace img {
+
+/**
+ * Convert float to IEEE 754 half(binary16) with round-to-nearest-even.
+ * Overflow is converted to infinity, NaN is kept(quiet).
+ */
+inline uint16_t float_to_half(float f) noexcept
+{
+  uint32_t x;
+  memcpy(&x, &f, sizeof x);
+
+  const uint32_t sign = (x >> 16) & 0x8000;
+  const uint32_t abs_x = x & 0x7fffffff;
+
+  // NaN or Inf
+  if (abs_x >= 0x7f800000) {
+    return (uint16_t)(sign | 0x7c00 | (abs_x > 0x7f800000 ? 0x200 : 0));
+  }
+
+  // Overflow(>= 65520 is rounded to inf)
+  if (abs_x >= 0x477ff000) {
+    return (uint16_t)(sign | 0x7c00);
+  }
+
+  // Normalized half
+  if (abs_x >= 0x38800000) {
+    uint32_t mant = abs_x & 0x007fffff;
+    uint32_t exp = (abs_x >> 23) - 127 + 15;
+    uint32_t h = (exp << 10) | (mant >> 13);
+    // Round to nearest even
+    uint32_t rest = mant & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (h & 1))) ++h;
+    return (uint16_t)(sign | h);
+  }
+
+  // Denormalized half or zero
+  if (abs_x < 0x33000000) return (uint16_t)sign;
+
+  uint32_t mant = (abs_x & 0x007fffff) | 0x00800000;
+  int shift = 126 - (int)(abs_x >> 23);
+  uint32_t h = mant >> shift;
+  uint32_t rest = mant & ((1u << shift) - 1);
+  uint32_t half_way = 1u << (shift - 1);
+  if (rest > half_way || (rest == half_way && (h & 1))) ++h;
+  return (uint16_t)(sign | h);
+}
+
+inline float half_to_float(uint16_t h) noexcept
+{
+  const uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+  uint32_t exp = (h >> 10) & 0x1f;
+  uint32_t mant = h & 0x3ff;
+  uint32_t x;
+
+  if (exp == 0) {
+    if (mant == 0) {
+      x = sign;
+    } else {
+      // Normalize the denormalized half
+      exp = 127 - 15 + 1;
+      while ((mant & 0x400) == 0) {
+        mant <<= 1;
+        --exp;
+      }
+      mant &= 0x3ff;
+      x = sign | (exp << 23) | (mant << 13);
+    }
+  } else if (exp == 0x1f) {
+    x = sign | 0x7f800000 | (mant << 13);
+  } else {
+    x = sign | ((exp - 15 + 127) << 23) | (mant << 13);
+  }
+
+  float f;
+  memcpy(&f, &x, sizeof f);
+  return f;
+}
+
+} // namespace img
+
+#endif
@@ -0,0 +1,632 @@
+#include "hdr_image.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+#include "half.hh"
+#include "../util/assert.hh"
+#include "../util/endian.h"
+#include "../util/file.hh"
+
+using namespace img;
+using namespace util;
+using namespace gm;
+
+HdrImage::HdrImage(int w, int h, unsigned aux)
+  : width_(w)
+  , height_(h)
+  , aux_(aux)
+  , rgb_((size_t)w * h * 3, 0.f)
+{
+  const size_t n = (size_t)w * h;
+  if (aux & ALBEDO) albedo_.resize(n * 3, 0.f);
+  if (aux & NORMAL) normal_.resize(n * 3, 0.f);
+  if (aux & DEPTH) depth_.resize(n, 0.f);
+  if (aux & SAMPLE_COUNT) sample_count_.resize(n, 0);
+}
+
+static inline void set_vec3(std::vector<float> &buf, size_t i,
+                            Vec3F const &v) noexcept
+{
+  buf[i * 3] = (float)v.x;
+  buf[i * 3 + 1] = (float)v.y;
+  buf[i * 3 + 2] = (float)v.z;
+}
+
+void HdrImage::SetPixel(int x, int y, Vec3F const &rgb) noexcept
+{
+  ASSERT(x >= 0 && x < width_ && y >= 0 && y < height_);
+  set_vec3(rgb_, index(x, y), rgb);
+}
+
+Vec3F HdrImage::GetPixel(int x, int y) const noexcept
+{
+  ASSERT(x >= 0 && x < width_ && y >= 0 && y < height_);
+  auto i = index(x, y) * 3;
+  return {rgb_[i], rgb_[i + 1], rgb_[i + 2]};
+}
+
+void HdrImage::SetAlbedo(int x, int y, Vec3F const &albedo) noexcept
+{
+  if (has_aux(ALBEDO)) set_vec3(albedo_, index(x, y), albedo);
+}
+
+void HdrImage::SetNormal(int x, int y, Vec3F const &normal) noexcept
+{
+  if (has_aux(NORMAL)) set_vec3(normal_, index(x, y), normal);
+}
+
+void HdrImage::SetDepth(int x, int y, float depth) noexcept
+{
+  if (has_aux(DEPTH)) depth_[index(x, y)] = depth;
+}
+
+void HdrImage::SetSampleCount(int x, int y, uint32_t count) noexcept
+{
+  if (has_aux(SAMPLE_COUNT)) sample_count_[index(x, y)] = count;
+}
+
+/*--------------------------------------------------*/
+/* Radiance RGBE                                    */
+/*--------------------------------------------------*/
+
+/**
+ * Shared exponent format:
+ * (r, g, b) = (R, G, B) * 2^(E - 128 - 8)
+ * \see https://www.graphics.cornell.edu/~bjw/rgbe.html
+ */
+static inline void float_to_rgbe(float const *rgb, uint8_t *rgbe) noexcept
+{
+  float v = std::max(rgb[0], std::max(rgb[1], rgb[2]));
+  if (!(v >= 1e-32f)) {
+    // Also handle negative and NaN
+    rgbe[0] = rgbe[1] = rgbe[2] = rgbe[3] = 0;
+    return;
+  }
+
+  int e;
+  float scale = frexpf(v, &e) * 256.f / v;
+  rgbe[0] = (uint8_t)(std::max(rgb[0], 0.f) * scale);
+  rgbe[1] = (uint8_t)(std::max(rgb[1], 0.f) * scale);
+  rgbe[2] = (uint8_t)(std::max(rgb[2], 0.f) * scale);
+  rgbe[3] = (uint8_t)(e + 128);
+}
+
+/**
+ * Encode one component of the scanline
+ * Run: count(> 128) - 128 same bytes
+ * Dump: count(<= 128) different bytes
+ */
+static void rgbe_rle_component(uint8_t const *data, int n,
+                               std::vector<uint8_t> &out)
+{
+  constexpr int MIN_RUN_LENGTH = 4;
+  int cur = 0;
+
+  while (cur < n) {
+    int beg_run = cur;
+    int run_count = 0;
+    int old_run_count = 0;
+
+    // Find the next run that is long enough
+    while (run_count < MIN_RUN_LENGTH && beg_run < n) {
+      beg_run += run_count;
+      old_run_count = run_count;
+      run_count = 1;
+      while (beg_run + run_count < n && run_count < 127 &&
+             data[beg_run] == data[beg_run + run_count])
+        run_count++;
+    }
+
+    // The short run before the long run is emitted as a run directly
+    if (old_run_count > 1 && old_run_count == beg_run - cur) {
+      out.push_back((uint8_t)(128 + old_run_count));
+      out.push_back(data[cur]);
+      cur = beg_run;
+    }
+
+    // Dump the different bytes before the run
+    while (cur < beg_run) {
+      int nonrun_count = std::min(beg_run - cur, 128);
+      out.push_back((uint8_t)nonrun_count);
+      out.insert(out.end(), data + cur, data + cur + nonrun_count);
+      cur += nonrun_count;
+    }
+
+    if (run_count >= MIN_RUN_LENGTH) {
+      out.push_back((uint8_t)(128 + run_count));
+      out.push_back(data[beg_run]);
+      cur += run_count;
+    }
+  }
+}
+
+bool HdrImage::WriteTo(char const *path, bool rle) const noexcept
+{
+  std::string_view path_view(path);
+  if (path_view.ends_with(".hdr")) {
+    return WriteHdr(path, rle);
+  } else if (path_view.ends_with(".pfm")) {
+    return WritePfm(path);
+  }
+  return WriteExr(path, rle);
+}
+
+bool HdrImage::WriteHdr(char const *path, bool rle) const noexcept
+{
+  File out;
+  if (!out.Open(path, File::TRUNC)) {
+    fprintf(stderr, "Failed to write hdr file: %s\n", path);
+    return false;
+  }
+
+  std::string header = "#?RADIANCE\n"
+                       "# Written by ray tracer\n"
+                       "FORMAT=32-bit_rle_rgbe\n\n";
+  // Top to bottom, left to right
+  header += "-Y " + std::to_string(height_) + " +X " + std::to_string(width_) +
+            "\n";
+  bool failed = out.Write(header.data(), header.size());
+
+  // The new RLE is only valid for the width in [8, 0x7fff]
+  const bool use_rle = rle && width_ >= 8 && width_ <= 0x7fff;
+  std::vector<uint8_t> scanline((size_t)width_ * 4);
+  std::vector<uint8_t> component(width_);
+  std::vector<uint8_t> buffer;
+  buffer.reserve(scanline.size() + 4);
+
+  for (int y = height_ - 1; y >= 0 && !failed; --y) {
+    for (int x = 0; x < width_; ++x) {
+      float_to_rgbe(&rgb_[index(x, y) * 3], &scanline[x * 4]);
+    }
+
+    if (!use_rle) {
+      failed |= out.Write(scanline.data(), scanline.size());
+      continue;
+    }
+
+    buffer.clear();
+    buffer.push_back(2);
+    buffer.push_back(2);
+    buffer.push_back((uint8_t)(width_ >> 8));
+    buffer.push_back((uint8_t)(width_ & 0xff));
+    for (int c = 0; c < 4; ++c) {
+      for (int x = 0; x < width_; ++x)
+        component[x] = scanline[x * 4 + c];
+      rgbe_rle_component(component.data(), width_, buffer);
+    }
+    failed |= out.Write(buffer.data(), buffer.size());
+  }
+
+  if (failed || out.Flush()) {
+    fprintf(stderr, "Failed to write hdr file: %s\n", path);
+    return false;
+  }
+  return true;
+}
+
+static inline void rgbe_to_float(uint8_t const *rgbe, float *rgb) noexcept
+{
+  if (rgbe[3] == 0) {
+    rgb[0] = rgb[1] = rgb[2] = 0.f;
+    return;
+  }
+
+  // The center of the quantization interval
+  float f = ldexpf(1.f, (int)rgbe[3] - (128 + 8));
+  rgb[0] = (rgbe[0] + 0.5f) * f;
+  rgb[1] = (rgbe[1] + 0.5f) * f;
+  rgb[2] = (rgbe[2] + 0.5f) * f;
+}
+
+/**
+ * Decode one component of the new RLE scanline
+ * \return The position after the component, null if the data is corrupted
+ */
+static uint8_t const *rgbe_unrle_component(uint8_t const *p,
+                                           uint8_t const *end, uint8_t *data,
+                                           int n) noexcept
+{
+  int x = 0;
+  while (x < n) {
+    if (p >= end) return nullptr;
+    int count = *p++;
+    if (count > 128) {
+      count -= 128;
+      if (p >= end || x + count > n) return nullptr;
+      memset(data + x, *p++, count);
+    } else {
+      if (count == 0 || end - p < count || x + count > n) return nullptr;
+      memcpy(data + x, p, count);
+      p += count;
+    }
+    x += count;
+  }
+  return p;
+}
+
+bool HdrImage::ReadHdr(char const *path) noexcept
+{
+  File in;
+  if (!in.Open(path, File::READ)) {
+    fprintf(stderr, "Failed to read hdr file: %s\n", path);
+    return false;
+  }
+
+  std::vector<uint8_t> content(in.GetFileSize());
+  if (content.empty() ||
+      in.Read(content.data(), content.size()) != content.size()) {
+    fprintf(stderr, "Failed to read hdr file: %s\n", path);
+    return false;
+  }
+
+  uint8_t const *p = content.data();
+  auto const end = p + content.size();
+  auto read_line = [&p, end](std::string &line) {
+    auto newline = (uint8_t const *)memchr(p, '\n', end - p);
+    if (!newline) return false;
+    line.assign((char const *)p, newline - p);
+    p = newline + 1;
+    return true;
+  };
+
+  // Header: magic, variables and an empty line, then the resolution
+  std::string line;
+  if (!read_line(line) || line.compare(0, 2, "#?") != 0) {
+    fprintf(stderr, "%s is not a radiance hdr file\n", path);
+    return false;
+  }
+  while (read_line(line) && !line.empty()) {
+    if (line.compare(0, 7, "FORMAT=") == 0 && line != "FORMAT=32-bit_rle_rgbe") {
+      fprintf(stderr, "Unsupported hdr format: %s\n", line.c_str());
+      return false;
+    }
+  }
+
+  int w = 0;
+  int h = 0;
+  if (!read_line(line) || sscanf(line.c_str(), "-Y %d +X %d", &h, &w) != 2 ||
+      w <= 0 || h <= 0)
+  {
+    fprintf(stderr, "Unsupported hdr resolution: %s\n", line.c_str());
+    return false;
+  }
+
+  *this = HdrImage(w, h);
+  std::vector<uint8_t> scanline((size_t)w * 4);
+  std::vector<uint8_t> component(w);
+
+  for (int y = h - 1; y >= 0; --y) {
+    const bool rle = w >= 8 && w <= 0x7fff && end - p >= 4 && p[0] == 2 &&
+                     p[1] == 2 && ((p[2] << 8) | p[3]) == w;
+    if (rle) {
+      p += 4;
+      for (int c = 0; c < 4 && p; ++c) {
+        p = rgbe_unrle_component(p, end, component.data(), w);
+        for (int x = 0; x < w && p; ++x)
+          scanline[x * 4 + c] = component[x];
+      }
+    } else if (end - p >= (ptrdiff_t)scanline.size()) {
+      memcpy(scanline.data(), p, scanline.size());
+      p += scanline.size();
+    } else {
+      p = nullptr;
+    }
+
+    if (!p) {
+      fprintf(stderr, "The hdr file is corrupted: %s\n", path);
+      return false;
+    }
+
+    for (int x = 0; x < w; ++x) {
+      rgbe_to_float(&scanline[x * 4], &rgb_[index(x, y) * 3]);
+    }
+  }
+
+  return true;
+}
+
+/*--------------------------------------------------*/
+/* Portable float map                               */
+/*--------------------------------------------------*/
+
+bool HdrImage::WritePfm(char const *path) const noexcept
+{
+  File out;
+  if (!out.Open(path, File::TRUNC)) {
+    fprintf(stderr, "Failed to write pfm file: %s\n", path);
+    return false;
+  }
+
+  // Negative scale indicates little endian
+  // The rows are from bottom to top, same as ours
+  std::string header = "PF\n" + std::to_string(width_) + " " +
+                       std::to_string(height_) + "\n-1.0\n";
+  bool failed = out.Write(header.data(), header.size());
+
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+  failed |= out.Write(rgb_.data(), rgb_.size() * sizeof(float));
+#else
+  std::vector<uint32_t> line((size_t)width_ * 3);
+  for (int y = 0; y < height_ && !failed; ++y) {
+    memcpy(line.data(), &rgb_[index(0, y) * 3], line.size() * 4);
+    for (auto &v : line) v = htole32(v);
+    failed |= out.Write(line.data(), line.size() * 4);
+  }
+#endif
+
+  if (failed || out.Flush()) {
+    fprintf(stderr, "Failed to write pfm file: %s\n", path);
+    return false;
+  }
+  return true;
+}
+
+/*--------------------------------------------------*/
+/* OpenEXR                                          */
+/*--------------------------------------------------*/
+
+namespace {
+
+enum ExrPixelType : int32_t {
+  EXR_UINT = 0,
+  EXR_HALF = 1,
+  EXR_FLOAT = 2,
+};
+
+struct ExrChannel {
+  char const *name;
+  ExrPixelType type;
+  std::vector<float> const *buffer; // UINT use sample count buffer
+  int stride;
+  int offset;
+};
+
+class ExrHeaderBuilder {
+ public:
+  template <typename T>
+  void Append(T const &value)
+  {
+    auto p = reinterpret_cast<uint8_t const *>(&value);
+    data_.insert(data_.end(), p, p + sizeof(T));
+  }
+
+  void AppendInt32(int32_t v) { Append(htole32((uint32_t)v)); }
+
+  void AppendFloat(float f)
+  {
+    uint32_t u;
+    memcpy(&u, &f, sizeof u);
+    Append(htole32(u));
+  }
+
+  void AppendString(char const *str)
+  {
+    data_.insert(data_.end(), str, str + strlen(str) + 1);
+  }
+
+  void AppendAttribute(char const *name, char const *type, int32_t size)
+  {
+    AppendString(name);
+    AppendString(type);
+    AppendInt32(size);
+  }
+
+  std::vector<uint8_t> &data() noexcept { return data_; }
+
+ private:
+  std::vector<uint8_t> data_;
+};
+
+/**
+ * The RLE compression of OpenEXR:
+ * 1. Split the bytes into even and odd parts(improve the correlation)
+ * 2. Predictor(delta)
+ * 3. Run-length encoding: (count - 1, byte) for run, (-count, bytes) for
+ *    literal bytes
+ *
+ * \return The compressed size, if it isn't less than the raw size,
+ *         the raw data should be used instead.
+ */
+size_t exr_rle_compress(std::vector<uint8_t> const &raw,
+                        std::vector<uint8_t> &tmp, std::vector<uint8_t> &out)
+{
+  const size_t n = raw.size();
+  tmp.resize(n);
+  out.clear();
+  if (n == 0) return 0;
+
+  // Reorder
+  size_t t1 = 0;
+  size_t t2 = (n + 1) / 2;
+  for (size_t i = 0; i < n; ++i) {
+    if (i & 1)
+      tmp[t2++] = raw[i];
+    else
+      tmp[t1++] = raw[i];
+  }
+
+  // Predictor
+  int p = tmp[0];
+  for (size_t i = 1; i < n; ++i) {
+    int d = int(tmp[i]) - p + (128 + 256);
+    p = tmp[i];
+    tmp[i] = (uint8_t)d;
+  }
+
+  // Run-length
+  constexpr size_t MIN_RUN_LENGTH = 3;
+  constexpr size_t MAX_RUN_LENGTH = 127;
+  size_t run_start = 0;
+  size_t run_end = 1;
+  while (run_start < n) {
+    while (run_end < n && tmp[run_start] == tmp[run_end] &&
+           run_end - run_start - 1 < MAX_RUN_LENGTH)
+      ++run_end;
+
+    if (run_end - run_start >= MIN_RUN_LENGTH) {
+      out.push_back((uint8_t)(run_end - run_start - 1));
+      out.push_back(tmp[run_start]);
+      run_start = run_end;
+    } else {
+      while (run_end < n &&
+             ((run_end + 1 >= n || tmp[run_end] != tmp[run_end + 1]) ||
+              (run_end + 2 >= n || tmp[run_end + 1] != tmp[run_end + 2])) &&
+             run_end - run_start < MAX_RUN_LENGTH)
+        ++run_end;
+
+      out.push_back((uint8_t)(int8_t)(-(int)(run_end - run_start)));
+      out.insert(out.end(), tmp.begin() + run_start, tmp.begin() + run_end);
+      run_start = run_end;
+    }
+    ++run_end;
+  }
+
+  return out.size();
+}
+
+} // namespace
+
+bool HdrImage::WriteExr(char const *path, bool rle) const noexcept
+{
+  File out;
+  if (!out.Open(path, File::TRUNC)) {
+    fprintf(stderr, "Failed to write exr file: %s\n", path);
+    return false;
+  }
+
+  // The channels must be sorted by name(strcmp)
+  std::vector<ExrChannel> channels = {
+      {"B", EXR_HALF, &rgb_, 3, 2},
+      {"G", EXR_HALF, &rgb_, 3, 1},
+      {"R", EXR_HALF, &rgb_, 3, 0},
+  };
+  if (has_aux(DEPTH)) channels.push_back({"Z", EXR_FLOAT, &depth_, 1, 0});
+  if (has_aux(ALBEDO)) {
+    channels.push_back({"albedo.B", EXR_HALF, &albedo_, 3, 2});
+    channels.push_back({"albedo.G", EXR_HALF, &albedo_, 3, 1});
+    channels.push_back({"albedo.R", EXR_HALF, &albedo_, 3, 0});
+  }
+  if (has_aux(NORMAL)) {
+    channels.push_back({"normal.X", EXR_HALF, &normal_, 3, 0});
+    channels.push_back({"normal.Y", EXR_HALF, &normal_, 3, 1});
+    channels.push_back({"normal.Z", EXR_HALF, &normal_, 3, 2});
+  }
+  if (has_aux(SAMPLE_COUNT))
+    channels.push_back({"sampleCount", EXR_UINT, nullptr, 1, 0});
+
+  std::sort(channels.begin(), channels.end(),
+            [](ExrChannel const &x, ExrChannel const &y) {
+              return strcmp(x.name, y.name) < 0;
+            });
+
+  ExrHeaderBuilder header;
+  // Magic number and version 2(single-part scanline)
+  header.AppendInt32(20000630);
+  header.AppendInt32(2);
+
+  int32_t chlist_size = 1;
+  for (auto const &c : channels)
+    chlist_size += (int32_t)strlen(c.name) + 1 + 16;
+  header.AppendAttribute("channels", "chlist", chlist_size);
+  for (auto const &c : channels) {
+    header.AppendString(c.name);
+    header.AppendInt32(c.type);
+    header.Append<uint32_t>(0); // pLinear + reserved
+    header.AppendInt32(1);      // x sampling
+    header.AppendInt32(1);      // y sampling
+  }
+  header.Append<uint8_t>(0);
+
+  header.AppendAttribute("compression", "compression", 1);
+  header.Append<uint8_t>(rle ? 1 : 0);
+
+  for (auto name : {"dataWindow", "displayWindow"}) {
+    header.AppendAttribute(name, "box2i", 16);
+    header.AppendInt32(0);
+    header.AppendInt32(0);
+    header.AppendInt32(width_ - 1);
+    header.AppendInt32(height_ - 1);
+  }
+
+  header.AppendAttribute("lineOrder", "lineOrder", 1);
+  header.Append<uint8_t>(0); // INCREASING_Y
+
+  header.AppendAttribute("pixelAspectRatio", "float", 4);
+  header.AppendFloat(1.f);
+
+  header.AppendAttribute("screenWindowCenter", "v2f", 8);
+  header.AppendFloat(0.f);
+  header.AppendFloat(0.f);
+
+  header.AppendAttribute("screenWindowWidth", "float", 4);
+  header.AppendFloat(1.f);
+
+  // End of header
+  header.Append<uint8_t>(0);
+
+  auto &header_data = header.data();
+  bool failed = out.Write(header_data.data(), header_data.size());
+
+  // Line offset table(one scanline per chunk for NO/RLE compression)
+  // Placeholder, patched after the chunks are written
+  const uint64_t table_offset = header_data.size();
+  std::vector<uint64_t> line_offsets(height_, 0);
+  failed |= out.Write(line_offsets.data(), line_offsets.size() * 8);
+  uint64_t offset = table_offset + line_offsets.size() * 8;
+
+  std::vector<uint8_t> raw;
+  std::vector<uint8_t> tmp;
+  std::vector<uint8_t> compressed;
+
+  // In EXR, y increases downward
+  for (int exr_y = 0; exr_y < height_ && !failed; ++exr_y) {
+    const int y = height_ - 1 - exr_y;
+
+    raw.clear();
+    for (auto const &c : channels) {
+      for (int x = 0; x < width_; ++x) {
+        const size_t i = index(x, y);
+        if (c.type == EXR_UINT) {
+          uint32_t v = htole32(sample_count_[i]);
+          auto p = reinterpret_cast<uint8_t const *>(&v);
+          raw.insert(raw.end(), p, p + 4);
+        } else if (c.type == EXR_HALF) {
+          uint16_t v = htole16(float_to_half((*c.buffer)[i * c.stride + c.offset]));
+          auto p = reinterpret_cast<uint8_t const *>(&v);
+          raw.insert(raw.end(), p, p + 2);
+        } else {
+          uint32_t v;
+          memcpy(&v, &(*c.buffer)[i * c.stride + c.offset], 4);
+          v = htole32(v);
+          auto p = reinterpret_cast<uint8_t const *>(&v);
+          raw.insert(raw.end(), p, p + 4);
+        }
+      }
+    }
+
+    auto *chunk = &raw;
+    if (rle && exr_rle_compress(raw, tmp, compressed) < raw.size()) {
+      chunk = &compressed;
+    }
+
+    uint32_t chunk_header[2] = {htole32((uint32_t)exr_y),
+                                htole32((uint32_t)chunk->size())};
+    failed |= out.Write(chunk_header, sizeof chunk_header);
+    failed |= out.Write(chunk->data(), chunk->size());
+
+    line_offsets[exr_y] = htole64(offset);
+    offset += sizeof chunk_header + chunk->size();
+  }
+
+  failed |= !out.SeekBegin((long)table_offset);
+  failed |= out.Write(line_offsets.data(), line_offsets.size() * 8);
+
+  if (failed || out.Flush()) {
+    fprintf(stderr, "Failed to write exr file: %s\n", path);
+    return false;
+  }
+  return true;
+}
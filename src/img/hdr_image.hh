@@ -0,0 +1,128 @@
+#ifndef IMG_HDR_IMAGE_HH__
+#define IMG_HDR_IMAGE_HH__
+
+#include <stdint.h>
+#include <string_view>
+#include <vector>
+
+#include "../gm/vec.hh"
+
+namespace img {
+
+/**
+ * High dynamic range image(linear radiance in float)
+ *
+ * Unlike TgaImage, the radiance is not gamma corrected and clamped,
+ * so the exposure and tone mapping can be adjusted without re-rendering.
+ *
+ * The auxiliary channels are used by denoiser and compositing:
+ * - albedo: The albedo of first(non-specular) hit
+ * - normal: The shading normal of first hit
+ * - depth: The distance from the camera to first hit
+ * - sample count: The samples of the pixel
+ * They are allocated only if the corresponding flag is specified.
+ *
+ * The origin is the bottom left corner as TgaImage, the writers flip the rows
+ * if the format requires top-down order.
+ */
+class HdrImage {
+ public:
+  enum AuxChannel : unsigned {
+    NO_AUX = 0,
+    ALBEDO = 0x1,
+    NORMAL = 0x2,
+    DEPTH = 0x4,
+    SAMPLE_COUNT = 0x8,
+    ALL_AUX = ALBEDO | NORMAL | DEPTH | SAMPLE_COUNT,
+  };
+
+  HdrImage() = default;
+  HdrImage(int w, int h, unsigned aux = NO_AUX);
+
+  /*--------------------------------------------------*/
+  /* File operation                                   */
+  /*--------------------------------------------------*/
+
+  /**
+   * Radiance RGBE format(*.hdr), only the color channels are written.
+   * \param rle Use the new run-length encoding of scanline
+   */
+  bool WriteHdr(char const *path, bool rle = true) const noexcept;
+
+  /**
+   * Read the Radiance RGBE format(*.hdr) written by WriteHdr()
+   * (flat or new run-length encoded scanlines, -Y H +X W orientation).
+   * The auxiliary channels are dropped.
+   */
+  bool ReadHdr(char const *path) noexcept;
+
+  /**
+   * Portable float map(*.pfm), only the color channels are written.
+   */
+  bool WritePfm(char const *path) const noexcept;
+
+  /**
+   * OpenEXR format(*.exr), single-part scanline image.
+   * The color, albedo and normal channels are half float,
+   * depth(Z) is float and sample count is unsigned int.
+   *
+   * \param rle Use RLE_COMPRESSION, otherwise NO_COMPRESSION
+   */
+  bool WriteExr(char const *path, bool rle = true) const noexcept;
+
+  /**
+   * Write the format of the extension of \p path(see is_hdr_path())
+   */
+  bool WriteTo(char const *path, bool rle = true) const noexcept;
+
+  /*--------------------------------------------------*/
+  /* Pixel manipulation                               */
+  /*--------------------------------------------------*/
+
+  void SetPixel(int x, int y, gm::Vec3F const &rgb) noexcept;
+  gm::Vec3F GetPixel(int x, int y) const noexcept;
+
+  void SetAlbedo(int x, int y, gm::Vec3F const &albedo) noexcept;
+  void SetNormal(int x, int y, gm::Vec3F const &normal) noexcept;
+  void SetDepth(int x, int y, float depth) noexcept;
+  void SetSampleCount(int x, int y, uint32_t count) noexcept;
+
+  /*--------------------------------------------------*/
+  /* Getter                                           */
+  /*--------------------------------------------------*/
+
+  int width() const noexcept { return width_; }
+  int height() const noexcept { return height_; }
+  unsigned aux() const noexcept { return aux_; }
+  bool has_aux(AuxChannel c) const noexcept { return (aux_ & c) != 0; }
+  float const *data() const noexcept { return rgb_.data(); }
+
+ private:
+  size_t index(int x, int y) const noexcept
+  {
+    return (size_t)y * width_ + x;
+  }
+
+  int width_ = 0;
+  int height_ = 0;
+  unsigned aux_ = NO_AUX;
+
+  std::vector<float> rgb_;
+  std::vector<float> albedo_;
+  std::vector<float> normal_;
+  std::vector<float> depth_;
+  std::vector<uint32_t> sample_count_;
+};
+
+/**
+ * The formats written by HdrImage(.hdr, .pfm and .exr)
+ */
+inline bool is_hdr_path(std::string_view path) noexcept
+{
+  return path.ends_with(".hdr") || path.ends_with(".pfm") ||
+         path.ends_with(".exr");
+}
+
+} // namespace img
+
+#endif
@@ -0,0 +1,72 @@
+#include "heatmap.hh"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace img;
+
+Heatmap::Heatmap(int w, int h)
+  : width_(w)
+  , height_(h)
+  , costs_((size_t)w * h, 0)
+{
+}
+
+Color Heatmap::MapColor(double t) noexcept
+{
+  // Piecewise linear between the keys
+  static const double keys[][3] = {
+    {0, 0, 0},
+    {0, 0, 1},
+    {1, 0, 0},
+    {1, 1, 0},
+    {1, 1, 1},
+  };
+  static constexpr int key_num = sizeof keys / sizeof keys[0];
+
+  t = std::clamp(t, 0., 1.) * (key_num - 1);
+  const int i = std::min((int)t, key_num - 2);
+  const double f = t - i;
+  return Color(keys[i][0] + (keys[i + 1][0] - keys[i][0]) * f,
+               keys[i][1] + (keys[i + 1][1] - keys[i][1]) * f,
+               keys[i][2] + (keys[i + 1][2] - keys[i][2]) * f);
+}
+
+uint64_t Heatmap::ScaleCost() const
+{
+  if (costs_.empty()) return 0;
+  auto sorted = costs_;
+  auto nth = sorted.begin() + (sorted.size() - 1) * 99 / 100;
+  std::nth_element(sorted.begin(), nth, sorted.end());
+  return *nth;
+}
+
+TgaImage Heatmap::ToImage() const
+{
+  TgaImage image(width_, height_);
+  const double scale = (double)std::max<uint64_t>(ScaleCost(), 1);
+  for (int y = 0; y < height_; ++y) {
+    for (int x = 0; x < width_; ++x) {
+      image.SetPixel(x, y, MapColor((double)Get(x, y) / scale));
+    }
+  }
+  return image;
+}
+
+bool Heatmap::WriteTo(char const *path) const
+{
+  uint64_t min_cost = UINT64_MAX;
+  uint64_t max_cost = 0;
+  double sum = 0;
+  for (auto cost : costs_) {
+    min_cost = std::min(min_cost, cost);
+    max_cost = std::max(max_cost, cost);
+    sum += (double)cost;
+  }
+  printf("Heatmap: min = %llu, max = %llu, mean = %.1lf, white = %llu(p99)\n",
+         (unsigned long long)min_cost, (unsigned long long)max_cost,
+         costs_.empty() ? 0. : sum / (double)costs_.size(),
+         (unsigned long long)ScaleCost());
+
+  return ToImage().WriteTo(path);
+}
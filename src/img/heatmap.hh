@@ -0,0 +1,60 @@
+#ifndef IMG_HEATMAP_HH__
+#define IMG_HEATMAP_HH__
+
+#include <stdint.h>
+#include <vector>
+
+#include "tga_image.hh"
+
+namespace img {
+
+/**
+ * Per-pixel cost(e.g. cycles, traversal steps) for debugging the performance
+ * of scene.
+ *
+ * The costs are mapped to colors(black -> blue -> red -> yellow -> white)
+ * linearly, the maximum of the map is the 99th percentile instead of the max
+ * cost, so a few outliers don't make the others dark.
+ */
+class Heatmap {
+ public:
+  Heatmap() = default;
+  Heatmap(int w, int h);
+
+  /**
+   * A pixel must be accumulated by one thread at the same time
+   * \param y From bottom to top as TgaImage
+   */
+  void Add(int x, int y, uint64_t cost) noexcept
+  {
+    costs_[(size_t)y * width_ + x] += cost;
+  }
+
+  uint64_t Get(int x, int y) const noexcept
+  {
+    return costs_[(size_t)y * width_ + x];
+  }
+
+  TgaImage ToImage() const;
+
+  /**
+   * Write the heatmap in TGA and print the cost range
+   */
+  bool WriteTo(char const *path) const;
+
+  static Color MapColor(double t) noexcept;
+
+  int width() const noexcept { return width_; }
+  int height() const noexcept { return height_; }
+
+ private:
+  uint64_t ScaleCost() const;
+
+  int width_ = 0;
+  int height_ = 0;
+  std::vector<uint64_t> costs_;
+};
+
+} // namespace img
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef IMG_IMAGE_STREAM_WRITER_HH__
+#define IMG_IMAGE_STREAM_WRITER_HH__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace img {
+
+struct ImageTile {
+  int x;
+  int y; // bottom row
+  int w;
+  int h;
+};
+
+/**
+ * Write image to disk tile by tile instead of holding the whole image in
+ * memory and encoding it at the end.
+ *
+ * The tile data is the same layout of the TgaImage, i.e. the pixel is
+ * stored in BGR(A) order and the first row is the bottom row of the tile.
+ * The coordinates of tile are also based on the bottom left origin.
+ *
+ * WriteTile() can be called from multiple threads concurrently,
+ * the implementation is responsible for the synchronization.
+ */
+class ImageStreamWriter {
+ public:
+  virtual ~ImageStreamWriter() noexcept = default;
+
+  /**
+   * \param x The left column of the tile
+   * \param y The bottom row of the tile
+   * \param w The width of the tile
+   * \param h The height of the tile
+   * \param data The pixels of the tile(w * h * bpp bytes)
+   *
+   * \return
+   *  false -- Failed to write or the tile is invalid
+   */
+  virtual bool WriteTile(int x, int y, int w, int h, uint8_t const *data) = 0;
+
+  /**
+   * Flush the remaining contents and write the trailer of the file.
+   * All tiles must be written before calling it.
+   */
+  virtual bool Close() = 0;
+
+  /**
+   * Split the image into the tiles that the writer accepts, and
+   * the order is also the preferred order of writing.
+   * The renderer should render the tiles in this order.
+   */
+  virtual std::vector<ImageTile> SplitTiles() const = 0;
+
+  /**
+   * The peak bytes of the tiles which are submitted but not written
+   */
+  size_t peak_pending_bytes() const noexcept { return peak_pending_bytes_; }
+
+ protected:
+  size_t peak_pending_bytes_ = 0;
+};
+
+} // namespace img
+
+#endif
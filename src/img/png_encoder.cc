@@ -0,0 +1,511 @@
+#include "png_encoder.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "../util/checksum.hh"
+#include "../util/file.hh"
+
+using namespace img;
+using namespace util;
+
+namespace {
+
+/*--------------------------------------------------*/
+/* Deflate(fixed Huffman codes)                     */
+/*--------------------------------------------------*/
+
+#define DEFLATE_WINDOW_SIZE 32768
+#define DEFLATE_MIN_MATCH 3
+#define DEFLATE_MAX_MATCH 258
+#define DEFLATE_HASH_BITS 15
+// Larger is slower but the compression ratio is better
+#define DEFLATE_MAX_CHAIN 32
+
+constexpr uint16_t LENGTH_BASE[] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+constexpr uint8_t LENGTH_EXTRA_BITS[] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+constexpr uint16_t DIST_BASE[] = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+  8193, 12289, 16385, 24577,
+};
+constexpr uint8_t DIST_EXTRA_BITS[] = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+
+inline uint32_t reverse_bits(uint32_t code, int len) noexcept
+{
+  uint32_t ret = 0;
+  for (int i = 0; i < len; ++i) {
+    ret = (ret << 1) | (code & 1);
+    code >>= 1;
+  }
+  return ret;
+}
+
+/**
+ * The fixed Huffman codes(RFC 1951 3.2.6) and the symbol lookup tables.
+ * The codes are reversed since the bits are packed starting with the LSB.
+ */
+struct FixedHuffmanTable {
+  uint16_t lit_code[288];
+  uint8_t lit_len[288];
+  uint8_t dist_code[30];
+  uint8_t length_sym[DEFLATE_MAX_MATCH + 1]; // length -> index of LENGTH_BASE
+  uint8_t dist_sym[512]; // see dist_symbol()
+
+  FixedHuffmanTable() noexcept
+  {
+    for (int v = 0; v < 288; ++v) {
+      uint32_t code;
+      int len;
+      if (v < 144) {
+        code = 0x30 + v;
+        len = 8;
+      } else if (v < 256) {
+        code = 0x190 + (v - 144);
+        len = 9;
+      } else if (v < 280) {
+        code = v - 256;
+        len = 7;
+      } else {
+        code = 0xc0 + (v - 280);
+        len = 8;
+      }
+      lit_code[v] = (uint16_t)reverse_bits(code, len);
+      lit_len[v] = (uint8_t)len;
+    }
+
+    for (int d = 0; d < 30; ++d) {
+      dist_code[d] = (uint8_t)reverse_bits(d, 5);
+    }
+
+    for (int i = 0, l = DEFLATE_MIN_MATCH; l <= DEFLATE_MAX_MATCH; ++l) {
+      while (i + 1 < 29 && LENGTH_BASE[i + 1] <= l) ++i;
+      length_sym[l] = (uint8_t)i;
+    }
+
+    // Same as zlib: the distances(minus 1) < 256 are indexed directly,
+    // the others are indexed by the high bits(their low 7 bits don't
+    // affect the symbol)
+    for (int i = 0, d = 1; d <= 256; ++d) {
+      while (i + 1 < 30 && DIST_BASE[i + 1] <= d) ++i;
+      dist_sym[d - 1] = (uint8_t)i;
+    }
+    for (int i = 0, hi = 2; hi < 256; ++hi) {
+      const int d = (hi << 7) + 1;
+      while (i + 1 < 30 && DIST_BASE[i + 1] <= d) ++i;
+      dist_sym[256 + hi] = (uint8_t)i;
+    }
+  }
+
+  int dist_symbol(int dist) const noexcept
+  {
+    return dist <= 256 ? dist_sym[dist - 1] : dist_sym[256 + ((dist - 1) >> 7)];
+  }
+};
+
+const FixedHuffmanTable fixed_huffman;
+
+class BitWriter {
+ public:
+  explicit BitWriter(std::vector<uint8_t> &out) noexcept
+    : out_(out)
+  {}
+
+  // n <= 24
+  void Put(uint32_t value, int n)
+  {
+    bits_ |= value << count_;
+    count_ += n;
+    while (count_ >= 8) {
+      out_.push_back(uint8_t(bits_));
+      bits_ >>= 8;
+      count_ -= 8;
+    }
+  }
+
+  void Align()
+  {
+    if (count_ > 0) {
+      out_.push_back(uint8_t(bits_));
+      bits_ = 0;
+      count_ = 0;
+    }
+  }
+
+ private:
+  std::vector<uint8_t> &out_;
+  uint32_t bits_ = 0;
+  int count_ = 0;
+};
+
+inline void put_literal(BitWriter &bw, int v)
+{
+  bw.Put(fixed_huffman.lit_code[v], fixed_huffman.lit_len[v]);
+}
+
+inline void put_match(BitWriter &bw, int len, int dist)
+{
+  const int ls = fixed_huffman.length_sym[len];
+  put_literal(bw, 257 + ls);
+  if (LENGTH_EXTRA_BITS[ls]) {
+    bw.Put(len - LENGTH_BASE[ls], LENGTH_EXTRA_BITS[ls]);
+  }
+
+  const int ds = fixed_huffman.dist_symbol(dist);
+  bw.Put(fixed_huffman.dist_code[ds], 5);
+  if (DIST_EXTRA_BITS[ds]) {
+    bw.Put(dist - DIST_BASE[ds], DIST_EXTRA_BITS[ds]);
+  }
+}
+
+inline uint32_t hash3(uint8_t const *p) noexcept
+{
+  return ((p[0] << 10) ^ (p[1] << 5) ^ p[2]) & ((1 << DEFLATE_HASH_BITS) - 1);
+}
+
+/**
+ * Compress the data in a fixed Huffman block(LZ77 with hash chains).
+ * If \p final is false, the block is followed by an empty stored block
+ * (i.e. sync flush) to align the stream to byte boundary.
+ */
+void deflate_segment(uint8_t const *data, size_t n, bool final,
+                     std::vector<uint8_t> &out)
+{
+  BitWriter bw(out);
+  bw.Put(final ? 1 : 0, 1); // BFINAL
+  bw.Put(1, 2);             // BTYPE = 01(fixed Huffman codes)
+
+  std::vector<int32_t> head(1 << DEFLATE_HASH_BITS, -1);
+  std::vector<int32_t> prev(n);
+
+  auto insert = [&](size_t pos) {
+    auto h = hash3(data + pos);
+    prev[pos] = head[h];
+    head[h] = (int32_t)pos;
+  };
+
+  size_t pos = 0;
+  while (pos < n) {
+    int best_len = 0;
+    int best_dist = 0;
+
+    if (pos + DEFLATE_MIN_MATCH <= n) {
+      const int max_len = (int)std::min<size_t>(DEFLATE_MAX_MATCH, n - pos);
+      int32_t candidate = head[hash3(data + pos)];
+      int chain = DEFLATE_MAX_CHAIN;
+
+      while (candidate >= 0 && pos - candidate <= DEFLATE_WINDOW_SIZE &&
+             chain-- > 0) {
+        auto a = data + candidate;
+        auto b = data + pos;
+        if (a[best_len] == b[best_len]) {
+          int len = 0;
+          while (len < max_len && a[len] == b[len]) ++len;
+          if (len > best_len) {
+            best_len = len;
+            best_dist = int(pos - candidate);
+            if (len == max_len) break;
+          }
+        }
+        candidate = prev[candidate];
+      }
+      insert(pos);
+    }
+
+    if (best_len >= DEFLATE_MIN_MATCH) {
+      put_match(bw, best_len, best_dist);
+      for (size_t i = pos + 1; i < pos + best_len; ++i) {
+        if (i + DEFLATE_MIN_MATCH <= n) insert(i);
+      }
+      pos += best_len;
+    } else {
+      put_literal(bw, data[pos]);
+      ++pos;
+    }
+  }
+
+  put_literal(bw, 256); // end of block
+
+  if (!final) {
+    // Empty stored block: BFINAL = 0, BTYPE = 00, LEN = 0, NLEN = 0xffff
+    bw.Put(0, 3);
+    bw.Align();
+    out.insert(out.end(), {0x00, 0x00, 0xff, 0xff});
+  } else {
+    bw.Align();
+  }
+}
+
+/*--------------------------------------------------*/
+/* PNG                                              */
+/*--------------------------------------------------*/
+
+enum PngFilter : uint8_t {
+  FILTER_NONE = 0,
+  FILTER_SUB = 1,
+  FILTER_UP = 2,
+  FILTER_AVERAGE = 3,
+  FILTER_PAETH = 4,
+};
+
+inline uint8_t paeth_predictor(int a, int b, int c) noexcept
+{
+  const int p = a + b - c;
+  const int pa = abs(p - a);
+  const int pb = abs(p - b);
+  const int pc = abs(p - c);
+  if (pa <= pb && pa <= pc) return (uint8_t)a;
+  if (pb <= pc) return (uint8_t)b;
+  return (uint8_t)c;
+}
+
+void filter_row(PngFilter filter, uint8_t const *cur, uint8_t const *prev,
+                int stride, int bpp, uint8_t *out) noexcept
+{
+  for (int x = 0; x < stride; ++x) {
+    const int a = x >= bpp ? cur[x - bpp] : 0;
+    const int b = prev[x];
+    const int c = x >= bpp ? prev[x - bpp] : 0;
+    uint8_t predictor = 0;
+    switch (filter) {
+      case FILTER_NONE: predictor = 0; break;
+      case FILTER_SUB: predictor = (uint8_t)a; break;
+      case FILTER_UP: predictor = (uint8_t)b; break;
+      case FILTER_AVERAGE: predictor = uint8_t((a + b) >> 1); break;
+      case FILTER_PAETH: predictor = paeth_predictor(a, b, c); break;
+    }
+    out[x] = uint8_t(cur[x] - predictor);
+  }
+}
+
+/**
+ * Convert the row \p y(from top to bottom) to RGB(A) order
+ */
+void load_row(uint8_t const *pixels, int w, int h, int bpp, int y,
+              uint8_t *row) noexcept
+{
+  const int stride = w * bpp;
+  memcpy(row, pixels + size_t(h - 1 - y) * stride, stride);
+  if (bpp >= 3) {
+    for (int x = 0; x < stride; x += bpp) {
+      std::swap(row[x], row[x + 2]);
+    }
+  }
+}
+
+struct PngSegment {
+  int y_begin;
+  int y_end;
+  uint32_t adler;   // Adler-32 of the filtered data
+  size_t raw_size;  // The size of the filtered data
+  std::vector<uint8_t> chunk; // IDAT chunk
+};
+
+inline void put_be32(uint8_t *p, uint32_t v) noexcept
+{
+  p[0] = uint8_t(v >> 24);
+  p[1] = uint8_t(v >> 16);
+  p[2] = uint8_t(v >> 8);
+  p[3] = uint8_t(v);
+}
+
+/**
+ * Append a chunk whose data is [data_begin, out.size()).
+ * The length and the type of chunk must have been reserved before data_begin.
+ */
+void finish_chunk(std::vector<uint8_t> &out, size_t data_begin)
+{
+  const auto len = uint32_t(out.size() - data_begin);
+  put_be32(&out[data_begin - 8], len);
+  auto crc = crc32(0, &out[data_begin - 4], len + 4);
+  out.resize(out.size() + 4);
+  put_be32(&out[out.size() - 4], crc);
+}
+
+void append_chunk(std::vector<uint8_t> &out, char const *type,
+                  uint8_t const *data, size_t n)
+{
+  out.resize(out.size() + 8);
+  memcpy(&out[out.size() - 4], type, 4);
+  const auto data_begin = out.size();
+  out.insert(out.end(), data, data + n);
+  finish_chunk(out, data_begin);
+}
+
+void encode_segment(uint8_t const *pixels, int w, int h, int bpp,
+                    bool first, bool last, PngSegment &seg)
+{
+  const int stride = w * bpp;
+  std::vector<uint8_t> filtered((size_t)(seg.y_end - seg.y_begin) * (stride + 1));
+  std::vector<uint8_t> prev_row(stride, 0);
+  std::vector<uint8_t> cur_row(stride);
+  std::vector<uint8_t> candidate(stride);
+
+  if (seg.y_begin > 0) {
+    load_row(pixels, w, h, bpp, seg.y_begin - 1, prev_row.data());
+  }
+
+  uint8_t *dst = filtered.data();
+  for (int y = seg.y_begin; y < seg.y_end; ++y) {
+    load_row(pixels, w, h, bpp, y, cur_row.data());
+
+    // Choose the filter which minimizes the sum of absolute
+    // differences(the heuristic in the PNG spec)
+    size_t best_sum = SIZE_MAX;
+    for (int f = FILTER_NONE; f <= FILTER_PAETH; ++f) {
+      filter_row((PngFilter)f, cur_row.data(), prev_row.data(), stride, bpp,
+                 candidate.data());
+      size_t sum = 0;
+      for (int x = 0; x < stride; ++x) {
+        sum += (size_t)abs((int8_t)candidate[x]);
+      }
+      if (sum < best_sum) {
+        best_sum = sum;
+        dst[0] = (uint8_t)f;
+        memcpy(dst + 1, candidate.data(), stride);
+      }
+    }
+
+    dst += stride + 1;
+    std::swap(prev_row, cur_row);
+  }
+
+  seg.raw_size = filtered.size();
+  seg.adler = adler32(1, filtered.data(), filtered.size());
+
+  auto &out = seg.chunk;
+  out.reserve(filtered.size() / 2 + 64);
+  out.resize(8);
+  memcpy(&out[4], "IDAT", 4);
+  if (first) {
+    // CMF: deflate, 32K window; FLG: fastest level, check bits
+    out.push_back(0x78);
+    out.push_back(0x01);
+  }
+  deflate_segment(filtered.data(), filtered.size(), last, out);
+  finish_chunk(out, 8);
+}
+
+} // namespace
+
+PngEncoder::PngEncoder(int thread_num)
+  : thread_num_(std::max(thread_num, 1))
+{
+}
+
+bool PngEncoder::Encode(uint8_t const *pixels, int w, int h, int bpp,
+                        std::vector<uint8_t> &out) const
+{
+  uint8_t color_type;
+  switch (bpp) {
+    case TgaImage::GRAYSCALE: color_type = 0; break;
+    case TgaImage::RGB: color_type = 2; break;
+    case TgaImage::RGBA: color_type = 6; break;
+    default:
+      fprintf(stderr, "PNG encoder: unsupported bytes per pixel: %d\n", bpp);
+      return false;
+  }
+  if (w <= 0 || h <= 0) {
+    fprintf(stderr, "PNG encoder: invalid image size: %d x %d\n", w, h);
+    return false;
+  }
+
+  // Split the image to segments.
+  // A segment should not be too small, otherwise the compression ratio
+  // is worse.
+  const size_t stride = (size_t)w * bpp + 1;
+  int rows = segment_rows_;
+  if (rows <= 0) {
+    rows = (h + thread_num_ * 4 - 1) / (thread_num_ * 4);
+    rows = std::max(rows, int((64 * 1024 + stride - 1) / stride));
+  }
+  rows = std::min(rows, h);
+
+  std::vector<PngSegment> segments;
+  for (int y = 0; y < h; y += rows) {
+    segments.push_back({y, std::min(y + rows, h), 0, 0, {}});
+  }
+
+  std::atomic<size_t> next_segment(0);
+  auto worker = [&]() {
+    size_t i;
+    while ((i = next_segment.fetch_add(1, std::memory_order_relaxed)) <
+           segments.size())
+    {
+      encode_segment(pixels, w, h, bpp, i == 0, i + 1 == segments.size(),
+                     segments[i]);
+    }
+  };
+
+  const int thread_num = std::min<int>(thread_num_, (int)segments.size());
+  std::vector<std::thread> thrs;
+  thrs.reserve(thread_num - 1);
+  for (int i = 1; i < thread_num; ++i) {
+    thrs.emplace_back(worker);
+  }
+  worker();
+  for (auto &thr : thrs) {
+    thr.join();
+  }
+
+  /* Stitch */
+  static const uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+  out.assign(signature, signature + sizeof signature);
+
+  uint8_t ihdr[13];
+  put_be32(ihdr, (uint32_t)w);
+  put_be32(ihdr + 4, (uint32_t)h);
+  ihdr[8] = 8;  // bit depth
+  ihdr[9] = color_type;
+  ihdr[10] = 0; // compression method: deflate
+  ihdr[11] = 0; // filter method: adaptive filtering
+  ihdr[12] = 0; // no interlace
+  append_chunk(out, "IHDR", ihdr, sizeof ihdr);
+
+  uint32_t adler = 1;
+  for (auto const &seg : segments) {
+    out.insert(out.end(), seg.chunk.begin(), seg.chunk.end());
+    adler = adler32_combine(adler, seg.adler, seg.raw_size);
+  }
+
+  // The trailer of zlib stream
+  uint8_t adler_be[4];
+  put_be32(adler_be, adler);
+  append_chunk(out, "IDAT", adler_be, sizeof adler_be);
+
+  append_chunk(out, "IEND", nullptr, 0);
+  return true;
+}
+
+bool PngEncoder::WriteTo(TgaImage const &image, char const *path) const
+{
+  std::vector<uint8_t> buffer;
+  if (!Encode(image.data(), image.width(), image.height(),
+              image.bytes_per_pixel(), buffer)) {
+    return false;
+  }
+
+  File out;
+  if (!out.Open(path, File::TRUNC)) {
+    fprintf(stderr, "Failed to write png file: %s\n", path);
+    return false;
+  }
+  if (out.Write(buffer.data(), buffer.size())) {
+    fprintf(stderr, "Failed to write png file: %s\n", path);
+    return false;
+  }
+  return true;
+}
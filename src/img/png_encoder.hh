@@ -0,0 +1,62 @@
+#ifndef IMG_PNG_ENCODER_HH__
+#define IMG_PNG_ENCODER_HH__
+
+#include <stdint.h>
+#include <vector>
+
+#include "tga_image.hh"
+
+namespace img {
+
+/**
+ * PNG format image encoder(*.png)
+ *
+ * The image is split into groups of scanlines(segments), and the segments
+ * are filtered and deflated in different threads. Each segment is an
+ * independent deflate block(fixed Huffman codes, as stb_image_write) which
+ * ends with a sync flush(empty stored block), so the compressed segments are
+ * byte-aligned and can be concatenated into one zlib stream directly.
+ * Every segment is written in its own IDAT chunk, then the CRC of chunk is
+ * also computed in parallel, and the Adler-32 of the zlib stream is combined
+ * from the ones of segments.
+ *
+ * The cost is that the matches can't cross the segments, so the file is
+ * slightly larger than the serial encoding.
+ *
+ * \see https://www.w3.org/TR/png/
+ * \see https://www.rfc-editor.org/rfc/rfc1950 (zlib)
+ * \see https://www.rfc-editor.org/rfc/rfc1951 (deflate)
+ */
+class PngEncoder {
+ public:
+  /**
+   * \param thread_num The number of encoding threads
+   */
+  explicit PngEncoder(int thread_num = 1);
+
+  /**
+   * Encode the pixels to PNG file content
+   *
+   * \param pixels The layout is same as TgaImage, i.e. the rows are stored
+   *               from bottom to top and the channels are in BGR(A) order
+   * \param bpp Bytes per pixel(GRAYSCALE/RGB/RGBA)
+   */
+  bool Encode(uint8_t const *pixels, int w, int h, int bpp,
+              std::vector<uint8_t> &out) const;
+
+  bool WriteTo(TgaImage const &image, char const *path) const;
+
+  /**
+   * The rows of a segment(0 means it is determined by image size
+   * and thread number)
+   */
+  void set_segment_rows(int rows) noexcept { segment_rows_ = rows; }
+
+ private:
+  int thread_num_;
+  int segment_rows_ = 0;
+};
+
+} // namespace img
+
+#endif
@@ -0,0 +1,200 @@
+#include "preview_server.hh"
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string_view>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "png_encoder.hh"
+
+using namespace img;
+
+// The minimum interval between two snapshots
+#define PREVIEW_SNAPSHOT_INTERVAL_MS 200
+
+static char const PREVIEW_PAGE[] =
+  "<!DOCTYPE html>\n"
+  "<html><head><title>rt preview</title></head>\n"
+  "<body style=\"background:#202020;margin:0\">\n"
+  "<img id=\"frame\" src=\"/frame.png\">\n"
+  "<script>\n"
+  "setInterval(() => {\n"
+  "  const next = new Image();\n"
+  "  next.onload = () => { document.getElementById('frame').src = next.src; };\n"
+  "  next.src = '/frame.png?' + Date.now();\n"
+  "  fetch('/pass').then(r => r.text()).then(t => document.title = 'rt preview ' + t);\n"
+  "}, 500);\n"
+  "</script>\n"
+  "</body></html>\n";
+
+static bool send_all(int fd, void const *data, size_t n) noexcept
+{
+  auto buf = static_cast<char const *>(data);
+  while (n > 0) {
+    auto ret = ::send(fd, buf, n, MSG_NOSIGNAL);
+    if (ret <= 0) return false;
+    buf += ret;
+    n -= ret;
+  }
+  return true;
+}
+
+static void send_response(int fd, char const *status, char const *type,
+                          void const *body, size_t n) noexcept
+{
+  char header[256];
+  auto len = snprintf(header, sizeof header,
+                      "HTTP/1.1 %s\r\n"
+                      "Content-Type: %s\r\n"
+                      "Content-Length: %zu\r\n"
+                      "Cache-Control: no-store\r\n"
+                      "Connection: close\r\n\r\n",
+                      status, type, n);
+  if (send_all(fd, header, len)) {
+    send_all(fd, body, n);
+  }
+}
+
+PreviewServer::PreviewServer(int w, int h)
+  : width_(w)
+  , height_(h)
+  , pixels_((size_t)w * h)
+  , version_(0)
+  , pass_(0)
+  , pass_num_(0)
+  , running_(false)
+{
+  // Black and opaque before any pixel is published
+  for (auto &pixel : pixels_) {
+    pixel.store(0xff000000u, std::memory_order_relaxed);
+  }
+}
+
+PreviewServer::~PreviewServer() noexcept
+{
+  Stop();
+}
+
+bool PreviewServer::Start(int port)
+{
+  listen_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listen_fd_ < 0) {
+    perror("Failed to create the socket of preview server");
+    return false;
+  }
+
+  int on = 1;
+  ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on);
+
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons((uint16_t)port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (::bind(listen_fd_, (sockaddr *)&addr, sizeof addr) < 0 ||
+      ::listen(listen_fd_, 16) < 0)
+  {
+    perror("Failed to listen the port of preview server");
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+    return false;
+  }
+
+  running_.store(true);
+  thread_ = std::thread([this]() { Run(); });
+  printf("Preview: http://127.0.0.1:%d/\n", port);
+  return true;
+}
+
+void PreviewServer::Stop() noexcept
+{
+  if (!running_.exchange(false)) return;
+  thread_.join();
+  ::close(listen_fd_);
+  listen_fd_ = -1;
+}
+
+void PreviewServer::Run() noexcept
+{
+  using namespace std::chrono;
+  auto last_snapshot = steady_clock::now() - milliseconds(PREVIEW_SNAPSHOT_INTERVAL_MS);
+
+  while (running_.load(std::memory_order_relaxed)) {
+    pollfd pfd{listen_fd_, POLLIN, 0};
+    // Timeout to check running_ and refresh snapshot
+    int ret = ::poll(&pfd, 1, 100);
+
+    auto now = steady_clock::now();
+    if (now - last_snapshot >= milliseconds(PREVIEW_SNAPSHOT_INTERVAL_MS)) {
+      UpdateSnapshot();
+      last_snapshot = now;
+    }
+
+    if (ret <= 0) continue;
+
+    int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) continue;
+    HandleConnection(fd);
+    ::close(fd);
+  }
+}
+
+void PreviewServer::UpdateSnapshot()
+{
+  const auto version = version_.load(std::memory_order_relaxed);
+  if (version == snapshot_version_ && !snapshot_[front_].empty()) return;
+  snapshot_version_ = version;
+
+  // Same layout as TgaImage(BGR, bottom to top)
+  std::vector<uint8_t> pixels((size_t)width_ * height_ * 3);
+  for (size_t i = 0; i < pixels_.size(); ++i) {
+    auto packed = pixels_[i].load(std::memory_order_relaxed);
+    memcpy(&pixels[i * 3], &packed, 3);
+  }
+
+  const int back = front_ ^ 1;
+  if (PngEncoder().Encode(pixels.data(), width_, height_, 3, snapshot_[back])) {
+    front_ = back;
+  }
+}
+
+void PreviewServer::HandleConnection(int fd) noexcept
+{
+  // Don't block the snapshot by a slow client for too long
+  timeval timeout{1, 0};
+  ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+  ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof timeout);
+
+  char request[2048];
+  auto n = ::recv(fd, request, sizeof request - 1, 0);
+  if (n <= 0) return;
+  request[n] = 0;
+
+  // Request line: GET <path>[?query] HTTP/1.1
+  std::string_view line(request, (size_t)n);
+  if (!line.starts_with("GET ")) {
+    send_response(fd, "405 Method Not Allowed", "text/plain", "", 0);
+    return;
+  }
+  line.remove_prefix(4);
+  auto path = line.substr(0, line.find_first_of(" ?\r\n"));
+
+  if (path == "/" || path == "/index.html") {
+    send_response(fd, "200 OK", "text/html", PREVIEW_PAGE,
+                  sizeof PREVIEW_PAGE - 1);
+  } else if (path == "/frame.png") {
+    auto const &png = snapshot_[front_];
+    send_response(fd, "200 OK", "image/png", png.data(), png.size());
+  } else if (path == "/pass") {
+    char text[64];
+    auto len = snprintf(text, sizeof text, "%d/%d",
+                        pass_.load(std::memory_order_relaxed),
+                        pass_num_.load(std::memory_order_relaxed));
+    send_response(fd, "200 OK", "text/plain", text, len);
+  } else {
+    send_response(fd, "404 Not Found", "text/plain", "Not Found", 9);
+  }
+}
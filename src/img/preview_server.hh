@@ -0,0 +1,85 @@
+#ifndef IMG_PREVIEW_SERVER_HH__
+#define IMG_PREVIEW_SERVER_HH__
+
+#include <atomic>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+#include "color.hh"
+
+namespace img {
+
+/**
+ * Serve the progressive render result over HTTP(localhost only)
+ *
+ * - GET /          A page which refreshes the frame periodically
+ * - GET /frame.png The latest snapshot of the framebuffer
+ *
+ * The render workers publish the tonemapped pixels by relaxed atomic stores,
+ * so publishing never blocks them(and a pixel is never torn).
+ * The server thread takes a snapshot of the framebuffer and encodes it to
+ * PNG only when some pixels are published since the last snapshot, the PNG is
+ * double buffered: the back one is encoded while the front one is served.
+ */
+class PreviewServer {
+ public:
+  PreviewServer(int w, int h);
+  ~PreviewServer() noexcept;
+
+  PreviewServer(PreviewServer const &) = delete;
+  PreviewServer &operator=(PreviewServer const &) = delete;
+
+  /**
+   * Listen on 127.0.0.1:port and start the server thread
+   */
+  bool Start(int port);
+  void Stop() noexcept;
+
+  /**
+   * Thread-safe and lock-free
+   *
+   * \param y From bottom to top as TgaImage
+   */
+  void Publish(int x, int y, Color const &color) noexcept
+  {
+    uint32_t packed;
+    memcpy(&packed, &color, sizeof packed);
+    pixels_[(size_t)y * width_ + x].store(packed, std::memory_order_relaxed);
+    version_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * The number of completed passes(shown in page title)
+   */
+  void set_pass(int pass, int pass_num) noexcept
+  {
+    pass_.store(pass, std::memory_order_relaxed);
+    pass_num_.store(pass_num, std::memory_order_relaxed);
+  }
+
+ private:
+  void Run() noexcept;
+  void HandleConnection(int fd) noexcept;
+  void UpdateSnapshot();
+
+  int width_;
+  int height_;
+  std::vector<std::atomic<uint32_t>> pixels_;
+  std::atomic<uint64_t> version_;
+  std::atomic<int> pass_;
+  std::atomic<int> pass_num_;
+
+  // Owned by the server thread
+  uint64_t snapshot_version_ = 0;
+  std::vector<uint8_t> snapshot_[2];
+  int front_ = 0;
+
+  int listen_fd_ = -1;
+  std::atomic<bool> running_;
+  std::thread thread_;
+};
+
+} // namespace img
+
+#endif
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <thread>
 
 #include "../util/assert.hh"
 #include "../util/file.hh"
@@ -57,25 +58,15 @@ TgaImage::TgaImage(uint8_t const *borrow_data, int w, int h, ImageType t)
 
 TgaImage::~TgaImage() noexcept {}
 
-bool TgaImage::WriteTo(char const *path, bool rle,
-                       ImageOriginOrder order) noexcept
+TgaHeader TgaImage::MakeHeader(int w, int h, ImageType t, bool rle,
+                               ImageOriginOrder order) noexcept
 {
-  if (enable_debug_) {
-    printf("===== WriteTo debug(start) =====\n");
-  }
-
-  File out;
-  if (!out.Open(path, File::TRUNC)) {
-    fprintf(stderr, "Failed to write tga file: %s\n", path);
-    return false;
-  }
-
   // NOTICE Must be little endian
   TgaHeader header;
-  header.pixel_depth = bits_per_pixel();
-  header.height = htole16(height_);
-  header.width = htole16(width_);
-  switch (image_type_) {
+  header.pixel_depth = (uint8_t)t << 3;
+  header.height = htole16(h);
+  header.width = htole16(w);
+  switch (t) {
     case NO_IMAGE_DATA:
       header.image_type = 0;
       break;
@@ -88,7 +79,146 @@ bool TgaImage::WriteTo(char const *path, bool rle,
       break;
   }
   header.image_descriptor |= (uint8_t)order;
-  
+  return header;
+}
+
+void TgaImage::EncodeRleScanline(uint8_t const *pixels, int pixel_num, int bpp,
+                                 std::vector<uint8_t> &image_buffer,
+                                 size_t *rle_packet_num,
+                                 size_t *raw_packet_num)
+{
+  size_t dummy_rle_packet_num = 0;
+  size_t dummy_raw_packet_num = 0;
+  if (!rle_packet_num) rle_packet_num = &dummy_rle_packet_num;
+  if (!raw_packet_num) raw_packet_num = &dummy_raw_packet_num;
+
+  size_t pixel_size = (size_t)pixel_num * bpp;
+  uint8_t const *image_raw_data = pixels;
+  uint8_t const *image_raw_data_end = image_raw_data + pixel_size;
+
+  size_t pixel_index = 0;
+  int pixel_bytes = 0;
+  int pixel_number = 0;
+
+  for (; pixel_index < pixel_size;) {
+    // 存在相邻元素
+    if (pixel_index < pixel_size - bpp) {
+      auto first_pixel = image_raw_data + pixel_index;
+      auto second_pixel = first_pixel + bpp;
+
+      // 如果相邻像素值相同，考虑Run-Length Packet
+      // 找到下一个不同于这两个像素的像素位置
+      //
+      // WARNING 不要用STL <algorithm>，因为不可以指定步长
+      if (memcmp(first_pixel, second_pixel, bpp) == 0) {
+        uint8_t const *next_diff_pixel = nullptr;
+        second_pixel += bpp;
+        for (; second_pixel < image_raw_data_end; second_pixel += bpp) {
+          if (memcmp(second_pixel, first_pixel, bpp) != 0) {
+            next_diff_pixel = second_pixel;
+            break;
+          }
+        }
+
+        if (!next_diff_pixel) next_diff_pixel = image_raw_data_end;
+        pixel_bytes = next_diff_pixel - first_pixel;
+        pixel_number = pixel_bytes / bpp;
+
+        for (; pixel_number >= 128; pixel_number -= 128) {
+          image_buffer.push_back(MakeTgaRlePacket(1, 128));
+
+          // 只需要第一个像素即可，因为均相同
+          image_buffer.insert(image_buffer.end(), first_pixel,
+                              first_pixel + bpp);
+          (*rle_packet_num)++;
+        }
+
+        if (pixel_number > 0) {
+          image_buffer.push_back(MakeTgaRlePacket(1, pixel_number));
+          image_buffer.insert(image_buffer.end(), first_pixel,
+                              first_pixel + bpp);
+          (*rle_packet_num)++;
+        }
+      } else {
+        // 不相同考虑Raw Packet
+        auto saved_first_pixel = first_pixel;
+        uint8_t const *next_adj_same_pixel = nullptr;
+
+        first_pixel += bpp;
+        second_pixel += bpp;
+        for (; second_pixel < image_raw_data_end;) {
+          if (memcmp(second_pixel, first_pixel, bpp) == 0) {
+            next_adj_same_pixel = first_pixel;
+            break;
+          }
+          first_pixel += bpp;
+          second_pixel += bpp;
+        }
+
+        if (!next_adj_same_pixel) next_adj_same_pixel = image_raw_data_end;
+        pixel_bytes = next_adj_same_pixel - saved_first_pixel;
+        pixel_number = pixel_bytes / bpp;
+
+        assert(pixel_number > 0);
+        for (; pixel_number >= 128; pixel_number -= 128) {
+          auto end = saved_first_pixel + 128 * bpp;
+          image_buffer.push_back(MakeTgaRlePacket(0, 128));
+          image_buffer.insert(image_buffer.end(), saved_first_pixel, end);
+          saved_first_pixel = end;
+          (*raw_packet_num)++;
+        }
+
+        if (pixel_number > 0) {
+          image_buffer.push_back(MakeTgaRlePacket(0, pixel_number));
+          image_buffer.insert(image_buffer.end(), saved_first_pixel,
+                              next_adj_same_pixel);
+          (*raw_packet_num)++;
+        }
+      }
+      pixel_index += pixel_bytes;
+    } else if (pixel_index == pixel_size - bpp) {
+      image_buffer.push_back(MakeTgaRlePacket(0, 1));
+      auto pixel = image_raw_data + pixel_index;
+      image_buffer.insert(image_buffer.end(), pixel, pixel + bpp);
+      pixel_index += bpp;
+      (*raw_packet_num)++;
+    }
+  }
+}
+
+void TgaImage::WriteFooter(File &out) noexcept
+{
+  /*
+   * Developer area
+   * and Extension area ignored also
+   */
+
+  /**
+   * Append footer to indicates this is new version tga format
+   */
+  TgaFooter footer;
+  footer.dev_dir_offset = htole32(footer.dev_dir_offset);
+  footer.ext_area_offset = htole32(footer.ext_area_offset);
+  memcpy(footer.signature, NEW_FORMAT_SIGNATURE, sizeof footer.signature);
+
+  out.Write(&footer, sizeof footer);
+}
+
+bool TgaImage::WriteTo(char const *path, bool rle,
+                       ImageOriginOrder order, int thread_num) noexcept
+{
+  if (enable_debug_) {
+    printf("===== WriteTo debug(start) =====\n");
+  }
+
+  File out;
+  if (!out.Open(path, File::TRUNC)) {
+    fprintf(stderr, "Failed to write tga file: %s\n", path);
+    return false;
+  }
+
+  auto header = MakeHeader(width_, height_, image_type_, rle, order);
+
   out.Write(&header, sizeof(header));
   if (enable_debug_)
     PrintHeader(header);
@@ -107,139 +237,62 @@ bool TgaImage::WriteTo(char const *path, bool rle,
       borrow_image_data_ ? borrow_image_data_ : image_data_.data();
   size_t pixel_total = width_ * height_;
   size_t pixel_size = pixel_total * bytes_per_pixel();
-  uint8_t const *image_raw_data_end = image_raw_data + pixel_size;
 
   if (rle) {
-    std::vector<uint8_t> image_buffer;
-    image_buffer.reserve(pixel_size);
+    const int bpp = bytes_per_pixel();
+    const size_t line_size = (size_t)width_ * bpp;
+
+    // Each thread encodes a group of consecutive scanlines into its buffer,
+    // then the buffers are written in order
+    thread_num = std::max(1, std::min(thread_num, (int)height_));
+    const int rows_per_group = (height_ + thread_num - 1) / thread_num;
+    const int group_num = (height_ + rows_per_group - 1) / rows_per_group;
+
+    struct RleGroup {
+      std::vector<uint8_t> buffer;
+      size_t raw_packet_num = 0;
+      size_t rle_packet_num = 0;
+    };
+    std::vector<RleGroup> groups(group_num);
+
+    auto encode_group = [&](int i) {
+      auto &group = groups[i];
+      const int y_end = std::min<int>(height_, (i + 1) * rows_per_group);
+      group.buffer.reserve(size_t(y_end - i * rows_per_group) * line_size);
+      for (int y = i * rows_per_group; y < y_end; ++y) {
+        EncodeRleScanline(image_raw_data + y * line_size, width_, bpp,
+                          group.buffer, &group.rle_packet_num,
+                          &group.raw_packet_num);
+      }
+    };
 
-    size_t pixel_index = 0;
-    int bpp = bytes_per_pixel();
-    int pixel_bytes = 0;
-    int pixel_number = 0;
+    std::vector<std::thread> thrs;
+    for (int i = 1; i < group_num; ++i) {
+      thrs.emplace_back(encode_group, i);
+    }
+    encode_group(0);
+    for (auto &thr : thrs) {
+      thr.join();
+    }
 
     size_t raw_packet_num = 0;
     size_t rle_packet_num = 0;
-
-    for (; pixel_index < pixel_size;) {
-      // 存在相邻元素
-      if (pixel_index < pixel_size - bpp) {
-        auto first_pixel = image_raw_data + pixel_index;
-        auto second_pixel = first_pixel + bpp;
-        
-        // 如果相邻像素值相同，考虑Run-Length Packet
-        // 找到下一个不同于这两个像素的像素位置
-        //
-        // WARNING 不要用STL <algorithm>，因为不可以指定步长
-        if (memcmp(first_pixel, second_pixel, bpp) == 0) {
-          uint8_t const *next_diff_pixel = nullptr;
-          second_pixel += bpp;
-          for (; second_pixel < image_raw_data_end; second_pixel += bpp) {
-            if (memcmp(second_pixel, first_pixel, bpp) != 0) {
-              next_diff_pixel = second_pixel;
-              break;
-            }
-          }
-          
-          if (rle_enable_debug_) {
-            printf("[RLE packet]\n");
-            printf("pixel number = %d\n", pixel_number);
-          }
-
-          if (!next_diff_pixel) next_diff_pixel = image_raw_data_end;
-          pixel_bytes = next_diff_pixel - first_pixel;
-          pixel_number = pixel_bytes / bpp;
-          
-          for (; pixel_number >= 128; pixel_number -= 128) {
-            image_buffer.push_back(MakeTgaRlePacket(1, 128));
-
-            // 只需要第一个像素即可，因为均相同
-            image_buffer.insert(image_buffer.end(), first_pixel,
-                                first_pixel + bpp);
-            rle_packet_num++;
-          }
-
-          if (pixel_number > 0) {
-            image_buffer.push_back(MakeTgaRlePacket(1, pixel_number));
-            image_buffer.insert(image_buffer.end(), first_pixel,
-                                first_pixel + bpp);
-            rle_packet_num++;
-          }
-        } else {
-          // 不相同考虑Raw Packet
-          auto saved_first_pixel = first_pixel;
-          uint8_t const *next_adj_same_pixel = nullptr;
-          
-          first_pixel += bpp;
-          second_pixel += bpp;
-          for (; second_pixel < image_raw_data_end;) {
-            if (memcmp(second_pixel, first_pixel, bpp) == 0) {
-              next_adj_same_pixel = first_pixel;
-              break;
-            }
-            first_pixel += bpp;
-            second_pixel += bpp;
-          }
-        
-          if (!next_adj_same_pixel) next_adj_same_pixel = image_raw_data_end;
-          pixel_bytes = next_adj_same_pixel - saved_first_pixel;
-          pixel_number = pixel_bytes / bpp;
-
-          if (rle_enable_debug_) {
-            printf("[Raw packet]\n");
-            printf("pixel_number = %d\n", pixel_number);
-          }
-          
-          assert(pixel_number > 0);
-          for (; pixel_number >= 128; pixel_number -= 128) {
-            auto end = saved_first_pixel + 128 * bpp;
-            image_buffer.push_back(MakeTgaRlePacket(0, 128));
-            image_buffer.insert(image_buffer.end(), saved_first_pixel, end);
-            saved_first_pixel = end;
-            raw_packet_num++;
-          }
-
-          if (pixel_number > 0) {
-            image_buffer.push_back(MakeTgaRlePacket(0, pixel_number));
-            image_buffer.insert(image_buffer.end(), saved_first_pixel,
-                                next_adj_same_pixel);
-            raw_packet_num++;
-          }
-        }
-        pixel_index += pixel_bytes;
-      } else if (pixel_index == pixel_size - bpp) {
-        image_buffer.push_back(MakeTgaRlePacket(0, 1));
-        auto pixel = image_raw_data + pixel_index;
-        image_buffer.insert(image_buffer.end(), pixel, pixel + bpp);
-        pixel_index += bpp;
-        raw_packet_num++;
-      }
+    for (auto const &group : groups) {
+      out.Write(group.buffer.data(), group.buffer.size());
+      raw_packet_num += group.raw_packet_num;
+      rle_packet_num += group.rle_packet_num;
     }
 
     if (enable_debug_) {
       printf("raw packet num = %zu\n", raw_packet_num);
       printf("rle packet num = %zu\n", rle_packet_num);
     }
-    out.Write(image_buffer.data(), image_buffer.size());
   } else {
     out.Write(image_raw_data, pixel_size);
   }
-  
-  /*
-   * Developer area
-   * and Extension area ignored also
-   */
 
-  /**
-   * Append footer to indicates this is new version tga format
-   */
-  TgaFooter footer;
-  footer.dev_dir_offset = htole32(footer.dev_dir_offset);
-  footer.ext_area_offset = htole32(footer.ext_area_offset);
-  memcpy(footer.signature, NEW_FORMAT_SIGNATURE, sizeof footer.signature);
+  WriteFooter(out);
 
-  out.Write(&footer, sizeof footer);
-  
   if (enable_debug_) {
     printf("===== WriteTo debug(end) =====\n");
   }
@@ -8,6 +8,10 @@
 
 #include "color.hh"
 
+namespace util {
+class File;
+} // namespace util
+
 namespace img {
 
 // Force to align to 1
@@ -124,12 +128,43 @@ class TgaImage {
   /* File operation                                   */
   /*--------------------------------------------------*/
 
+  /**
+   * \param thread_num The scanlines are RLE encoded in \p thread_num
+   *                   threads(the packets never cross the scanlines)
+   */
   bool WriteTo(char const *path,
                bool rle = false,
-               ImageOriginOrder order = ImageOriginOrder::BOTTOM_LEFT) noexcept;
+               ImageOriginOrder order = ImageOriginOrder::BOTTOM_LEFT,
+               int thread_num = 1) noexcept;
 
   bool ReadFrom(char const *path) noexcept;
 
+  /**
+   * Build the header of a TGA file(little endian has been handled)
+   */
+  static TgaHeader MakeHeader(int w, int h, ImageType t, bool rle,
+                              ImageOriginOrder order) noexcept;
+
+  /**
+   * Encode a scanline in Run-length packets and Raw packets and append them
+   * to the \p image_buffer.
+   * TGA 2.0 spec requires that the packets should never cross the scanline
+   * boundaries, so the caller should encode the image line by line, and the
+   * lines can be encoded independently(e.g. in different threads).
+   *
+   * \param pixels The first pixel of the scanline
+   * \param pixel_num The number of pixels in the scanline(i.e. width)
+   * \param bpp Bytes per pixel
+   * \param rle_packet_num The counter of Run-length packets(optional)
+   * \param raw_packet_num The counter of Raw packets(optional)
+   */
+  static void EncodeRleScanline(uint8_t const *pixels, int pixel_num, int bpp,
+                                std::vector<uint8_t> &image_buffer,
+                                size_t *rle_packet_num = nullptr,
+                                size_t *raw_packet_num = nullptr);
+
+  static void WriteFooter(util::File &out) noexcept;
+
   /*--------------------------------------------------*/
   /* Pixel manipulation                               */
   /*--------------------------------------------------*/
@@ -0,0 +1,114 @@
+#include "tga_stream_writer.hh"
+
+#include <algorithm>
+
+using namespace img;
+using namespace util;
+
+TgaStreamWriter::TgaStreamWriter(int w, int h, int block_height,
+                                 TgaImage::ImageType t, bool rle)
+  : width_(w)
+  , height_(h)
+  , block_height_(block_height > 0 ? block_height : h)
+  , bpp_((int)t)
+  , rle_(rle)
+{
+}
+
+TgaStreamWriter::~TgaStreamWriter() noexcept
+{
+  if (out_.IsValid() && !closed_) {
+    fprintf(stderr, "The TGA stream is not closed, it is incomplete\n");
+  }
+}
+
+bool TgaStreamWriter::Open(char const *path) noexcept
+{
+  if (!out_.Open(path, File::TRUNC)) {
+    fprintf(stderr, "Failed to write tga file: %s\n", path);
+    return false;
+  }
+
+  auto header =
+      TgaImage::MakeHeader(width_, height_, TgaImage::ImageType(bpp_), rle_,
+                           TgaImage::BOTTOM_LEFT);
+  out_.Write(&header, sizeof header);
+  return true;
+}
+
+bool TgaStreamWriter::WriteTile(int x, int y, int w, int h,
+                                uint8_t const *data)
+{
+  if (x != 0 || w != width_ || y < 0 || h <= 0 || y + h > height_) {
+    fprintf(stderr, "TGA stream only accepts the whole scanlines\n");
+    return false;
+  }
+
+  const size_t line_size = (size_t)width_ * bpp_;
+  std::vector<uint8_t> block;
+  if (rle_) {
+    block.reserve(line_size * h);
+    for (int i = 0; i < h; ++i) {
+      TgaImage::EncodeRleScanline(data + i * line_size, width_, bpp_, block);
+    }
+  } else {
+    block.assign(data, data + line_size * h);
+  }
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (y == next_row_) {
+    // Fast path: don't cache
+    if (out_.Write(block.data(), block.size())) {
+      fprintf(stderr, "Failed to write the TGA scanlines\n");
+      return false;
+    }
+    next_row_ += h;
+    return FlushPendingBlocks();
+  }
+
+  pending_bytes_ += block.size();
+  peak_pending_bytes_ = std::max(peak_pending_bytes_, pending_bytes_);
+  pending_blocks_.emplace(y, std::make_pair(h, std::move(block)));
+  return true;
+}
+
+std::vector<ImageTile> TgaStreamWriter::SplitTiles() const
+{
+  // From bottom to top, i.e. the order of TGA image data
+  std::vector<ImageTile> tiles;
+  for (int y = 0; y < height_; y += block_height_) {
+    tiles.push_back({0, y, width_, std::min(block_height_, height_ - y)});
+  }
+  return tiles;
+}
+
+bool TgaStreamWriter::FlushPendingBlocks() noexcept
+{
+  for (auto iter = pending_blocks_.begin();
+       iter != pending_blocks_.end() && iter->first == next_row_;)
+  {
+    auto &block = iter->second.second;
+    if (out_.Write(block.data(), block.size())) {
+      fprintf(stderr, "Failed to write the TGA scanlines\n");
+      return false;
+    }
+    next_row_ += iter->second.first;
+    pending_bytes_ -= block.size();
+    iter = pending_blocks_.erase(iter);
+  }
+  return true;
+}
+
+bool TgaStreamWriter::Close()
+{
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (next_row_ != height_) {
+    fprintf(stderr, "The TGA stream is incomplete: %d/%d rows are written\n",
+            next_row_, height_);
+    return false;
+  }
+
+  TgaImage::WriteFooter(out_);
+  closed_ = true;
+  return !out_.Flush();
+}
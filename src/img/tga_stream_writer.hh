@@ -0,0 +1,65 @@
+#ifndef IMG_TGA_STREAM_WRITER_HH__
+#define IMG_TGA_STREAM_WRITER_HH__
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "image_stream_writer.hh"
+#include "tga_image.hh"
+#include "../util/file.hh"
+
+namespace img {
+
+/**
+ * Write TGA image in scanline blocks.
+ *
+ * The image data of TGA is a sequential stream from the bottom line to the
+ * top line(BOTTOM_LEFT order), so the block can be written only if all
+ * blocks under it have been written. The blocks that arrive earlier are
+ * cached until the gap is filled.
+ * Therefore, the renderer should render the blocks from bottom to top, then
+ * the cached blocks are bounded by the number of in-flight blocks.
+ *
+ * If RLE is enabled, the block is encoded in the caller thread before
+ * entering the critical section.
+ */
+class TgaStreamWriter : public ImageStreamWriter {
+ public:
+  /**
+   * \param block_height The number of rows per block
+   */
+  TgaStreamWriter(int w, int h, int block_height,
+                  TgaImage::ImageType t = TgaImage::RGB, bool rle = false);
+  ~TgaStreamWriter() noexcept override;
+
+  bool Open(char const *path) noexcept;
+
+  bool WriteTile(int x, int y, int w, int h, uint8_t const *data) override;
+  bool Close() override;
+
+  std::vector<ImageTile> SplitTiles() const override;
+
+ private:
+  bool FlushPendingBlocks() noexcept;
+
+  int width_;
+  int height_;
+  int block_height_;
+  int bpp_;
+  bool rle_;
+  bool closed_ = false;
+
+  util::File out_;
+
+  std::mutex mutex_;
+  // The next row(from bottom) should be written
+  int next_row_ = 0;
+  size_t pending_bytes_ = 0;
+  // row -> (row number, encoded data)
+  std::map<int, std::pair<int, std::vector<uint8_t>>> pending_blocks_;
+};
+
+} // namespace img
+
+#endif
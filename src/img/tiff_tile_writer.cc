@@ -0,0 +1,244 @@
+#include "tiff_tile_writer.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "../util/endian.h"
+
+using namespace img;
+using namespace util;
+
+namespace {
+
+enum TiffTag : uint16_t {
+  IMAGE_WIDTH = 256,
+  IMAGE_LENGTH = 257,
+  BITS_PER_SAMPLE = 258,
+  COMPRESSION = 259,
+  PHOTOMETRIC_INTERPRETATION = 262,
+  SAMPLES_PER_PIXEL = 277,
+  PLANAR_CONFIGURATION = 284,
+  TILE_WIDTH = 322,
+  TILE_LENGTH = 323,
+  TILE_OFFSETS = 324,
+  TILE_BYTE_COUNTS = 325,
+  EXTRA_SAMPLES = 338,
+};
+
+enum TiffType : uint16_t {
+  SHORT = 3,
+  LONG = 4,
+};
+
+#pragma pack(push, 1)
+struct TiffIfdEntry {
+  uint16_t tag;
+  uint16_t type;
+  uint32_t count;
+  uint32_t value; // value or offset
+};
+#pragma pack(pop)
+
+static_assert(sizeof(TiffIfdEntry) == 12, "The length of IFD entry is 12");
+
+inline TiffIfdEntry make_entry(uint16_t tag, uint16_t type, uint32_t count,
+                               uint32_t value) noexcept
+{
+  // The SHORT value is left-justified in the 4 bytes
+  // i.e. the lower 2 bytes in little endian
+  return {htole16(tag), htole16(type), htole32(count), htole32(value)};
+}
+
+} // namespace
+
+TiffTileWriter::TiffTileWriter(int w, int h, int tile_size,
+                               TgaImage::ImageType t)
+  : width_(w)
+  , height_(h)
+  , tile_size_(std::max(16, (tile_size + 15) / 16 * 16))
+  , bpp_((int)t)
+  , tiles_across_((w + tile_size_ - 1) / tile_size_)
+  , tiles_down_((h + tile_size_ - 1) / tile_size_)
+  , tile_offsets_(tiles_across_ * tiles_down_, 0)
+  , tile_byte_counts_(tiles_across_ * tiles_down_, 0)
+{
+}
+
+TiffTileWriter::~TiffTileWriter() noexcept
+{
+  if (out_.IsValid() && !closed_) {
+    fprintf(stderr, "The TIFF stream is not closed, it is incomplete\n");
+  }
+}
+
+bool TiffTileWriter::Open(char const *path) noexcept
+{
+  // The offsets of baseline TIFF are 32 bits, the padded tiles, the IFD and
+  // the arrays after it must be in the first 4GB.
+  // Check it before writing anything instead of writing the wrapped offsets.
+  const uint64_t tile_num = tile_offsets_.size();
+  const uint64_t tile_bytes = (uint64_t)tile_size_ * tile_size_ * bpp_;
+  const uint64_t file_size = 8 + tile_num * tile_bytes + 1 +
+                             (2 + 12 * sizeof(TiffIfdEntry) + 4) +
+                             4 * sizeof(uint16_t) + tile_num * 8;
+  if (file_size > UINT32_MAX) {
+    fprintf(stderr,
+            "The TIFF file is too large(%llu bytes), "
+            "the baseline TIFF must be smaller than 4GB\n",
+            (unsigned long long)file_size);
+    return false;
+  }
+
+  if (!out_.Open(path, File::TRUNC)) {
+    fprintf(stderr, "Failed to write tiff file: %s\n", path);
+    return false;
+  }
+
+  // Little endian, the IFD offset is unknown now
+  uint8_t header[8] = {'I', 'I', 42, 0, 0, 0, 0, 0};
+  out_.Write(header, sizeof header);
+  file_offset_ = sizeof header;
+  return true;
+}
+
+std::vector<ImageTile> TiffTileWriter::SplitTiles() const
+{
+  // The tile grid of TIFF starts from the top left corner
+  std::vector<ImageTile> tiles;
+  tiles.reserve(tiles_across_ * tiles_down_);
+  for (int ty = 0; ty < tiles_down_; ++ty) {
+    const int top = ty * tile_size_;
+    const int h = std::min(tile_size_, height_ - top);
+    for (int tx = 0; tx < tiles_across_; ++tx) {
+      const int x = tx * tile_size_;
+      tiles.push_back(
+          {x, height_ - top - h, std::min(tile_size_, width_ - x), h});
+    }
+  }
+  return tiles;
+}
+
+bool TiffTileWriter::WriteTile(int x, int y, int w, int h, uint8_t const *data)
+{
+  const int top = height_ - y - h;
+  if (x % tile_size_ != 0 || top % tile_size_ != 0 || w <= 0 || h <= 0 ||
+      w != std::min(tile_size_, width_ - x) ||
+      h != std::min(tile_size_, height_ - top))
+  {
+    fprintf(stderr, "The tile(%d, %d, %d, %d) is not in the TIFF tile grid\n",
+            x, y, w, h);
+    return false;
+  }
+
+  // Flip the rows and convert BGR(A) to RGB(A)
+  // The tile at the edge must be padded to the whole tile size
+  const size_t tile_bytes = (size_t)tile_size_ * tile_size_ * bpp_;
+  std::vector<uint8_t> tile(tile_bytes, 0);
+  for (int row = 0; row < h; ++row) {
+    auto src = data + (size_t)(h - 1 - row) * w * bpp_;
+    auto dst = &tile[(size_t)row * tile_size_ * bpp_];
+    memcpy(dst, src, (size_t)w * bpp_);
+    if (bpp_ >= 3) {
+      for (int i = 0; i < w; ++i) {
+        std::swap(dst[i * bpp_], dst[i * bpp_ + 2]);
+      }
+    }
+  }
+
+  const int index = (top / tile_size_) * tiles_across_ + x / tile_size_;
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (out_.Write(tile.data(), tile.size())) {
+    fprintf(stderr, "Failed to write the TIFF tile\n");
+    return false;
+  }
+  tile_offsets_[index] = file_offset_;
+  tile_byte_counts_[index] = (uint32_t)tile_bytes;
+  file_offset_ += (uint32_t)tile_bytes;
+  return true;
+}
+
+bool TiffTileWriter::Close()
+{
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (std::find(tile_byte_counts_.begin(), tile_byte_counts_.end(), 0u) !=
+      tile_byte_counts_.end())
+  {
+    fprintf(stderr, "The TIFF stream is incomplete: some tiles are missing\n");
+    return false;
+  }
+
+  // The IFD must begin on a word boundary
+  if (file_offset_ & 1) {
+    uint8_t pad = 0;
+    out_.Write(&pad, 1);
+    file_offset_++;
+  }
+
+  const uint32_t tile_num = (uint32_t)tile_offsets_.size();
+  const bool has_alpha = bpp_ == TgaImage::RGBA;
+  const uint16_t entry_num = has_alpha ? 12 : 11;
+  const uint32_t ifd_offset = file_offset_;
+  const uint32_t ifd_size = 2 + entry_num * (uint32_t)sizeof(TiffIfdEntry) + 4;
+  // The arrays after IFD
+  const uint32_t bits_offset = ifd_offset + ifd_size;
+  const uint32_t offsets_offset = bits_offset + 4 * sizeof(uint16_t);
+  const uint32_t counts_offset = offsets_offset + tile_num * 4;
+
+  // Single value is stored in the entry directly
+  auto array_value = [tile_num](uint32_t offset, uint32_t single) {
+    return tile_num == 1 ? single : offset;
+  };
+
+  std::vector<TiffIfdEntry> entries;
+  entries.push_back(make_entry(IMAGE_WIDTH, LONG, 1, width_));
+  entries.push_back(make_entry(IMAGE_LENGTH, LONG, 1, height_));
+  entries.push_back(make_entry(BITS_PER_SAMPLE, SHORT, bpp_,
+                               bpp_ <= 2 ? 8 : bits_offset));
+  entries.push_back(make_entry(COMPRESSION, SHORT, 1, 1));
+  entries.push_back(
+      make_entry(PHOTOMETRIC_INTERPRETATION, SHORT, 1, bpp_ >= 3 ? 2 : 1));
+  entries.push_back(make_entry(SAMPLES_PER_PIXEL, SHORT, 1, bpp_));
+  entries.push_back(make_entry(PLANAR_CONFIGURATION, SHORT, 1, 1));
+  entries.push_back(make_entry(TILE_WIDTH, LONG, 1, tile_size_));
+  entries.push_back(make_entry(TILE_LENGTH, LONG, 1, tile_size_));
+  entries.push_back(make_entry(TILE_OFFSETS, LONG, tile_num,
+                               array_value(offsets_offset, tile_offsets_[0])));
+  entries.push_back(
+      make_entry(TILE_BYTE_COUNTS, LONG, tile_num,
+                 array_value(counts_offset, tile_byte_counts_[0])));
+  if (has_alpha) {
+    // Unassociated alpha
+    entries.push_back(make_entry(EXTRA_SAMPLES, SHORT, 1, 2));
+  }
+
+  uint16_t le_entry_num = htole16(entry_num);
+  uint32_t next_ifd = 0;
+  bool failed = false;
+  failed |= out_.Write(&le_entry_num, sizeof le_entry_num);
+  failed |= out_.Write(entries.data(), entries.size() * sizeof(TiffIfdEntry));
+  failed |= out_.Write(&next_ifd, sizeof next_ifd);
+
+  uint16_t bits[4] = {htole16(8), htole16(8), htole16(8), htole16(8)};
+  failed |= out_.Write(bits, sizeof bits);
+
+  if (tile_num > 1) {
+    for (auto &offset : tile_offsets_) offset = htole32(offset);
+    for (auto &count : tile_byte_counts_) count = htole32(count);
+    failed |= out_.Write(tile_offsets_.data(), tile_num * 4);
+    failed |= out_.Write(tile_byte_counts_.data(), tile_num * 4);
+  }
+
+  // Patch the offset of the first IFD
+  uint32_t le_ifd_offset = htole32(ifd_offset);
+  failed |= !out_.SeekBegin(4);
+  failed |= out_.Write(&le_ifd_offset, sizeof le_ifd_offset);
+
+  if (failed || out_.Flush()) {
+    fprintf(stderr, "Failed to write the IFD of TIFF\n");
+    return false;
+  }
+  closed_ = true;
+  return true;
+}
@@ -0,0 +1,71 @@
+#ifndef IMG_TIFF_TILE_WRITER_HH__
+#define IMG_TIFF_TILE_WRITER_HH__
+
+#include <mutex>
+#include <vector>
+
+#include "image_stream_writer.hh"
+#include "tga_image.hh"
+#include "../util/file.hh"
+
+namespace img {
+
+/**
+ * Tiled TIFF format image(*.tif, *.tiff)
+ *
+ * Baseline TIFF with the tile extension(TIFF 6.0 Section 15), uncompressed.
+ * The tiles can be written in any order since the TileOffsets is written in
+ * the IFD at the end of the file, so the tile is written once it is
+ * completed and no tile is cached.
+ *
+ * Layout:
+ * |++++++++++++++++++++++++++++++|
+ * | header(8 bytes)              | -- IFD offset is patched in Close()
+ * | tile data                    | -- in the order of completion
+ * | IFD + BitsPerSample + tile   |
+ * | offsets + tile byte counts   |
+ * |++++++++++++++++++++++++++++++|
+ *
+ * \see https://www.itu.int/itudoc/itu-t/com16/tiff-fx/docs/tiff6.pdf
+ */
+class TiffTileWriter : public ImageStreamWriter {
+ public:
+  /**
+   * \param tile_size The width and height of tile(must be multiple of 16)
+   */
+  TiffTileWriter(int w, int h, int tile_size,
+                 TgaImage::ImageType t = TgaImage::RGB);
+  ~TiffTileWriter() noexcept override;
+
+  /**
+   * \return
+   *  false -- Failed to open the file or the file will be larger than 4GB
+   *           (the offsets of baseline TIFF are 32 bits)
+   */
+  bool Open(char const *path) noexcept;
+
+  bool WriteTile(int x, int y, int w, int h, uint8_t const *data) override;
+  bool Close() override;
+
+  std::vector<ImageTile> SplitTiles() const override;
+
+ private:
+  int width_;
+  int height_;
+  int tile_size_;
+  int bpp_;
+  int tiles_across_;
+  int tiles_down_;
+  bool closed_ = false;
+
+  util::File out_;
+
+  std::mutex mutex_;
+  uint32_t file_offset_ = 0;
+  std::vector<uint32_t> tile_offsets_;
+  std::vector<uint32_t> tile_byte_counts_;
+};
+
+} // namespace img
+
+#endif
@@ -1,33 +1,48 @@
+#include <atomic>
 #include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
 #include <string_view>
 #include <thread>
-#include <random>
 
-#define USE_STB_IMAGE_WRITE 1
+// The PNG and TGA are encoded in parallel by PngEncoder and TgaImage,
+// stb_image_write is single-threaded
+#define USE_STB_IMAGE_WRITE 0
 
 #if USE_STB_IMAGE_WRITE
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb/stb_image_write.h>
 #endif
 
-#include "main_scene.hh"
 #include "option.hh"
+#include "pixel_kernel.hh"
+#include "sequence.hh"
 #include "gm/util.hh"
 #include "rt/ray.hh"
-#include "rt/hit_record.hh"
-#include "rt/scatter_record.hh"
 #include "rt/camera.hh"
+#include "rt/integrator.hh"
+#include "rt/scene.hh"
+#include "rt/stats.hh"
+#include "sample/sampler.hh"
 #include "img/color.hh"
+#include "img/hdr_image.hh"
+#include "img/heatmap.hh"
+#include "img/png_encoder.hh"
+#include "img/preview_server.hh"
 #include "img/tga_image.hh"
-#include "material/material.hh"
-#include "sample/cosine_pdf.hh"
-#include "sample/mixture_pdf.hh"
-#include "sample/shape_pdf.hh"
+#include "img/tga_stream_writer.hh"
+#include "img/tiff_tile_writer.hh"
 #include "util/atomic_counter.h"
+#include "util/cycle_clock.hh"
 #include "util/progress_bar.hh"
 #include "util/random.hh"
 
-#define MAX_DEPTH 50
+// The rows of a render block if the image isn't written in stream
+#define RENDER_BLOCK_HEIGHT 16
+
+// The number of progressive passes when the preview is enabled
+#define PREVIEW_PASS_NUM 16
 
 using namespace rt;
 using namespace std;
@@ -37,11 +52,87 @@ using namespace img;
 
 namespace ktm = std::chrono;
 
-Vec3F ray_color(Ray const &ray, rt::Color const &background, Shape const &shape,
-                ShapeSPtr const &lights, int max_depth);
+/**
+ * The cost counter of current thread(the cost of a pixel is the difference)
+ */
+inline uint64_t read_pixel_cost(HeatmapMode mode) noexcept
+{
+  switch (mode) {
+    case HEATMAP_TIME:
+      return read_cycle_counter();
+#ifdef RT_ENABLE_STATS
+    case HEATMAP_BVH:
+      return tls_stats_counters[STATS_BVH_NODES_VISITED];
+    case HEATMAP_PRIMS:
+      return tls_stats_counters[STATS_SPHERE_TESTS] +
+             tls_stats_counters[STATS_RECT_TESTS] +
+             tls_stats_counters[STATS_MEDIUM_TESTS];
+#endif
+    default:
+      return 0;
+  }
+}
+
+/**
+ * e.g. 1.png -> 1_heat_time.tga
+ */
+std::string heatmap_path(Option const &option)
+{
+  std::string_view path(option.path);
+  auto dot_pos = path.rfind('.');
+  auto slash_pos = path.rfind('/');
+  if (dot_pos != path.npos && (slash_pos == path.npos || dot_pos > slash_pos)) {
+    path = path.substr(0, dot_pos);
+  }
+
+  static char const *const mode_names[] = {"", "time", "bvh", "prims"};
+  std::string ret(path);
+  ret += "_heat_";
+  ret += mode_names[option.heatmap];
+  ret += ".tga";
+  return ret;
+}
+
+/**
+ * Create the writer that writes the tiles to disk once they are rendered.
+ * \return
+ *  nullptr -- The image is written after rendering
+ */
+std::unique_ptr<ImageStreamWriter>
+make_stream_writer(Option const &option, int width, int height)
+{
+  std::string_view path_view(option.path);
+  if (path_view.ends_with(".tif") || path_view.ends_with(".tiff")) {
+    // TIFF is always tiled
+    auto writer = std::make_unique<TiffTileWriter>(
+        width, height, option.stream_tile > 0 ? option.stream_tile : 64);
+    if (!writer->Open(option.path)) return nullptr;
+    return writer;
+  }
+
+  if (option.stream_tile <= 0) return nullptr;
+
+  if (path_view.ends_with(".tga")) {
+    auto writer = std::make_unique<TgaStreamWriter>(
+        width, height, option.stream_tile, TgaImage::RGB, option.rle);
+    if (!writer->Open(option.path)) return nullptr;
+    return writer;
+  }
+
+  fprintf(stderr, "Only *.tga/*.tif can be written in stream, "
+                  "the image will be written after rendering\n");
+  return nullptr;
+}
 
-img::Color compute_color(Vec3F const &c, int sample_per_pixel,
-                         double gamma_exp);
+std::vector<ImageTile> split_image_blocks(int width, int height,
+                                          int block_height)
+{
+  std::vector<ImageTile> blocks;
+  for (int y = 0; y < height; y += block_height) {
+    blocks.push_back({0, y, width, std::min(block_height, height - y)});
+  }
+  return blocks;
+}
 
 #if USE_STB_IMAGE_WRITE
 bool write_tga_by_stb(TgaImage const& image, char const *path)
@@ -77,124 +168,218 @@ int main(int argc, char *argv[])
 
   double gamma_exp = 1. / option.gamma;
 
-  // Setup camera
-  double aspect_ratio = 16. / 9.;
-
-  // Setup Scene
-  ShapeList world;
+  // The scene may be generated randomly(e.g. random spheres)
+  if (option.seed != 0) {
+    seed_random(option.seed);
+  }
 
-  rt::Color background(0, 0, 0);
-  Point3F lookfrom(0, 0, 0);
-  Point3F lookat(0, 0, -1);
-  double fov = 90;
-  ShapeSPtr lights = nullptr;
-  
   // Setup Scene
-  switch (option.scene_id) {
-    case 0: {
-      setup_scene(world);
-    } break;
-    case 1: {
-      background = rt::Color(0.8, 0.4, 0.3);
-      lookfrom = Point3F(13., 2., 3.);
-      // Point3F lookfrom(0, 0, 0);
-      lookat = Point3F(0, 0, 0);
-      // auto focus_dist = (lookat-lookfrom).length();
-      fov = 30;
-      setup_random_scene(world);
-    } break;
-
-    case 2: {
-      background = rt::Color(0, 0, 0);
-      lookfrom = Point3F(26, 3, 6);
-      lookat = Point3F(0, 2, 0);
-      fov = 20;
-      setup_light_scene(world);
-    } break;
-
-    case 3: {
-      background = rt::Color(1, 1, 1);
-      lookfrom = Point3F(13, 2, 3);
-      lookat = Point3F(0, 0, 0);
-      fov = 20;
-      setup_image_scene(world);
-    } break;
-
-    default:
-    case 4: {
-      // background = rt::Color(1, 1, 1);
-      aspect_ratio = 1;
-      lookfrom = Point3F(0, 278, 800);
-      lookat = Point3F(0, 278, 0);
-      fov = 40;
-      setup_cornellbox(world, lights);
-    } break;
-
-    case 5: {
-      aspect_ratio = 1.0 / 1.0;
-      lookfrom = Point3F(278, 278, -800);
-      lookat = Point3F(278, 278, 0);
-      fov = 40;
-      setup_cornellbox2(world, lights);
-      // background = { 187 / 255., 1, 1 };
-    } break;
+  Scene scene;
+  scene.light_strategy = option.light_sampler == LIGHT_SAMPLER_BVH
+                            ? LightSampler::LIGHT_BVH
+                            : LightSampler::POWER;
+  if (option.texture_cache_mb > 0) {
+    scene.texture_cache = std::make_shared<TextureCache>(
+      (size_t)option.texture_cache_mb << 20);
+  }
+  setup_builtin_scene(option.scene_id, scene);
+  printf("materials = %zu, textures = %zu, reused = %zu\n",
+         scene.resources->material_count(), scene.resources->texture_count(),
+         scene.resources->reused());
+  if (auto arena = scene.resources->arena()) {
+    arena->stats().Print(stdout);
   }
+  if (option.frame_end > 0) {
+    return render_sequence(option, scene);
+  }
+  const double aspect_ratio = scene.aspect_ratio;
 
-  Camera camera(lookfrom, lookat, aspect_ratio, fov, 1);
+  Camera camera(scene.lookfrom, scene.lookat, aspect_ratio, scene.fov, 1);
   camera.set_aperture(0.0);
+  camera.set_shutter(scene.time0, scene.time1);
   camera.DebugPrint();
 
   // Setup image
   int image_width = aspect_ratio * option.image_height;
-  TgaImage image(image_width, option.image_height);
-  
-  // Setup thread and slice
+  int image_height = option.image_height;
+  scene.pixel_spread_angle = camera.pixel_spread_angle(image_height);
+  const bool hdr_output = is_hdr_path(option.path);
+  auto stream_writer = hdr_output
+                           ? nullptr
+                           : make_stream_writer(option, image_width, image_height);
+
+  // The whole image is needed only if it is written after rendering
+  TgaImage image;
+  HdrImage hdr_image;
+  if (hdr_output) {
+    // Only EXR can hold the auxiliary channels
+    hdr_image = make_hdr_image(option.path, image_width, image_height);
+  } else if (!stream_writer) {
+    image = TgaImage(image_width, image_height);
+  }
+
+  Heatmap heatmap;
+  if (option.heatmap != HEATMAP_NONE) {
+    if (option.heatmap != HEATMAP_TIME && !stats_enabled()) {
+      fprintf(stderr, "The bvh/prims heatmap requires RT_ENABLE_STATS=ON\n");
+      return EXIT_FAILURE;
+    }
+    heatmap = Heatmap(image_width, image_height);
+  }
+
+  // Setup thread and blocks
+  // The blocks are dispatched dynamically, so the threads are balanced and
+  // the streamed blocks are completed in the order of writer approximately.
   std::vector<std::thread> thrs;
   thrs.reserve(option.thread_num);
 
-  int start = image.height() - 1;
-  int slice = (image.height() - 1) / option.thread_num;
-  printf("init start = %d\n", start);
-  printf("slice = %d\n", slice);
+  auto tiles = stream_writer ? stream_writer->SplitTiles()
+                             : split_image_blocks(image_width, image_height,
+                                                  RENDER_BLOCK_HEIGHT);
+  std::atomic<size_t> next_task(0);
+  std::atomic<bool> write_failed(false);
+  printf("tile number = %zu\n", tiles.size());
+
+  // Progressive rendering:
+  // Every tile is rendered in passes, and the samples of a pass are
+  // accumulated into the accumulation buffer and published to the preview.
+  // The tasks are ordered by pass, so the whole image is refined gradually.
+  std::unique_ptr<PreviewServer> preview;
+  const int pass_spp = option.preview_port > 0
+    ? (option.sample_per_pixel + PREVIEW_PASS_NUM - 1) / PREVIEW_PASS_NUM
+    : option.sample_per_pixel;
+  const int pass_num = (option.sample_per_pixel + pass_spp - 1) / pass_spp;
+  std::vector<PixelSamples> accumulation;
+  // The number of completed passes of every tile
+  std::unique_ptr<std::atomic<int>[]> tile_passes;
+  if (option.preview_port > 0) {
+    preview = std::make_unique<PreviewServer>(image_width, image_height);
+    if (!preview->Start(option.preview_port)) {
+      return EXIT_FAILURE;
+    }
+    preview->set_pass(0, pass_num);
+    accumulation.resize((size_t)image_width * image_height);
+    tile_passes = std::make_unique<std::atomic<int>[]>(tiles.size());
+    for (size_t i = 0; i < tiles.size(); ++i) {
+      tile_passes[i].store(0, std::memory_order_relaxed);
+    }
+  }
+  const size_t task_num = tiles.size() * pass_num;
+
+  // The scrambling of the samplers, the samples of a pixel depend only on
+  // the seed and the pixel
+  const uint64_t sampler_seed =
+    option.seed != 0 ? option.seed
+                     : ((uint64_t)std::random_device{}() << 32) |
+                         std::random_device{}();
 
   const size_t total_sample =
-    image.height() * image.width() * option.sample_per_pixel;
+    (size_t)image_height * image_width * option.sample_per_pixel;
   AtomicCounter64 current_complete_sample(0);
 
   auto start_of_render = ktm::steady_clock::now();
 
   for (int ti = 0; ti < option.thread_num; ++ti) {
-    int end = start - slice;
-    if (ti == option.thread_num - 1 && end != 0) {
-      end = 0;
-    }
-  
     // Setup main render loop
     thrs.emplace_back(std::thread(
-      [start, end, &option, gamma_exp, &background,
-      &world, &camera, &image,
-      &current_complete_sample, &lights]() {
-        for (int j = start; j >= end; --j) {
-          for (int i = 0; i < image.width(); ++i) {
-            // propertion
-            Vec3F color_prop(0, 0, 0);
-            for (int k = 0; k < option.sample_per_pixel; ++k) {
-              auto offset = double(k) / option.sample_per_pixel;
-              auto u = double(i + offset) / (image.width() - 1);
-              auto v = double(j + offset) / (image.height() - 1);
-
-              auto ray = camera.ray(u, v);
-              color_prop += ray_color(ray, background, world, lights, MAX_DEPTH);
-              current_complete_sample++;
+      [&tiles, &next_task, task_num, pass_spp, pass_num, &tile_passes,
+      &accumulation, &preview, &write_failed, &stream_writer, image_width,
+      image_height, hdr_output, &option, gamma_exp, &scene,
+      &camera, &image, &hdr_image, &heatmap, sampler_seed,
+      &current_complete_sample]() {
+        const int bpp = TgaImage::RGB;
+        auto sampler =
+          make_sampler(option.sampler, option.sample_per_pixel, sampler_seed);
+        set_thread_sampler(sampler.get());
+        std::vector<uint8_t> tile_buffer;
+
+        for (;;) {
+          auto task_index = next_task.fetch_add(1, std::memory_order_relaxed);
+          if (task_index >= task_num) break;
+          const auto tile_index = task_index % tiles.size();
+          const int pass = int(task_index / tiles.size());
+
+          // The random sequence of a task doesn't depend on which thread
+          // renders it, so the image is reproducible with the same seed
+          if (option.seed != 0) {
+            seed_random(mix_seed(option.seed, task_index));
+          }
+          auto const &tile = tiles[tile_index];
+          if (stream_writer) tile_buffer.resize((size_t)tile.w * tile.h * bpp);
+
+          // The previous pass of the tile may be still in progress
+          // if there are fewer tiles than threads
+          if (pass > 0) {
+            while (tile_passes[tile_index].load(std::memory_order_acquire) < pass) {
+              std::this_thread::yield();
+            }
+          }
+
+          const int sample_begin = pass * pass_spp;
+          const int sample_end =
+            std::min(option.sample_per_pixel, sample_begin + pass_spp);
+          const bool last_pass = sample_end == option.sample_per_pixel;
+
+          for (int j = tile.y; j < tile.y + tile.h; ++j) {
+            for (int i = tile.x; i < tile.x + tile.w; ++i) {
+              PixelSamples pixel;
+              if (pass > 0) pixel = accumulation[(size_t)j * image_width + i];
+
+              const auto cost_begin = read_pixel_cost(option.heatmap);
+              render_pixel(camera, scene, *sampler, i, j, image_width,
+                           image_height, sample_begin, sample_end, hdr_output,
+                           pixel);
+              current_complete_sample.Add((uint64_t)(sample_end - sample_begin));
+              if (option.heatmap != HEATMAP_NONE) {
+                heatmap.Add(i, j, read_pixel_cost(option.heatmap) - cost_begin);
+              }
+
+              if (preview) {
+                preview->Publish(i, j,
+                                 compute_color(pixel.color, sample_end, gamma_exp));
+                if (!last_pass) {
+                  accumulation[(size_t)j * image_width + i] = pixel;
+                  continue;
+                }
+              }
+
+              if (hdr_output) {
+                set_hdr_pixel(hdr_image, i, j, pixel, option.sample_per_pixel);
+                continue;
+              }
+
+              auto color =
+                compute_color(pixel.color, option.sample_per_pixel, gamma_exp);
+              if (stream_writer) {
+                auto offset = ((j - tile.y) * tile.w + (i - tile.x)) * bpp;
+                memcpy(&tile_buffer[offset], color.data(), bpp);
+              } else {
+#if USE_STB_IMAGE_WRITE
+                // stb requires RGB order
+                std::swap(color.r, color.b);
+#endif
+                image.SetPixel(i, j, color);
+              }
             }
-            auto color =
-              compute_color(color_prop, option.sample_per_pixel, gamma_exp);
-            image.SetPixel(i, j, color);
+          }
+
+          if (preview) {
+            tile_passes[tile_index].store(pass + 1, std::memory_order_release);
+            if (tile_index + 1 == tiles.size()) preview->set_pass(pass + 1, pass_num);
+          }
+
+          if (stream_writer && last_pass &&
+              !stream_writer->WriteTile(tile.x, tile.y, tile.w, tile.h,
+                                        tile_buffer.data()))
+          {
+            write_failed.store(true, std::memory_order_relaxed);
           }
         }
-      }));
 
-    start -= slice + 1;
+        set_thread_sampler(nullptr);
+        stats_flush();
+        if (scene.texture_cache) scene.texture_cache->flush_thread_stats();
+      }));
   }
   
   // Set and Update progress bar indicator
@@ -214,115 +399,74 @@ int main(int argc, char *argv[])
   ktm::duration<double> cost_time_of_render = end_of_render - start_of_render;
   printf("\nThe consume time of render is %.3lf sec\n",
     cost_time_of_render.count());
+
+  if (scene.texture_cache) {
+    scene.texture_cache->stats().Print(stdout);
+  }
+
+  if (stats_enabled()) {
+    auto stats = stats_collect();
+    stats.Print(stdout, cost_time_of_render.count());
+    if (option.stats_path &&
+        !stats.WriteJson(option.stats_path, cost_time_of_render.count())) {
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (option.heatmap != HEATMAP_NONE &&
+      !heatmap.WriteTo(heatmap_path(option).c_str())) {
+    return EXIT_FAILURE;
+  }
   fflush(stdout);
+
+  if (stream_writer) {
+    if (write_failed.load() || !stream_writer->Close()) {
+      return EXIT_FAILURE;
+    }
+    printf("The peak bytes of pending tiles is %zu\n",
+           stream_writer->peak_pending_bytes());
+    return EXIT_SUCCESS;
+  }
+
+  if (hdr_output) {
+    return hdr_image.WriteTo(option.path, option.rle) ? EXIT_SUCCESS
+                                                      : EXIT_FAILURE;
+  }
   
-#if USE_STB_IMAGE_WRITE
+  auto start_of_encode = ktm::steady_clock::now();
   std::string_view path_view(option.path);
+#if USE_STB_IMAGE_WRITE
   if (path_view.ends_with(".png")) {
-    if (write_png_by_stb(image, option.path)) {
+    if (!write_png_by_stb(image, option.path)) {
       return EXIT_FAILURE;
     }
   }
   else if (path_view.ends_with(".tga")) {
-    if (write_tga_by_stb(image, option.path)) {
+    if (!write_tga_by_stb(image, option.path)) {
       return EXIT_FAILURE;
     }
   }
-  else {
-    fprintf(stderr, "The valid image format is *.png/*.tga");
-    return EXIT_FAILURE;
-  }
-#else
-  if (!image.WriteTo(option.path)) {
-    return EXIT_FAILURE;
-  }
-#endif
-  return EXIT_SUCCESS;
-}
-
-double RR_probability = 0.9999;
-
-#define RR_COLOR(c) (c) / RR_probability
-
-rt::Color ray_color(Ray const &ray, rt::Color const &background, Shape const &world,
-                ShapeSPtr const &lights, int max_depth)
-{
-  static std::random_device rd;
-  static std::mt19937 gen(rd());
-  static std::uniform_real_distribution<> urd(0., 1.);
-  
-#if 0
-  RR_probability = 1.;
-  if (max_depth <= 0) return {0, 0, 0};
 #else
-  if (urd(gen) > RR_probability || max_depth <= 0) return {0, 0, 0};
-#endif
-
-  HitRecord record;
-  if (!world.hit(ray, 0.001, inf, record)) {
-    return RR_COLOR(background);
-  }
-
-  ScatterRecord scatter_rec;
-  auto emitted = record.material->emitted(record, record.u, record.v, record.p);
-
-  if (!record.material->scatter(ray, record, scatter_rec)) {
-    return RR_COLOR(emitted);
+  if (path_view.ends_with(".png")) {
+    if (!PngEncoder(option.thread_num).WriteTo(image, option.path)) {
+      return EXIT_FAILURE;
+    }
   }
-
-  if (scatter_rec.is_specular) {
-    return RR_COLOR(scatter_rec.attenuation *
-           ray_color(scatter_rec.specular_ray, background, world, lights,
-                     max_depth - 1));
+  else if (path_view.ends_with(".tga")) {
+    if (!image.WriteTo(option.path, option.rle, TgaImage::BOTTOM_LEFT,
+                       option.thread_num)) {
+      return EXIT_FAILURE;
+    }
   }
-  ShapePdf light_pdf(lights.get(), record.p);
-  MixturePdf mixture_pdf(scatter_rec.pdf.get(), &light_pdf);
-  Pdf *used_pdf = nullptr;
-#define PDF_TEST 3
-#if PDF_TEST == 1
-  used_pdf = scatter_rec.pdf.get();
-#elif PDF_TEST == 2
-  used_pdf = &light_pdf;
-#elif PDF_TEST == 3
-  used_pdf = &mixture_pdf;
-#else
-  used_pdf = scatter_rec.pdf.get();
 #endif
-  Ray out_ray(record.p, used_pdf->generate());
-
-  double pdf_value = used_pdf->value(out_ray.direction());
-  if (pdf_value < epsilon) return RR_COLOR(emitted);
-  const auto cosine_theta_i =
-      std::max(dot(out_ray.direction().normalize(), record.normal), 0.);
-  return RR_COLOR((scatter_rec.attenuation / pi) *
-              ray_color(out_ray, background, world, lights, max_depth - 1) *
-              cosine_theta_i / pdf_value +
-          emitted);
-}
+  else {
+    fprintf(stderr, "The valid image format is *.png/*.tga/*.tif/*.hdr/*.pfm/*.exr");
+    return EXIT_FAILURE;
+  }
 
-img::Color compute_color(Vec3F const &c, int sample_per_pixel, double gamma_exp)
-{
-  auto scale = 1. / sample_per_pixel;
-  auto rgb = c * scale;
-  if (isnan(rgb.x)) rgb.x = 0;
-  if (isnan(rgb.y)) rgb.y = 0;
-  if (isnan(rgb.z)) rgb.z = 0;
-
-  rgb.x = std::pow(rgb.x, gamma_exp);
-  rgb.y = std::pow(rgb.y, gamma_exp);
-  rgb.z = std::pow(rgb.z, gamma_exp);
-
-  /*
-   * 由于light的强度不限制于[0, 1]，因此rgb的比例可能大于1
-   * 对于这种情况，当作1处理
-   * 使用clamp()约束
-   */
-  img::Color color(int(256 * clamp(rgb.x, 0, 0.99999)),
-                   int(256 * clamp(rgb.y, 0, 0.99999)),
-                   int(256 * clamp(rgb.z, 0, 0.99999)));
-#if USE_STB_IMAGE_WRITE
-  std::swap(color.r, color.b);
-#endif
-  return color;
+  ktm::duration<double> cost_time_of_encode =
+      ktm::steady_clock::now() - start_of_encode;
+  printf("The consume time of encode is %.3lf sec\n",
+    cost_time_of_encode.count());
+  return EXIT_SUCCESS;
 }
-
@@ -8,14 +8,10 @@ namespace rt {
 class Dielectric : public Material {
  public:
   explicit Dielectric(double ratio_of_refraction)
-    : rr_(ratio_of_refraction)
   {
+    record_.type = MATERIAL_DIELECTRIC;
+    record_.param = ratio_of_refraction;
   }
-
-  bool scatter(const Ray &in_ray, const HitRecord &record, ScatterRecord &srec) const override;
-
- private:
-  double rr_;
 };
 
 } // namespace rt
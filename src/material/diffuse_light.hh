@@ -16,22 +16,16 @@ namespace rt {
 class DiffuseLight : public Material {
  public:
   explicit DiffuseLight(TextureSPtr emit)
-    : emit_(emit)
   {
+    record_.type = MATERIAL_DIFFUSE_LIGHT;
+    set_texture(std::move(emit));
   }
 
-  explicit DiffuseLight(Color const &emit);
-
-  bool scatter(Ray const &in_ray, HitRecord const &record, ScatterRecord &srec) const override
+  explicit DiffuseLight(Color const &emit)
   {
-    return false;
+    record_.type = MATERIAL_DIFFUSE_LIGHT;
+    record_.color = emit;
   }
-  
-  Color emitted(HitRecord const &rec, double u, double v, Point3F const &p) const override;
-
-  virtual bool is_emissive() const override { return true; }
- private:
-  TextureSPtr emit_;
 };
 
 } // namespace rt
@@ -9,17 +9,16 @@ namespace rt {
 class Iostropic : public Material {
  public:
   explicit Iostropic(TextureSPtr albedo)
-    : albedo_(std::move(albedo))
   {
+    record_.type = MATERIAL_ISOTROPIC;
+    set_texture(std::move(albedo));
   }
 
-  explicit Iostropic(Color c);
-
-  virtual bool scatter(Ray const &ray, HitRecord const &record,
-                       ScatterRecord &srec) const override;
-
- private:
-  TextureSPtr albedo_;
+  explicit Iostropic(Color c)
+  {
+    record_.type = MATERIAL_ISOTROPIC;
+    record_.color = c;
+  }
 };
 
 } // namespace rt
@@ -10,17 +10,17 @@ namespace rt {
 
 class Lambertian : public Material {
  public:
-  explicit Lambertian(Color const &albedo);
-  explicit Lambertian(TextureSPtr const &texture)
-    : albedo_(texture)
+  explicit Lambertian(Color const &albedo)
   {
+    record_.type = MATERIAL_LAMBERTIAN;
+    record_.color = albedo;
   }
 
-  bool scatter(Ray const &in_ray, HitRecord const &record,
-               ScatterRecord &srec) const override;
-
- private:
-  TextureSPtr albedo_;
+  explicit Lambertian(TextureSPtr const &texture)
+  {
+    record_.type = MATERIAL_LAMBERTIAN;
+    set_texture(texture);
+  }
 };
 
 } // namespace rt
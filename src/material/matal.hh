@@ -8,15 +8,11 @@ namespace rt {
 class Matal : public Material {
  public:
   explicit Matal(Color const &albedo, double fuzzy)
-    : albedo_(albedo)
-    , fuzzy_(fuzzy < 1 ? fuzzy : 1)
   {
+    record_.type = MATERIAL_METAL;
+    record_.color = albedo;
+    record_.param = fuzzy < 1 ? fuzzy : 1;
   }
-
-  virtual bool scatter(const Ray &in_ray, const HitRecord &record, ScatterRecord &srec) const override;
- private:
-  Color albedo_;
-  double fuzzy_;
 };
 
 } // namespace rt
@@ -0,0 +1,203 @@
+#include "material.hh"
+
+#include <atomic>
+
+#include "../gm/fast_math.hh"
+#include "../gm/util.hh"
+#include "../rt/hit_record.hh"
+#include "../rt/scatter_record.hh"
+#include "../sample/sampler.hh"
+#include "../texture/solid_texture.hh"
+#include "util.hh"
+
+using namespace rt;
+using namespace gm;
+
+static std::atomic<uint32_t> s_material_id{0};
+
+Material::Material() noexcept
+{
+  record_.id = s_material_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Material::set_texture(TextureSPtr texture)
+{
+  if (auto solid = dynamic_cast<SolidTexture const *>(texture.get())) {
+    record_.color = solid->color();
+    record_.texture = nullptr;
+    texture_ = nullptr;
+    return;
+  }
+  texture_ = std::move(texture);
+  record_.texture = texture_.get();
+}
+
+/*--------------------------------------------------*/
+/* Builtin materials                                */
+/*--------------------------------------------------*/
+
+/**
+ * The texture is only looked up(and the UV computed) if it is not solid,
+ * it is filtered over the footprint of ray cone
+ */
+static inline Color texture_value(MaterialRecord const &mat,
+                                  HitRecord const &record) noexcept
+{
+  if (!mat.texture) return mat.color;
+  double u, v;
+  record.get_uv(u, v);
+  return mat.texture->filtered_value(u, v, record.p,
+                                    record.footprint * record.uv_scale);
+}
+
+static inline bool lambertian_scatter(MaterialRecord const &mat,
+                                      HitRecord const &record,
+                                      ScatterRecord &srec)
+{
+  srec.is_specular = false;
+  srec.attenuation = texture_value(mat, record);
+  srec.pdf = &srec.cosine_pdf.emplace(record.normal);
+  return true;
+}
+
+static inline bool metal_scatter(MaterialRecord const &mat, Ray const &in_ray,
+                                 HitRecord const &record, ScatterRecord &srec)
+{
+  auto reflect_light = reflect(in_ray.direction(), record.normal);
+  // 如果dot() <
+  // 0，表示出射光射向了表面，这是由于模糊参数(fuzzy)过大导致的，故舍弃该光线（过于模糊不遵循镜面反射规则）
+  srec.is_specular = true;
+  srec.attenuation = mat.color;
+  srec.specular_ray =
+      Ray(record.p, reflect_light + mat.param * gm::random_in_unit_sphere(),
+          in_ray.time());
+  srec.pdf = nullptr;
+  return dot(srec.specular_ray.direction(), record.normal);
+}
+
+static inline double schelink_reflectance(double cosine, double refract_ratio)
+{
+  auto r0 = (1 - refract_ratio) / (1 + refract_ratio);
+  r0 *= r0;
+  return r0 + (1 - r0) * pow5(1 - cosine);
+}
+
+static inline bool dielectric_scatter(MaterialRecord const &mat,
+                                      Ray const &in_ray,
+                                      HitRecord const &record,
+                                      ScatterRecord &srec)
+{
+  // 针对表面法向量n，取外侧（法向量相对侧)/内侧(法向量这一侧)的折射率作为构造参数表示折射率比值
+  // 如果交点角度来看，法向量朝内，说明折射率是内侧/外侧，需要取倒数
+  // 而法向量朝外，内外侧反转，说明折射率就是原来的外侧/原来的内侧，不需要取倒数
+  double refract_ratio = record.front_face ? (1.0 / mat.param) : mat.param;
+
+  auto unit_direciton = in_ray.direction().normalize();
+  double cos_theta = fmin(dot(-unit_direciton, record.normal), 1.0);
+
+  bool cannot_refract = refract_ratio * gm::sin_from_cos(cos_theta) > 1.0;
+
+  Vec3F out_ray_direction;
+  if (cannot_refract ||
+      schelink_reflectance(cos_theta, refract_ratio) > sample_1d())
+    out_ray_direction = reflect(unit_direciton, record.normal);
+  else
+    out_ray_direction = refract(unit_direciton, record.normal, refract_ratio);
+
+  srec.attenuation = rt::Color(1.0, 1.0, 1.0);
+  srec.specular_ray = Ray(record.p, out_ray_direction, in_ray.time());
+  srec.is_specular = true;
+  srec.pdf = nullptr;
+  return true;
+}
+
+static inline bool isotropic_scatter(MaterialRecord const &mat,
+                                     Ray const &in_ray,
+                                     HitRecord const &record,
+                                     ScatterRecord &srec)
+{
+  // Not specular, the lights are sampled in the medium too
+  srec.is_specular = false;
+  srec.is_phase = true;
+  srec.attenuation = texture_value(mat, record);
+  srec.pdf = &srec.isotropic_pdf.emplace();
+  return true;
+}
+
+static bool builtin_scatter(MaterialRecord const &mat, Ray const &in_ray,
+                            HitRecord const &record, ScatterRecord &srec)
+{
+  switch (mat.type) {
+    case MATERIAL_LAMBERTIAN:
+      return lambertian_scatter(mat, record, srec);
+    case MATERIAL_METAL:
+      return metal_scatter(mat, in_ray, record, srec);
+    case MATERIAL_DIELECTRIC:
+      return dielectric_scatter(mat, in_ray, record, srec);
+    case MATERIAL_ISOTROPIC:
+      return isotropic_scatter(mat, in_ray, record, srec);
+    case MATERIAL_DIFFUSE_LIGHT:
+    case MATERIAL_CUSTOM:
+      return false;
+  }
+  return false;
+}
+
+static Color builtin_emitted(MaterialRecord const &mat,
+                             HitRecord const &record) noexcept
+{
+  // 只有正面发光
+  if (mat.type != MATERIAL_DIFFUSE_LIGHT || !record.front_face)
+    return {0, 0, 0};
+  return texture_value(mat, record);
+}
+
+/*--------------------------------------------------*/
+/* Material                                         */
+/*--------------------------------------------------*/
+
+bool Material::scatter(Ray const &in_ray, HitRecord const &record,
+                       ScatterRecord &srec) const
+{
+  return builtin_scatter(record_, in_ray, record, srec);
+}
+
+Color Material::emitted(HitRecord const &rec, double u, double v,
+                        Point3F const &p) const
+{
+  if (record_.type != MATERIAL_DIFFUSE_LIGHT || !rec.front_face)
+    return {0, 0, 0};
+  return record_.texture ? record_.texture->value(u, v, p) : record_.color;
+}
+
+Color Material::average_emitted() const
+{
+  if (record_.type != MATERIAL_DIFFUSE_LIGHT) return {0, 0, 0};
+  // Exact for the solid texture
+  return record_.texture ? record_.texture->value(0.5, 0.5, Point3F(0, 0, 0))
+                         : record_.color;
+}
+
+namespace rt {
+
+bool material_scatter(Material const &material, Ray const &in_ray,
+                      HitRecord const &record, ScatterRecord &srec)
+{
+  auto const &mat = material.record();
+  if (mat.type == MATERIAL_CUSTOM)
+    return material.scatter(in_ray, record, srec);
+  return builtin_scatter(mat, in_ray, record, srec);
+}
+
+Color material_emitted(Material const &material, HitRecord const &record)
+{
+  auto const &mat = material.record();
+  if (mat.type == MATERIAL_CUSTOM) {
+    double u, v;
+    record.get_uv(u, v);
+    return material.emitted(record, u, v, record.p);
+  }
+  return builtin_emitted(mat, record);
+}
+
+} // namespace rt
@@ -4,7 +4,9 @@
 #include "../rt/color.hh"
 #include "../gm/point.hh"
 
+#include "material_record.hh"
 #include "type.hh"
+#include "../texture/texture.hh"
 
 namespace rt {
 
@@ -12,18 +14,70 @@ class Ray;
 struct HitRecord;
 struct ScatterRecord;
 
+/**
+ * The builtin materials only fill the record_ in their constructors, the
+ * shading(material_scatter() and material_emitted()) switches on its type.
+ * The materials defined outside override the virtual functions, their type
+ * is MATERIAL_CUSTOM.
+ */
 class Material
 {
  public:
-  virtual bool scatter(Ray const &in_ray, HitRecord const &record, ScatterRecord &sca_rec) const = 0;
-  virtual Color emitted(HitRecord const &rec, double u, double v, Point3F const &p) const
-  {
-    return { 0, 0, 0 };
-  }
+  Material() noexcept;
+  virtual ~Material() = default;
 
-  virtual bool is_emissive() const { return false; }
+  /**
+   * The default implementation shades the builtin material of record_
+   */
+  virtual bool scatter(Ray const &in_ray, HitRecord const &record, ScatterRecord &sca_rec) const;
+  virtual Color emitted(HitRecord const &rec, double u, double v, Point3F const &p) const;
+
+  virtual bool is_emissive() const { return record_.type == MATERIAL_DIFFUSE_LIGHT; }
+
+  /**
+   * The light passes through it(e.g. glass), the shapes made of it are
+   * sampled by the diffuse surfaces to find the caustics
+   */
+  virtual bool is_transmissive() const { return record_.type == MATERIAL_DIELECTRIC; }
+
+  /**
+   * The average emitted radiance, used to estimate the power of emitters
+   */
+  virtual Color average_emitted() const;
+
+  MaterialRecord const &record() const noexcept { return record_; }
+  uint32_t id() const noexcept { return record_.id; }
+
+ protected:
+  /**
+   * The solid texture is flattened into the record_.color
+   */
+  void set_texture(TextureSPtr texture);
+
+  MaterialRecord record_;
+  // The owner of record_.texture
+  TextureSPtr texture_;
 };
 
+/**
+ * Shade without virtual dispatch unless the material is MATERIAL_CUSTOM
+ * \return false if the ray is absorbed
+ */
+bool material_scatter(Material const &material, Ray const &in_ray,
+                      HitRecord const &record, ScatterRecord &srec);
+
+/**
+ * The emitted radiance at the hit, the UV is computed only if it is used
+ */
+Color material_emitted(Material const &material, HitRecord const &record);
+
+inline bool material_is_emissive(Material const &material)
+{
+  auto const type = material.record().type;
+  return type == MATERIAL_CUSTOM ? material.is_emissive()
+                                 : type == MATERIAL_DIFFUSE_LIGHT;
+}
+
 } // namespace rt
 
 #endif
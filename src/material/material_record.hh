@@ -0,0 +1,48 @@
+#ifndef MATERIAL_MATERIAL_RECORD_HH__
+#define MATERIAL_MATERIAL_RECORD_HH__
+
+#include <stdint.h>
+
+#include "../rt/color.hh"
+
+namespace rt {
+
+class Texture;
+
+/**
+ * The builtin materials, the shading switches on it instead of calling the
+ * virtual functions
+ */
+enum MaterialType : uint8_t {
+  MATERIAL_LAMBERTIAN,
+  MATERIAL_METAL,
+  MATERIAL_DIELECTRIC,
+  MATERIAL_DIFFUSE_LIGHT,
+  MATERIAL_ISOTROPIC,
+  // Derived from Material outside, the virtual functions are called
+  MATERIAL_CUSTOM,
+};
+
+/**
+ * The plain data of a material: type tag and parameters
+ *
+ * It is embedded in the Material, so the shading reaches the parameters
+ * through the Material pointer of HitRecord directly.
+ */
+struct MaterialRecord {
+  MaterialType type = MATERIAL_CUSTOM;
+  // Unique among the materials of the process,
+  // e.g. the key to sort the hits by material
+  uint32_t id = 0;
+  // The albedo(or emission) if texture is null
+  Color color{0, 0, 0};
+  // Null if the texture is solid(the color is used), not owned
+  Texture const *texture = nullptr;
+  // Metal: fuzz
+  // Dielectric: index of refraction
+  double param = 0;
+};
+
+} // namespace rt
+
+#endif
@@ -2,6 +2,7 @@
 
 #include <cstdio>
 #include <cstring>
+#include <string>
 #include <string_view>
 
 #include "util/str_cvt.hh"
@@ -17,6 +18,16 @@ void Option::DebugPrint() const
   printf("image_height = %d\n", image_height);
   printf("gamma = %d\n", gamma);
   printf("scene = %d\n", scene_id);
+  printf("stream_tile = %d\n", stream_tile);
+  printf("rle = %d\n", rle ? 1 : 0);
+  printf("preview_port = %d\n", preview_port);
+  printf("stats_path = %s\n", stats_path ? stats_path : "");
+  printf("heatmap = %d\n", (int)heatmap);
+  printf("seed = %llu\n", (unsigned long long)seed);
+  printf("light_sampler = %d\n", (int)light_sampler);
+  printf("sampler = %d\n", (int)sampler);
+  printf("texture_cache_mb = %d\n", texture_cache_mb);
+  printf("frames = [%d, %d)\n", frame_begin, frame_end);
 }
 
 #define PROGRAM_USAGE                                                          \
@@ -25,7 +36,17 @@ void Option::DebugPrint() const
   "[--threads/-t integer] "                                                    \
   "[--gamma/-g integer] "                                                      \
   "[--height/-h integer] "                                                     \
-  "[--scene/-s integer]\n",                                                    \
+  "[--scene/-s integer] "                                                      \
+  "[--stream/-S integer] "                                                     \
+  "[--rle/-r 0/1] "                                                            \
+  "[--preview/-P port] "                                                       \
+  "[--stats/-T json path] "                                                    \
+  "[--heatmap/-H time/bvh/prims] "                                             \
+  "[--seed/-R integer] "                                                       \
+  "[--light_sampler/-L power/bvh] "                                            \
+  "[--sampler/-Q independent/stratified/sobol/bluenoise] "                     \
+  "[--texture_cache/-C MB] "                                                   \
+  "[--frames/-F end or begin:end]\n",                                          \
       argv[0]
 
 inline bool check_option(std::string_view opt, char const *lopt,
@@ -97,6 +118,101 @@ bool parse_options(int argc, char *argv[], Option *option)
         return false;
       }
       option->scene_id = *ret;
+    } else if (check_option(opt, "--stream", "-S")) {
+      auto ret = util::str2int(arg);
+      if (!ret || *ret < 0) {
+        fprintf(stderr, "The argument of --stream/-S is invalid\n");
+        return false;
+      }
+      option->stream_tile = *ret;
+    } else if (check_option(opt, "--rle", "-r")) {
+      auto ret = util::str2int(arg);
+      if (!ret) {
+        fprintf(stderr, "The argument of --rle/-r is invalid\n");
+        return false;
+      }
+      option->rle = *ret != 0;
+    } else if (check_option(opt, "--preview", "-P")) {
+      auto ret = util::str2int(arg);
+      if (!ret || *ret < 0 || *ret > 65535) {
+        fprintf(stderr, "The argument of --preview/-P is invalid\n");
+        return false;
+      }
+      option->preview_port = *ret;
+    } else if (check_option(opt, "--stats", "-T")) {
+      if (*arg == '\0') {
+        fprintf(stderr, "The argument of --stats/-T is invalid\n");
+        return false;
+      }
+      option->stats_path = arg;
+    } else if (check_option(opt, "--heatmap", "-H")) {
+      std::string_view mode(arg);
+      if (mode == "time") {
+        option->heatmap = HEATMAP_TIME;
+      } else if (mode == "bvh") {
+        option->heatmap = HEATMAP_BVH;
+      } else if (mode == "prims") {
+        option->heatmap = HEATMAP_PRIMS;
+      } else {
+        fprintf(stderr, "The argument of --heatmap/-H is invalid\n");
+        return false;
+      }
+    } else if (check_option(opt, "--seed", "-R")) {
+      auto ret = util::str2int(arg);
+      if (!ret || *ret < 0) {
+        fprintf(stderr, "The argument of --seed/-R is invalid\n");
+        return false;
+      }
+      option->seed = (uint64_t)*ret;
+    } else if (check_option(opt, "--light_sampler", "-L")) {
+      std::string_view mode(arg);
+      if (mode == "power") {
+        option->light_sampler = LIGHT_SAMPLER_POWER;
+      } else if (mode == "bvh") {
+        option->light_sampler = LIGHT_SAMPLER_BVH;
+      } else {
+        fprintf(stderr, "The argument of --light_sampler/-L is invalid\n");
+        return false;
+      }
+    } else if (check_option(opt, "--sampler", "-Q")) {
+      std::string_view type(arg);
+      if (type == "independent") {
+        option->sampler = SAMPLER_INDEPENDENT;
+      } else if (type == "stratified") {
+        option->sampler = SAMPLER_STRATIFIED;
+      } else if (type == "sobol") {
+        option->sampler = SAMPLER_SOBOL;
+      } else if (type == "bluenoise") {
+        option->sampler = SAMPLER_BLUE_NOISE;
+      } else {
+        fprintf(stderr, "The argument of --sampler/-Q is invalid\n");
+        return false;
+      }
+    } else if (check_option(opt, "--texture_cache", "-C")) {
+      auto ret = util::str2int(arg);
+      if (!ret || *ret < 0) {
+        fprintf(stderr, "The argument of --texture_cache/-C is invalid\n");
+        return false;
+      }
+      option->texture_cache_mb = *ret;
+    } else if (check_option(opt, "--frames", "-F")) {
+      std::string range(arg);
+      auto colon_pos = range.find(':');
+      std::optional<int> begin = 0;
+      std::optional<int> end;
+      if (colon_pos == range.npos) {
+        end = util::str2int(range.c_str());
+      } else {
+        range[colon_pos] = '\0';
+        begin = util::str2int(range.c_str());
+        end = util::str2int(range.c_str() + colon_pos + 1);
+      }
+      if (!begin || !end || *begin < 0 || *end <= *begin) {
+        fprintf(stderr, "The argument of --frames/-F is invalid\n");
+        return false;
+      }
+      option->frame_begin = *begin;
+      option->frame_end = *end;
     } else {
       fprintf(stderr, "Unknown option: %s\n", *argv);
       return false;
@@ -1,8 +1,24 @@
 #ifndef RT_OPTION_HH__
 #define RT_OPTION_HH__
 
+#include <stdint.h>
+
+#include "sample/sampler.hh"
+
 namespace rt {
 
+enum HeatmapMode {
+  HEATMAP_NONE = 0,
+  HEATMAP_TIME,  // cycles
+  HEATMAP_BVH,   // BVH nodes visited
+  HEATMAP_PRIMS, // primitives tested
+};
+
+enum LightSamplerMode {
+  LIGHT_SAMPLER_POWER = 0, // proportional to the power
+  LIGHT_SAMPLER_BVH,       // light BVH(power, distance and orientation)
+};
+
 struct Option {
   char const *path = nullptr;
   int sample_per_pixel = 100;
@@ -10,6 +26,33 @@ struct Option {
   int gamma = 2;
   int image_height = 400;
   int scene_id = -1;
+  // The rows of block(*.tga) or the tile size(*.tif) written in stream
+  // 0 indicates the image is written after rendering
+  int stream_tile = 0;
+  // Run-length encoding(Only for the builtin TGA writer)
+  bool rle = false;
+  // The port of preview server(0 indicates no preview).
+  // The image is rendered in progressive passes if the preview is enabled.
+  int preview_port = 0;
+  // The path of render statistics in JSON(valid if RT_ENABLE_STATS is ON)
+  char const *stats_path = nullptr;
+  // Write the per-pixel cost in <path>_heat_<mode>.tga
+  HeatmapMode heatmap = HEATMAP_NONE;
+  // The seed of random generators, the image is reproducible with the same
+  // nonzero seed. 0 indicates the generators are seeded by random_device.
+  uint64_t seed = 0;
+  // The strategy of choosing a light for next event estimation
+  LightSamplerMode light_sampler = LIGHT_SAMPLER_POWER;
+  // The source of the random numbers of paths
+  SamplerType sampler = SAMPLER_SOBOL;
+  // The memory budget(MB) of the texture cache, the image textures are
+  // paged in from the tiled files. 0 indicates the images are loaded entirely.
+  int texture_cache_mb = 0;
+  // Render the frames [frame_begin, frame_end) of the builtin animation of
+  // the scene into the numbered images(e.g. out_%04d.png).
+  // 0 frame_end indicates a single image is rendered.
+  int frame_begin = 0;
+  int frame_end = 0;
   void DebugPrint() const;
 };
 
@@ -0,0 +1,66 @@
+#include "pixel_kernel.hh"
+
+#include <cmath>
+
+#include "rt/stats.hh"
+
+using namespace gm;
+using namespace img;
+
+namespace rt {
+
+void render_pixel(Camera const &camera, Scene const &scene, Sampler &sampler,
+                  int i, int j, int width, int height, int sample_begin,
+                  int sample_end, bool with_aux, PixelSamples &pixel)
+{
+  for (int k = sample_begin; k < sample_end; ++k) {
+    sampler.start_pixel_sample(i, j, k);
+    double dx, dy;
+    sampler.get_2d(dx, dy);
+    auto u = double(i + dx) / (width - 1);
+    auto v = double(j + dy) / (height - 1);
+
+    auto ray = camera.ray(u, v);
+    RT_STATS_INC(STATS_CAMERA_RAYS);
+    Vec3F sample;
+    if (with_aux) {
+      AuxSample aux;
+      sample = ray_color(ray, scene, MAX_DEPTH, &aux);
+      pixel.aux.albedo += aux.albedo;
+      pixel.aux.normal += aux.normal;
+      if (aux.depth < inf) {
+        pixel.aux.depth += aux.depth;
+        pixel.depth_num++;
+      }
+    } else {
+      sample = ray_color(ray, scene, MAX_DEPTH);
+    }
+    if (stats_enabled() && (std::isnan(sample.x) || std::isnan(sample.y) ||
+                            std::isnan(sample.z))) {
+      RT_STATS_INC(STATS_NAN_SAMPLES);
+    }
+    pixel.color += sample;
+  }
+}
+
+HdrImage make_hdr_image(std::string_view path, int width, int height)
+{
+  return HdrImage(width, height,
+                  path.ends_with(".exr") ? HdrImage::ALL_AUX
+                                         : HdrImage::NO_AUX);
+}
+
+void set_hdr_pixel(HdrImage &image, int i, int j, PixelSamples const &pixel,
+                   int sample_num)
+{
+  const double scale = 1. / sample_num;
+  image.SetPixel(i, j, resolve_radiance(pixel.color, sample_num));
+  image.SetAlbedo(i, j, pixel.aux.albedo * scale);
+  image.SetNormal(i, j, pixel.aux.normal * scale);
+  image.SetDepth(i, j,
+                 pixel.depth_num ? float(pixel.aux.depth / pixel.depth_num)
+                                 : INFINITY);
+  image.SetSampleCount(i, j, (uint32_t)sample_num);
+}
+
+} // namespace rt
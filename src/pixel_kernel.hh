@@ -0,0 +1,53 @@
+#ifndef RT_PIXEL_KERNEL_HH__
+#define RT_PIXEL_KERNEL_HH__
+
+#include <string_view>
+
+#include "rt/camera.hh"
+#include "rt/integrator.hh"
+#include "rt/scene.hh"
+#include "sample/sampler.hh"
+#include "img/hdr_image.hh"
+
+namespace rt {
+
+/**
+ * The samples of a pixel accumulated so far(e.g. by the previous passes of
+ * progressive rendering)
+ */
+struct PixelSamples {
+  gm::Vec3F color{0, 0, 0};
+  // The sums of the auxiliary channels, the depth is the sum of the finite
+  // ones
+  AuxSample aux{Color(0, 0, 0), gm::Vec3F(0, 0, 0), 0};
+  int depth_num = 0;
+};
+
+/**
+ * Trace the samples [sample_begin, sample_end) of the pixel(i, j) and
+ * accumulate them into the \p pixel, the NaN samples are counted in the
+ * stats.
+ * It is the kernel shared by the single image and the sequence.
+ *
+ * \param sampler The sampler of current thread
+ * \param with_aux Accumulate the auxiliary channels of the first hits
+ */
+void render_pixel(Camera const &camera, Scene const &scene, Sampler &sampler,
+                  int i, int j, int width, int height, int sample_begin,
+                  int sample_end, bool with_aux, PixelSamples &pixel);
+
+/**
+ * The HDR image of the \p path, only EXR holds the auxiliary channels
+ */
+img::HdrImage make_hdr_image(std::string_view path, int width, int height);
+
+/**
+ * Write the radiance and the auxiliary channels of the \p pixel of
+ * \p sample_num samples to the \p image
+ */
+void set_hdr_pixel(img::HdrImage &image, int i, int j,
+                   PixelSamples const &pixel, int sample_num);
+
+} // namespace rt
+
+#endif
@@ -0,0 +1,113 @@
+#include "animation.hh"
+
+#include <cmath>
+
+#include "../gm/util.hh"
+#include "../material/material.hh"
+
+using namespace rt;
+using namespace gm;
+
+// The max angle of the swinging camera of cornell boxes
+#define CORNELLBOX_SWING_DEGREE 20.
+// The height of the bouncing spheres of cornell boxes
+#define CORNELLBOX_BOUNCE_HEIGHT 120.
+
+void Animation::set_camera(KeyframeTrack lookfrom, KeyframeTrack lookat)
+{
+  camera_.emplace(Camera{std::move(lookfrom), std::move(lookat)});
+}
+
+void Animation::add_object(ObjectHandle handle, KeyframeTrack rotation,
+                           KeyframeTrack translation)
+{
+  objects_.push_back({handle, std::move(rotation), std::move(translation)});
+}
+
+void Animation::apply(double frame, Scene &scene, SceneEditor &editor) const
+{
+  if (camera_) {
+    scene.lookfrom = Point3F(0, 0, 0) + camera_->lookfrom.at(frame);
+    scene.lookat = Point3F(0, 0, 0) + camera_->lookat.at(frame);
+  }
+
+  for (auto const &object : objects_) {
+    const auto rotation = object.rotation.at(frame);
+    editor.set_transform(object.handle,
+                         Degree{rotation.x, rotation.y, rotation.z},
+                         object.translation.at(frame));
+  }
+}
+
+/**
+ * Rotate the lookfrom around the vertical axis through the lookat,
+ * \p degree(frame) is the angle at the frame
+ */
+template <typename F>
+static void orbit_camera(Scene const &scene, Animation &animation, F degree)
+{
+  const auto to_eye = scene.lookfrom - scene.lookat;
+  std::vector<Keyframe> lookfrom;
+  for (int frame = 0; frame <= BUILTIN_ANIMATION_FRAMES; ++frame) {
+    const auto theta = degree(frame) * pi / 180;
+    const auto cos_theta = cos(theta);
+    const auto sin_theta = sin(theta);
+    const Vec3F eye(cos_theta * to_eye.x + sin_theta * to_eye.z, to_eye.y,
+                    -sin_theta * to_eye.x + cos_theta * to_eye.z);
+    lookfrom.push_back({(double)frame, (scene.lookat + eye) - Point3F(0, 0, 0)});
+  }
+  const auto lookat = scene.lookat - Point3F(0, 0, 0);
+  animation.set_camera(KeyframeTrack(std::move(lookfrom)),
+                       KeyframeTrack({{0, lookat}}));
+}
+
+// The sphere bounces twice in the animation
+static void bounce_object(ObjectHandle handle, Animation &animation)
+{
+  std::vector<Keyframe> translation;
+  for (int frame = 0; frame <= BUILTIN_ANIMATION_FRAMES; frame += 2) {
+    const auto s = fabs(sin(2 * pi * frame / BUILTIN_ANIMATION_FRAMES));
+    translation.push_back(
+      {(double)frame, Vec3F(0, CORNELLBOX_BOUNCE_HEIGHT * s, 0)});
+  }
+  animation.add_object(handle, KeyframeTrack({{0, Vec3F(0, 0, 0)}}),
+                       KeyframeTrack(std::move(translation)));
+}
+
+namespace rt {
+
+Animation builtin_animation(int id, Scene const &scene,
+                            SceneEditor const &editor)
+{
+  Animation animation;
+  switch (id) {
+    case 0:
+    case 1:
+    case 2:
+    case 3:
+    case 6:
+      orbit_camera(scene, animation, [](int frame) {
+        return 360. * frame / BUILTIN_ANIMATION_FRAMES;
+      });
+      break;
+
+    default:
+    case 4:
+    case 5:
+    case 7: {
+      orbit_camera(scene, animation, [](int frame) {
+        return CORNELLBOX_SWING_DEGREE *
+               sin(2 * pi * frame / BUILTIN_ANIMATION_FRAMES);
+      });
+      for (ObjectHandle handle = 0; handle < (ObjectHandle)editor.size();
+           ++handle) {
+        auto material = editor.object(handle).material();
+        if (material && material->is_transmissive())
+          bounce_object(handle, animation);
+      }
+    } break;
+  }
+  return animation;
+}
+
+} // namespace rt
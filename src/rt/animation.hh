@@ -0,0 +1,71 @@
+#ifndef RT_ANIMATION_HH__
+#define RT_ANIMATION_HH__
+
+#include <optional>
+#include <vector>
+
+#include "scene.hh"
+#include "scene_editor.hh"
+#include "../shape/keyframe_track.hh"
+
+namespace rt {
+
+// The length of the builtin animations(a full turn of the turntable)
+#define BUILTIN_ANIMATION_FRAMES 48
+
+/**
+ * The keyframes of the camera and the objects of SceneEditor, the time of
+ * keyframes is the frame number(it may be fractional).
+ *
+ * The camera and transforms are interpolated linearly between the keyframes
+ * (see KeyframeTrack), so a circular path needs a keyframe per frame.
+ */
+class Animation {
+ public:
+  void set_camera(KeyframeTrack lookfrom, KeyframeTrack lookat);
+
+  /**
+   * \param rotation The degrees around the x, y and z axes
+   */
+  void add_object(ObjectHandle handle, KeyframeTrack rotation,
+                  KeyframeTrack translation);
+
+  /**
+   * Set the camera of \p scene and the transforms of the objects at the
+   * \p frame, the transforms are applied by SceneEditor::update()
+   */
+  void apply(double frame, Scene &scene, SceneEditor &editor) const;
+
+  bool empty() const noexcept { return !camera_ && objects_.empty(); }
+  size_t object_num() const noexcept { return objects_.size(); }
+
+ private:
+  struct Camera {
+    KeyframeTrack lookfrom;
+    KeyframeTrack lookat;
+  };
+
+  struct Object {
+    ObjectHandle handle;
+    KeyframeTrack rotation;
+    KeyframeTrack translation;
+  };
+
+  std::optional<Camera> camera_;
+  std::vector<Object> objects_;
+};
+
+/**
+ * The camera orbits around the lookat in BUILTIN_ANIMATION_FRAMES frames.
+ * The camera of cornell boxes swings instead(it can't leave the box) and
+ * the transmissive objects(glass spheres) bounce.
+ *
+ * \param scene The scene set up by setup_builtin_scene(id)
+ * \param editor The editor of the \p scene
+ */
+Animation builtin_animation(int id, Scene const &scene,
+                            SceneEditor const &editor);
+
+} // namespace rt
+
+#endif
@@ -1,6 +1,8 @@
 #include "camera.hh"
 
+#include "../gm/fast_math.hh"
 #include "../gm/util.hh"
+#include "../sample/sampler.hh"
 
 using namespace rt;
 using namespace gm;
@@ -32,11 +34,21 @@ void Camera::set_aperture(double aperture) { len_radius_ = aperture / 2; }
 
 Ray Camera::ray(double u, double v) const noexcept
 {
-  auto offset_corr = len_radius_ * random_in_unit_sphere();
-  auto offset = offset_corr.x * x_axis_ + offset_corr.y * y_axis_;
-  auto origin = lookfrom_ + offset;
+  auto origin = lookfrom_;
+  if (len_radius_ > 0) {
+    // Uniform on the lens
+    double r, phi, sin_phi, cos_phi;
+    sample_2d(r, phi);
+    r = len_radius_ * sqrt(r);
+    fast_sincos(2 * pi * phi, sin_phi, cos_phi);
+    origin += r * cos_phi * x_axis_ + r * sin_phi * y_axis_;
+  }
+  double time = shutter_open_;
+  if (shutter_close_ > shutter_open_)
+    time += (shutter_close_ - shutter_open_) * sample_1d();
   return Ray(origin,
-             lower_left_corner_ + u * horizontal_ + v * vertical_ - origin);
+             lower_left_corner_ + u * horizontal_ + v * vertical_ - origin,
+             time);
 }
 
 void Camera::DebugPrint() const noexcept
@@ -53,5 +65,6 @@ void Camera::DebugPrint() const noexcept
             << "lower_left_corner: " << lower_left_corner_ << '\n'
             << "focal length: " << focal_length_ << '\n'
             << "len_radius: " << len_radius_ << '\n'
+            << "shutter: [" << shutter_open_ << ", " << shutter_close_ << "]\n"
             << "===== Camera information(end) =====\n";
 }
@@ -1,6 +1,8 @@
 #ifndef RT_CAMERA_HH__
 #define RT_CAMERA_HH__
 
+#include <cmath>
+
 #include "../gm/point.hh"
 #include "../gm/util.hh"
 #include "../gm/vec.hh"
@@ -12,10 +14,33 @@ class Camera {
  public:
   Camera(gm::Point3F lookfrom, gm::Point3F lookat, double aspect_ratio,
          double fov = 90, double focus_dist = 1, Vec3F up = Vec3F(0., 1., 0.));
+  /**
+   * \param u, v The position on the film
+   * The position on the lens and the time in the shutter interval are taken
+   * from the sampler of current thread.
+   */
   Ray ray(double u, double v) const noexcept;
 
   void set_aperture(double aperture);
 
+  /**
+   * The rays are distributed uniformly in [open, close](motion blur),
+   * the shutter is instant by default
+   */
+  void set_shutter(double open, double close) noexcept
+  {
+    shutter_open_ = open;
+    shutter_close_ = close;
+  }
+
+  /**
+   * The angle subtended by a pixel(the spread of ray cone)
+   */
+  double pixel_spread_angle(int image_height) const noexcept
+  {
+    return std::atan(film_height_ / image_height);
+  }
+
   void DebugPrint() const noexcept;
 
  private:
@@ -36,6 +61,8 @@ class Camera {
   Vec3F x_axis_;
   Vec3F y_axis_;
   double len_radius_ = 0;
+  double shutter_open_ = 0;
+  double shutter_close_ = 0;
 };
 
 } // namespace rt
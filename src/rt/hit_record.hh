@@ -1,13 +1,73 @@
 #ifndef RT_HIT_RECORD_HH__
 #define RT_HIT_RECORD_HH__
 
+#include <cassert>
+
 #include "../gm/point.hh"
 #include "../gm/vec.hh"
 #include "ray.hh"
 
+// The max nesting depth of instances(Translate, Rotate, FlipFace)
+#define HIT_INFO_MAX_INSTANCES 8
+
 namespace rt {
 
 class Material;
+class Shape;
+
+/**
+ * The result of the first phase of intersection(Shape::intersect())
+ *
+ * Only the parameter and the local coordinates are recorded during the
+ * traversal, the HitRecord of the closest hit is filled once by
+ * Shape::compute_surface_interaction() of the hit shape.
+ */
+struct HitInfo {
+  double t = 0;
+  // The shape which fills the HitRecord,
+  // it is in the same space as the ray passed to intersect()
+  Shape const *shape = nullptr;
+  // Local coordinates, their meaning depends on the shape
+  // (e.g. the UV of rectangle)
+  double u = 0;
+  double v = 0;
+
+  // The shapes in the instances, pushed from the innermost one
+  Shape const *instances[HIT_INFO_MAX_INSTANCES] = {};
+  int instance_count = 0;
+
+  /**
+   * Called by the primitives, the instances recorded by the former hits are
+   * discarded
+   */
+  void set(double t_, Shape const *shape_) noexcept
+  {
+    t = t_;
+    shape = shape_;
+    instance_count = 0;
+  }
+
+  /**
+   * Called by the instances after the inner shape is hit
+   */
+  void push_instance(Shape const *instance) noexcept
+  {
+    assert(instance_count < HIT_INFO_MAX_INSTANCES);
+    instances[instance_count++] = shape;
+    shape = instance;
+  }
+
+  /**
+   * The information of the inner shape of the instance(shape)
+   */
+  HitInfo pop_instance() const noexcept
+  {
+    assert(instance_count > 0);
+    HitInfo ret = *this;
+    ret.shape = instances[--ret.instance_count];
+    return ret;
+  }
+};
 
 struct HitRecord {
   // 用于更新t的边界值，获取最近的t
@@ -21,6 +81,17 @@ struct HitRecord {
   double u = 0;
   double v = 0;
 
+  // The UV of some shapes(e.g. sphere needs atan2 and acos) is computed
+  // lazily by get_uv(), most materials don't use it
+  void (*uv_func)(Point3F const &p, double &u, double &v) = nullptr;
+  Point3F uv_point { 0, 0, 0 };
+
+  // The UV change per unit length on the surface(filled by the shape),
+  // 0 if unknown
+  double uv_scale = 0;
+  // The width of ray cone at p(filled by the integrator), 0 if unknown
+  double footprint = 0;
+
   // 折射Snell's Law涉及两边介质的比值。
   // 如果是normal被反转了，介质比值也得反转。
   // 因此需要记录。
@@ -35,6 +106,23 @@ struct HitRecord {
     front_face = dot(r.direction(), outward_normal) < 0;
     normal = front_face ? outward_normal : -outward_normal;
   }
+
+  void set_uv(double u_, double v_) noexcept
+  {
+    u = u_;
+    v = v_;
+    uv_func = nullptr;
+  }
+
+  void get_uv(double &u_, double &v_) const noexcept
+  {
+    if (uv_func) {
+      uv_func(uv_point, u_, v_);
+    } else {
+      u_ = u;
+      v_ = v;
+    }
+  }
 };
 
 } // namespace rt
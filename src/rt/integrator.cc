@@ -0,0 +1,218 @@
+#include "integrator.hh"
+
+#include <cmath>
+
+#include "hit_record.hh"
+#include "scatter_record.hh"
+#include "stats.hh"
+#include "../material/material.hh"
+#include "../sample/mixture_pdf.hh"
+#include "../sample/sampler.hh"
+#include "../sample/shape_pdf.hh"
+
+using namespace gm;
+
+namespace rt {
+
+static double RR_probability = 0.9999;
+
+/**
+ * The power heuristic(beta = 2) of multiple importance sampling
+ * One sample is taken from each strategy.
+ */
+static inline double power_heuristic(double pdf, double other_pdf) noexcept
+{
+  const auto p2 = pdf * pdf;
+  return p2 / (p2 + other_pdf * other_pdf);
+}
+
+static inline bool is_black(Color const &c) noexcept
+{
+  return c.x <= 0 && c.y <= 0 && c.z <= 0;
+}
+
+/**
+ * The scattering function times the cosine(without the albedo):
+ * cos/pi of the lambertian BRDF or 1/(4pi) of the isotropic phase function
+ */
+static inline double scattering_cosine(HitRecord const &record,
+                                       ScatterRecord const &scatter_rec,
+                                       Vec3F const &direction) noexcept
+{
+  if (scatter_rec.is_phase) return 1 / (4 * pi);
+  return std::max(dot(direction.normalize(), record.normal), 0.) / pi;
+}
+
+/**
+ * Next event estimation: sample a point on the lights and trace a shadow ray
+ * \param bsdf_sampler The other strategy of MIS
+ * \param time The time of the path
+ * \return The direct light weighted by MIS
+ */
+static Color sample_direct_light(HitRecord const &record,
+                                 ScatterRecord const &scatter_rec,
+                                 Pdf const &bsdf_sampler, Shape const &world,
+                                 Shape const &lights, double time)
+{
+  const auto direction = lights.random_direction(record.p);
+  const auto light_pdf = lights.pdf_value(record.p, direction);
+  if (!(light_pdf > epsilon) || std::isinf(light_pdf)) return {0, 0, 0};
+
+  const auto f = scattering_cosine(record, scatter_rec, direction);
+  if (f <= 0) return {0, 0, 0};
+
+  RT_STATS_INC(STATS_SHADOW_RAYS);
+  HitRecord light_rec;
+  if (!world.hit(Ray(record.p, direction, time), 0.001, inf, light_rec))
+    return {0, 0, 0};
+
+  // Occluded if the first hit is not emissive
+  if (!material_is_emissive(*light_rec.material)) return {0, 0, 0};
+  auto emitted = material_emitted(*light_rec.material, light_rec);
+  if (is_black(emitted)) return {0, 0, 0};
+
+  const auto bsdf_pdf = bsdf_sampler.value(direction);
+  return scatter_rec.attenuation * f * emitted / light_pdf *
+         power_heuristic(light_pdf, bsdf_pdf);
+}
+
+Color ray_color(Ray const &camera_ray, Scene const &scene, int max_depth,
+                AuxSample *aux)
+{
+  Shape const &world =
+    scene.bvh ? (Shape const &)*scene.bvh : (Shape const &)scene.world;
+  auto const &lights = scene.lights;
+  auto const &background = scene.background;
+
+  Color radiance(0, 0, 0);
+  Color throughput(1, 1, 1);
+  Ray ray = camera_ray;
+
+  // The BSDF pdf and origin of the last bounce,
+  // the pdf is 0 if the emission can't be sampled by NEE
+  // (camera ray, specular bounce or no lights)
+  double bsdf_pdf = 0;
+  Point3F last_p;
+
+  // Ray cone(Akenine-Moller et al. 2019), the width grows linearly with the
+  // distance. The spread is not changed by the bounces, the curvature is
+  // ignored.
+  double cone_width = 0;
+  const double cone_spread = scene.pixel_spread_angle;
+
+  for (int depth = 0; depth < max_depth; ++depth) {
+    // The offset of each event is fixed, see BOUNCE_DIMENSIONS
+    const int dimension = CAMERA_DIMENSIONS + depth * BOUNCE_DIMENSIONS;
+    set_sample_dimension(dimension);
+    if (sample_1d() > RR_probability) {
+      RT_STATS_INC(STATS_RR_TERMINATIONS);
+      break;
+    }
+    throughput /= RR_probability;
+
+    HitRecord record;
+    if (!world.hit(ray, 0.001, inf, record)) {
+      if (aux && depth == 0) aux->albedo = background;
+      radiance += throughput * background;
+      break;
+    }
+
+    RT_STATS_INC(STATS_PATH_VERTICES);
+    cone_width += cone_spread * record.t * ray.direction().length();
+    record.footprint = cone_width;
+
+    if (aux && depth == 0) {
+      aux->normal = record.normal;
+      aux->depth = record.t * ray.direction().length();
+    }
+
+    Color emitted(0, 0, 0);
+    if (material_is_emissive(*record.material)) {
+      emitted = material_emitted(*record.material, record);
+      // The emission has been sampled by the NEE of last vertex
+      if (bsdf_pdf > 0) {
+        emitted *= power_heuristic(
+            bsdf_pdf, lights->pdf_value(last_p, ray.direction()));
+      }
+      radiance += throughput * emitted;
+    }
+
+    ScatterRecord scatter_rec;
+    set_sample_dimension(dimension + 5);
+    if (!material_scatter(*record.material, ray, record, scatter_rec)) {
+      if (aux && depth == 0) {
+        aux->albedo = {clamp(emitted.x, 0, 1), clamp(emitted.y, 0, 1),
+                       clamp(emitted.z, 0, 1)};
+      }
+      break;
+    }
+
+    if (aux && depth == 0) aux->albedo = scatter_rec.attenuation;
+
+    RT_STATS_INC(STATS_BOUNCE_RAYS);
+    if (scatter_rec.is_specular) {
+      throughput *= scatter_rec.attenuation;
+      ray = scatter_rec.specular_ray;
+      bsdf_pdf = 0;
+      continue;
+    }
+
+    // Also sample the transmissive shapes to find the caustics
+    ShapePdf important_pdf(scene.important, record.p);
+    MixturePdf mixture_pdf(scatter_rec.pdf, &important_pdf);
+    Pdf const &bsdf_sampler =
+      scene.important ? (Pdf const &)mixture_pdf : *scatter_rec.pdf;
+
+    if (lights) {
+      set_sample_dimension(dimension + 1);
+      radiance +=
+        throughput * sample_direct_light(record, scatter_rec, bsdf_sampler,
+                                         world, *lights, ray.time());
+    }
+
+    set_sample_dimension(dimension + 6);
+    Ray out_ray(record.p, bsdf_sampler.generate(), ray.time());
+    const double pdf_value = bsdf_sampler.value(out_ray.direction());
+    if (pdf_value < epsilon) break;
+
+    throughput *= scatter_rec.attenuation *
+                  scattering_cosine(record, scatter_rec, out_ray.direction()) /
+                  pdf_value;
+    ray = out_ray;
+    bsdf_pdf = lights ? pdf_value : 0;
+    last_p = record.p;
+  }
+
+  return radiance;
+}
+
+Vec3F resolve_radiance(Vec3F const &c, int sample_per_pixel)
+{
+  auto scale = 1. / sample_per_pixel;
+  auto rgb = c * scale;
+  if (std::isnan(rgb.x)) rgb.x = 0;
+  if (std::isnan(rgb.y)) rgb.y = 0;
+  if (std::isnan(rgb.z)) rgb.z = 0;
+  return rgb;
+}
+
+img::Color compute_color(Vec3F const &c, int sample_per_pixel, double gamma_exp)
+{
+  auto rgb = resolve_radiance(c, sample_per_pixel);
+
+  rgb.x = std::pow(rgb.x, gamma_exp);
+  rgb.y = std::pow(rgb.y, gamma_exp);
+  rgb.z = std::pow(rgb.z, gamma_exp);
+
+  /*
+   * 由于light的强度不限制于[0, 1]，因此rgb的比例可能大于1
+   * 对于这种情况，当作1处理
+   * 使用clamp()约束
+   */
+  img::Color color(int(256 * clamp(rgb.x, 0, 0.99999)),
+                   int(256 * clamp(rgb.y, 0, 0.99999)),
+                   int(256 * clamp(rgb.z, 0, 0.99999)));
+  return color;
+}
+
+} // namespace rt
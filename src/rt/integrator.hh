@@ -0,0 +1,57 @@
+#ifndef RT_INTEGRATOR_HH__
+#define RT_INTEGRATOR_HH__
+
+#include "color.hh"
+#include "ray.hh"
+#include "scene.hh"
+#include "../img/color.hh"
+
+// The max bounces of a path
+#define MAX_DEPTH 50
+
+// The layout of the sampler dimensions of a path(see Sampler):
+// pixel position(2), lens(2) and shutter time(1), then every bounce takes
+// Russian roulette(1), light sample(4), scatter(1) and BSDF sample(3)
+#define CAMERA_DIMENSIONS 5
+#define BOUNCE_DIMENSIONS 9
+
+namespace rt {
+
+/**
+ * The features of the first hit of camera ray
+ * (auxiliary channels of HDR output)
+ */
+struct AuxSample {
+  Color albedo{0, 0, 0};
+  gm::Vec3F normal{0, 0, 0};
+  double depth = gm::inf;
+};
+
+/**
+ * Estimate the radiance along the ray(path tracing)
+ *
+ * At every diffuse vertex, one light sample(next event estimation with a
+ * shadow ray) and one BSDF sample are combined by the power heuristic, so the
+ * emission hit by the BSDF sample is not counted twice.
+ * The BSDF sample is mixed with the sampling of scene.important if any.
+ * The random numbers are taken from the sampler of current thread.
+ *
+ * \param aux Record the features of the first hit if it is not null
+ */
+Color ray_color(Ray const &camera_ray, Scene const &scene, int max_depth,
+                AuxSample *aux = nullptr);
+
+/**
+ * Average the samples and discard the invalid radiance(NaN)
+ */
+gm::Vec3F resolve_radiance(gm::Vec3F const &c, int sample_per_pixel);
+
+/**
+ * Average, gamma correct and quantize the samples
+ */
+img::Color compute_color(gm::Vec3F const &c, int sample_per_pixel,
+                         double gamma_exp);
+
+} // namespace rt
+
+#endif
@@ -10,6 +10,7 @@ std::ostream &operator<<(std::ostream &os, Ray const &ray)
   return os << "===== Ray info(start)=====\n"
             << "origin: " << ray.origin() << '\n'
             << "direction: " << ray.direction() << '\n'
+            << "time: " << ray.time() << '\n'
             << "===== Ray info(end)=====";
 }
 
@@ -11,9 +11,14 @@ namespace rt {
 class Ray {
  public:
   Ray() = default;
-  Ray(gm::Point3F const &o, gm::Vec3F const &d)
+  /**
+   * \param time The time in the shutter interval(motion blur), the moving
+   *             shapes are intersected at it
+   */
+  Ray(gm::Point3F const &o, gm::Vec3F const &d, double time = 0)
     : o_(o)
     , d_(d)
+    , time_(time)
   {
   }
 
@@ -24,6 +29,7 @@ class Ray {
   // 增加了set_XXX()接口
   gm::Point3F origin() const noexcept { return o_; }
   gm::Vec3F direction() const noexcept { return d_; }
+  double time() const noexcept { return time_; }
 
   void set_origin(gm::Point3F const &o) noexcept { o_ = o; }
   void set_direction(gm::Vec3F const &d) noexcept { d_ = d; }
@@ -33,6 +39,7 @@ class Ray {
  private:
   gm::Point3F o_;
   gm::Vec3F d_;
+  double time_ = 0;
 };
 
 std::ostream &operator<<(std::ostream &os, Ray const &ray);
@@ -0,0 +1,150 @@
+#include "resource_registry.hh"
+
+#include <functional>
+
+#include "../material/dielectric.hh"
+#include "../material/diffuse_light.hh"
+#include "../material/iostropic.hh"
+#include "../material/lambertian.hh"
+#include "../material/matal.hh"
+#include "../texture/cached_image_texture.hh"
+#include "../texture/checker_texture.hh"
+#include "../texture/solid_texture.hh"
+
+using namespace rt;
+
+static inline size_t hash_combine(size_t seed, size_t value) noexcept
+{
+  return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+static inline size_t hash_combine(size_t seed, double value) noexcept
+{
+  return hash_combine(seed, std::hash<double>{}(value));
+}
+
+size_t ResourceRegistry::Hash::operator()(Color const &color) const noexcept
+{
+  return hash_combine(hash_combine(hash_combine((size_t)0, color.x), color.y),
+                      color.z);
+}
+
+size_t ResourceRegistry::Hash::operator()(ColorPair const &pair) const noexcept
+{
+  return hash_combine((*this)(pair.even), (*this)(pair.odd));
+}
+
+size_t ResourceRegistry::Hash::operator()(MaterialKey const &key) const noexcept
+{
+  size_t seed = (*this)(key.color);
+  seed = hash_combine(seed, key.param);
+  seed = hash_combine(seed, std::hash<Texture const *>{}(key.texture));
+  return hash_combine(seed, (size_t)key.type);
+}
+
+ResourceRegistry::ResourceRegistry(bool use_arena)
+  : arena_(use_arena ? SceneArena::create() : nullptr)
+{
+}
+
+template <typename M, typename... Args>
+MaterialSPtr ResourceRegistry::intern(MaterialKey const &key, Args &&...args)
+{
+  auto iter = materials_.find(key);
+  if (iter != materials_.end()) {
+    ++reused_;
+    return iter->second;
+  }
+  MaterialSPtr material = make<M>(std::forward<Args>(args)...);
+  materials_.emplace(key, material);
+  return material;
+}
+
+auto ResourceRegistry::texture_key(MaterialType type,
+                                   TextureSPtr const &texture) noexcept
+  -> MaterialKey
+{
+  if (auto solid = dynamic_cast<SolidTexture const *>(texture.get()))
+    return {type, solid->color(), nullptr, 0};
+  return {type, Color(0, 0, 0), texture.get(), 0};
+}
+
+MaterialSPtr ResourceRegistry::lambertian(Color const &albedo)
+{
+  return intern<Lambertian>({MATERIAL_LAMBERTIAN, albedo, nullptr, 0}, albedo);
+}
+
+MaterialSPtr ResourceRegistry::lambertian(TextureSPtr const &albedo)
+{
+  return intern<Lambertian>(texture_key(MATERIAL_LAMBERTIAN, albedo), albedo);
+}
+
+MaterialSPtr ResourceRegistry::metal(Color const &albedo, double fuzz)
+{
+  // Matal clamps the fuzz
+  fuzz = fuzz < 1 ? fuzz : 1;
+  return intern<Matal>({MATERIAL_METAL, albedo, nullptr, fuzz}, albedo, fuzz);
+}
+
+MaterialSPtr ResourceRegistry::dielectric(double ratio_of_refraction)
+{
+  return intern<Dielectric>(
+    {MATERIAL_DIELECTRIC, Color(0, 0, 0), nullptr, ratio_of_refraction},
+    ratio_of_refraction);
+}
+
+MaterialSPtr ResourceRegistry::diffuse_light(Color const &emit)
+{
+  return intern<DiffuseLight>({MATERIAL_DIFFUSE_LIGHT, emit, nullptr, 0},
+                              emit);
+}
+
+MaterialSPtr ResourceRegistry::diffuse_light(TextureSPtr const &emit)
+{
+  return intern<DiffuseLight>(texture_key(MATERIAL_DIFFUSE_LIGHT, emit), emit);
+}
+
+MaterialSPtr ResourceRegistry::isotropic(Color const &albedo)
+{
+  return intern<Iostropic>({MATERIAL_ISOTROPIC, albedo, nullptr, 0}, albedo);
+}
+
+MaterialSPtr ResourceRegistry::isotropic(TextureSPtr const &albedo)
+{
+  return intern<Iostropic>(texture_key(MATERIAL_ISOTROPIC, albedo), albedo);
+}
+
+TextureSPtr ResourceRegistry::solid_texture(Color const &color)
+{
+  auto &texture = solid_textures_[color];
+  if (texture) {
+    ++reused_;
+    return texture;
+  }
+  return texture = make<SolidTexture>(color);
+}
+
+TextureSPtr ResourceRegistry::checker_texture(Color const &even,
+                                              Color const &odd)
+{
+  auto &texture = checker_textures_[ColorPair{even, odd}];
+  if (texture) {
+    ++reused_;
+    return texture;
+  }
+  return texture = make<CheckerTexture>(solid_texture(even),
+                                       solid_texture(odd));
+}
+
+TextureSPtr ResourceRegistry::image_texture(char const *path, bool srgb,
+                                            TextureCacheSPtr const &cache)
+{
+  // The same image may be decoded in both ways
+  auto &texture = image_textures_[(srgb ? "srgb:" : "linear:") +
+                                  std::string(path)];
+  if (texture) {
+    ++reused_;
+    return texture;
+  }
+  return texture = make_image_texture(path, srgb, cache);
+}
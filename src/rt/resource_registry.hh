@@ -0,0 +1,141 @@
+#ifndef RT_RESOURCE_REGISTRY_HH__
+#define RT_RESOURCE_REGISTRY_HH__
+
+#include <stddef.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "color.hh"
+#include "scene_arena.hh"
+#include "../material/material.hh"
+#include "../material/type.hh"
+#include "../texture/texture.hh"
+#include "../texture/texture_cache.hh"
+#include "../util/noncopyable.hh"
+
+namespace rt {
+
+/**
+ * Intern the materials and textures while building a scene
+ *
+ * The same arguments return the same object, e.g. the thousands of
+ * Dielectric(1.5) of a random scene are one material, and an image is
+ * loaded once however many materials use it.
+ * The constant colors are stored in the MaterialRecord of materials, no
+ * texture object is created for them.
+ *
+ * The materials, textures and the shapes created by make() are placed in
+ * the SceneArena of the registry. They are owned by the shared_ptrs either
+ * way, the arena only changes where they are placed.
+ * It is not thread-safe, the scene is built by one thread.
+ */
+class ResourceRegistry : kanon::noncopyable {
+ public:
+  /**
+   * \param use_arena Create the objects by make_shared instead
+   *        (e.g. to compare the footprint)
+   */
+  explicit ResourceRegistry(bool use_arena = true);
+
+  /**
+   * Create the object of the scene(e.g. shape) in the arena
+   */
+  template <typename T, typename... Args>
+  std::shared_ptr<T> make(Args &&...args)
+  {
+    if (!arena_) return std::make_shared<T>(std::forward<Args>(args)...);
+    return arena_->make<T>(std::forward<Args>(args)...);
+  }
+
+  MaterialSPtr lambertian(Color const &albedo);
+  MaterialSPtr lambertian(TextureSPtr const &albedo);
+  MaterialSPtr metal(Color const &albedo, double fuzz);
+  MaterialSPtr dielectric(double ratio_of_refraction);
+  MaterialSPtr diffuse_light(Color const &emit);
+  MaterialSPtr diffuse_light(TextureSPtr const &emit);
+  MaterialSPtr isotropic(Color const &albedo);
+  MaterialSPtr isotropic(TextureSPtr const &albedo);
+
+  TextureSPtr solid_texture(Color const &color);
+  TextureSPtr checker_texture(Color const &even, Color const &odd);
+  /**
+   * \param cache Page the image in through it if it is not null
+   *        (see make_image_texture())
+   */
+  TextureSPtr image_texture(char const *path, bool srgb,
+                            TextureCacheSPtr const &cache = nullptr);
+
+  size_t material_count() const noexcept { return materials_.size(); }
+  size_t texture_count() const noexcept
+  {
+    return solid_textures_.size() + checker_textures_.size() +
+           image_textures_.size();
+  }
+
+  /**
+   * The number of requests resolved by an existing resource
+   */
+  size_t reused() const noexcept { return reused_; }
+
+  /**
+   * null if the arena is not used
+   */
+  SceneArena const *arena() const noexcept { return arena_.get(); }
+
+ private:
+  /**
+   * The builtin material is determined by its type, color(or texture) and
+   * parameter
+   */
+  struct MaterialKey {
+    MaterialType type;
+    Color color;
+    Texture const *texture;
+    double param;
+
+    bool operator==(MaterialKey const &o) const noexcept
+    {
+      return type == o.type && color.x == o.color.x && color.y == o.color.y &&
+             color.z == o.color.z && texture == o.texture && param == o.param;
+    }
+  };
+
+  struct ColorPair {
+    Color even;
+    Color odd;
+
+    bool operator==(ColorPair const &o) const noexcept
+    {
+      return even.x == o.even.x && even.y == o.even.y && even.z == o.even.z &&
+             odd.x == o.odd.x && odd.y == o.odd.y && odd.z == o.odd.z;
+    }
+  };
+
+  struct Hash {
+    size_t operator()(MaterialKey const &key) const noexcept;
+    size_t operator()(Color const &color) const noexcept;
+    size_t operator()(ColorPair const &pair) const noexcept;
+  };
+
+  template <typename M, typename... Args>
+  MaterialSPtr intern(MaterialKey const &key, Args &&...args);
+
+  /**
+   * The key of the material using the texture, the solid texture is
+   * flattened into the color
+   */
+  static MaterialKey texture_key(MaterialType type,
+                                 TextureSPtr const &texture) noexcept;
+
+  SceneArena::Ref arena_;
+  std::unordered_map<MaterialKey, MaterialSPtr, Hash> materials_;
+  std::unordered_map<Color, TextureSPtr, Hash> solid_textures_;
+  std::unordered_map<ColorPair, TextureSPtr, Hash> checker_textures_;
+  std::unordered_map<std::string, TextureSPtr> image_textures_;
+  size_t reused_ = 0;
+};
+
+} // namespace rt
+
+#endif
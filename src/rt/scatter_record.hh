@@ -1,6 +1,10 @@
 #ifndef RT_SCATTER_RECORD_HH__
 #define RT_SCATTER_RECORD_HH__
 
+#include <optional>
+
+#include "../sample/cosine_pdf.hh"
+#include "../sample/isotropic_pdf.hh"
 #include "../sample/pdf.hh"
 #include "../rt/ray.hh"
 #include "../rt/color.hh"
@@ -10,8 +14,24 @@ namespace rt {
 struct ScatterRecord {
   Ray specular_ray;
   bool is_specular = true;
+  // The scattering function is the isotropic phase function 1/(4pi)
+  // instead of the lambertian BRDF cos/pi(scattered in a medium)
+  bool is_phase = false;
   Color attenuation;
-  PdfSPtr pdf = nullptr;
+  // The pdf of the diffuse bounce,
+  // it points to cosine_pdf or the one owned by pdf_owner
+  Pdf const *pdf = nullptr;
+
+  // The builtin materials construct the pdf in place instead of allocating
+  std::optional<CosinePdf> cosine_pdf;
+  std::optional<IsotropicPdf> isotropic_pdf;
+  // The pdf of the material defined outside
+  PdfSPtr pdf_owner = nullptr;
+
+  ScatterRecord() = default;
+  // pdf may point to the member
+  ScatterRecord(ScatterRecord const &) = delete;
+  ScatterRecord &operator=(ScatterRecord const &) = delete;
 };
 
 } // namespace rt
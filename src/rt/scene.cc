@@ -0,0 +1,437 @@
+#include "scene.hh"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+
+#include "../accelerate/bvh_node.hh"
+#include "../shape/box.hh"
+#include "../shape/flip_face.hh"
+#include "../shape/grid_medium.hh"
+#include "../shape/moving_sphere.hh"
+#include "../shape/rect.hh"
+#include "../shape/rotate.hh"
+#include "../shape/sphere.hh"
+#include "../shape/translate.hh"
+#include "../shape/constant_medium.hh"
+#include "../texture/image_texture.hh"
+#include "../texture/perlin.hh"
+#include "../util/random.hh"
+
+using namespace util;
+using namespace img;
+using namespace gm;
+using namespace std;
+
+namespace rt {
+
+void setup_builtin_scene(int id, Scene &scene)
+{
+  switch (id) {
+    case 0: {
+      setup_scene(scene.world, *scene.resources);
+    } break;
+    case 1: {
+      scene.background = rt::Color(0.8, 0.4, 0.3);
+      scene.lookfrom = Point3F(13., 2., 3.);
+      scene.lookat = Point3F(0, 0, 0);
+      scene.fov = 30;
+      setup_random_scene(scene.world, *scene.resources);
+    } break;
+
+    case 2: {
+      scene.background = rt::Color(0, 0, 0);
+      scene.lookfrom = Point3F(26, 3, 6);
+      scene.lookat = Point3F(0, 2, 0);
+      scene.fov = 20;
+      setup_light_scene(scene.world, *scene.resources);
+    } break;
+
+    case 3: {
+      scene.background = rt::Color(1, 1, 1);
+      scene.lookfrom = Point3F(13, 2, 3);
+      scene.lookat = Point3F(0, 0, 0);
+      scene.fov = 20;
+      setup_image_scene(scene.world, *scene.resources, scene.texture_cache);
+    } break;
+
+    default:
+    case 4: {
+      scene.aspect_ratio = 1;
+      scene.lookfrom = Point3F(0, 278, 800);
+      scene.lookat = Point3F(0, 278, 0);
+      scene.fov = 40;
+      setup_cornellbox(scene.world, *scene.resources);
+    } break;
+
+    case 5: {
+      scene.aspect_ratio = 1.0 / 1.0;
+      scene.lookfrom = Point3F(278, 278, -800);
+      scene.lookat = Point3F(278, 278, 0);
+      scene.fov = 40;
+      setup_cornellbox2(scene.world, *scene.resources);
+    } break;
+
+    case 6: {
+      scene.background = rt::Color(0.7, 0.8, 1.0);
+      scene.lookfrom = Point3F(13, 2, 3);
+      scene.lookat = Point3F(0, 0, 0);
+      scene.fov = 20;
+      scene.time0 = 0;
+      scene.time1 = 1;
+      setup_bouncing_spheres(scene.world, *scene.resources);
+    } break;
+
+    case 7: {
+      scene.aspect_ratio = 1;
+      scene.lookfrom = Point3F(0, 278, 800);
+      scene.lookat = Point3F(0, 278, 0);
+      scene.fov = 40;
+      setup_cornellbox_smoke(scene.world, *scene.resources);
+    } break;
+  }
+
+  collect_lights(scene);
+  build_bvh(scene);
+}
+
+// The max number of transmissive shapes sampled by the diffuse bounce
+// Half of the bounce directions are toward them, the small ones(e.g. the
+// glass balls of the random scene) only waste the samples
+#define IMPORTANT_SHAPE_MAX 16
+
+static void collect_shapes(ShapeList const &list,
+                           std::vector<ShapeSPtr> &emitters,
+                           std::vector<ShapeSPtr> &transmissive)
+{
+  for (auto const &shape : list.shape()) {
+    if (auto sub_list = dynamic_cast<ShapeList const *>(shape.get())) {
+      collect_shapes(*sub_list, emitters, transmissive);
+      continue;
+    }
+
+    auto material = shape->material();
+    if (!material) continue;
+    if (material->is_emissive()) {
+      emitters.push_back(shape);
+    } else if (material->is_transmissive()) {
+      transmissive.push_back(shape);
+    }
+  }
+}
+
+void collect_lights(Scene &scene)
+{
+  std::vector<ShapeSPtr> emitters;
+  std::vector<ShapeSPtr> transmissive;
+  collect_shapes(scene.world, emitters, transmissive);
+
+  scene.lights = nullptr;
+  if (!emitters.empty())
+    scene.lights = make_shared<LightSampler>(emitters, scene.light_strategy);
+
+  // The caustics are the light of emitters focused by the transmissive
+  // shapes, the background is found by the BSDF sampling well
+  scene.important = nullptr;
+  if (emitters.empty() || transmissive.empty()) return;
+
+  // Keep the largest ones, the unknown area is treated as 1
+  auto shape_area = [](ShapeSPtr const &shape) {
+    const auto area = shape->area();
+    return area > 0 ? area : 1.;
+  };
+  if (transmissive.size() > IMPORTANT_SHAPE_MAX) {
+    std::nth_element(transmissive.begin(),
+                     transmissive.begin() + IMPORTANT_SHAPE_MAX,
+                     transmissive.end(),
+                     [&shape_area](ShapeSPtr const &a, ShapeSPtr const &b) {
+                       return shape_area(a) > shape_area(b);
+                     });
+    transmissive.resize(IMPORTANT_SHAPE_MAX);
+  }
+
+  // The importance of light BVH(area / d^2) is about the solid angle, so
+  // the near and large shapes are preferred
+  std::vector<double> areas;
+  areas.reserve(transmissive.size());
+  for (auto const &shape : transmissive) areas.push_back(shape_area(shape));
+  scene.important =
+    make_shared<LightSampler>(transmissive, areas, LightSampler::LIGHT_BVH);
+}
+
+void build_bvh(Scene &scene)
+{
+  scene.bvh = nullptr;
+  if (scene.world.shape().empty()) return;
+  scene.bvh =
+    make_shared<BvhTree>(scene.world.shape(), scene.time0, scene.time1);
+}
+
+char const *builtin_scene_name(int id) noexcept
+{
+  static char const *const names[BUILTIN_SCENE_NUM] = {
+    "spheres",
+    "random_spheres",
+    "light",
+    "image",
+    "cornellbox",
+    "cornellbox2",
+    "bouncing_spheres",
+    "cornellbox_smoke",
+  };
+  return (id >= 0 && id < BUILTIN_SCENE_NUM) ? names[id] : names[4];
+}
+
+void setup_scene(ShapeList &world, ResourceRegistry &resources)
+{
+  // setup textures
+  auto checker_texture =
+      resources.checker_texture(rt::Color(0, 0, 0), rt::Color(1, 1, 1));
+  // Setup materia1, 1, 1l
+  auto material_ground = resources.lambertian(checker_texture);
+  auto material_center = resources.lambertian(rt::Color(0.7, 0.3, 0.3));
+  // auto material_center = std::make_unique<Dielectric>(1.5);
+  // auto material_left = std::make_unique<Matal>(rt::Color(0.8, 0.8, 0.8),
+  // 0.0);
+  auto material_left = resources.dielectric(1.5);
+  auto material_right = resources.metal(rt::Color(0.8, 0.6, 0.2), 0.0);
+
+  // Setup shapes
+  world.add(resources.make<Sphere>(Point3F(0, 0, -1), 0.5, material_center));
+  world.add(
+      resources.make<Sphere>(Point3F(0, -100.5, -1), 100, material_ground));
+  world.add(resources.make<Sphere>(Point3F(-1.0, 0, -1), 0.5, material_left));
+  world.add(resources.make<Sphere>(Point3F(1.0, 0, -1), 0.5, material_right));
+}
+
+void setup_random_scene(ShapeList &world, ResourceRegistry &resources)
+{
+  auto material_ground = resources.lambertian(rt::Color(0.5, 0.8, 0.5));
+  world.add(
+      resources.make<Sphere>(Point3F(0, -1000, 0), 1000, material_ground));
+
+  for (int a = -11; a < 110; ++a) {
+    for (int b = -11; b < 11; ++b) {
+      auto choose_mat = random_double();
+      Point3F center(a + 0.9 * random_double(), 0.2, b + 0.9 * random_double());
+
+      if ((center - Point3F(4, 0.2, 0)).length() > 0.9) {
+        MaterialSPtr material;
+        if (choose_mat < 0.8) {
+          auto albedo = rt::Color::random() * rt::Color::random();
+          material = resources.lambertian(albedo);
+        } else if (choose_mat < 0.95) {
+          auto albedo = rt::Color::random(0.5, 1);
+          auto fuzz = random_double(0, 0.5);
+          material = resources.metal(albedo, fuzz);
+        } else {
+          material = resources.dielectric(1.5);
+        }
+
+        world.add(resources.make<Sphere>(center, 0.2, std::move(material)));
+      }
+    }
+  }
+
+  world.add(
+      resources.make<Sphere>(Point3F(0, 1, 0), 1.0, resources.dielectric(1.5)));
+  world.add(
+      resources.make<Sphere>(Point3F(-4, 1, 0), 1.0,
+                             resources.lambertian(rt::Color(0.4, 0.2, 0.1))));
+  world.add(
+      resources.make<Sphere>(Point3F(4, 1, 0), 1.0,
+                             resources.metal(rt::Color(0.7, 0.6, 0.5), 0.0)));
+}
+
+void setup_light_scene(ShapeList &world, ResourceRegistry &resources)
+{
+  auto light_texture = resources.solid_texture(rt::Color(16, 4, 4));
+  auto diffuse_light_material = resources.diffuse_light(light_texture);
+  auto rect_light =
+      resources.make<XyRect>(3, 5, 1, 3, -2, diffuse_light_material);
+  world.add(std::move(rect_light));
+  world.add(
+      resources.make<Sphere>(Point3F(0, 7, 0), 1, diffuse_light_material));
+  world.add(resources.make<Sphere>(
+      Point3F(0, 2, 0), 2, resources.lambertian(rt::Color(0.4, 0.6, 0.9))));
+  world.add(
+      resources.make<Sphere>(Point3F(0, -1000, 0), 1000,
+                             resources.lambertian(rt::Color(0.3, 0.2, 0.8))));
+}
+
+void setup_image_scene(ShapeList &world, ResourceRegistry &resources,
+                       TextureCacheSPtr const &cache)
+{
+  auto earth_texture = resources.image_texture("img/earthmap.jpg", true, cache);
+  if (auto image = dynamic_cast<ImageTexture const *>(earth_texture.get()))
+    std::cout << *image << "\n";
+  world.add(resources.make<Sphere>(Point3F(0, 0, 0), 2,
+                                   resources.lambertian(earth_texture)));
+}
+
+/**
+ * The walls and light of setup_cornellbox()
+ */
+static void add_cornellbox_walls(ShapeList &world, ResourceRegistry &resources)
+{
+  auto red = resources.lambertian(rt::Color(.65, .05, .05));
+  auto green = resources.lambertian(rt::Color(.12, .65, .45));
+  auto white = resources.lambertian(rt::Color(.75, .75, .75));
+  auto light = resources.diffuse_light(rt::Color(15, 15, 15));
+
+  world.add(resources.make<YzRect>(0, 556, -556, 0, -278, green));   // left
+  world.add(resources.make<YzRect>(0, 556, -556, 0, 278, red));      // right
+  world.add(resources.make<XyRect>(-278, 278, 0, 556, -556, white)); // front
+  world.add(resources.make<XzRect>(-278, 278, -556, 0, 0, white));   // bottom
+  world.add(resources.make<XzRect>(-278, 278, -556, 0, 556, white)); // top
+  auto light_rect = resources.make<FlipFace>(
+      XzRect::create_based_mid(0, 200, -278, 200, 554, light));
+  world.add(light_rect);
+}
+
+void setup_cornellbox(ShapeList &world, ResourceRegistry &resources)
+{
+  add_cornellbox_walls(world, resources);
+  auto white = resources.lambertian(rt::Color(.75, .75, .75));
+
+  MaterialSPtr box1_mat = nullptr;
+#if 1
+  box1_mat = white;
+#else
+  auto mirror = resources.metal(rt::Color(1, 1, 1), 0);
+  box1_mat = mirror;
+#endif
+  ShapeSPtr box1 = resources.make<Box>(Point3F(0, 0, 0), Point3F(165, 330, 165),
+                                       box1_mat); // left
+
+  ShapeSPtr box2 = resources.make<Box>(Point3F(0, 0, 0), Point3F(165, 165, 165),
+                                       white); // right
+
+  box1 = resources.make<Rotate>(std::move(box1), Degree{.y = 18});
+  box2 = resources.make<Rotate>(std::move(box2), Degree{.y = -15});
+  box1 = resources.make<Translate>(std::move(box1), Vec3F{-152, 0, -460});
+  box2 = resources.make<Translate>(std::move(box2), Vec3F{17, 0, -230});
+#define CORNELLBOX_SCENE 1
+#if CORNELLBOX_SCENE == 0
+  world.add(resources.make<ConstantMedium>(std::move(box1), 0.01,
+                                          resources.isotropic(Color{0, 0, 0})));
+  world.add(resources.make<ConstantMedium>(std::move(box2), 0.01,
+                                          resources.isotropic(Color{1, 1, 1})));
+#elif CORNELLBOX_SCENE == 1
+  auto glass = resources.dielectric(1.5);
+  auto sphere = resources.make<Sphere>(Point3F(107, 90, -230), 90, glass);
+  world.add(sphere);
+  world.add(box1);
+#elif CORNELLBOX_SCENE == 2
+  world.add(box1);
+  world.add(box2);
+#endif
+}
+
+void setup_cornellbox2(ShapeList &world, ResourceRegistry &resources)
+{
+  auto red = resources.lambertian(rt::Color(.65, .05, .05));
+  auto white = resources.lambertian(rt::Color(.73, .73, .73));
+  auto green = resources.lambertian(rt::Color(.12, .45, .15));
+  auto light = resources.diffuse_light(rt::Color(15, 15, 15));
+
+  world.add(resources.make<YzRect>(0, 555, 0, 555, 555, green));
+  world.add(resources.make<YzRect>(0, 555, 0, 555, 0, red));
+  world.add(resources.make<FlipFace>(
+      resources.make<XzRect>(213, 343, 227, 332, 554, light)));
+  world.add(resources.make<XzRect>(0, 555, 0, 555, 555, white));
+  world.add(resources.make<XzRect>(0, 555, 0, 555, 0, white));
+  world.add(resources.make<XyRect>(0, 555, 0, 555, 555, white));
+
+  // shared_ptr<Material> aluminum =
+  //     resources.metal(rt::Color(0.8, 0.85, 0.88), 0.0);
+  shared_ptr<Shape> box1 =
+      resources.make<Box>(Point3F(0, 0, 0), Point3F(165, 330, 165), white);
+  box1 = resources.make<Rotate>(box1, Degree{.y = 18});
+  box1 = resources.make<Translate>(box1, Vec3F(265, 0, 295));
+  world.add(box1);
+
+  auto glass = resources.dielectric(1.5);
+  world.add(resources.make<Sphere>(Point3F(190, 90, 190), 90, glass));
+}
+
+void setup_bouncing_spheres(ShapeList &world, ResourceRegistry &resources)
+{
+  auto checker = resources.checker_texture(rt::Color(0.2, 0.3, 0.1),
+                                           rt::Color(0.9, 0.9, 0.9));
+  world.add(resources.make<Sphere>(Point3F(0, -1000, 0), 1000,
+                                   resources.lambertian(checker)));
+
+  for (int a = -11; a < 11; ++a) {
+    for (int b = -11; b < 11; ++b) {
+      auto choose_mat = random_double();
+      Point3F center(a + 0.9 * random_double(), 0.2, b + 0.9 * random_double());
+      if ((center - Point3F(4, 0.2, 0)).length() <= 0.9) continue;
+
+      if (choose_mat < 0.6) {
+        // Moves up linearly in the shutter interval
+        auto albedo = rt::Color::random() * rt::Color::random();
+        auto center1 = center + Vec3F(0, random_double(0, 0.5), 0);
+        world.add(resources.make<MovingSphere>(center, 0., center1, 1., 0.2,
+                                               resources.lambertian(albedo)));
+      } else if (choose_mat < 0.8) {
+        // Bounces once: up and back to the ground
+        auto albedo = rt::Color::random() * rt::Color::random();
+        const double height = random_double(0.2, 0.6);
+        KeyframeTrack track({{0., {0, 0, 0}},
+                             {0.5, {0, height, 0}},
+                             {1., {0, 0, 0}}});
+        world.add(resources.make<MovingSphere>(center, std::move(track), 0.2,
+                                               resources.lambertian(albedo)));
+      } else if (choose_mat < 0.95) {
+        auto albedo = rt::Color::random(0.5, 1);
+        auto fuzz = random_double(0, 0.5);
+        world.add(resources.make<Sphere>(center, 0.2,
+                                         resources.metal(albedo, fuzz)));
+      } else {
+        world.add(
+            resources.make<Sphere>(center, 0.2, resources.dielectric(1.5)));
+      }
+    }
+  }
+
+  world.add(
+      resources.make<Sphere>(Point3F(0, 1, 0), 1.0, resources.dielectric(1.5)));
+  world.add(
+      resources.make<Sphere>(Point3F(-4, 1, 0), 1.0,
+                             resources.lambertian(rt::Color(0.4, 0.2, 0.1))));
+  world.add(
+      resources.make<Sphere>(Point3F(4, 1, 0), 1.0,
+                             resources.metal(rt::Color(0.7, 0.6, 0.5), 0.0)));
+}
+
+void setup_cornellbox_smoke(ShapeList &world, ResourceRegistry &resources)
+{
+  add_cornellbox_walls(world, resources);
+
+  // The smoke box of setup_cornellbox() variant 0
+  auto white = resources.lambertian(rt::Color(.75, .75, .75));
+  ShapeSPtr box =
+      resources.make<Box>(Point3F(0, 0, 0), Point3F(165, 330, 165), white);
+  box = resources.make<Rotate>(std::move(box), Degree{.y = 18});
+  box = resources.make<Translate>(std::move(box), Vec3F{-152, 0, -460});
+  world.add(resources.make<ConstantMedium>(
+      std::move(box), 0.01, resources.isotropic(Color{0, 0, 0})));
+
+  // The cloud: noise fading out from the center
+  const Point3F center(60, 220, -230);
+  const double radius = 150;
+  Perlin perlin(7);
+  auto grid = resources.make<DensityGrid>(DensityGrid::from_function(
+      Aabb(center - radius, center + radius), 64, 64, 64,
+      [&](Point3F const &p) {
+        const auto falloff = 1 - (p - center).length() / radius;
+        if (falloff <= 0) return 0.;
+        const auto q = Point3F(0, 0, 0) + (p - center) * 0.02;
+        return falloff * 2 * (0.6 + perlin.fbm(q, 4));
+      }));
+  world.add(resources.make<GridMedium>(std::move(grid), 0.05,
+                                       resources.isotropic(Color{.9, .9, .9})));
+}
+
+} // namespace rt
@@ -0,0 +1,85 @@
+#ifndef RT_SCENE_HH__
+#define RT_SCENE_HH__
+
+#include <memory>
+
+#include "color.hh"
+#include "resource_registry.hh"
+#include "../accelerate/bvh_node.hh"
+#include "../gm/point.hh"
+#include "../sample/light_sampler.hh"
+#include "../shape/shape_list.hh"
+#include "../texture/texture_cache.hh"
+
+namespace rt {
+
+/**
+ * The shapes and view settings of a scene
+ */
+struct Scene {
+  ShapeList world;
+  // The emitters for light sampling(LightSampler), null if there is no one
+  ShapeSPtr lights = nullptr;
+  // The transmissive shapes sampled by the diffuse bounce(caustics),
+  // null if there is no one or no emitter
+  ShapeSPtr important = nullptr;
+  LightSampler::Strategy light_strategy = LightSampler::POWER;
+  // The BVH over the world, the world is traversed linearly if it is null
+  std::shared_ptr<BvhTree> bvh = nullptr;
+  Color background{0, 0, 0};
+
+  gm::Point3F lookfrom{0, 0, 0};
+  gm::Point3F lookat{0, 0, -1};
+  double fov = 90;
+  double aspect_ratio = 16. / 9.;
+  // The shutter interval, the camera rays are distributed in it
+  // (motion blur)
+  double time0 = 0;
+  double time1 = 0;
+  // The spread angle of the ray cone of a pixel(set by the renderer),
+  // the textures are filtered over the footprint. 0 disables the filtering.
+  double pixel_spread_angle = 0;
+  // The image textures are paged in by it if it is not null
+  // (set before setup_builtin_scene())
+  TextureCacheSPtr texture_cache = nullptr;
+  // The materials and textures shared by the shapes
+  // (the copies of scene share it too)
+  std::shared_ptr<ResourceRegistry> resources =
+    std::make_shared<ResourceRegistry>();
+};
+
+#define BUILTIN_SCENE_NUM 8
+
+/**
+ * \param id [0, BUILTIN_SCENE_NUM), otherwise the default scene
+ */
+void setup_builtin_scene(int id, Scene &scene);
+char const *builtin_scene_name(int id) noexcept;
+
+/**
+ * Collect the emitters(Material::is_emissive()) and transmissive shapes of
+ * the world into scene.lights and scene.important.
+ * The transmissive shapes are collected only if there are emitters, and
+ * only the largest ones are kept.
+ * The shapes are shared instead of duplicated.
+ */
+void collect_lights(Scene &scene);
+
+/**
+ * Build scene.bvh over the shapes of the world in the shutter interval
+ */
+void build_bvh(Scene &scene);
+
+void setup_scene(ShapeList &world, ResourceRegistry &resources);
+void setup_random_scene(ShapeList &world, ResourceRegistry &resources);
+void setup_light_scene(ShapeList &world, ResourceRegistry &resources);
+void setup_image_scene(ShapeList &world, ResourceRegistry &resources,
+                       TextureCacheSPtr const &cache = nullptr);
+void setup_cornellbox(ShapeList &world, ResourceRegistry &resources);
+void setup_cornellbox2(ShapeList &world, ResourceRegistry &resources);
+void setup_bouncing_spheres(ShapeList &world, ResourceRegistry &resources);
+void setup_cornellbox_smoke(ShapeList &world, ResourceRegistry &resources);
+
+} // namespace rt
+
+#endif
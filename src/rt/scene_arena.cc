@@ -0,0 +1,88 @@
+#include "scene_arena.hh"
+
+#include <algorithm>
+#include <new>
+
+using namespace rt;
+
+// The bytes of the first chunk of a pool, the next one is twice as large
+// until SCENE_ARENA_MAX_CHUNK_SIZE(a chunk holds one object at least)
+#define SCENE_ARENA_MIN_CHUNK_SIZE (1 << 10)
+#define SCENE_ARENA_MAX_CHUNK_SIZE (16 << 10)
+// The control block of make_shared(vptr, use count and weak count)
+#define SHARED_CONTROL_BLOCK_SIZE 16
+#define MALLOC_HEADER_SIZE 8
+#define MALLOC_ALIGNMENT 16
+#define MALLOC_MIN_CHUNK_SIZE 32
+
+SceneArena::~SceneArena()
+{
+  // The objects have been destroyed by their owners
+  for (auto &[type, pool] : pools_) {
+    for (auto &chunk : pool.chunks) {
+      ::operator delete(chunk.data, std::align_val_t(pool.align));
+    }
+  }
+}
+
+void *SceneArena::allocate(std::type_index type, size_t size, size_t align,
+                           size_t object_size)
+{
+  auto iter = pools_.find(type);
+  if (iter == pools_.end()) {
+    // The size is a multiple of the alignment
+    iter = pools_.emplace(type, Pool{size, align, object_size, {}}).first;
+  }
+
+  auto &pool = iter->second;
+  if (pool.chunks.empty() ||
+      pool.chunks.back().count == pool.chunks.back().capacity) {
+    size_t capacity =
+      std::max<size_t>(1, SCENE_ARENA_MIN_CHUNK_SIZE / pool.stride);
+    if (!pool.chunks.empty()) {
+      capacity = std::max(
+        capacity, std::min(pool.chunks.back().capacity * 2,
+                           SCENE_ARENA_MAX_CHUNK_SIZE / pool.stride));
+    }
+    auto data = static_cast<char *>(::operator new(
+      capacity * pool.stride, std::align_val_t(pool.align)));
+    pool.chunks.push_back({data, capacity, 0});
+  }
+  auto &chunk = pool.chunks.back();
+  return chunk.data + chunk.count++ * pool.stride;
+}
+
+size_t SceneArena::shared_footprint(size_t size) noexcept
+{
+  const size_t n = SHARED_CONTROL_BLOCK_SIZE + size + MALLOC_HEADER_SIZE;
+  return std::max<size_t>(MALLOC_MIN_CHUNK_SIZE,
+                          (n + MALLOC_ALIGNMENT - 1) & ~(MALLOC_ALIGNMENT - 1));
+}
+
+auto SceneArena::stats() const noexcept -> Stats
+{
+  Stats stats;
+  stats.type_num = pools_.size();
+  for (auto const &[type, pool] : pools_) {
+    stats.chunk_num += pool.chunks.size();
+    for (auto const &chunk : pool.chunks) {
+      stats.object_num += chunk.count;
+      stats.used_bytes += chunk.count * pool.stride;
+      stats.reserved_bytes += chunk.capacity * pool.stride;
+      stats.shared_bytes +=
+        chunk.count * shared_footprint(pool.object_size);
+    }
+  }
+  return stats;
+}
+
+void SceneArena::Stats::Print(FILE *out) const
+{
+  fprintf(out, "===== Scene arena statistics =====\n");
+  fprintf(out, "%-20s %20zu\n", "objects", object_num);
+  fprintf(out, "%-20s %20zu\n", "types", type_num);
+  fprintf(out, "%-20s %20zu\n", "chunks", chunk_num);
+  fprintf(out, "%-20s %20zu\n", "used_bytes", used_bytes);
+  fprintf(out, "%-20s %20zu\n", "reserved_bytes", reserved_bytes);
+  fprintf(out, "%-20s %20zu\n", "shared_ptr_bytes", shared_bytes);
+}
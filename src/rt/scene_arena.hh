@@ -0,0 +1,172 @@
+#ifndef RT_SCENE_ARENA_HH__
+#define RT_SCENE_ARENA_HH__
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <memory>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../util/noncopyable.hh"
+
+namespace rt {
+
+/**
+ * The bump allocator of the objects of a scene(shapes, materials and
+ * textures)
+ *
+ * The objects of the same type are placed contiguously in the chunks of
+ * their pool, so the shapes traversed together(e.g. the spheres of a BVH
+ * leaf) are close in memory. The chunks of a pool grow geometrically, a type
+ * with few objects doesn't reserve a large chunk. The chunks are freed at
+ * once.
+ *
+ * make() places the object and its control block(allocate_shared) in the
+ * arena, so the shared_ptr owns the object as usual. Every object keeps the
+ * arena alive, the arena is destroyed once its creator and all objects
+ * release it, a copy of the shared_ptr never dangles.
+ * The memory of a destroyed object is not reused.
+ *
+ * Creating the objects is not thread-safe, the scene is built by one
+ * thread. The objects can be released by any thread.
+ */
+class SceneArena : kanon::noncopyable {
+ public:
+  struct Stats {
+    size_t object_num = 0;
+    size_t type_num = 0;
+    size_t chunk_num = 0;
+    // The bytes of the objects
+    size_t used_bytes = 0;
+    // The bytes of the chunks
+    size_t reserved_bytes = 0;
+    // The estimated heap bytes if every object were created by make_shared
+    // (control block and malloc header, see shared_footprint())
+    size_t shared_bytes = 0;
+
+    void Print(FILE *out) const;
+  };
+
+  struct Release {
+    void operator()(SceneArena *arena) const noexcept { arena->release(); }
+  };
+
+  /**
+   * The reference of the creator, the arena lives on until the objects are
+   * destroyed
+   */
+  using Ref = std::unique_ptr<SceneArena, Release>;
+
+  static Ref create() { return Ref(new SceneArena); }
+
+  /**
+   * The allocator of allocate_shared, it holds a reference of the arena.
+   * \tparam Object The type created by make(), it is kept by the rebinding
+   *                (the control block is allocated actually)
+   */
+  template <typename T, typename Object>
+  class Allocator {
+   public:
+    using value_type = T;
+
+    explicit Allocator(SceneArena *arena) noexcept
+      : arena_(arena)
+    {
+      arena_->retain();
+    }
+
+    template <typename U>
+    Allocator(Allocator<U, Object> const &other) noexcept
+      : Allocator(other.arena_)
+    {
+    }
+
+    Allocator(Allocator const &other) noexcept
+      : Allocator(other.arena_)
+    {
+    }
+
+    Allocator &operator=(Allocator const &) = delete;
+
+    ~Allocator() noexcept { arena_->release(); }
+
+    T *allocate(size_t n)
+    {
+      assert(n == 1);
+      (void)n;
+      return static_cast<T *>(
+        arena_->allocate(typeid(T), sizeof(T), alignof(T), sizeof(Object)));
+    }
+
+    // Freed with the arena
+    void deallocate(T *, size_t) noexcept {}
+
+    template <typename U>
+    bool operator==(Allocator<U, Object> const &other) const noexcept
+    {
+      return arena_ == other.arena_;
+    }
+
+   private:
+    template <typename, typename>
+    friend class Allocator;
+
+    SceneArena *arena_;
+  };
+
+  template <typename T, typename... Args>
+  std::shared_ptr<T> make(Args &&...args)
+  {
+    return std::allocate_shared<T>(Allocator<T, T>(this),
+                                   std::forward<Args>(args)...);
+  }
+
+  Stats stats() const noexcept;
+
+  /**
+   * The heap bytes of an object of \p size created by make_shared:
+   * the control block of libstdc++ is placed before the object in a malloc
+   * chunk(glibc: 8 bytes header, 16 bytes aligned, at least 32 bytes)
+   */
+  static size_t shared_footprint(size_t size) noexcept;
+
+ private:
+  struct Chunk {
+    char *data;
+    size_t capacity;
+    size_t count;
+  };
+
+  struct Pool {
+    size_t stride;
+    size_t align;
+    // The size of the object without the control block
+    size_t object_size;
+    std::vector<Chunk> chunks;
+  };
+
+  SceneArena() = default;
+  ~SceneArena();
+
+  void retain() noexcept { refs_.fetch_add(1, std::memory_order_relaxed); }
+  void release() noexcept
+  {
+    if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+  }
+
+  void *allocate(std::type_index type, size_t size, size_t align,
+                 size_t object_size);
+
+  std::unordered_map<std::type_index, Pool> pools_;
+  // The creator and the allocators(one per object)
+  std::atomic<size_t> refs_{1};
+};
+
+} // namespace rt
+
+#endif
@@ -0,0 +1,101 @@
+#include "scene_editor.hh"
+
+#include <assert.h>
+
+#include "../material/material.hh"
+
+using namespace rt;
+using namespace gm;
+
+// The BVH is rebuilt if the refit one is so worse than the built one
+#define SCENE_REBUILD_SAH_RATIO 1.5
+
+// The shape is collected by collect_lights()
+static inline bool is_collected(Material const *material) noexcept
+{
+  return material && (material->is_emissive() || material->is_transmissive());
+}
+
+SceneEditor::SceneEditor(Scene &scene)
+  : scene_(scene)
+{
+  ShapeList world;
+  for (auto const &shape : scene.world.shape()) {
+    objects_.push_back(std::make_shared<Instance>(shape));
+    world.add(objects_.back());
+  }
+  is_moved_.resize(objects_.size());
+  scene.world = std::move(world);
+
+  collect_lights(scene);
+  build_bvh(scene);
+}
+
+ObjectHandle SceneEditor::add(ShapeSPtr shape)
+{
+  auto object = std::make_shared<Instance>(std::move(shape));
+  if (is_collected(object->material())) need_collect_lights_ = true;
+  scene_.world.add(object);
+  objects_.push_back(std::move(object));
+  is_moved_.push_back(false);
+  need_rebuild_ = true;
+  return (ObjectHandle)objects_.size() - 1;
+}
+
+void SceneEditor::set_transform(ObjectHandle handle, Degree const &rotation,
+                                Vec3F const &translation)
+{
+  assert(handle >= 0 && (size_t)handle < objects_.size());
+  auto &object = *objects_[handle];
+  object.set_transform(rotation, translation);
+  // The bounds of light BVH are changed
+  if (is_collected(object.material())) need_collect_lights_ = true;
+  if (!is_moved_[handle]) {
+    is_moved_[handle] = true;
+    moved_.push_back(handle);
+  }
+}
+
+void SceneEditor::set_material(ObjectHandle handle, MaterialSPtr material)
+{
+  assert(handle >= 0 && (size_t)handle < objects_.size());
+  auto &object = *objects_[handle];
+  if (is_collected(object.material()) || is_collected(material.get()))
+    need_collect_lights_ = true;
+  object.set_material(std::move(material));
+  // The restored material of shape may be collected too
+  if (is_collected(object.material())) need_collect_lights_ = true;
+}
+
+auto SceneEditor::update() -> UpdateStats
+{
+  UpdateStats stats;
+  if (!need_rebuild_ && scene_.bvh && !moved_.empty()) {
+    stats.refit_nodes = scene_.bvh->refit(moved_);
+    const auto build_cost = scene_.bvh->build_cost();
+    if (build_cost > 0) stats.sah_ratio = scene_.bvh->sah_cost() / build_cost;
+    need_rebuild_ = stats.sah_ratio > SCENE_REBUILD_SAH_RATIO;
+  }
+  if (need_rebuild_ || (!scene_.bvh && !objects_.empty())) {
+    build_bvh(scene_);
+    stats.rebuilt = true;
+    stats.sah_ratio = 1;
+  }
+  if (need_collect_lights_) {
+    collect_lights(scene_);
+    stats.lights_collected = true;
+  }
+
+  for (auto handle : moved_) is_moved_[handle] = false;
+  moved_.clear();
+  need_rebuild_ = false;
+  need_collect_lights_ = false;
+  return stats;
+}
+
+void SceneEditor::UpdateStats::Print(FILE *out) const
+{
+  fprintf(out, "Scene update: refit nodes = %zu, rebuilt = %d, "
+               "lights collected = %d, SAH cost ratio = %.3f\n",
+          refit_nodes, rebuilt, lights_collected, sah_ratio);
+}
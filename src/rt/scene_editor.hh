@@ -0,0 +1,83 @@
+#ifndef RT_SCENE_EDITOR_HH__
+#define RT_SCENE_EDITOR_HH__
+
+#include <stdio.h>
+#include <memory>
+#include <vector>
+
+#include "scene.hh"
+#include "../shape/instance.hh"
+#include "../util/noncopyable.hh"
+
+namespace rt {
+
+// The index of the object in the SceneEditor
+using ObjectHandle = int;
+
+/**
+ * Edit the scene between the renders(e.g. look development) instead of
+ * setting it up again
+ *
+ * The top-level shapes of the world are wrapped by Instances, the handles
+ * are their indices. The edits are marked and applied by update():
+ * - material: the acceleration structure is not touched, the lights are
+ *   collected again only if the emitters or transmissive shapes change
+ * - transform: the BVH is refit in O(changed * depth), it is rebuilt
+ *   when its SAH cost is more than SCENE_REBUILD_SAH_RATIO times the one
+ *   after building
+ * - add: the BVH is rebuilt
+ *
+ * The emitters should be the top-level shapes(collect_lights() doesn't look
+ * into the shape of instance).
+ */
+class SceneEditor : kanon::noncopyable {
+ public:
+  struct UpdateStats {
+    size_t refit_nodes = 0;
+    bool rebuilt = false;
+    bool lights_collected = false;
+    // sah_cost() / build_cost() of the BVH
+    double sah_ratio = 1;
+
+    void Print(FILE *out) const;
+  };
+
+  /**
+   * The world of \p scene is replaced by the instances of its shapes
+   * (it should not be edited directly after this)
+   */
+  explicit SceneEditor(Scene &scene);
+
+  ObjectHandle add(ShapeSPtr shape);
+
+  void set_transform(ObjectHandle handle, Degree const &rotation,
+                     gm::Vec3F const &translation);
+  /**
+   * \param material null restores the material of the shape
+   */
+  void set_material(ObjectHandle handle, MaterialSPtr material);
+
+  /**
+   * Apply the edits since the last update()
+   */
+  UpdateStats update();
+
+  Instance const &object(ObjectHandle handle) const
+  {
+    return *objects_[handle];
+  }
+  size_t size() const noexcept { return objects_.size(); }
+
+ private:
+  Scene &scene_;
+  std::vector<std::shared_ptr<Instance>> objects_;
+  // The objects transformed since the last update()
+  std::vector<ObjectHandle> moved_;
+  std::vector<bool> is_moved_;
+  bool need_rebuild_ = false;
+  bool need_collect_lights_ = false;
+};
+
+} // namespace rt
+
+#endif
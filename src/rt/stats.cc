@@ -0,0 +1,84 @@
+#include "stats.hh"
+
+#include <mutex>
+
+namespace rt {
+
+static char const *const stats_counter_names[] = {
+  "camera_rays",
+  "bounce_rays",
+  "shadow_rays",
+  "path_vertices",
+  "rr_terminations",
+  "nan_samples",
+  "bvh_nodes_visited",
+  "sphere_tests",
+  "rect_tests",
+  "medium_tests",
+  "instance_tests",
+};
+
+static_assert(sizeof stats_counter_names / sizeof stats_counter_names[0] ==
+              STATS_COUNTER_NUM, "The name of every counter must be given");
+
+#ifdef RT_ENABLE_STATS
+thread_local uint64_t tls_stats_counters[STATS_COUNTER_NUM];
+#endif
+
+static std::mutex stats_mutex;
+static RenderStats global_stats;
+
+void stats_flush() noexcept
+{
+#ifdef RT_ENABLE_STATS
+  std::lock_guard<std::mutex> guard(stats_mutex);
+  for (int i = 0; i < STATS_COUNTER_NUM; ++i) {
+    global_stats.counters[i] += tls_stats_counters[i];
+    tls_stats_counters[i] = 0;
+  }
+#endif
+}
+
+RenderStats stats_collect() noexcept
+{
+  stats_flush();
+  std::lock_guard<std::mutex> guard(stats_mutex);
+  return global_stats;
+}
+
+void RenderStats::Print(FILE *fp, double seconds) const
+{
+  fprintf(fp, "===== Render statistics =====\n");
+  for (int i = 0; i < STATS_COUNTER_NUM; ++i) {
+    fprintf(fp, "%-20s %20llu\n", stats_counter_names[i],
+            (unsigned long long)counters[i]);
+  }
+  fprintf(fp, "%-20s %20.3lf\n", "average_path_length", average_path_length());
+  fprintf(fp, "%-20s %20.3lf\n", "mrays_per_sec",
+          seconds > 0 ? double(total_rays()) / seconds * 1e-6 : 0.);
+}
+
+bool RenderStats::WriteJson(char const *path, double seconds) const
+{
+  auto fp = fopen(path, "w");
+  if (!fp) {
+    fprintf(stderr, "Failed to write statistics: %s\n", path);
+    return false;
+  }
+
+  fprintf(fp, "{\n");
+  for (int i = 0; i < STATS_COUNTER_NUM; ++i) {
+    fprintf(fp, "  \"%s\": %llu,\n", stats_counter_names[i],
+            (unsigned long long)counters[i]);
+  }
+  fprintf(fp, "  \"total_rays\": %llu,\n", (unsigned long long)total_rays());
+  fprintf(fp, "  \"average_path_length\": %.6lf,\n", average_path_length());
+  fprintf(fp, "  \"render_seconds\": %.6lf,\n", seconds);
+  fprintf(fp, "  \"mrays_per_sec\": %.6lf\n",
+          seconds > 0 ? double(total_rays()) / seconds * 1e-6 : 0.);
+  fprintf(fp, "}\n");
+
+  return fclose(fp) == 0;
+}
+
+} // namespace rt
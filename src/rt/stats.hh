@@ -0,0 +1,96 @@
+#ifndef RT_STATS_HH__
+#define RT_STATS_HH__
+
+#include <stdint.h>
+#include <stdio.h>
+
+namespace rt {
+
+/**
+ * Render statistics
+ *
+ * Every thread counts in its own thread_local counters(no atomic operation
+ * and no false sharing in the hot path), and flushes them into the global
+ * ones once it is done.
+ *
+ * The counters are compiled out entirely unless RT_ENABLE_STATS is defined
+ * (cmake -DRT_ENABLE_STATS=ON), i.e. RT_STATS_ADD() is an empty statement.
+ */
+enum StatsCounter : int {
+  STATS_CAMERA_RAYS = 0,
+  STATS_BOUNCE_RAYS,
+  STATS_SHADOW_RAYS,
+  STATS_PATH_VERTICES,     // The number of hits of all paths
+  STATS_RR_TERMINATIONS,   // Russian roulette
+  STATS_NAN_SAMPLES,
+  STATS_BVH_NODES_VISITED,
+  STATS_SPHERE_TESTS,
+  STATS_RECT_TESTS,
+  STATS_MEDIUM_TESTS,      // ConstantMedium
+  STATS_INSTANCE_TESTS,    // Translate/Rotate/FlipFace
+  STATS_COUNTER_NUM,
+};
+
+struct RenderStats {
+  uint64_t counters[STATS_COUNTER_NUM] = {0};
+
+  uint64_t operator[](StatsCounter c) const noexcept { return counters[c]; }
+
+  uint64_t total_rays() const noexcept
+  {
+    return counters[STATS_CAMERA_RAYS] + counters[STATS_BOUNCE_RAYS] +
+           counters[STATS_SHADOW_RAYS];
+  }
+
+  double average_path_length() const noexcept
+  {
+    return counters[STATS_CAMERA_RAYS]
+               ? double(counters[STATS_PATH_VERTICES]) /
+                     double(counters[STATS_CAMERA_RAYS])
+               : 0;
+  }
+
+  /**
+   * \param seconds The render time(for Mrays/s)
+   */
+  void Print(FILE *fp, double seconds) const;
+  bool WriteJson(char const *path, double seconds) const;
+};
+
+#ifdef RT_ENABLE_STATS
+
+extern thread_local uint64_t tls_stats_counters[STATS_COUNTER_NUM];
+
+#define RT_STATS_ADD(counter, n) (::rt::tls_stats_counters[(counter)] += (n))
+
+#else
+
+#define RT_STATS_ADD(counter, n) ((void)0)
+
+#endif
+
+#define RT_STATS_INC(counter) RT_STATS_ADD(counter, 1)
+
+/**
+ * Flush the counters of current thread into the global counters.
+ * Must be called by the render threads before they exit.
+ */
+void stats_flush() noexcept;
+
+/**
+ * Flush the current thread and get the sum of all threads
+ */
+RenderStats stats_collect() noexcept;
+
+inline constexpr bool stats_enabled() noexcept
+{
+#ifdef RT_ENABLE_STATS
+  return true;
+#else
+  return false;
+#endif
+}
+
+} // namespace rt
+
+#endif
@@ -0,0 +1,56 @@
+#include "alias_table.hh"
+
+#include <algorithm>
+#include <assert.h>
+
+using namespace rt;
+
+AliasTable::AliasTable(std::vector<double> const &weights)
+  : bins_(weights.size())
+  , pmf_(weights.size())
+{
+  const size_t n = weights.size();
+  if (n == 0) return;
+
+  double sum = 0;
+  for (auto w : weights) {
+    assert(w >= 0);
+    sum += w;
+  }
+  for (size_t i = 0; i < n; ++i)
+    pmf_[i] = sum > 0 ? weights[i] / sum : 1. / (double)n;
+
+  // Scale to the average 1, then pair the bins under and over the average
+  std::vector<double> scaled(n);
+  std::vector<uint32_t> under;
+  std::vector<uint32_t> over;
+  for (size_t i = 0; i < n; ++i) {
+    scaled[i] = pmf_[i] * (double)n;
+    (scaled[i] < 1 ? under : over).push_back((uint32_t)i);
+  }
+
+  while (!under.empty() && !over.empty()) {
+    auto small = under.back();
+    auto large = over.back();
+    under.pop_back();
+    over.pop_back();
+
+    bins_[small] = {scaled[small], large};
+    // The remaining of the large one
+    scaled[large] -= 1 - scaled[small];
+    (scaled[large] < 1 ? under : over).push_back(large);
+  }
+
+  // The rest are 1 except the rounding error
+  for (auto i : under) bins_[i] = {1, i};
+  for (auto i : over) bins_[i] = {1, i};
+}
+
+size_t AliasTable::sample(double u) const noexcept
+{
+  assert(!bins_.empty());
+  const double scaled = u * (double)bins_.size();
+  const size_t index = std::min((size_t)scaled, bins_.size() - 1);
+  auto const &bin = bins_[index];
+  return scaled - (double)index < bin.probability ? index : bin.alias;
+}
@@ -0,0 +1,51 @@
+#ifndef RT_ALIAS_TABLE_HH__
+#define RT_ALIAS_TABLE_HH__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace rt {
+
+/**
+ * Sample a discrete distribution in O(1)(Walker/Vose's alias method)
+ *
+ * Every bin holds the probability of itself and the index of an alias,
+ * one uniform number selects the bin and then chooses between the two.
+ */
+class AliasTable {
+ public:
+  AliasTable() = default;
+
+  /**
+   * \param weights Non-negative, need not be normalized.
+   *                If all of them are zero, the distribution is uniform.
+   */
+  explicit AliasTable(std::vector<double> const &weights);
+
+  /**
+   * \param u Uniform random number in [0, 1)
+   */
+  size_t sample(double u) const noexcept;
+
+  /**
+   * The probability of the \p index
+   */
+  double pmf(size_t index) const noexcept { return pmf_[index]; }
+
+  size_t size() const noexcept { return bins_.size(); }
+  bool empty() const noexcept { return bins_.empty(); }
+
+ private:
+  struct Bin {
+    double probability; // Choose the bin itself
+    uint32_t alias;
+  };
+
+  std::vector<Bin> bins_;
+  std::vector<double> pmf_;
+};
+
+} // namespace rt
+
+#endif
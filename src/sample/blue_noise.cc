@@ -0,0 +1,142 @@
+#include "blue_noise.hh"
+
+#include <cmath>
+#include <stdint.h>
+#include <vector>
+
+#include "../util/random.hh"
+
+using namespace rt;
+
+#define MASK_PIXELS (BLUE_NOISE_MASK_SIZE * BLUE_NOISE_MASK_SIZE)
+// The sigma of the gaussian filter measuring the density of points
+#define VOID_AND_CLUSTER_SIGMA 1.5
+// The ratio of points in the initial binary pattern
+#define INITIAL_POINT_RATIO 10
+
+namespace {
+
+/**
+ * The binary pattern and its density(filtered by the gaussian on the torus)
+ */
+class VoidAndCluster {
+ public:
+  VoidAndCluster()
+    : kernel_(MASK_PIXELS)
+    , energy_(MASK_PIXELS, 0.)
+    , pattern_(MASK_PIXELS, 0)
+  {
+    for (int y = 0; y < BLUE_NOISE_MASK_SIZE; ++y) {
+      for (int x = 0; x < BLUE_NOISE_MASK_SIZE; ++x) {
+        const int dx = std::min(x, BLUE_NOISE_MASK_SIZE - x);
+        const int dy = std::min(y, BLUE_NOISE_MASK_SIZE - y);
+        kernel_[y * BLUE_NOISE_MASK_SIZE + x] =
+          exp(-(dx * dx + dy * dy) /
+              (2 * VOID_AND_CLUSTER_SIGMA * VOID_AND_CLUSTER_SIGMA));
+      }
+    }
+  }
+
+  bool get(int p) const noexcept { return pattern_[p]; }
+
+  void set(int p, bool on) noexcept
+  {
+    if (pattern_[p] == on) return;
+    pattern_[p] = on;
+    const double sign = on ? 1 : -1;
+    const int px = p % BLUE_NOISE_MASK_SIZE;
+    const int py = p / BLUE_NOISE_MASK_SIZE;
+    for (int y = 0; y < BLUE_NOISE_MASK_SIZE; ++y) {
+      const int dy = (y - py + BLUE_NOISE_MASK_SIZE) % BLUE_NOISE_MASK_SIZE;
+      for (int x = 0; x < BLUE_NOISE_MASK_SIZE; ++x) {
+        const int dx = (x - px + BLUE_NOISE_MASK_SIZE) % BLUE_NOISE_MASK_SIZE;
+        energy_[y * BLUE_NOISE_MASK_SIZE + x] +=
+          sign * kernel_[dy * BLUE_NOISE_MASK_SIZE + dx];
+      }
+    }
+  }
+
+  // The point with the densest neighbourhood
+  int tightest_cluster() const noexcept
+  {
+    int ret = -1;
+    for (int p = 0; p < MASK_PIXELS; ++p) {
+      if (pattern_[p] && (ret < 0 || energy_[p] > energy_[ret])) ret = p;
+    }
+    return ret;
+  }
+
+  // The empty pixel with the sparsest neighbourhood
+  int largest_void() const noexcept
+  {
+    int ret = -1;
+    for (int p = 0; p < MASK_PIXELS; ++p) {
+      if (!pattern_[p] && (ret < 0 || energy_[p] < energy_[ret])) ret = p;
+    }
+    return ret;
+  }
+
+ private:
+  std::vector<double> kernel_;
+  std::vector<double> energy_;
+  std::vector<uint8_t> pattern_;
+};
+
+} // namespace
+
+static std::vector<double> generate_blue_noise()
+{
+  // The initial pattern is random(but fixed)
+  VoidAndCluster initial;
+  int point_num = 0;
+  for (uint64_t i = 0; point_num < MASK_PIXELS / INITIAL_POINT_RATIO; ++i) {
+    const int p = int(util::mix_seed(0, i) % MASK_PIXELS);
+    if (initial.get(p)) continue;
+    initial.set(p, true);
+    ++point_num;
+  }
+
+  // Move the point in the tightest cluster to the largest void until the
+  // points are distributed evenly(it converges quickly, the limit is only
+  // a guard against the oscillation)
+  for (int i = 0; i < MASK_PIXELS; ++i) {
+    const int cluster = initial.tightest_cluster();
+    initial.set(cluster, false);
+    const int void_ = initial.largest_void();
+    initial.set(void_, true);
+    if (void_ == cluster) break;
+  }
+
+  std::vector<double> rank(MASK_PIXELS);
+
+  // The points of the initial pattern: remove the tightest cluster first,
+  // it gets the highest rank
+  VoidAndCluster pattern = initial;
+  for (int n = point_num; n > 0; --n) {
+    const int cluster = pattern.tightest_cluster();
+    pattern.set(cluster, false);
+    rank[cluster] = n - 1;
+  }
+
+  // The other pixels: fill the largest void first
+  // (the largest void of ones is the tightest cluster of zeros)
+  pattern = initial;
+  for (int n = point_num; n < MASK_PIXELS; ++n) {
+    const int void_ = pattern.largest_void();
+    pattern.set(void_, true);
+    rank[void_] = n;
+  }
+
+  for (auto &r : rank) r = (r + 0.5) / MASK_PIXELS;
+  return rank;
+}
+
+double rt::blue_noise(int x, int y) noexcept
+{
+  static const std::vector<double> mask = generate_blue_noise();
+  x %= BLUE_NOISE_MASK_SIZE;
+  y %= BLUE_NOISE_MASK_SIZE;
+  if (x < 0) x += BLUE_NOISE_MASK_SIZE;
+  if (y < 0) y += BLUE_NOISE_MASK_SIZE;
+  return mask[y * BLUE_NOISE_MASK_SIZE + x];
+}
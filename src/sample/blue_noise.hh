@@ -0,0 +1,18 @@
+#ifndef RT_BLUE_NOISE_HH__
+#define RT_BLUE_NOISE_HH__
+
+namespace rt {
+
+#define BLUE_NOISE_MASK_SIZE 64
+
+/**
+ * The tileable blue noise mask, the values are the ranks in
+ * [0, BLUE_NOISE_MASK_SIZE^2) mapped to [0, 1), each of them appears once.
+ * It is generated by void-and-cluster at the first call.
+ * \see Ulichney. The void-and-cluster method for dither array generation. 1993
+ */
+double blue_noise(int x, int y) noexcept;
+
+} // namespace rt
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef RT_SAMPLE_ISOTROPIC_PDF_HH__
+#define RT_SAMPLE_ISOTROPIC_PDF_HH__
+
+#include "pdf.hh"
+#include "sample.hh"
+#include "../gm/util.hh"
+
+namespace rt {
+
+/**
+ * The uniform directions of the isotropic phase function
+ */
+class IsotropicPdf : public Pdf {
+ public:
+  double value(Vec3F const &dir) const override { return 1 / (4 * gm::pi); }
+  Vec3F generate() const override { return uniform_sphere_sample(); }
+};
+
+} // namespace rt
+
+#endif
@@ -0,0 +1,347 @@
+#include "light_sampler.hh"
+
+#include <algorithm>
+#include <assert.h>
+
+#include "../gm/util.hh"
+#include "../material/material.hh"
+#include "../rt/hit_record.hh"
+#include "sampler.hh"
+
+using namespace rt;
+using namespace gm;
+
+// The depth of stack used to traverse the BVH
+#define LIGHT_BVH_STACK_SIZE 64
+
+static inline double luminance(Color const &c) noexcept
+{
+  return 0.2126 * c.x + 0.7152 * c.y + 0.0722 * c.z;
+}
+
+static inline Point3F box_center(Aabb const &box) noexcept
+{
+  return box.min() + (box.max() - box.min()) / 2.;
+}
+
+/**
+ * Rotate \p v around the unit \p axis(Rodrigues' rotation formula)
+ */
+static inline Vec3F rotate(Vec3F const &v, Vec3F const &axis,
+                           double theta) noexcept
+{
+  const auto cos_theta = cos(theta);
+  return v * cos_theta + cross(axis, v) * sin(theta) +
+         axis * dot(axis, v) * (1 - cos_theta);
+}
+
+/*--------------------------------------------------*/
+/* LightBounds                                      */
+/*--------------------------------------------------*/
+
+/**
+ * The upper bound of the contribution of the emitters to the point p:
+ * power * cos(theta') / d^2
+ * theta' is the minimum angle between the emission directions and the
+ * direction to p, the emission cone of a diffuse surface is pi/2 wider than
+ * its normal cone.
+ * \see Conty Estevez and Kulla. Importance Sampling of Many Lights with
+ *      Adaptive Tree Splitting. 2018
+ */
+double LightSampler::LightBounds::importance(Point3F const &p) const noexcept
+{
+  if (power <= 0) return 0;
+
+  const auto center = box_center(box);
+  const auto radius = (box.max() - box.min()).length() / 2;
+  const auto to_p = p - center;
+  // Avoid the infinity when p is close to(or in) the emitters
+  const auto distance_squared =
+    std::max(to_p.length_squared(), radius * radius);
+  if (cos_theta <= -1) return power / distance_squared;
+
+  const auto distance = to_p.length();
+  if (distance <= radius) return power / distance_squared;
+
+  const auto theta_w = acos(clamp(dot(axis, to_p) / distance, -1, 1));
+  const auto theta_o = acos(clamp(cos_theta, -1, 1));
+  // The angle subtended by the bounding sphere
+  const auto theta_b = asin(radius / distance);
+  const auto theta = std::max(0., theta_w - theta_o - theta_b);
+  if (theta >= pi / 2) return 0;
+
+  return power * cos(theta) / distance_squared;
+}
+
+auto LightSampler::LightBounds::merge(LightBounds const &a, LightBounds const &b)
+  -> LightBounds
+{
+  if (a.power <= 0) return b;
+  if (b.power <= 0) return a;
+
+  LightBounds ret;
+  ret.box = Aabb::surrouding_box(a.box, b.box);
+  ret.power = a.power + b.power;
+
+  // The union of the normal cones
+  const auto theta_a = acos(clamp(a.cos_theta, -1, 1));
+  const auto theta_b = acos(clamp(b.cos_theta, -1, 1));
+  const auto theta_d = acos(clamp(dot(a.axis, b.axis), -1, 1));
+  if (std::min(theta_d + theta_b, pi) <= theta_a) {
+    ret.axis = a.axis;
+    ret.cos_theta = a.cos_theta;
+    return ret;
+  }
+  if (std::min(theta_d + theta_a, pi) <= theta_b) {
+    ret.axis = b.axis;
+    ret.cos_theta = b.cos_theta;
+    return ret;
+  }
+
+  const auto theta_o = (theta_a + theta_d + theta_b) / 2;
+  const auto rotate_axis = cross(a.axis, b.axis);
+  if (theta_o >= pi || rotate_axis.length_squared() < epsilon) {
+    ret.cos_theta = -1;
+    return ret;
+  }
+
+  ret.axis = rotate(a.axis, rotate_axis.normalize(), theta_o - theta_a);
+  ret.cos_theta = cos(theta_o);
+  return ret;
+}
+
+/*--------------------------------------------------*/
+/* LightSampler                                     */
+/*--------------------------------------------------*/
+
+LightSampler::LightSampler(std::vector<ShapeSPtr> const &shapes,
+                           Strategy strategy)
+  : strategy_(strategy)
+{
+  for (auto const &shape : shapes) {
+    auto material = shape->material();
+    if (!material || !material->is_emissive()) continue;
+
+    // The unknown area is treated as 1
+    const auto area = shape->area();
+    const auto power =
+      luminance(material->average_emitted()) * pi * (area > 0 ? area : 1.);
+    add(shape, power, true);
+  }
+  build();
+}
+
+LightSampler::LightSampler(std::vector<ShapeSPtr> const &shapes,
+                           std::vector<double> const &weights,
+                           Strategy strategy)
+  : strategy_(strategy)
+{
+  assert(shapes.size() == weights.size());
+  for (size_t i = 0; i < shapes.size(); ++i) {
+    if (weights[i] > 0) add(shapes[i], weights[i], false);
+  }
+  build();
+}
+
+void LightSampler::add(ShapeSPtr const &shape, double power, bool one_sided)
+{
+  Emitter emitter;
+  if (!shape->get_bounding_box(emitter.bounds.box)) return;
+
+  emitter.shape = shape;
+  emitter.power = power;
+  emitter.bounds.power = power;
+  if (!one_sided ||
+      !shape->normal_bounds(emitter.bounds.axis, emitter.bounds.cos_theta))
+    emitter.bounds.cos_theta = -1;
+  emitter.bit_trail = 0;
+  emitters_.push_back(std::move(emitter));
+}
+
+void LightSampler::build()
+{
+  if (emitters_.empty()) return;
+
+  std::vector<double> powers;
+  powers.reserve(emitters_.size());
+  for (auto const &emitter : emitters_) powers.push_back(emitter.power);
+  alias_table_ = AliasTable(powers);
+
+  std::vector<int> indices(emitters_.size());
+  for (size_t i = 0; i < indices.size(); ++i) indices[i] = (int)i;
+  nodes_.reserve(emitters_.size() * 2 - 1);
+  build(indices, 0, indices.size(), 0, 0);
+}
+
+int LightSampler::build(std::vector<int> &indices, size_t begin, size_t end,
+                        uint64_t bit_trail, int depth)
+{
+  assert(end > begin);
+  assert(depth < LIGHT_BVH_STACK_SIZE);
+  const int node_index = (int)nodes_.size();
+  nodes_.push_back({});
+
+  if (end - begin == 1) {
+    auto &emitter = emitters_[indices[begin]];
+    emitter.bit_trail = bit_trail;
+    nodes_[node_index] = {emitter.bounds, indices[begin], true};
+    return node_index;
+  }
+
+  // Split at the median of centroids along the longest axis
+  auto first_center = box_center(emitters_[indices[begin]].bounds.box);
+  Aabb centroid_box(first_center, first_center);
+  for (size_t i = begin + 1; i < end; ++i) {
+    auto center = box_center(emitters_[indices[i]].bounds.box);
+    centroid_box = Aabb::surrouding_box(centroid_box, Aabb(center, center));
+  }
+  const auto extent = centroid_box.max() - centroid_box.min();
+  const int axis = extent.x >= extent.y ? (extent.x >= extent.z ? 0 : 2)
+                                        : (extent.y >= extent.z ? 1 : 2);
+
+  const size_t mid = (begin + end) / 2;
+  std::nth_element(indices.begin() + begin, indices.begin() + mid,
+                   indices.begin() + end, [this, axis](int a, int b) {
+                     return box_center(emitters_[a].bounds.box)[axis] <
+                            box_center(emitters_[b].bounds.box)[axis];
+                   });
+
+  build(indices, begin, mid, bit_trail, depth + 1);
+  const int right =
+    build(indices, mid, end, bit_trail | (uint64_t(1) << depth), depth + 1);
+
+  nodes_[node_index] = {
+    LightBounds::merge(nodes_[node_index + 1].bounds, nodes_[right].bounds),
+    right, false};
+  return node_index;
+}
+
+bool LightSampler::intersect(Ray const &ray, double tmin, double tmax,
+                             HitInfo &info) const
+{
+  if (nodes_.empty()) return false;
+
+  int stack[LIGHT_BVH_STACK_SIZE];
+  int top = 0;
+  stack[top++] = 0;
+  bool hit_anything = false;
+
+  while (top > 0) {
+    auto const &node = nodes_[stack[--top]];
+    if (!node.bounds.box.hit(ray, tmin, tmax)) continue;
+
+    if (node.is_leaf) {
+      if (emitters_[node.index].shape->intersect(ray, tmin, tmax, info)) {
+        hit_anything = true;
+        tmax = info.t;
+      }
+    } else {
+      stack[top++] = node.index;
+      stack[top++] = (int)(&node - nodes_.data()) + 1;
+    }
+  }
+  return hit_anything;
+}
+
+bool LightSampler::get_bounding_box(Aabb &output_box) const
+{
+  if (nodes_.empty()) return false;
+  output_box = nodes_[0].bounds.box;
+  return true;
+}
+
+int LightSampler::sample(Point3F const &origin, double u) const
+{
+  if (emitters_.empty()) return -1;
+  if (strategy_ == POWER) return (int)alias_table_.sample(u);
+
+  int i = 0;
+  if (nodes_[0].is_leaf)
+    return nodes_[0].bounds.importance(origin) > 0 ? nodes_[0].index : -1;
+
+  while (!nodes_[i].is_leaf) {
+    const int left = i + 1;
+    const int right = nodes_[i].index;
+    const auto left_importance = nodes_[left].bounds.importance(origin);
+    const auto right_importance = nodes_[right].bounds.importance(origin);
+    const auto sum = left_importance + right_importance;
+    if (sum <= 0) return -1;
+
+    // Reuse the random number
+    const auto p_left = left_importance / sum;
+    if (u < p_left) {
+      u = std::min(u / p_left, 1 - epsilon);
+      i = left;
+    } else {
+      u = std::min((u - p_left) / (1 - p_left), 1 - epsilon);
+      i = right;
+    }
+  }
+  return nodes_[i].index;
+}
+
+double LightSampler::pmf(Point3F const &origin, int index) const
+{
+  if (strategy_ == POWER) return alias_table_.pmf(index);
+
+  if (nodes_[0].is_leaf)
+    return nodes_[0].bounds.importance(origin) > 0 ? 1 : 0;
+
+  const auto bit_trail = emitters_[index].bit_trail;
+  double ret = 1;
+  int i = 0;
+  for (int depth = 0; !nodes_[i].is_leaf; ++depth) {
+    const int left = i + 1;
+    const int right = nodes_[i].index;
+    const auto left_importance = nodes_[left].bounds.importance(origin);
+    const auto right_importance = nodes_[right].bounds.importance(origin);
+    const auto sum = left_importance + right_importance;
+    if (sum <= 0) return 0;
+
+    if ((bit_trail >> depth) & 1) {
+      ret *= right_importance / sum;
+      i = right;
+    } else {
+      ret *= left_importance / sum;
+      i = left;
+    }
+  }
+  assert(nodes_[i].index == index);
+  return ret;
+}
+
+double LightSampler::pdf_value(Point3F const &origin,
+                               Vec3F const &direction) const
+{
+  if (nodes_.empty() || direction.length_squared() == 0) return 0;
+
+  // Only the emitters intersected by the direction contribute
+  Ray ray(origin, direction);
+  int stack[LIGHT_BVH_STACK_SIZE];
+  int top = 0;
+  stack[top++] = 0;
+  double ret = 0;
+
+  while (top > 0) {
+    const int i = stack[--top];
+    auto const &node = nodes_[i];
+    if (!node.bounds.box.hit(ray, 0.001, inf)) continue;
+
+    if (node.is_leaf) {
+      const auto pdf = emitters_[node.index].shape->pdf_value(origin, direction);
+      if (pdf > 0) ret += pmf(origin, node.index) * pdf;
+    } else {
+      stack[top++] = node.index;
+      stack[top++] = i + 1;
+    }
+  }
+  return ret;
+}
+
+Vec3F LightSampler::random_direction(Point3F const &origin) const
+{
+  const int index = sample(origin, sample_1d());
+  // The pdf of zero direction is 0, it is discarded
+  if (index < 0) return {0, 0, 0};
+  return emitters_[index].shape->random_direction(origin);
+}
@@ -0,0 +1,121 @@
+#ifndef RT_LIGHT_SAMPLER_HH__
+#define RT_LIGHT_SAMPLER_HH__
+
+#include <vector>
+
+#include "alias_table.hh"
+#include "../shape/shape.hh"
+
+namespace rt {
+
+/**
+ * The registry of emitters for light sampling(next event estimation)
+ *
+ * Only the shapes whose Material::is_emissive() is true are registered,
+ * unless the weights of the shapes are given(e.g. the transmissive shapes
+ * sampled to find the caustics).
+ * Choosing an emitter is O(1)(alias table weighted by power) or O(log n)
+ * (light BVH), instead of O(n) of ShapeList.
+ * pdf_value() only visits the emitters intersected by the direction, they
+ * are found by the BVH over the emitters.
+ *
+ * It is a Shape, so it can be passed as the lights of ray_color().
+ */
+class LightSampler : public Shape {
+ public:
+  enum Strategy {
+    // Probability is proportional to the power
+    POWER,
+    // Probability is proportional to the importance of the light BVH node
+    // at the shading point(power, distance and orientation)
+    LIGHT_BVH,
+  };
+
+  explicit LightSampler(std::vector<ShapeSPtr> const &shapes,
+                        Strategy strategy = POWER);
+
+  /**
+   * Register all the \p shapes, the \p weights are used as the power
+   * \param weights The weights of shapes, the shape of weight 0 is skipped.
+   *                The importance of light BVH is about the solid angle if
+   *                the weight is the area.
+   *                The shapes are seen from all directions.
+   */
+  LightSampler(std::vector<ShapeSPtr> const &shapes,
+               std::vector<double> const &weights, Strategy strategy);
+
+  bool intersect(Ray const &ray, double tmin, double tmax,
+                 HitInfo &info) const override;
+  bool get_bounding_box(Aabb &output_box) const override;
+
+  double pdf_value(Point3F const &origin,
+                   Vec3F const &direction) const override;
+  Vec3F random_direction(Point3F const &origin) const override;
+
+  /**
+   * Choose an emitter
+   * \param u Uniform random number in [0, 1)
+   * \return The index of emitter, -1 if no emitter can contribute
+   */
+  int sample(Point3F const &origin, double u) const;
+
+  /**
+   * The probability of choosing the \p index-th emitter at the \p origin
+   */
+  double pmf(Point3F const &origin, int index) const;
+
+  size_t size() const noexcept { return emitters_.size(); }
+  bool empty() const noexcept { return emitters_.empty(); }
+  Strategy strategy() const noexcept { return strategy_; }
+  ShapeSPtr const &emitter(int index) const { return emitters_[index].shape; }
+  double power(int index) const { return emitters_[index].power; }
+
+ private:
+  /**
+   * The bounds of emitters:
+   * position(box), power and the cone of emission directions
+   */
+  struct LightBounds {
+    Aabb box;
+    double power = 0;
+    Vec3F axis{0, 0, 1};
+    double cos_theta = -1; // -1 means all directions
+
+    double importance(Point3F const &p) const noexcept;
+    static LightBounds merge(LightBounds const &a, LightBounds const &b);
+  };
+
+  struct Emitter {
+    ShapeSPtr shape;
+    double power;
+    LightBounds bounds;
+    // The path from the root to the leaf(1 means right child)
+    uint64_t bit_trail;
+  };
+
+  struct Node {
+    LightBounds bounds;
+    // Interior node: the right child(the left one is the next node)
+    // Leaf: the index of emitter
+    int index;
+    bool is_leaf;
+  };
+
+  /**
+   * \param one_sided Whether the shape only emits toward its normal(the
+   *                  emission cone is its normal bounds)
+   */
+  void add(ShapeSPtr const &shape, double power, bool one_sided);
+  void build();
+  int build(std::vector<int> &indices, size_t begin, size_t end,
+            uint64_t bit_trail, int depth);
+
+  std::vector<Emitter> emitters_;
+  std::vector<Node> nodes_;
+  AliasTable alias_table_;
+  Strategy strategy_;
+};
+
+} // namespace rt
+
+#endif
@@ -2,8 +2,9 @@
 
 #include <algorithm>
 
+#include "sampler.hh"
+
 using namespace rt;
-using namespace util;
 
 double MixturePdf::value(const Vec3F &dir) const
 {
@@ -12,7 +13,7 @@ double MixturePdf::value(const Vec3F &dir) const
 
 Vec3F MixturePdf::generate() const
 {
-  if (random_double() < 0.5)
+  if (sample_1d() < 0.5)
     return pdfs_[0]->generate();
   return pdfs_[1]->generate();
 }
@@ -10,7 +10,7 @@ namespace rt {
 
 class MixturePdf : public Pdf {
  public:
-  explicit MixturePdf(Pdf *p0, Pdf *p1)
+  explicit MixturePdf(Pdf const *p0, Pdf const *p1)
   {
     pdfs_[0] = p0;
     pdfs_[1] = p1;
@@ -20,7 +20,7 @@ class MixturePdf : public Pdf {
   virtual Vec3F generate() const;
 
  private:
-  Pdf* pdfs_[2];
+  Pdf const *pdfs_[2];
 };
 
 } // namespace rt
@@ -1,37 +1,50 @@
 #include "sample.hh"
 
-#include "../util/random.hh"
+#include "sampler.hh"
+#include "../gm/fast_math.hh"
 
 using namespace gm;
-using namespace util;
 
 namespace rt {
 
 Vec3F cosine_direction_sample()
 {
-  const auto r1 = random_double();
-  const auto r2 = random_double();
+  double r1, r2;
+  sample_2d(r1, r2);
   const auto sqrt_r2 = sqrt(r2);
 
-  auto phi = 2 * pi * r1;
+  double sin_phi, cos_phi;
+  fast_sincos(2 * pi * r1, sin_phi, cos_phi);
   return {
-      cos(phi) * sqrt_r2,
-      sin(phi) * sqrt_r2,
+      cos_phi * sqrt_r2,
+      sin_phi * sqrt_r2,
       sqrt(1 - r2),
   };
 }
 
 Vec3F sphere_direction_sample(double radius, double distance_squared)
 {
-  const auto r1 = random_double();
-  const auto r2 = random_double();
+  double r1, r2;
+  sample_2d(r1, r2);
   auto z = 1 + r2 * (sqrt(1 - radius * radius / distance_squared) - 1);
-  const auto phi = 2 * pi * r1;
+  double sin_phi, cos_phi;
+  fast_sincos(2 * pi * r1, sin_phi, cos_phi);
   auto sin_theta = sqrt(1 - z * z);
-  const auto x = cos(phi) * sin_theta;
-  const auto y = sin(phi) * sin_theta;
+  const auto x = cos_phi * sin_theta;
+  const auto y = sin_phi * sin_theta;
   // 此时，center_ - origin就是旋转轴(局部坐标系的z轴)
   return {x, y, z};
 }
 
+Vec3F uniform_sphere_sample()
+{
+  double r1, r2;
+  sample_2d(r1, r2);
+  const auto z = 1 - 2 * r1;
+  const auto r = sqrt(std::max(0., 1 - z * z));
+  double sin_phi, cos_phi;
+  fast_sincos(2 * pi * r2, sin_phi, cos_phi);
+  return {r * cos_phi, r * sin_phi, z};
+}
+
 } // namespace rt
@@ -9,6 +9,9 @@ Vec3F cosine_direction_sample();
 
 Vec3F sphere_direction_sample(double radius, double distance_squared);
 
+// Uniform on the unit sphere
+Vec3F uniform_sphere_sample();
+
 }
 
 #endif
\ No newline at end of file
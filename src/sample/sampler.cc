@@ -0,0 +1,263 @@
+#include "sampler.hh"
+
+#include <cmath>
+
+#include "blue_noise.hh"
+#include "../util/random.hh"
+
+using namespace rt;
+using namespace util;
+
+// 2^-32
+#define UINT32_TO_UNIT 2.3283064365386963e-10
+// The largest double below 1
+#define ONE_MINUS_EPSILON 0x1.fffffffffffffp-1
+
+static inline double to_unit(uint32_t x) noexcept
+{
+  return std::min(x * UINT32_TO_UNIT, ONE_MINUS_EPSILON);
+}
+
+static inline uint64_t hash(uint64_t a, uint64_t b, uint64_t c) noexcept
+{
+  return mix_seed(mix_seed(a, b), c);
+}
+
+static inline uint32_t reverse_bits(uint32_t x) noexcept
+{
+  x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+  x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+  x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+  x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+  return (x >> 16) | (x << 16);
+}
+
+/**
+ * The bijection of [0, n) chosen by the \p seed
+ * \see Kensler. Correlated Multi-Jittered Sampling. 2013
+ */
+static uint32_t permute(uint32_t i, uint32_t n, uint32_t seed) noexcept
+{
+  uint32_t w = n - 1;
+  w |= w >> 1;
+  w |= w >> 2;
+  w |= w >> 4;
+  w |= w >> 8;
+  w |= w >> 16;
+  do {
+    i ^= seed;
+    i *= 0xe170893d;
+    i ^= seed >> 16;
+    i ^= (i & w) >> 4;
+    i ^= seed >> 8;
+    i *= 0x0929eb3f;
+    i ^= seed >> 23;
+    i ^= (i & w) >> 1;
+    i *= 1 | seed >> 27;
+    i *= 0x6935fa69;
+    i ^= (i & w) >> 11;
+    i *= 0x74dcb303;
+    i ^= (i & w) >> 2;
+    i *= 0x9e501cc3;
+    i ^= (i & w) >> 2;
+    i *= 0xc860a3df;
+    i &= w;
+    i ^= i >> 5;
+  } while (i >= n);
+  return (i + seed) % n;
+}
+
+/**
+ * Owen scrambling of the bits(from the highest) by hashing
+ * \see Burley. Practical Hash-based Owen Scrambling. 2020
+ */
+static inline uint32_t nested_uniform_scramble(uint32_t x, uint32_t seed) noexcept
+{
+  x = reverse_bits(x);
+  // Laine-Karras permutation, a bit only depends on the lower bits
+  x += seed;
+  x ^= x * 0x6c50b47cu;
+  x ^= x * 0xb82f1e52u;
+  x ^= x * 0xc7afe638u;
+  x ^= x * 0x8d22f6e6u;
+  return reverse_bits(x);
+}
+
+// The first dimension of Sobol is the van der Corput sequence
+static inline uint32_t sobol0(uint32_t index) noexcept
+{
+  return reverse_bits(index);
+}
+
+// The second dimension(primitive polynomial x + 1)
+static inline uint32_t sobol1(uint32_t index) noexcept
+{
+  uint32_t ret = 0;
+  for (uint32_t v = 1u << 31; index != 0; index >>= 1, v ^= v >> 1) {
+    if (index & 1) ret ^= v;
+  }
+  return ret;
+}
+
+/*--------------------------------------------------*/
+/* Sampler                                          */
+/*--------------------------------------------------*/
+
+void Sampler::generate_2d(int dimension, double &u, double &v)
+{
+  u = generate_1d(dimension);
+  v = generate_1d(dimension + 1);
+}
+
+double IndependentSampler::generate_1d(int dimension)
+{
+  return random_double();
+}
+
+/*--------------------------------------------------*/
+/* StratifiedSampler                                */
+/*--------------------------------------------------*/
+
+StratifiedSampler::StratifiedSampler(int sample_per_pixel, uint64_t seed)
+  : sample_per_pixel_(std::max(1, sample_per_pixel))
+  , seed_(seed)
+{
+  // The grid covers all samples, some strata are empty if it isn't a square
+  x_strata_ = std::max(1, (int)sqrt(sample_per_pixel_));
+  y_strata_ = (sample_per_pixel_ + x_strata_ - 1) / x_strata_;
+}
+
+double StratifiedSampler::generate_1d(int dimension)
+{
+  const auto h = hash(seed_, ((uint64_t)x_ << 32) | (uint32_t)y_, dimension);
+  const auto stratum = permute(index_ % sample_per_pixel_, sample_per_pixel_,
+                               (uint32_t)h);
+  const auto jitter = to_unit(uint32_t(mix_seed(h, index_) >> 32));
+  return std::min((stratum + jitter) / sample_per_pixel_, ONE_MINUS_EPSILON);
+}
+
+void StratifiedSampler::generate_2d(int dimension, double &u, double &v)
+{
+  const int cell_num = x_strata_ * y_strata_;
+  const auto h = hash(seed_, ((uint64_t)x_ << 32) | (uint32_t)y_, dimension);
+  const auto cell = permute(index_ % cell_num, cell_num, (uint32_t)h);
+  const auto jitter = mix_seed(h, index_);
+  u = std::min((cell % x_strata_ + to_unit(uint32_t(jitter))) / x_strata_,
+               ONE_MINUS_EPSILON);
+  v = std::min((cell / x_strata_ + to_unit(uint32_t(jitter >> 32))) / y_strata_,
+               ONE_MINUS_EPSILON);
+}
+
+/*--------------------------------------------------*/
+/* SobolSampler                                     */
+/*--------------------------------------------------*/
+
+uint32_t SobolSampler::scramble_seed(int dimension) const noexcept
+{
+  return (uint32_t)hash(seed_, ((uint64_t)x_ << 32) | (uint32_t)y_, dimension);
+}
+
+double SobolSampler::generate_1d(int dimension)
+{
+  const auto seed = scramble_seed(dimension);
+  const auto index = nested_uniform_scramble((uint32_t)index_, seed);
+  return to_unit(nested_uniform_scramble(sobol0(index), (uint32_t)mix_seed(seed, 0)));
+}
+
+void SobolSampler::generate_2d(int dimension, double &u, double &v)
+{
+  const auto seed = scramble_seed(dimension);
+  const auto index = nested_uniform_scramble((uint32_t)index_, seed);
+  u = to_unit(nested_uniform_scramble(sobol0(index), (uint32_t)mix_seed(seed, 0)));
+  v = to_unit(nested_uniform_scramble(sobol1(index), (uint32_t)mix_seed(seed, 1)));
+}
+
+/*--------------------------------------------------*/
+/* BlueNoiseSampler                                 */
+/*--------------------------------------------------*/
+
+BlueNoiseSampler::BlueNoiseSampler(uint64_t seed)
+  : SobolSampler(seed)
+{
+  // Generate the mask before rendering
+  blue_noise(0, 0);
+}
+
+uint32_t BlueNoiseSampler::scramble_seed(int dimension) const noexcept
+{
+  // The same points in all pixels
+  return (uint32_t)mix_seed(seed_, dimension);
+}
+
+double BlueNoiseSampler::shift(int dimension) const noexcept
+{
+  // Every dimension uses a different toroidal offset of the mask
+  const auto h = mix_seed(seed_ ^ 0xb1e5eull, dimension);
+  return blue_noise(x_ + int(h % BLUE_NOISE_MASK_SIZE),
+                    y_ + int((h >> 32) % BLUE_NOISE_MASK_SIZE));
+}
+
+static inline double wrap(double x) noexcept
+{
+  return std::min(x >= 1 ? x - 1 : x, ONE_MINUS_EPSILON);
+}
+
+double BlueNoiseSampler::generate_1d(int dimension)
+{
+  return wrap(SobolSampler::generate_1d(dimension) + shift(dimension));
+}
+
+void BlueNoiseSampler::generate_2d(int dimension, double &u, double &v)
+{
+  SobolSampler::generate_2d(dimension, u, v);
+  u = wrap(u + shift(dimension));
+  v = wrap(v + shift(dimension + 1));
+}
+
+std::unique_ptr<Sampler> rt::make_sampler(SamplerType type,
+                                          int sample_per_pixel, uint64_t seed)
+{
+  switch (type) {
+    case SAMPLER_STRATIFIED:
+      return std::make_unique<StratifiedSampler>(sample_per_pixel, seed);
+    case SAMPLER_SOBOL:
+      return std::make_unique<SobolSampler>(seed);
+    case SAMPLER_BLUE_NOISE:
+      return std::make_unique<BlueNoiseSampler>(seed);
+    default:
+      return std::make_unique<IndependentSampler>();
+  }
+}
+
+/*--------------------------------------------------*/
+/* The sampler of current thread                    */
+/*--------------------------------------------------*/
+
+static thread_local Sampler *tls_sampler = nullptr;
+
+void rt::set_thread_sampler(Sampler *sampler) noexcept
+{
+  tls_sampler = sampler;
+}
+
+Sampler *rt::thread_sampler() noexcept { return tls_sampler; }
+
+double rt::sample_1d()
+{
+  return tls_sampler ? tls_sampler->get_1d() : random_double();
+}
+
+void rt::sample_2d(double &u, double &v)
+{
+  if (tls_sampler) {
+    tls_sampler->get_2d(u, v);
+  } else {
+    u = random_double();
+    v = random_double();
+  }
+}
+
+void rt::set_sample_dimension(int dimension) noexcept
+{
+  if (tls_sampler) tls_sampler->set_dimension(dimension);
+}
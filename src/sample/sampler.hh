@@ -0,0 +1,165 @@
+#ifndef RT_SAMPLER_HH__
+#define RT_SAMPLER_HH__
+
+#include <memory>
+#include <stdint.h>
+
+namespace rt {
+
+enum SamplerType {
+  SAMPLER_INDEPENDENT = 0,
+  SAMPLER_STRATIFIED,
+  SAMPLER_SOBOL,
+  SAMPLER_BLUE_NOISE,
+};
+
+/**
+ * The source of the random numbers of a path
+ *
+ * The numbers are requested by dimension: the n-th number of the k-th
+ * sample in a pixel is taken from the n-th dimension of the k-th point of
+ * a (low-discrepancy) sequence. The same dimension must be used for the same
+ * decision(e.g. the pixel position, the light selection of the 2nd bounce)
+ * to benefit from the stratification, set_dimension() skips to a fixed
+ * dimension whatever the previous events consumed.
+ */
+class Sampler {
+ public:
+  virtual ~Sampler() = default;
+
+  /**
+   * Start the \p index-th sample of the pixel(x, y), the dimension is reset
+   * to 0
+   */
+  void start_pixel_sample(int x, int y, int index) noexcept
+  {
+    x_ = x;
+    y_ = y;
+    index_ = index;
+    dimension_ = 0;
+  }
+
+  void set_dimension(int dimension) noexcept { dimension_ = dimension; }
+  int dimension() const noexcept { return dimension_; }
+
+  /**
+   * \return Uniform random number in [0, 1)
+   */
+  double get_1d() { return generate_1d(dimension_++); }
+
+  /**
+   * Two dimensions which are stratified jointly
+   */
+  void get_2d(double &u, double &v)
+  {
+    generate_2d(dimension_, u, v);
+    dimension_ += 2;
+  }
+
+ protected:
+  virtual double generate_1d(int dimension) = 0;
+  virtual void generate_2d(int dimension, double &u, double &v);
+
+  int x_ = 0;
+  int y_ = 0;
+  int index_ = 0;
+  int dimension_ = 0;
+};
+
+/**
+ * util::random_double()
+ */
+class IndependentSampler : public Sampler {
+ protected:
+  double generate_1d(int dimension) override;
+};
+
+/**
+ * Jittered strata: a dimension(pair) is divided into sample_per_pixel
+ * strata, the samples of a pixel take them in a random order
+ */
+class StratifiedSampler : public Sampler {
+ public:
+  StratifiedSampler(int sample_per_pixel, uint64_t seed);
+
+ protected:
+  double generate_1d(int dimension) override;
+  void generate_2d(int dimension, double &u, double &v) override;
+
+ private:
+  int sample_per_pixel_;
+  int x_strata_;
+  int y_strata_;
+  uint64_t seed_;
+};
+
+/**
+ * Owen-scrambled Sobol sequence
+ *
+ * Every dimension pair uses the first two dimensions of Sobol, the order of
+ * the points is shuffled per pixel and dimension so that the pairs are
+ * decorrelated(padding). The first 2^k points of a pair are a (0, k, 2)-net.
+ * \see Burley. Practical Hash-based Owen Scrambling. 2020
+ */
+class SobolSampler : public Sampler {
+ public:
+  explicit SobolSampler(uint64_t seed)
+    : seed_(seed)
+  {
+  }
+
+ protected:
+  double generate_1d(int dimension) override;
+  void generate_2d(int dimension, double &u, double &v) override;
+
+  // The seed of the scrambling of a dimension
+  virtual uint32_t scramble_seed(int dimension) const noexcept;
+
+  uint64_t seed_;
+};
+
+/**
+ * The same Owen-scrambled Sobol points in all pixels shifted by a blue
+ * noise mask(Cranley-Patterson rotation), the error of neighbouring pixels
+ * is negatively correlated and looks like blue noise instead of white noise.
+ * \see Georgiev and Fajardo. Blue-noise Dithered Sampling. 2016
+ */
+class BlueNoiseSampler : public SobolSampler {
+ public:
+  explicit BlueNoiseSampler(uint64_t seed);
+
+ protected:
+  double generate_1d(int dimension) override;
+  void generate_2d(int dimension, double &u, double &v) override;
+
+  uint32_t scramble_seed(int dimension) const noexcept override;
+
+ private:
+  double shift(int dimension) const noexcept;
+};
+
+std::unique_ptr<Sampler> make_sampler(SamplerType type, int sample_per_pixel,
+                                      uint64_t seed);
+
+/*--------------------------------------------------*/
+/* The sampler of current thread                    */
+/*--------------------------------------------------*/
+
+/**
+ * The sample_1d()/sample_2d() of current thread are taken from the
+ * \p sampler, util::random_double() is used if it is null(by default)
+ */
+void set_thread_sampler(Sampler *sampler) noexcept;
+Sampler *thread_sampler() noexcept;
+
+double sample_1d();
+void sample_2d(double &u, double &v);
+
+/**
+ * \see Sampler::set_dimension()
+ */
+void set_sample_dimension(int dimension) noexcept;
+
+} // namespace rt
+
+#endif
@@ -0,0 +1,105 @@
+#include "spherical_rect.hh"
+
+#include <cmath>
+
+#include "../gm/fast_math.hh"
+#include "../gm/util.hh"
+
+using namespace rt;
+using namespace gm;
+
+// The solid angle below it is computed with catastrophic cancellation
+#define SPHERICAL_RECT_MIN_SOLID_ANGLE 1e-4
+
+SphericalRect::SphericalRect(Point3F const &origin, Point3F const &corner,
+                             Vec3F const &ex, Vec3F const &ey) noexcept
+  : origin_(origin)
+  , corner_(corner)
+  , ex_(ex)
+  , ey_(ey)
+{
+  const auto ex_length = ex.length();
+  const auto ey_length = ey.length();
+  x_ = ex / ex_length;
+  y_ = ey / ey_length;
+  z_ = cross(x_, y_);
+
+  const auto d = corner - origin;
+  x0_ = dot(d, x_);
+  y0_ = dot(d, y_);
+  z0_ = dot(d, z_);
+  if (z0_ > 0) {
+    z0_ = -z0_;
+    z_ = -z_;
+  }
+  x1_ = x0_ + ex_length;
+  y1_ = y0_ + ey_length;
+
+  // The origin is on the plane of rectangle
+  if (z0_ == 0) {
+    b0_ = b1_ = k_ = solid_angle_ = 0;
+    return;
+  }
+
+  const Vec3F v00(x0_, y0_, z0_);
+  const Vec3F v01(x0_, y1_, z0_);
+  const Vec3F v10(x1_, y0_, z0_);
+  const Vec3F v11(x1_, y1_, z0_);
+  // The normals of the planes through the origin and the edges
+  const auto n0 = cross(v00, v10).normalize();
+  const auto n1 = cross(v10, v11).normalize();
+  const auto n2 = cross(v11, v01).normalize();
+  const auto n3 = cross(v01, v00).normalize();
+
+  // The internal angles of the spherical rectangle
+  const auto g0 = fast_acos(-dot(n0, n1));
+  const auto g1 = fast_acos(-dot(n1, n2));
+  const auto g2 = fast_acos(-dot(n2, n3));
+  const auto g3 = fast_acos(-dot(n3, n0));
+
+  b0_ = n0.z;
+  b1_ = n2.z;
+  k_ = 2 * pi - g2 - g3;
+  solid_angle_ = std::max(0., g0 + g1 - k_);
+}
+
+bool SphericalRect::area_sampling() const noexcept
+{
+  return !(solid_angle_ >= SPHERICAL_RECT_MIN_SOLID_ANGLE);
+}
+
+Point3F SphericalRect::sample(double u, double v) const noexcept
+{
+  if (area_sampling()) return corner_ + ex_ * u + ey_ * v;
+
+  // Choose the x by the area(solid angle) on the left
+  const auto au = u * solid_angle_ + k_;
+  double sin_au, cos_au;
+  fast_sincos(au, sin_au, cos_au);
+  const auto fu = (cos_au * b0_ - b1_) / sin_au;
+  auto cu = 1 / sqrt(fu * fu + b0_ * b0_) * (fu > 0 ? 1 : -1);
+  cu = clamp(cu, -1, 1);
+  const auto xu = clamp(-(cu * z0_) / sqrt(1 - cu * cu), x0_, x1_);
+
+  // Then the y is uniform in the solid angle of the vertical segment
+  const auto d = sqrt(xu * xu + z0_ * z0_);
+  const auto h0 = y0_ / sqrt(d * d + y0_ * y0_);
+  const auto h1 = y1_ / sqrt(d * d + y1_ * y1_);
+  const auto hv = h0 + v * (h1 - h0);
+  const auto hv2 = hv * hv;
+  const auto yv = hv2 < 1 - epsilon ? (hv * d) / sqrt(1 - hv2) : y1_;
+
+  return origin_ + x_ * xu + y_ * yv + z_ * z0_;
+}
+
+double SphericalRect::pdf(Point3F const &p) const noexcept
+{
+  if (!area_sampling()) return 1 / solid_angle_;
+
+  const auto direction = p - origin_;
+  const auto distance_squared = direction.length_squared();
+  const auto cos_theta = fabs(dot(direction, z_)) / sqrt(distance_squared);
+  const auto area = ex_.length() * ey_.length();
+  if (cos_theta <= 0 || area <= 0) return 0;
+  return distance_squared / (area * cos_theta);
+}
@@ -0,0 +1,59 @@
+#ifndef RT_SPHERICAL_RECT_HH__
+#define RT_SPHERICAL_RECT_HH__
+
+#include "../gm/point.hh"
+#include "../gm/vec.hh"
+
+namespace rt {
+
+/**
+ * The rectangle {corner + s * ex + t * ey | s, t in [0, 1]} projected on the
+ * unit sphere around the origin(ex and ey are orthogonal)
+ *
+ * Sampling it is uniform in solid angle, so the variance doesn't grow at
+ * grazing angles or near the rectangle like the area sampling.
+ * If the solid angle is too small to be computed stably, the area sampling
+ * is used instead, sample() and pdf() are always consistent.
+ *
+ * \see Ureña, Fajardo and King. An Area-Preserving Parametrization for
+ *      Spherical Rectangles. 2013
+ */
+class SphericalRect {
+ public:
+  SphericalRect(gm::Point3F const &origin, gm::Point3F const &corner,
+                gm::Vec3F const &ex, gm::Vec3F const &ey) noexcept;
+
+  double solid_angle() const noexcept { return solid_angle_; }
+
+  /**
+   * \param u, v Uniform random numbers in [0, 1)
+   * \return The point on the rectangle
+   */
+  gm::Point3F sample(double u, double v) const noexcept;
+
+  /**
+   * The pdf(in solid angle) of the direction toward \p p
+   * \param p The point on the rectangle
+   */
+  double pdf(gm::Point3F const &p) const noexcept;
+
+ private:
+  bool area_sampling() const noexcept;
+
+  gm::Point3F origin_;
+  gm::Point3F corner_;
+  gm::Vec3F ex_;
+  gm::Vec3F ey_;
+  // The local frame: x, y along the edges and z points away from the
+  // rectangle(the rectangle is at z = z0_ < 0)
+  gm::Vec3F x_;
+  gm::Vec3F y_;
+  gm::Vec3F z_;
+  double x0_, y0_, z0_, x1_, y1_;
+  double b0_, b1_, k_;
+  double solid_angle_;
+};
+
+} // namespace rt
+
+#endif
@@ -0,0 +1,273 @@
+#include "sequence.hh"
+
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "pixel_kernel.hh"
+#include "rt/animation.hh"
+#include "rt/camera.hh"
+#include "rt/integrator.hh"
+#include "rt/scene_editor.hh"
+#include "rt/stats.hh"
+#include "sample/sampler.hh"
+#include "img/hdr_image.hh"
+#include "img/image_stream_writer.hh"
+#include "img/png_encoder.hh"
+#include "img/tga_image.hh"
+#include "util/random.hh"
+#include "util/worker_pool.hh"
+
+// The rows of a render block of the frame
+#define SEQUENCE_BLOCK_HEIGHT 16
+
+using namespace util;
+using namespace gm;
+using namespace img;
+
+namespace ktm = std::chrono;
+
+namespace rt {
+
+std::string sequence_frame_path(std::string_view path, int frame)
+{
+  char number[32];
+  // %d or %0Nd
+  for (auto pos = path.find('%'); pos != path.npos;
+       pos = path.find('%', pos + 1)) {
+    auto end = pos + 1;
+    int width = 0;
+    if (end < path.size() && path[end] == '0') {
+      while (++end < path.size() && path[end] >= '0' && path[end] <= '9') {
+        width = width * 10 + (path[end] - '0');
+      }
+    }
+    if (end >= path.size() || path[end] != 'd') continue;
+
+    snprintf(number, sizeof number, "%0*d", width, frame);
+    std::string ret(path.substr(0, pos));
+    ret += number;
+    ret += path.substr(end + 1);
+    return ret;
+  }
+
+  auto dot_pos = path.rfind('.');
+  auto slash_pos = path.rfind('/');
+  if (dot_pos == path.npos ||
+      (slash_pos != path.npos && dot_pos < slash_pos)) {
+    dot_pos = path.size();
+  }
+  snprintf(number, sizeof number, "_%04d", frame);
+  std::string ret(path.substr(0, dot_pos));
+  ret += number;
+  ret += path.substr(dot_pos);
+  return ret;
+}
+
+namespace {
+
+// The image of a frame, one is written while the other is rendered
+struct FrameBuffer {
+  TgaImage image;
+  HdrImage hdr_image;
+  std::string path;
+};
+
+} // namespace
+
+int render_sequence(Option const &option, Scene &scene)
+{
+  std::string_view path_view(option.path);
+  const bool hdr_output = is_hdr_path(path_view);
+  if (!hdr_output && !path_view.ends_with(".png") &&
+      !path_view.ends_with(".tga")) {
+    fprintf(stderr, "The valid format of frames is "
+                    "*.png/*.tga/*.hdr/*.pfm/*.exr\n");
+    return EXIT_FAILURE;
+  }
+  if (option.stream_tile > 0 || option.preview_port > 0 ||
+      option.heatmap != HEATMAP_NONE) {
+    fprintf(stderr, "The stream, preview and heatmap are ignored by the "
+                    "sequence\n");
+  }
+
+  auto start_of_setup = ktm::steady_clock::now();
+  SceneEditor editor(scene);
+  const auto animation = builtin_animation(option.scene_id, scene, editor);
+
+  const int image_height = option.image_height;
+  const int image_width = (int)(scene.aspect_ratio * image_height);
+  const double gamma_exp = 1. / option.gamma;
+
+  std::vector<ImageTile> tiles;
+  for (int y = 0; y < image_height; y += SEQUENCE_BLOCK_HEIGHT) {
+    tiles.push_back(
+      {0, y, image_width, std::min(SEQUENCE_BLOCK_HEIGHT, image_height - y)});
+  }
+
+  FrameBuffer buffers[2];
+  for (auto &buffer : buffers) {
+    if (hdr_output) {
+      buffer.hdr_image = make_hdr_image(option.path, image_width, image_height);
+    }
+    else buffer.image = TgaImage(image_width, image_height);
+  }
+
+  const uint64_t sampler_seed =
+    option.seed != 0 ? option.seed
+                     : ((uint64_t)std::random_device{}() << 32) |
+                         std::random_device{}();
+  std::vector<std::unique_ptr<Sampler>> samplers;
+  for (int i = 0; i < option.thread_num; ++i) {
+    samplers.push_back(
+      make_sampler(option.sampler, option.sample_per_pixel, sampler_seed));
+  }
+
+  // Declared after the samplers, the threads exit before they are destroyed
+  WorkerPool workers(option.thread_num);
+  // The frame is encoded by one thread, the others are rendering
+  WorkerPool encoder(1);
+  std::atomic<bool> write_failed(false);
+
+  ktm::duration<double> setup_time = ktm::steady_clock::now() - start_of_setup;
+  printf("sequence: frames = [%d, %d), objects = %zu, animated = %zu, "
+         "setup %.3lf sec\n",
+         option.frame_begin, option.frame_end, editor.size(),
+         animation.object_num(), setup_time.count());
+
+  const auto samples_per_frame =
+    (double)image_width * image_height * option.sample_per_pixel;
+  ktm::duration<double> total_update(0);
+  ktm::duration<double> total_render(0);
+  ktm::duration<double> total_stall(0);
+  std::atomic<int64_t> total_encode_ns(0);
+  size_t total_refit_nodes = 0;
+  int rebuild_num = 0;
+
+  auto start_of_sequence = ktm::steady_clock::now();
+  for (int frame = option.frame_begin; frame < option.frame_end; ++frame) {
+    auto start_of_frame = ktm::steady_clock::now();
+    animation.apply(frame, scene, editor);
+    const auto update = editor.update();
+    total_refit_nodes += update.refit_nodes;
+    rebuild_num += update.rebuilt;
+
+    Camera camera(scene.lookfrom, scene.lookat, scene.aspect_ratio, scene.fov,
+                  1);
+    camera.set_aperture(0.0);
+    camera.set_shutter(scene.time0, scene.time1);
+    scene.pixel_spread_angle = camera.pixel_spread_angle(image_height);
+
+    // The buffer of frame - 2 is written before the frame - 1 is rendered
+    auto &buffer = buffers[(frame - option.frame_begin) & 1];
+    buffer.path = sequence_frame_path(option.path, frame);
+    auto start_of_render = ktm::steady_clock::now();
+
+    workers.Run(tiles.size(), [&, frame](size_t task_index, int thread_index) {
+      auto sampler = samplers[thread_index].get();
+      set_thread_sampler(sampler);
+      if (option.seed != 0) {
+        seed_random(mix_seed(mix_seed(option.seed, frame), task_index));
+      }
+
+      auto const &tile = tiles[task_index];
+      for (int j = tile.y; j < tile.y + tile.h; ++j) {
+        for (int i = tile.x; i < tile.x + tile.w; ++i) {
+          PixelSamples pixel;
+          render_pixel(camera, scene, *sampler, i, j, image_width,
+                       image_height, 0, option.sample_per_pixel, hdr_output,
+                       pixel);
+
+          if (hdr_output) {
+            set_hdr_pixel(buffer.hdr_image, i, j, pixel,
+                          option.sample_per_pixel);
+          } else {
+            buffer.image.SetPixel(
+              i, j,
+              compute_color(pixel.color, option.sample_per_pixel, gamma_exp));
+          }
+        }
+      }
+
+      stats_flush();
+      if (scene.texture_cache) scene.texture_cache->flush_thread_stats();
+    });
+
+    auto end_of_render = ktm::steady_clock::now();
+    // The previous frame must be written before its buffer is reused
+    encoder.Wait();
+    auto end_of_stall = ktm::steady_clock::now();
+    encoder.Submit(1, [&buffer, &option, hdr_output, &write_failed,
+                       &total_encode_ns](size_t, int) {
+      auto start_of_encode = ktm::steady_clock::now();
+      auto path = buffer.path.c_str();
+      bool ok;
+      if (hdr_output) {
+        ok = buffer.hdr_image.WriteTo(path, option.rle);
+      } else if (buffer.path.ends_with(".png")) {
+        ok = PngEncoder(1).WriteTo(buffer.image, path);
+      } else {
+        ok = buffer.image.WriteTo(path, option.rle, TgaImage::BOTTOM_LEFT, 1);
+      }
+      if (!ok) {
+        fprintf(stderr, "Failed to write %s\n", path);
+        write_failed.store(true, std::memory_order_relaxed);
+      }
+      total_encode_ns += ktm::duration_cast<ktm::nanoseconds>(
+                           ktm::steady_clock::now() - start_of_encode)
+                           .count();
+    });
+
+    ktm::duration<double> update_time = start_of_render - start_of_frame;
+    ktm::duration<double> render_time = end_of_render - start_of_render;
+    total_update += update_time;
+    total_render += render_time;
+    total_stall += end_of_stall - end_of_render;
+    printf("frame %d: update %.3lf ms(refit nodes = %zu%s), "
+           "render %.3lf sec, %.3lf Msamples/s\n",
+           frame, update_time.count() * 1e3, update.refit_nodes,
+           update.rebuilt ? ", rebuilt" : "", render_time.count(),
+           samples_per_frame / render_time.count() * 1e-6);
+    fflush(stdout);
+  }
+  auto start_of_last_write = ktm::steady_clock::now();
+  encoder.Wait();
+  total_stall += ktm::steady_clock::now() - start_of_last_write;
+
+  ktm::duration<double> total_time =
+    ktm::steady_clock::now() - start_of_sequence;
+  const int frame_num = option.frame_end - option.frame_begin;
+  printf("===== Sequence statistics =====\n");
+  printf("%-20s %20d\n", "frames", frame_num);
+  printf("%-20s %20.3lf\n", "total_sec", total_time.count());
+  printf("%-20s %20.3lf\n", "frames_per_sec", frame_num / total_time.count());
+  printf("%-20s %20.3lf\n", "msamples_per_sec",
+         samples_per_frame * frame_num / total_render.count() * 1e-6);
+  printf("%-20s %20.3lf\n", "update_ms_per_frame",
+         total_update.count() * 1e3 / frame_num);
+  printf("%-20s %20zu\n", "refit_nodes", total_refit_nodes);
+  printf("%-20s %20d\n", "rebuilds", rebuild_num);
+  // The encoding is hidden by the rendering except the stall
+  printf("%-20s %20.3lf\n", "encode_sec", (double)total_encode_ns.load() * 1e-9);
+  printf("%-20s %20.3lf\n", "encode_stall_sec", total_stall.count());
+
+  if (scene.texture_cache) {
+    scene.texture_cache->stats().Print(stdout);
+  }
+  if (stats_enabled()) {
+    auto stats = stats_collect();
+    stats.Print(stdout, total_render.count());
+    if (option.stats_path &&
+        !stats.WriteJson(option.stats_path, total_render.count())) {
+      return EXIT_FAILURE;
+    }
+  }
+  return write_failed.load() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+} // namespace rt
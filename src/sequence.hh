@@ -0,0 +1,37 @@
+#ifndef RT_SEQUENCE_HH__
+#define RT_SEQUENCE_HH__
+
+#include <string>
+#include <string_view>
+
+#include "option.hh"
+#include "rt/scene.hh"
+
+namespace rt {
+
+/**
+ * The path of the \p frame:
+ * The first %d(or %0Nd) of \p path is replaced by the frame number,
+ * otherwise _%04d is inserted before the extension.
+ */
+std::string sequence_frame_path(std::string_view path, int frame);
+
+/**
+ * Render the frames [option.frame_begin, option.frame_end) of the builtin
+ * animation of the \p scene
+ *
+ * Unlike rendering the frames by the separate processes, the scene, the
+ * render threads and the samplers are set up once:
+ * - The objects are moved by SceneEditor, the BVH is refit instead of being
+ *   built for every frame
+ * - The tiles of every frame are dispatched to the same WorkerPool
+ * - The frame is encoded and written by another thread while the next one is
+ *   rendered(double buffered)
+ *
+ * The preview, stream writer and heatmap are not supported.
+ */
+int render_sequence(Option const &option, Scene &scene);
+
+} // namespace rt
+
+#endif
@@ -1,6 +1,8 @@
 #include "box.hh"
 
 #include "../accelerate/aabb.hh"
+#include "../sample/sampler.hh"
+#include "../sample/spherical_rect.hh"
 #include "rect.hh"
 
 using namespace rt;
@@ -10,6 +12,7 @@ using namespace gm;
 Box::Box(Point3F const &bottom, Point3F const &top, MaterialSPtr const &material)
   : top_(top)
   , bottom_(bottom)
+  , material_(material)
 {
   faces_.add(make_shared<XyRect>(bottom.x, top.x, bottom.y, top.y, bottom.z, material));
   faces_.add(make_shared<XyRect>(bottom.x, top.x, bottom.y, top.y, top.z, material));
@@ -17,11 +20,23 @@ Box::Box(Point3F const &bottom, Point3F const &top, MaterialSPtr const &material
   faces_.add(make_shared<XzRect>(bottom.x, top.x, bottom.z, top.z, top.y, material));
   faces_.add(make_shared<YzRect>(bottom.y, top.y, bottom.z, top.z, bottom.x, material));
   faces_.add(make_shared<YzRect>(bottom.y, top.y, bottom.z, top.z, top.x, material));
+
+  const auto extent = top - bottom;
+  const Vec3F ex(extent.x, 0, 0);
+  const Vec3F ey(0, extent.y, 0);
+  const Vec3F ez(0, 0, extent.z);
+  face_geometry_[0] = {bottom, ex, ey, Vec3F(0, 0, -1)};
+  face_geometry_[1] = {bottom + ez, ex, ey, Vec3F(0, 0, 1)};
+  face_geometry_[2] = {bottom, ex, ez, Vec3F(0, -1, 0)};
+  face_geometry_[3] = {bottom + ey, ex, ez, Vec3F(0, 1, 0)};
+  face_geometry_[4] = {bottom, ey, ez, Vec3F(-1, 0, 0)};
+  face_geometry_[5] = {bottom + ex, ey, ez, Vec3F(1, 0, 0)};
 }
 
-bool Box::hit(Ray const &ray, double tmin, double tmax, HitRecord &record) const
+bool Box::intersect(Ray const &ray, double tmin, double tmax, HitInfo &info) const
 {
-  return faces_.hit(ray, tmin, tmax, record);
+  // The hit face fills the HitRecord
+  return faces_.intersect(ray, tmin, tmax, info);
 }
 
 bool Box::get_bounding_box(Aabb &bbox) const
@@ -29,3 +44,81 @@ bool Box::get_bounding_box(Aabb &bbox) const
   bbox = Aabb(bottom_, top_);
   return true;
 }
+
+double Box::area() const noexcept
+{
+  const auto extent = top_ - bottom_;
+  return 2 * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+int Box::visible_faces(Point3F const &origin, int *indices,
+                       double *weights) const
+{
+  const bool inside = origin.x > bottom_.x && origin.x < top_.x &&
+                      origin.y > bottom_.y && origin.y < top_.y &&
+                      origin.z > bottom_.z && origin.z < top_.z;
+  int n = 0;
+  for (int i = 0; i < 6; ++i) {
+    auto const &face = face_geometry_[i];
+    if (!inside && dot(origin - face.corner, face.normal) <= 0) continue;
+
+    // The solid angle(or its approximation if it is tiny)
+    SphericalRect srect(origin, face.corner, face.ex, face.ey);
+    const auto pdf = srect.pdf(face.corner + face.ex / 2 + face.ey / 2);
+    if (!(pdf > 0)) continue;
+    indices[n] = i;
+    weights[n] = 1 / pdf;
+    ++n;
+  }
+  return n;
+}
+
+double Box::pdf_value(Point3F const &origin, Vec3F const &direction) const
+{
+  int indices[6];
+  double weights[6];
+  const int n = visible_faces(origin, indices, weights);
+
+  double weight_sum = 0;
+  for (int i = 0; i < n; ++i) weight_sum += weights[i];
+  if (!(weight_sum > 0)) return 0;
+
+  // The box is convex, the direction hits only one visible face
+  for (int i = 0; i < n; ++i) {
+    auto const &face = face_geometry_[indices[i]];
+    const auto denom = dot(direction, face.normal);
+    if (denom == 0) continue;
+    const auto t = dot(face.corner - origin, face.normal) / denom;
+    if (t <= 0.001) continue;
+
+    const auto p = origin + direction * t;
+    const auto s = dot(p - face.corner, face.ex) / face.ex.length_squared();
+    const auto r = dot(p - face.corner, face.ey) / face.ey.length_squared();
+    if (s < 0 || s > 1 || r < 0 || r > 1) continue;
+
+    SphericalRect srect(origin, face.corner, face.ex, face.ey);
+    return weights[i] / weight_sum * srect.pdf(p);
+  }
+  return 0;
+}
+
+Vec3F Box::random_direction(Point3F const &origin) const
+{
+  int indices[6];
+  double weights[6];
+  const int n = visible_faces(origin, indices, weights);
+  if (n == 0) return {0, 0, 0};
+
+  double weight_sum = 0;
+  for (int i = 0; i < n; ++i) weight_sum += weights[i];
+
+  auto u = sample_1d() * weight_sum;
+  int i = 0;
+  for (; i < n - 1 && u >= weights[i]; ++i) u -= weights[i];
+
+  auto const &face = face_geometry_[indices[i]];
+  SphericalRect srect(origin, face.corner, face.ex, face.ey);
+  double s, t;
+  sample_2d(s, t);
+  return srect.sample(s, t) - origin;
+}
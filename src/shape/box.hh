@@ -13,12 +13,36 @@ class Box : public Shape {
  public:
   Box(gm::Point3F const &bottom, gm::Point3F const &top, MaterialSPtr const &material);
 
-  bool hit(Ray const &ray, double tmin, double tmax, HitRecord &record) const override;
+  bool intersect(Ray const &ray, double tmin, double tmax, HitInfo &info) const override;
   bool get_bounding_box(Aabb &bbox) const override;
+
+  /**
+   * Choose a face facing the origin(all faces if the origin is inside) by
+   * its solid angle, then sample the face uniformly in solid angle
+   */
+  double pdf_value(gm::Point3F const &origin,
+                   gm::Vec3F const &direction) const override;
+  gm::Vec3F random_direction(gm::Point3F const &origin) const override;
+
+  Material const *material() const noexcept override { return material_.get(); }
+  double area() const noexcept override;
  private:
+  struct Face {
+    gm::Point3F corner;
+    gm::Vec3F ex;
+    gm::Vec3F ey;
+    gm::Vec3F normal; // outward
+  };
+
+  // The faces can be seen from the origin and their weights
+  int visible_faces(gm::Point3F const &origin, int *indices,
+                    double *weights) const;
+
   gm::Point3F top_;
   gm::Point3F bottom_;
   ShapeList faces_;
+  Face face_geometry_[6];
+  MaterialSPtr material_;
 };
 
 }
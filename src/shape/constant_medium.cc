@@ -1,8 +1,9 @@
 #include "constant_medium.hh"
 
+#include "../gm/fast_math.hh"
 #include "../material/iostropic.hh"
-#include "../texture/solid_texture.hh"
 #include "../rt/hit_record.hh"
+#include "../rt/stats.hh"
 
 using namespace rt;
 using namespace std;
@@ -18,17 +19,26 @@ ConstantMedium::ConstantMedium(ShapeSPtr &&boundary, double density,
 }
 
 ConstantMedium::ConstantMedium(ShapeSPtr &&boundary, double density, Color albedo)
-  : ConstantMedium(std::move(boundary), density, make_shared<SolidTexture>(albedo))
+  : ConstantMedium(std::move(boundary), density, make_shared<Iostropic>(albedo))
 {
 }
 
-bool ConstantMedium::hit(Ray const &ray, double tmin, double tmax,
-                         HitRecord &record) const
+ConstantMedium::ConstantMedium(ShapeSPtr &&boundary, double density,
+                               MaterialSPtr phase_function)
+  : boundary_(std::move(boundary))
+  , density_(density)
+  , phase_function_(std::move(phase_function))
+{
+}
+
+bool ConstantMedium::intersect(Ray const &ray, double tmin, double tmax,
+                               HitInfo &info) const
 {
-  // 先获取boundary的两个交点上下文
-  HitRecord rec1, rec2;
-  if (!boundary_->hit(ray, -inf, inf, rec1)) return false;
-  if (!boundary_->hit(ray, rec1.t+0.0001, inf, rec2)) return false;
+  RT_STATS_INC(STATS_MEDIUM_TESTS);
+  // 先获取boundary的两个交点（只需要t）
+  HitInfo rec1, rec2;
+  if (!boundary_->intersect(ray, -inf, inf, rec1)) return false;
+  if (!boundary_->intersect(ray, rec1.t+0.0001, inf, rec2)) return false;
   
   // volume的第一个交点在tmin之后，比如ray.origin后面，tmin之后的距离舍去
   // 处理ray.origin在volume内的情形
@@ -43,17 +53,26 @@ bool ConstantMedium::hit(Ray const &ray, double tmin, double tmax,
   if (rec1.t < 0) rec1.t = 0;
   const auto ray_distance = ray.direction().length();
   const auto distance_inside_boundary = (rec2.t - rec1.t) * ray_distance;
-  const auto hit_distance = -(1 / density_) * log(random_double());
+  // 1 - u is in (0, 1], log(0) is avoided
+  const auto hit_distance = -(1 / density_) * fast_log(1 - random_double());
   // 当在boundary中的前进距离大于某个值时，发生散射
   if (hit_distance > distance_inside_boundary) return false;
 
-  record.t = rec1.t + hit_distance / ray_distance;
+  info.set(rec1.t + hit_distance / ray_distance, this);
+  return true;
+}
+
+void ConstantMedium::compute_surface_interaction(Ray const &ray,
+                                                 HitInfo const &info,
+                                                 HitRecord &record) const
+{
+  record.t = info.t;
   record.p = ray.at(record.t);
   record.material = phase_function_.get();
   record.normal = Vec3F(1, 0, 0); // 随意
   record.front_face = true; // 随意
-
-  return true;
+  record.set_uv(0, 0);
+  record.uv_scale = 0;
 }
 
 bool ConstantMedium::get_bounding_box(Aabb &output_box) const
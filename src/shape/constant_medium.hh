@@ -11,8 +11,13 @@ class ConstantMedium : public Shape {
  public:
   ConstantMedium(ShapeSPtr &&boundary, double density, TextureSPtr albedo);
   ConstantMedium(ShapeSPtr &&boundary, double density, Color albedo);
+  // The phase function is shared(e.g. interned by ResourceRegistry)
+  ConstantMedium(ShapeSPtr &&boundary, double density,
+                 MaterialSPtr phase_function);
 
-  virtual bool hit(Ray const &ray, double tmin, double tmax, HitRecord &record) const override;
+  virtual bool intersect(Ray const &ray, double tmin, double tmax, HitInfo &info) const override;
+  virtual void compute_surface_interaction(Ray const &ray, HitInfo const &info,
+                                           HitRecord &record) const override;
   virtual bool get_bounding_box(Aabb &output_box) const override;
  private:
   ShapeSPtr boundary_;
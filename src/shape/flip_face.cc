@@ -1,15 +1,25 @@
 #include "flip_face.hh"
 
 #include "../rt/hit_record.hh"
+#include "../rt/stats.hh"
 
 using namespace rt;
 
-bool FlipFace::hit(Ray const &ray, double tmin, double tmax, HitRecord &rec) const
+bool FlipFace::intersect(Ray const &ray, double tmin, double tmax, HitInfo &info) const
 {
-  if (!shape_->hit(ray, tmin, tmax, rec)) return false;
+  RT_STATS_INC(STATS_INSTANCE_TESTS);
+  if (!shape_->intersect(ray, tmin, tmax, info)) return false;
+  info.push_instance(this);
+  return true;
+}
+
+void FlipFace::compute_surface_interaction(Ray const &ray, HitInfo const &info,
+                                           HitRecord &rec) const
+{
+  auto inner_info = info.pop_instance();
+  inner_info.shape->compute_surface_interaction(ray, inner_info, rec);
   // FIXME flip normal
   rec.front_face = !rec.front_face;
-  return true;
 }
 
 bool FlipFace::get_bounding_box(Aabb &bbox) const
@@ -22,9 +22,29 @@ class FlipFace : public Shape {
     return shape_->random_direction(origin);
   }
 
-  virtual bool hit(Ray const &ray, double tmin, double tmax,
-                   HitRecord &rec) const override;
+  virtual bool intersect(Ray const &ray, double tmin, double tmax,
+                         HitInfo &info) const override;
+  virtual void compute_surface_interaction(Ray const &ray, HitInfo const &info,
+                                           HitRecord &rec) const override;
   virtual bool get_bounding_box(Aabb &bbox) const override;
+  bool get_motion_bounds(double time0, double time1, Aabb &box0,
+                         Aabb &box1) const override
+  {
+    return shape_->get_motion_bounds(time0, time1, box0, box1);
+  }
+
+  Material const *material() const noexcept override
+  {
+    return shape_->material();
+  }
+  double area() const noexcept override { return shape_->area(); }
+  // The emission(front face) is on the other side
+  bool normal_bounds(Vec3F &axis, double &cos_theta) const override
+  {
+    if (!shape_->normal_bounds(axis, cos_theta)) return false;
+    axis = -axis;
+    return true;
+  }
 
  private:
   ShapeSPtr shape_;
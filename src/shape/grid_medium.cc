@@ -0,0 +1,102 @@
+#include "grid_medium.hh"
+
+#include "../gm/fast_math.hh"
+#include "../material/material.hh"
+#include "../rt/hit_record.hh"
+#include "../rt/stats.hh"
+#include "../util/random.hh"
+
+using namespace rt;
+using namespace gm;
+using namespace util;
+
+GridMedium::GridMedium(std::shared_ptr<DensityGrid const> grid,
+                       double density_scale, MaterialSPtr phase_function)
+  : grid_(std::move(grid))
+  , density_scale_(density_scale)
+  , phase_function_(std::move(phase_function))
+{
+}
+
+static inline Vec3F reciprocal(Vec3F const &v) noexcept
+{
+  return {1 / v.x, 1 / v.y, 1 / v.z};
+}
+
+bool GridMedium::intersect(Ray const &ray, double tmin, double tmax,
+                           HitInfo &info) const
+{
+  RT_STATS_INC(STATS_MEDIUM_TESTS);
+  // The entry and exit of the boundary
+  if (!grid_->bounds().clip(ray.origin(), reciprocal(ray.direction()), tmin,
+                            tmax))
+    return false;
+
+  const auto ray_length = ray.direction().length();
+  double hit_t = -1;
+  grid_->traverse(
+    ray.origin(), ray.direction(), tmin, tmax,
+    [&](double t0, double t1, double majorant) {
+      const double sigma = majorant * density_scale_ * ray_length;
+      if (sigma <= 0) return true;
+
+      // The tentative collisions, the sampling restarts at the next cell
+      // (the exponential distribution is memoryless)
+      for (double t = t0;;) {
+        t -= fast_log(1 - random_double()) / sigma;
+        if (t >= t1) return true;
+        if (random_double() * majorant < grid_->density(ray.at(t))) {
+          hit_t = t;
+          return false;
+        }
+      }
+    });
+
+  if (hit_t < 0) return false;
+  info.set(hit_t, this);
+  return true;
+}
+
+double GridMedium::transmittance(Ray const &ray, double tmin,
+                                 double tmax) const
+{
+  if (!grid_->bounds().clip(ray.origin(), reciprocal(ray.direction()), tmin,
+                            tmax))
+    return 1;
+
+  const auto ray_length = ray.direction().length();
+  double ret = 1;
+  grid_->traverse(
+    ray.origin(), ray.direction(), tmin, tmax,
+    [&](double t0, double t1, double majorant) {
+      const double sigma = majorant * density_scale_ * ray_length;
+      if (sigma <= 0) return true;
+
+      for (double t = t0;;) {
+        t -= fast_log(1 - random_double()) / sigma;
+        if (t >= t1) return true;
+        ret *= 1 - grid_->density(ray.at(t)) / majorant;
+      }
+    });
+  return ret;
+}
+
+void GridMedium::compute_surface_interaction(Ray const &ray,
+                                             HitInfo const &info,
+                                             HitRecord &record) const
+{
+  record.t = info.t;
+  record.p = ray.at(record.t);
+  record.material = phase_function_.get();
+  // The normal is meaningless for the isotropic phase function
+  record.normal = Vec3F(1, 0, 0);
+  record.front_face = true;
+  record.set_uv(0, 0);
+  record.uv_scale = 0;
+}
+
+bool GridMedium::get_bounding_box(Aabb &output_box) const
+{
+  output_box = grid_->bounds();
+  return true;
+}
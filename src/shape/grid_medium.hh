@@ -0,0 +1,54 @@
+#ifndef RT_SHAPE_GRID_MEDIUM_HH__
+#define RT_SHAPE_GRID_MEDIUM_HH__
+
+#include "shape.hh"
+#include "../material/type.hh"
+#include "../volume/density_grid.hh"
+
+namespace rt {
+
+/**
+ * The heterogeneous medium whose density is given by a DensityGrid
+ *
+ * The scattering distance is sampled by delta tracking: the tentative
+ * collisions are sampled with the majorant of the cell, and accepted with
+ * probability density / majorant. The empty cells are skipped, so the cost
+ * depends on the optical thickness instead of the resolution.
+ * The boundary is the box of grid, the interval of the ray inside it is
+ * computed once by the slab test(ConstantMedium intersects its boundary
+ * twice).
+ *
+ * \see Novak et al. Monte Carlo Methods for Volumetric Light Transport
+ *      Simulation. 2018
+ */
+class GridMedium : public Shape {
+ public:
+  /**
+   * \param density_scale Multiplied to the density of grid
+   */
+  GridMedium(std::shared_ptr<DensityGrid const> grid, double density_scale,
+             MaterialSPtr phase_function);
+
+  bool intersect(Ray const &ray, double tmin, double tmax,
+                 HitInfo &info) const override;
+  void compute_surface_interaction(Ray const &ray, HitInfo const &info,
+                                   HitRecord &record) const override;
+  bool get_bounding_box(Aabb &output_box) const override;
+
+  /**
+   * Estimate the transmittance in (tmin, tmax) by ratio tracking,
+   * it has lower variance than the 0/1 estimate of delta tracking
+   */
+  double transmittance(Ray const &ray, double tmin, double tmax) const;
+
+  DensityGrid const &grid() const noexcept { return *grid_; }
+
+ private:
+  std::shared_ptr<DensityGrid const> grid_;
+  double density_scale_;
+  MaterialSPtr phase_function_;
+};
+
+} // namespace rt
+
+#endif
@@ -0,0 +1,95 @@
+#include "instance.hh"
+
+#include "../gm/transform.hh"
+#include "../rt/hit_record.hh"
+#include "../rt/stats.hh"
+
+using namespace rt;
+using namespace gm;
+
+Instance::Instance(ShapeSPtr shape)
+  : shape_(std::move(shape))
+{
+  has_bbox_ = shape_->get_bounding_box(local_bbox_);
+  set_transform({}, {0, 0, 0});
+}
+
+void Instance::set_transform(Degree const &rotation, Vec3F const &translation)
+{
+  rotation_ = rotation;
+  translation_ = translation;
+  is_rotated_ = rotation.x != 0 || rotation.y != 0 || rotation.z != 0;
+  rotate_mat_ = get_x_rotation_matrix(rotation.x) *
+                get_y_rotation_matrix(rotation.y) *
+                get_z_rotation_matrix(rotation.z);
+  reverse_rotate_mat_ = get_x_rotation_matrix(-rotation.x) *
+                        get_y_rotation_matrix(-rotation.y) *
+                        get_z_rotation_matrix(-rotation.z);
+
+  if (!has_bbox_) return;
+  bbox_ = is_rotated_ ? rotate_bounding_box(rotate_mat_, local_bbox_)
+                      : local_bbox_;
+  bbox_ = Aabb(bbox_.min() + translation_, bbox_.max() + translation_);
+}
+
+Ray Instance::to_local(Ray const &ray) const noexcept
+{
+  const auto origin = ray.origin() - translation_;
+  if (!is_rotated_) return Ray(origin, ray.direction(), ray.time());
+  return Ray(reverse_rotate_mat_ * origin,
+             reverse_rotate_mat_ * ray.direction(), ray.time());
+}
+
+bool Instance::intersect(Ray const &ray, double tmin, double tmax,
+                         HitInfo &info) const
+{
+  RT_STATS_INC(STATS_INSTANCE_TESTS);
+  if (!shape_->intersect(to_local(ray), tmin, tmax, info)) return false;
+  info.push_instance(this);
+  return true;
+}
+
+void Instance::compute_surface_interaction(Ray const &ray, HitInfo const &info,
+                                           HitRecord &record) const
+{
+  const auto local_ray = to_local(ray);
+  auto inner_info = info.pop_instance();
+  inner_info.shape->compute_surface_interaction(local_ray, inner_info, record);
+
+  if (material_) record.material = material_.get();
+  // The rigid transform keeps the side of the normal(front_face)
+  if (is_rotated_) {
+    record.p = rotate_mat_ * record.p;
+    record.normal = rotate_mat_ * record.normal;
+  }
+  record.p += translation_;
+}
+
+bool Instance::get_bounding_box(Aabb &output_box) const
+{
+  if (has_bbox_) output_box = bbox_;
+  return has_bbox_;
+}
+
+double Instance::pdf_value(Point3F const &origin, Vec3F const &direction) const
+{
+  const auto local_origin = origin - translation_;
+  if (!is_rotated_) return shape_->pdf_value(local_origin, direction);
+  return shape_->pdf_value(reverse_rotate_mat_ * local_origin,
+                           reverse_rotate_mat_ * direction);
+}
+
+Vec3F Instance::random_direction(Point3F const &origin) const
+{
+  const auto local_origin = origin - translation_;
+  if (!is_rotated_) return shape_->random_direction(local_origin);
+  return rotate_mat_ *
+         shape_->random_direction(reverse_rotate_mat_ * local_origin);
+}
+
+bool Instance::normal_bounds(Vec3F &axis, double &cos_theta) const
+{
+  if (!shape_->normal_bounds(axis, cos_theta)) return false;
+  if (is_rotated_) axis = rotate_mat_ * axis;
+  return true;
+}
@@ -0,0 +1,74 @@
+#ifndef RT_SHAPE_INSTANCE_HH__
+#define RT_SHAPE_INSTANCE_HH__
+
+#include "shape.hh"
+#include "rotate.hh"
+#include "../gm/matrix.hh"
+#include "../material/type.hh"
+
+namespace rt {
+
+/**
+ * The editable placement of a shape: rotation, then translation, and the
+ * material replacing the one of the shape.
+ * Unlike Rotate and Translate, they can be changed after construction
+ * (see SceneEditor), the bounding box is recomputed by set_transform().
+ * The shape should not be shared by the instances whose material is
+ * replaced.
+ */
+class Instance : public Shape {
+ public:
+  explicit Instance(ShapeSPtr shape);
+
+  void set_transform(Degree const &rotation, gm::Vec3F const &translation);
+  /**
+   * \param material null restores the material of the shape
+   */
+  void set_material(MaterialSPtr material) noexcept
+  {
+    material_ = std::move(material);
+  }
+
+  bool intersect(Ray const &ray, double tmin, double tmax,
+                 HitInfo &info) const override;
+  void compute_surface_interaction(Ray const &ray, HitInfo const &info,
+                                   HitRecord &record) const override;
+  bool get_bounding_box(Aabb &output_box) const override;
+
+  double pdf_value(gm::Point3F const &origin,
+                   gm::Vec3F const &direction) const override;
+  gm::Vec3F random_direction(gm::Point3F const &origin) const override;
+
+  Material const *material() const noexcept override
+  {
+    return material_ ? material_.get() : shape_->material();
+  }
+  double area() const noexcept override { return shape_->area(); }
+  bool normal_bounds(gm::Vec3F &axis, double &cos_theta) const override;
+
+  ShapeSPtr const &shape() const noexcept { return shape_; }
+  Degree const &rotation() const noexcept { return rotation_; }
+  gm::Vec3F const &translation() const noexcept { return translation_; }
+
+ private:
+  // Into the space of the shape
+  Ray to_local(Ray const &ray) const noexcept;
+
+  ShapeSPtr shape_;
+  MaterialSPtr material_ = nullptr;
+
+  Degree rotation_;
+  gm::Vec3F translation_{0, 0, 0};
+  gm::Matrix3x3F rotate_mat_;
+  gm::Matrix3x3F reverse_rotate_mat_;
+  // The rotation is skipped
+  bool is_rotated_ = false;
+
+  Aabb local_bbox_;
+  Aabb bbox_;
+  bool has_bbox_;
+};
+
+} // namespace rt
+
+#endif
@@ -0,0 +1,60 @@
+#include "keyframe_track.hh"
+
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+
+using namespace rt;
+using namespace gm;
+
+KeyframeTrack::KeyframeTrack(std::vector<Keyframe> keys)
+  : keys_(std::move(keys))
+{
+  assert(!keys_.empty());
+  std::stable_sort(keys_.begin(), keys_.end(),
+                   [](Keyframe const &a, Keyframe const &b) {
+                     return a.time < b.time;
+                   });
+}
+
+Vec3F KeyframeTrack::at(double time) const noexcept
+{
+  if (time <= keys_.front().time) return keys_.front().offset;
+  if (time >= keys_.back().time) return keys_.back().offset;
+
+  // The first key after the time
+  auto next = std::upper_bound(
+    keys_.begin(), keys_.end(), time,
+    [](double t, Keyframe const &key) { return t < key.time; });
+  auto prev = next - 1;
+  const double s = (time - prev->time) / (next->time - prev->time);
+  return prev->offset + (next->offset - prev->offset) * s;
+}
+
+void KeyframeTrack::linear_bounds(double time0, double time1, Vec3F &offset0,
+                                  Vec3F &offset1, Vec3F &pad) const noexcept
+{
+  offset0 = at(time0);
+  offset1 = at(time1);
+  pad = Vec3F(0, 0, 0);
+  if (!(time1 > time0)) return;
+
+  // The motion is linear between the keys, the max deviations are at them
+  for (auto const &key : keys_) {
+    if (key.time <= time0 || key.time >= time1) continue;
+    const double s = (key.time - time0) / (time1 - time0);
+    const auto d = key.offset - (offset0 + (offset1 - offset0) * s);
+    for (int i = 0; i < 3; ++i) pad[i] = std::max(pad[i], std::fabs(d[i]));
+  }
+}
+
+void KeyframeTrack::bounds(Vec3F &min, Vec3F &max) const noexcept
+{
+  min = max = keys_.front().offset;
+  for (auto const &key : keys_) {
+    for (int i = 0; i < 3; ++i) {
+      min[i] = std::min(min[i], key.offset[i]);
+      max[i] = std::max(max[i], key.offset[i]);
+    }
+  }
+}
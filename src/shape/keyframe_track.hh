@@ -0,0 +1,49 @@
+#ifndef RT_SHAPE_KEYFRAME_TRACK_HH__
+#define RT_SHAPE_KEYFRAME_TRACK_HH__
+
+#include <vector>
+
+#include "../gm/vec.hh"
+
+namespace rt {
+
+struct Keyframe {
+  double time;
+  gm::Vec3F offset;
+};
+
+/**
+ * The piecewise linear motion through the keyframes, it stays at the first
+ * (last) keyframe before(after) them
+ */
+class KeyframeTrack {
+ public:
+  /**
+   * \param keys At least one, they are sorted by time
+   */
+  explicit KeyframeTrack(std::vector<Keyframe> keys);
+
+  gm::Vec3F at(double time) const noexcept;
+
+  /**
+   * The linear bounds of the motion in [time0, time1]:
+   * |at(t) - lerp(offset0, offset1, s)| <= pad(per component)
+   * where s = (t - time0) / (time1 - time0)
+   */
+  void linear_bounds(double time0, double time1, gm::Vec3F &offset0,
+                     gm::Vec3F &offset1, gm::Vec3F &pad) const noexcept;
+
+  /**
+   * The box of all offsets
+   */
+  void bounds(gm::Vec3F &min, gm::Vec3F &max) const noexcept;
+
+  std::vector<Keyframe> const &keys() const noexcept { return keys_; }
+
+ private:
+  std::vector<Keyframe> keys_;
+};
+
+} // namespace rt
+
+#endif
@@ -0,0 +1,69 @@
+#include "moving_sphere.hh"
+
+#include <cassert>
+
+#include "sphere.hh"
+#include "../rt/hit_record.hh"
+#include "../rt/stats.hh"
+
+using namespace rt;
+using namespace gm;
+
+bool MovingSphere::intersect(Ray const &ray, double tmin, double tmax,
+                             HitInfo &info) const
+{
+  RT_STATS_INC(STATS_SPHERE_TESTS);
+  auto co = ray.origin() - center(ray.time());
+  auto a = ray.direction().length_squared();
+  auto half_b = dot(ray.direction(), co);
+  auto c = co.length_squared() - radius_ * radius_;
+
+  auto delta = half_b * half_b - a * c;
+  if (delta <= 0) return false;
+
+  auto sqrt_delta = std::sqrt(delta);
+  auto root = (-half_b - sqrt_delta) / a;
+  if (root < tmin || tmax < root) {
+    root = (-half_b + sqrt_delta) / a;
+    if (root < tmin || tmax < root) return false;
+  }
+
+  info.set(root, this);
+  return true;
+}
+
+void MovingSphere::compute_surface_interaction(Ray const &ray,
+                                               HitInfo const &info,
+                                               HitRecord &record) const
+{
+  record.material = material_.get();
+  record.t = info.t;
+  record.p = ray.at(record.t);
+
+  auto outward_normal = (record.p - center(ray.time())) / radius_;
+  record.set_face_normal(ray, outward_normal);
+  record.uv_func = &Sphere::get_uv;
+  record.uv_point = outward_normal;
+  record.uv_scale = 1 / (pi * radius_);
+}
+
+bool MovingSphere::get_bounding_box(Aabb &output_box) const
+{
+  Vec3F min, max;
+  track_.bounds(min, max);
+  output_box = Aabb(center_ + min - radius_, center_ + max + radius_);
+  return true;
+}
+
+bool MovingSphere::get_motion_bounds(double time0, double time1, Aabb &box0,
+                                     Aabb &box1) const
+{
+  Vec3F offset0, offset1, pad;
+  track_.linear_bounds(time0, time1, offset0, offset1, pad);
+  const auto extent = pad + radius_;
+  const auto center0 = center_ + offset0;
+  const auto center1 = center_ + offset1;
+  box0 = Aabb(center0 - extent, center0 + extent);
+  box1 = Aabb(center1 - extent, center1 + extent);
+  return true;
+}
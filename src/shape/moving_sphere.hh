@@ -0,0 +1,62 @@
+#ifndef SHAPE_MOVING_SPHERE_HH__
+#define SHAPE_MOVING_SPHERE_HH__
+
+#include "shape.hh"
+#include "keyframe_track.hh"
+
+#include "../material/type.hh"
+
+namespace rt {
+
+/**
+ * The sphere whose center is offset by the keyframes,
+ * it is intersected at the time of ray
+ *
+ * It is not sampled as a light(the pdf of a moving emitter depends on the
+ * time which is unknown by pdf_value())
+ */
+class MovingSphere : public Shape {
+ public:
+  MovingSphere(gm::Point3F const &center, KeyframeTrack track, double radius,
+               MaterialSPtr material)
+    : center_(center)
+    , track_(std::move(track))
+    , radius_(radius)
+    , material_(std::move(material))
+  {
+  }
+
+  MovingSphere(gm::Point3F const &center0, double time0,
+               gm::Point3F const &center1, double time1, double radius,
+               MaterialSPtr material)
+    : MovingSphere(
+        center0,
+        KeyframeTrack({{time0, {0, 0, 0}}, {time1, center1 - center0}}),
+        radius, std::move(material))
+  {
+  }
+
+  bool intersect(Ray const &ray, double tmin, double tmax,
+                 HitInfo &info) const override;
+  void compute_surface_interaction(Ray const &ray, HitInfo const &info,
+                                   HitRecord &record) const override;
+  bool get_bounding_box(Aabb &output_box) const override;
+  bool get_motion_bounds(double time0, double time1, Aabb &box0,
+                         Aabb &box1) const override;
+
+  gm::Point3F center(double time) const noexcept
+  {
+    return center_ + track_.at(time);
+  }
+
+ private:
+  gm::Point3F center_;
+  KeyframeTrack track_;
+  double radius_;
+
+  MaterialSPtr material_;
+};
+
+} // namespace rt
+
+#endif
@@ -1,84 +1,113 @@
 #include "rect.hh"
 
+#include <algorithm>
+
 #include "../accelerate/aabb.hh"
 #include "../rt/hit_record.hh"
-#include "../util/random.hh"
+#include "../rt/stats.hh"
+#include "../sample/sampler.hh"
+#include "../sample/spherical_rect.hh"
 
 using namespace rt;
 using namespace gm;
-using namespace util;
 
-bool XyRect::hit(Ray const &ray, double tmin, double tmax,
-                 HitRecord &record) const
+bool XyRect::intersect(Ray const &ray, double tmin, double tmax,
+                       HitInfo &info) const
 {
+  RT_STATS_INC(STATS_RECT_TESTS);
   auto t = (k_ - ray.origin().z) / ray.direction().z;
   if (t <= tmin || t >= tmax) return false;
 
   auto p = ray.at(t);
   if (p.x <= x1_ && p.x >= x0_ && p.y <= y1_ && p.y >= y0_) {
-    record.p = p;
-    record.t = t;
-    record.material = material_.get();
-    record.u = (p.x - x0_) / (x1_ - x0_);
-    record.v = (p.y - y0_) / (y1_ - y0_);
-    record.set_face_normal(ray, Vec3F(0, 0, 1));
+    info.set(t, this);
+    info.u = (p.x - x0_) / (x1_ - x0_);
+    info.v = (p.y - y0_) / (y1_ - y0_);
     return true;
   }
   return false;
 }
 
-bool YzRect::hit(Ray const &ray, double tmin, double tmax,
-                 HitRecord &record) const
+void XyRect::compute_surface_interaction(Ray const &ray, HitInfo const &info,
+                                         HitRecord &record) const
+{
+  record.t = info.t;
+  record.p = ray.at(info.t);
+  record.material = material_.get();
+  record.set_uv(info.u, info.v);
+  record.uv_scale = 1 / std::min(width(), height());
+  record.set_face_normal(ray, Vec3F(0, 0, 1));
+}
+
+bool YzRect::intersect(Ray const &ray, double tmin, double tmax,
+                       HitInfo &info) const
 {
+  RT_STATS_INC(STATS_RECT_TESTS);
   auto t = (k_ - ray.origin().x) / ray.direction().x;
   if (t <= tmin || t >= tmax) return false;
 
   auto p = ray.at(t);
   if (p.y <= y1_ && p.y >= y0_ && p.z <= z1_ && p.z >= z0_) {
-    record.p = p;
-    record.t = t;
-    record.material = material_.get();
-    record.u = (p.z - z0_) / (z1_ - z0_);
-    record.v = (p.y - y0_) / (y1_ - y0_);
-    record.set_face_normal(ray, Vec3F(1, 0, 0));
+    info.set(t, this);
+    info.u = (p.z - z0_) / (z1_ - z0_);
+    info.v = (p.y - y0_) / (y1_ - y0_);
     return true;
   }
   return false;
 }
 
-bool XzRect::hit(Ray const &ray, double tmin, double tmax,
-                 HitRecord &record) const
+void YzRect::compute_surface_interaction(Ray const &ray, HitInfo const &info,
+                                         HitRecord &record) const
 {
+  record.t = info.t;
+  record.p = ray.at(info.t);
+  record.material = material_.get();
+  record.set_uv(info.u, info.v);
+  record.uv_scale = 1 / std::min(width(), height());
+  record.set_face_normal(ray, Vec3F(1, 0, 0));
+}
+
+bool XzRect::intersect(Ray const &ray, double tmin, double tmax,
+                       HitInfo &info) const
+{
+  RT_STATS_INC(STATS_RECT_TESTS);
   auto t = (k_ - ray.origin().y) / ray.direction().y;
   if (t <= tmin || t >= tmax) return false;
 
   auto p = ray.at(t);
   if (p.x <= x1_ && p.x >= x0_ && p.z <= z1_ && p.z >= z0_) {
-    record.p = p;
-    record.t = t;
-    record.material = material_.get();
-    record.u = (p.x - x0_) / (x1_ - x0_);
-    record.v = (p.z - z0_) / (z1_ - z0_);
-    record.set_face_normal(ray, Vec3F(0, 1, 0));
+    info.set(t, this);
+    info.u = (p.x - x0_) / (x1_ - x0_);
+    info.v = (p.z - z0_) / (z1_ - z0_);
     return true;
   }
-
   return false;
 }
 
+void XzRect::compute_surface_interaction(Ray const &ray, HitInfo const &info,
+                                         HitRecord &record) const
+{
+  record.t = info.t;
+  record.p = ray.at(info.t);
+  record.material = material_.get();
+  record.set_uv(info.u, info.v);
+  record.uv_scale = 1 / std::min(width(), height());
+  record.set_face_normal(ray, Vec3F(0, 1, 0));
+}
+
 #define THICKNESS 0.001
 
 bool XyRect::get_bounding_box(Aabb &bbox) const
 {
   bbox = Aabb(Point3F(x0_, y0_, k_ - THICKNESS),
-              Point3F(x1_, x1_, k_ + THICKNESS));
+              Point3F(x1_, y1_, k_ + THICKNESS));
   return true;
 }
 
 bool YzRect::get_bounding_box(Aabb &bbox) const
 {
   bbox = Aabb(Point3F(k_ - THICKNESS, y0_, z0_),
-              Point3F(k_ + THICKNESS, y1_, z0_));
+              Point3F(k_ + THICKNESS, y1_, z1_));
   return true;
 }
 
@@ -89,28 +118,68 @@ bool XzRect::get_bounding_box(Aabb &bbox) const
   return true;
 }
 
-double XzRect::pdf_value(const Point3F &origin, const Vec3F &direction) const
+/*--------------------------------------------------*/
+/* Light sampling                                   */
+/*--------------------------------------------------*/
+
+SphericalRect XyRect::spherical_rect(Point3F const &origin) const noexcept
+{
+  return SphericalRect(origin, Point3F(x0_, y0_, k_), Vec3F(width(), 0, 0),
+                       Vec3F(0, height(), 0));
+}
+
+SphericalRect YzRect::spherical_rect(Point3F const &origin) const noexcept
 {
-  HitRecord hit_rec;
-  // 如果scatter ray没有与该矩形面相交，那么就不针对其采样，即pdf为0
-  if (!XzRect::hit(Ray(origin, direction), 0.001, inf, hit_rec)) return 0;
+  return SphericalRect(origin, Point3F(k_, y0_, z0_), Vec3F(0, 0, width()),
+                       Vec3F(0, height(), 0));
+}
 
-  const auto area = (x1_ - x0_) * (z1_ - z0_);
-  // FIXME
-  // (hit_rec.p - origin).length_squared() is better?
-  const auto distance_squared =
-      hit_rec.t * hit_rec.t * direction.length_squared();
+SphericalRect XzRect::spherical_rect(Point3F const &origin) const noexcept
+{
+  return SphericalRect(origin, Point3F(x0_, k_, z0_), Vec3F(x1_ - x0_, 0, 0),
+                       Vec3F(0, 0, z1_ - z0_));
+}
 
+double XyRect::pdf_value(Point3F const &origin, Vec3F const &direction) const
+{
+  HitInfo info;
+  // 如果scatter ray没有与该矩形面相交，那么就不针对其采样，即pdf为0
   // 两面都可以采样
-  const auto cos_theta = fabs(dot(direction.normalize(), hit_rec.normal));
-  // const auto cos_theta = fabs(dot(direction, hit_rec.normal) / direction.length());
+  if (!XyRect::intersect(Ray(origin, direction), 0.001, inf, info)) return 0;
+  return spherical_rect(origin).pdf(origin + info.t * direction);
+}
+
+Vec3F XyRect::random_direction(Point3F const &origin) const
+{
+  double u, v;
+  sample_2d(u, v);
+  return spherical_rect(origin).sample(u, v) - origin;
+}
+
+double YzRect::pdf_value(Point3F const &origin, Vec3F const &direction) const
+{
+  HitInfo info;
+  if (!YzRect::intersect(Ray(origin, direction), 0.001, inf, info)) return 0;
+  return spherical_rect(origin).pdf(origin + info.t * direction);
+}
 
-  return distance_squared / (area * cos_theta);
+Vec3F YzRect::random_direction(Point3F const &origin) const
+{
+  double u, v;
+  sample_2d(u, v);
+  return spherical_rect(origin).sample(u, v) - origin;
+}
+
+double XzRect::pdf_value(Point3F const &origin, Vec3F const &direction) const
+{
+  HitInfo info;
+  if (!XzRect::intersect(Ray(origin, direction), 0.001, inf, info)) return 0;
+  return spherical_rect(origin).pdf(origin + info.t * direction);
 }
 
-Vec3F XzRect::random_direction(const Point3F &origin) const
+Vec3F XzRect::random_direction(Point3F const &origin) const
 {
-  auto point = Point3F{random_double(x0_, x1_), k_, random_double(z0_, z1_)};
-  // std::cout << point << '\n';
-  return point - origin;
+  double u, v;
+  sample_2d(u, v);
+  return spherical_rect(origin).sample(u, v) - origin;
 }
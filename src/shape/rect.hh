@@ -9,6 +9,8 @@
 
 namespace rt {
 
+class SphericalRect;
+
 class XyRect : public Shape {
  public:
   XyRect(double x0, double x1, double y0, double y1, double k,
@@ -22,14 +24,34 @@ class XyRect : public Shape {
   {
   }
 
-  bool hit(Ray const &ray, double tmin, double tmax,
-           HitRecord &record) const override;
+  bool intersect(Ray const &ray, double tmin, double tmax,
+                 HitInfo &info) const override;
+  void compute_surface_interaction(Ray const &ray, HitInfo const &info,
+                                   HitRecord &record) const override;
   bool get_bounding_box(Aabb &bbox) const override;
 
+  /**
+   * Sample the rectangle uniformly in solid angle
+   */
+  virtual double pdf_value(Point3F const &origin,
+                           Vec3F const &direction) const override;
+  virtual Vec3F random_direction(Point3F const &origin) const override;
+
+  Material const *material() const noexcept override { return material_.get(); }
+  double area() const noexcept override { return width() * height(); }
+  bool normal_bounds(Vec3F &axis, double &cos_theta) const override
+  {
+    axis = Vec3F(0, 0, 1);
+    cos_theta = 1;
+    return true;
+  }
+
   double width() const noexcept { return x1_ - x0_; }
   double height() const noexcept { return y1_ - y0_; }
 
  private:
+  SphericalRect spherical_rect(Point3F const &origin) const noexcept;
+
   double x0_ = 0;
   double x1_ = 0;
   double y0_ = 0;
@@ -51,14 +73,31 @@ class YzRect : public Shape {
   {
   }
 
-  bool hit(Ray const &ray, double tmin, double tmax,
-           HitRecord &record) const override;
+  bool intersect(Ray const &ray, double tmin, double tmax,
+                 HitInfo &info) const override;
+  void compute_surface_interaction(Ray const &ray, HitInfo const &info,
+                                   HitRecord &record) const override;
   bool get_bounding_box(Aabb &bbox) const override;
 
+  virtual double pdf_value(Point3F const &origin,
+                           Vec3F const &direction) const override;
+  virtual Vec3F random_direction(Point3F const &origin) const override;
+
+  Material const *material() const noexcept override { return material_.get(); }
+  double area() const noexcept override { return width() * height(); }
+  bool normal_bounds(Vec3F &axis, double &cos_theta) const override
+  {
+    axis = Vec3F(1, 0, 0);
+    cos_theta = 1;
+    return true;
+  }
+
   double width() const noexcept { return z1_ - z0_; }
   double height() const noexcept { return y1_ - y0_; }
 
  private:
+  SphericalRect spherical_rect(Point3F const &origin) const noexcept;
+
   double y0_, y1_, z0_, z1_, k_;
   MaterialSPtr material_;
 };
@@ -76,14 +115,28 @@ class XzRect : public Shape {
   {
   }
 
-  bool hit(Ray const &ray, double tmin, double tmax,
-           HitRecord &record) const override;
+  bool intersect(Ray const &ray, double tmin, double tmax,
+                 HitInfo &info) const override;
+  void compute_surface_interaction(Ray const &ray, HitInfo const &info,
+                                   HitRecord &record) const override;
   bool get_bounding_box(Aabb &bbox) const override;
 
+  Material const *material() const noexcept override { return material_.get(); }
+  double area() const noexcept override { return width() * height(); }
+  bool normal_bounds(Vec3F &axis, double &cos_theta) const override
+  {
+    axis = Vec3F(0, 1, 0);
+    cos_theta = 1;
+    return true;
+  }
+
   virtual double pdf_value(Point3F const &origin,
                            Vec3F const &direction) const override;
   virtual Vec3F random_direction(Point3F const &origin) const override;
 
+  double width() const noexcept { return x1_ - x0_; }
+  double height() const noexcept { return z1_ - z0_; }
+
   static std::shared_ptr<XzRect> create_based_mid(double x, double width,
                                                   double z, double height,
                                                   double k, MaterialSPtr mat)
@@ -94,6 +147,8 @@ class XzRect : public Shape {
   }
 
  private:
+  SphericalRect spherical_rect(Point3F const &origin) const noexcept;
+
   double x0_, x1_, z0_, z1_, k_;
   MaterialSPtr material_;
 };
@@ -1,6 +1,11 @@
 #include "rotate.hh"
+
+#include <algorithm>
+
 #include "../gm/transform.hh"
+#include "../gm/util.hh"
 #include "../rt/hit_record.hh"
+#include "../rt/stats.hh"
 
 using namespace rt;
 using namespace gm;
@@ -15,22 +20,50 @@ Rotate::Rotate(ShapeSPtr shape, Degree const &degree)
                 get_z_rotation_matrix(degree.z))
 {
   has_bbox_ = shape_->get_bounding_box(cache_bbox_);
-  if (has_bbox_) {
-    cache_bbox_ = Aabb(rotate_mat_ * cache_bbox_.min(),
-                       rotate_mat_ * cache_bbox_.max());
+  if (has_bbox_) cache_bbox_ = rotate_bounding_box(rotate_mat_, cache_bbox_);
+}
+
+Aabb rt::rotate_bounding_box(Matrix3x3F const &mat, Aabb const &box) noexcept
+{
+  // The box of the 8 rotated corners
+  Point3F min(inf, inf, inf);
+  Point3F max(-inf, -inf, -inf);
+  for (int i = 0; i < 8; ++i) {
+    const Point3F corner(i & 1 ? box.max().x : box.min().x,
+                         i & 2 ? box.max().y : box.min().y,
+                         i & 4 ? box.max().z : box.min().z);
+    const auto p = mat * corner;
+    for (int c = 0; c < 3; ++c) {
+      min[c] = std::min(min[c], p[c]);
+      max[c] = std::max(max[c], p[c]);
+    }
   }
+  return {min, max};
 }
 
-bool Rotate::hit(const Ray &ray, double tmin, double tmax,
-                 HitRecord &record) const
+bool Rotate::intersect(const Ray &ray, double tmin, double tmax,
+                       HitInfo &info) const
 {
-  Ray r_ray(reverse_rotate_mat_ * ray.origin(), reverse_rotate_mat_ * ray.direction());
-  if (!shape_->hit(r_ray, tmin, tmax, record))
+  RT_STATS_INC(STATS_INSTANCE_TESTS);
+  Ray r_ray(reverse_rotate_mat_ * ray.origin(),
+            reverse_rotate_mat_ * ray.direction(), ray.time());
+  if (!shape_->intersect(r_ray, tmin, tmax, info))
     return false;
 
+  info.push_instance(this);
+  return true;
+}
+
+void Rotate::compute_surface_interaction(Ray const &ray, HitInfo const &info,
+                                         HitRecord &record) const
+{
+  Ray r_ray(reverse_rotate_mat_ * ray.origin(),
+            reverse_rotate_mat_ * ray.direction(), ray.time());
+  auto inner_info = info.pop_instance();
+  inner_info.shape->compute_surface_interaction(r_ray, inner_info, record);
+
   record.p = rotate_mat_ * record.p;
   record.set_face_normal(r_ray, rotate_mat_ * record.normal);
-  return true;
 }
 
 bool Rotate::get_bounding_box(Aabb &output_box) const
@@ -39,4 +72,22 @@ bool Rotate::get_bounding_box(Aabb &output_box) const
     output_box = cache_bbox_;
   }
   return has_bbox_;
-}
\ No newline at end of file
+}
+
+double Rotate::pdf_value(Point3F const &origin, Vec3F const &direction) const
+{
+  return shape_->pdf_value(reverse_rotate_mat_ * origin,
+                           reverse_rotate_mat_ * direction);
+}
+
+Vec3F Rotate::random_direction(Point3F const &origin) const
+{
+  return rotate_mat_ * shape_->random_direction(reverse_rotate_mat_ * origin);
+}
+
+bool Rotate::normal_bounds(Vec3F &axis, double &cos_theta) const
+{
+  if (!shape_->normal_bounds(axis, cos_theta)) return false;
+  axis = rotate_mat_ * axis;
+  return true;
+}
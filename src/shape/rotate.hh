@@ -13,12 +13,31 @@ struct Degree {
   double z = 0;
 };
 
+/**
+ * The box bounding the rotated \p box
+ */
+Aabb rotate_bounding_box(gm::Matrix3x3F const &mat, Aabb const &box) noexcept;
+
 class Rotate : public Shape {
  public:
   Rotate(ShapeSPtr shape, Degree const &degree);
 
-  virtual bool hit(Ray const &ray, double tmin, double tmax, HitRecord &record) const override;
+  virtual bool intersect(Ray const &ray, double tmin, double tmax, HitInfo &info) const override;
+  virtual void compute_surface_interaction(Ray const &ray, HitInfo const &info,
+                                           HitRecord &record) const override;
   virtual bool get_bounding_box(Aabb &output_box) const override;
+
+  // The rotation preserves the solid angle
+  double pdf_value(gm::Point3F const &origin,
+                   gm::Vec3F const &direction) const override;
+  gm::Vec3F random_direction(gm::Point3F const &origin) const override;
+
+  Material const *material() const noexcept override
+  {
+    return shape_->material();
+  }
+  double area() const noexcept override { return shape_->area(); }
+  bool normal_bounds(gm::Vec3F &axis, double &cos_theta) const override;
  private:
   ShapeSPtr shape_;
   gm::Matrix3x3F reverse_rotate_mat_;
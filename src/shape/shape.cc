@@ -1,5 +1,10 @@
 #include "shape.hh"
+
+#include <cmath>
+
 #include "../accelerate/aabb.hh"
+#include "../gm/util.hh"
+#include "../rt/hit_record.hh"
 
 using namespace rt;
 
@@ -9,3 +14,41 @@ Aabb Shape::get_bounding_box() const
   get_bounding_box(bbox);
   return bbox;
 }
+
+bool Shape::get_motion_bounds(double time0, double time1, Aabb &box0,
+                              Aabb &box1) const
+{
+  if (!get_bounding_box(box0)) return false;
+  box1 = box0;
+  return true;
+}
+
+bool Shape::hit(Ray const &ray, double tmin, double tmax,
+                HitRecord &record) const
+{
+  HitInfo info;
+  if (!intersect(ray, tmin, tmax, info)) return false;
+  info.shape->compute_surface_interaction(ray, info, record);
+  return true;
+}
+
+// The shapes which only override hit()
+
+bool Shape::intersect(Ray const &ray, double tmin, double tmax,
+                      HitInfo &info) const
+{
+  HitRecord record;
+  if (!hit(ray, tmin, tmax, record)) return false;
+  info.set(record.t, this);
+  return true;
+}
+
+void Shape::compute_surface_interaction(Ray const &ray, HitInfo const &info,
+                                        HitRecord &record) const
+{
+  // Find the same hit again, t is in the open interval
+  [[maybe_unused]] const bool is_hit =
+    hit(ray, std::nextafter(info.t, -gm::inf), std::nextafter(info.t, gm::inf),
+        record);
+  assert(is_hit);
+}
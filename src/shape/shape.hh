@@ -8,35 +8,97 @@
 
 namespace rt {
 
+struct HitInfo;
 struct HitRecord;
+class Material;
 
+/**
+ * A shape overrides hit() or the two phases of intersection:
+ * intersect() and compute_surface_interaction().
+ * The former one is simpler, the latter one avoids filling the HitRecord
+ * for the hits which are superseded by a closer one.
+ */
 class Shape
 {
  public:
-  virtual bool hit(Ray const &ray, double tmin, double tmax, HitRecord &record) const = 0;
+  /**
+   * intersect() and then compute_surface_interaction() of the hit shape
+   */
+  virtual bool hit(Ray const &ray, double tmin, double tmax, HitRecord &record) const;
+  /**
+   * The box bounding the shape at any time(the whole motion if it moves)
+   */
   virtual bool get_bounding_box(Aabb &output_box) const = 0;
+
+  /**
+   * The boxes at \p time0 and \p time1, their linear interpolation bounds
+   * the shape at any time between them(used by the BVH with motion).
+   * The static shapes return their bounding box twice.
+   */
+  virtual bool get_motion_bounds(double time0, double time1, Aabb &box0,
+                                 Aabb &box1) const;
+
+  /**
+   * Find the intersection in (tmin, tmax), only \p info is filled
+   * \return false if no intersection, \p info is not modified in this case
+   */
+  virtual bool intersect(Ray const &ray, double tmin, double tmax, HitInfo &info) const;
+
+  /**
+   * Fill the \p record of the hit found by intersect()
+   * \param ray The ray passed to intersect()
+   */
+  virtual void compute_surface_interaction(Ray const &ray, HitInfo const &info,
+                                           HitRecord &record) const;
   
   /**
+   * The pdf(in solid angle) of sampling the \p direction by
+   * random_direction()
    * \param origin The origin of the scatter ray
    * \param direction The direction of the scatter ray
    */
   virtual double pdf_value(gm::Point3F const &origin, gm::Vec3F const &direction) const
   {
-    // FIXME Pure virtual function
     return 0;
   }
 
   /**
+   * Sample a direction toward the shape
    * \param origin The origin of the scatter ray(i.e. the intersected point)
+   * \return Zero vector if the shape can't be sampled(its pdf is 0)
    */
   virtual gm::Vec3F random_direction(gm::Point3F const &origin) const
   {
-    // FIXME Pure virtual function
-    std::cout << "FIXME random_direction\n";
     return { 0, 0, 0 };
   }
 
   Aabb get_bounding_box() const;
+
+  /*--------------------------------------------------*/
+  /* Emitter information(used by LightSampler)        */
+  /*--------------------------------------------------*/
+
+  /**
+   * The material of the whole surface,
+   * null if the shape is an aggregate(e.g. ShapeList) or a volume
+   */
+  virtual Material const *material() const noexcept { return nullptr; }
+
+  /**
+   * The surface area, 0 if unknown
+   */
+  virtual double area() const noexcept { return 0; }
+
+  /**
+   * The cone bounding the outward normals of the surface
+   * \param axis The axis of the cone(unit vector)
+   * \param cos_theta The cosine of the half angle
+   * \return false if the normals may be any direction(e.g. sphere)
+   */
+  virtual bool normal_bounds(gm::Vec3F &axis, double &cos_theta) const
+  {
+    return false;
+  }
 };
 
 using ShapePtr = std::shared_ptr<Shape>;
@@ -4,26 +4,23 @@
 
 #include "../accelerate/aabb.hh"
 #include "../rt/hit_record.hh"
-#include "../util/random.hh"
+#include "../sample/sampler.hh"
 
 using namespace rt;
 using namespace util;
 
-bool ShapeList::hit(Ray const &ray, double tmin, double tmax,
-                    HitRecord &record) const
+bool ShapeList::intersect(Ray const &ray, double tmin, double tmax,
+                          HitInfo &info) const
 {
-  // 由于hit返回false时，record不一定没被修改，
-  // 这样会得到覆盖原有的record，
-  // 所以临时record是有必要的。
-  HitRecord tmp_record;
+  // intersect()返回false时不修改info，因此不需要临时变量，
+  // HitRecord只由最近的交点填充一次
   double cur_max = tmax;
 
   bool has_anything_hit = false;
   for (auto const &shape : shapes_) {
-    if (shape->hit(ray, tmin, cur_max, tmp_record)) {
+    if (shape->intersect(ray, tmin, cur_max, info)) {
       has_anything_hit = true;
-      record = std::move(tmp_record);
-      cur_max = record.t;
+      cur_max = info.t;
     }
   }
 
@@ -41,6 +38,24 @@ bool ShapeList::get_bounding_box(Aabb &output_box) const
 
     output_box =
         is_first_box ? tmp_box : Aabb::surrouding_box(output_box, tmp_box);
+    is_first_box = false;
+  }
+  return true;
+}
+
+bool ShapeList::get_motion_bounds(double time0, double time1, Aabb &box0,
+                                  Aabb &box1) const
+{
+  if (shapes_.empty()) return false;
+
+  // The union of the interpolations is bounded by the interpolation of
+  // the unions
+  Aabb tmp_box0, tmp_box1;
+  for (size_t i = 0; i < shapes_.size(); ++i) {
+    if (!shapes_[i]->get_motion_bounds(time0, time1, tmp_box0, tmp_box1))
+      return false;
+    box0 = i ? Aabb::surrouding_box(box0, tmp_box0) : tmp_box0;
+    box1 = i ? Aabb::surrouding_box(box1, tmp_box1) : tmp_box1;
   }
   return true;
 }
@@ -57,5 +72,7 @@ double ShapeList::pdf_value(const Point3F &origin, const Vec3F &direction) const
 Vec3F ShapeList::random_direction(const Point3F &origin) const
 {
   assert(!shapes_.empty());
-  return shapes_[random_int(0, shapes_.size()-1)]->random_direction(origin);
+  const auto index =
+    std::min(size_t(sample_1d() * shapes_.size()), shapes_.size() - 1);
+  return shapes_[index]->random_direction(origin);
 }
@@ -13,10 +13,12 @@ class ShapeList : public Shape {
 
   void add(ShapePtr const &shape) { shapes_.push_back(shape); }
 
-  bool hit(Ray const &ray, double tmin, double tmax,
-           HitRecord &record) const override;
+  bool intersect(Ray const &ray, double tmin, double tmax,
+                 HitInfo &info) const override;
 
   bool get_bounding_box(Aabb &output_box) const override;
+  bool get_motion_bounds(double time0, double time1, Aabb &box0,
+                         Aabb &box1) const override;
 
   virtual double pdf_value(Point3F const &origin, Vec3F const &direction) const override;
   virtual Vec3F random_direction(Point3F const &origin) const override;
@@ -3,7 +3,9 @@
 #include <cassert>
 
 #include "../rt/hit_record.hh"
+#include "../rt/stats.hh"
 #include "../accelerate/aabb.hh"
+#include "../gm/fast_math.hh"
 #include "../gm/onb.hh"
 #include "../sample/sample.hh"
 
@@ -11,9 +13,10 @@ using namespace rt;
 using namespace util;
 using namespace gm;
 
-bool Sphere::hit(Ray const &ray, double tmin, double tmax,
-                 HitRecord &record) const
+bool Sphere::intersect(Ray const &ray, double tmin, double tmax,
+                       HitInfo &info) const
 {
+  RT_STATS_INC(STATS_SPHERE_TESTS);
   auto co = ray.origin() - center_;
   auto a = ray.direction().length_squared();
   auto half_b = dot(ray.direction(), co);
@@ -31,21 +34,31 @@ bool Sphere::hit(Ray const &ray, double tmin, double tmax,
       }
     }
 
-    record.material = material_.get();
-    record.t = root;
-    record.p = ray.at(record.t);
-
-    assert((record.p - center_).length() - radius_ <= 0.0001);
-    auto outward_normal = normal(record.p);
-    record.set_face_normal(ray, outward_normal);
-    // outward normal is also the point in the identity sphere
-    get_uv(outward_normal, record.u, record.v);
+    info.set(root, this);
     return true;
   }
 
   return false;
 }
 
+void Sphere::compute_surface_interaction(Ray const &ray, HitInfo const &info,
+                                         HitRecord &record) const
+{
+  record.material = material_.get();
+  record.t = info.t;
+  record.p = ray.at(record.t);
+
+  assert((record.p - center_).length() - radius_ <= 0.0001);
+  auto outward_normal = normal(record.p);
+  record.set_face_normal(ray, outward_normal);
+  // outward normal is also the point in the identity sphere,
+  // the UV is computed by get_uv() when it is used
+  record.uv_func = &Sphere::get_uv;
+  record.uv_point = outward_normal;
+  // v spans the half great circle
+  record.uv_scale = 1 / (pi * radius_);
+}
+
 Vec3F Sphere::normal(Point3F const &p) const noexcept
 {
   // 法向量单位化是有必要的，
@@ -62,17 +75,20 @@ bool Sphere::get_bounding_box(Aabb &output_box) const
 void Sphere::get_uv(Point3F const &p, double &u, double &v)
 {
   // radius == 1
-  auto theta = acos(-p.y);
-  auto pi = atan2(-p.z, p.x) + gm::pi;
-  u = pi / (gm::pi * 2);
+  auto theta = fast_acos(-p.y);
+  auto phi = fast_atan2(-p.z, p.x) + gm::pi;
+  u = phi / (gm::pi * 2);
   v = theta / gm::pi;
 }
 
 double Sphere::pdf_value(const Point3F &origin, const Vec3F &direction) const
 {
-  HitRecord rec;
-  if (!Sphere::hit(Ray(origin, direction), 0.001, inf, rec)) return 0;
-  auto cos_theta_max = sqrt(1 - radius_ * radius_ / (center_ - origin).length_squared());
+  HitInfo info;
+  if (!Sphere::intersect(Ray(origin, direction), 0.001, inf, info)) return 0;
+  const auto distance_squared = (center_ - origin).length_squared();
+  // The origin is inside, the sphere covers all directions
+  if (distance_squared <= radius_ * radius_) return 1 / (4 * pi);
+  auto cos_theta_max = sqrt(1 - radius_ * radius_ / distance_squared);
   auto solid_angle = 2 * pi * (1 - cos_theta_max);
   return 1 / solid_angle;
 }
@@ -80,6 +96,8 @@ double Sphere::pdf_value(const Point3F &origin, const Vec3F &direction) const
 Vec3F Sphere::random_direction(const Point3F &origin) const
 {
   auto z_axis = center_ - origin;
+  if (z_axis.length_squared() <= radius_ * radius_)
+    return uniform_sphere_sample();
   Onb onb(z_axis);
   return onb.local(sphere_direction_sample(radius_, z_axis.length_squared()));
 }
@@ -19,9 +19,14 @@ class Sphere : public Shape
   {
   }
     
-  bool hit(Ray const &ray, double tmin, double tmax, HitRecord &record) const override;
+  bool intersect(Ray const &ray, double tmin, double tmax, HitInfo &info) const override;
+  void compute_surface_interaction(Ray const &ray, HitInfo const &info,
+                                   HitRecord &record) const override;
   bool get_bounding_box(Aabb &output_box) const override;
 
+  Material const *material() const noexcept override { return material_.get(); }
+  double area() const noexcept override { return 4 * gm::pi * radius_ * radius_; }
+
   Vec3F normal(Point3F const &p) const noexcept;
 
   virtual double pdf_value(Point3F const &origin, Vec3F const &direction) const override;
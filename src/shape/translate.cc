@@ -1,20 +1,30 @@
 #include "translate.hh"
 
 #include "../rt/hit_record.hh"
+#include "../rt/stats.hh"
 #include "../accelerate/aabb.hh"
 
 using namespace rt;
 
-bool Translate::hit(Ray const &ray, double tmin, double tmax, HitRecord &record) const
+bool Translate::intersect(Ray const &ray, double tmin, double tmax, HitInfo &info) const
 {
-  Ray moved_ray(ray.origin()-offset_, ray.direction());
+  RT_STATS_INC(STATS_INSTANCE_TESTS);
+  Ray moved_ray(ray.origin() - offset_, ray.direction(), ray.time());
 
-  auto ret = shape_->hit(moved_ray, tmin, tmax, record);
-  if (!ret) return false;
+  if (!shape_->intersect(moved_ray, tmin, tmax, info)) return false;
+  info.push_instance(this);
+  return true;
+}
+
+void Translate::compute_surface_interaction(Ray const &ray, HitInfo const &info,
+                                            HitRecord &record) const
+{
+  Ray moved_ray(ray.origin() - offset_, ray.direction(), ray.time());
+  auto inner_info = info.pop_instance();
+  inner_info.shape->compute_surface_interaction(moved_ray, inner_info, record);
 
   record.p += offset_;
   record.set_face_normal(moved_ray, record.normal);
-  return true;
 }
 
 bool Translate::get_bounding_box(Aabb &bbox) const
@@ -26,3 +36,61 @@ bool Translate::get_bounding_box(Aabb &bbox) const
   bbox = Aabb(bbox.min() + offset_, bbox.max() + offset_);
   return true;
 }
+
+bool Translate::get_motion_bounds(double time0, double time1, Aabb &box0,
+                                  Aabb &box1) const
+{
+  if (!shape_->get_motion_bounds(time0, time1, box0, box1)) return false;
+
+  box0 = Aabb(box0.min() + offset_, box0.max() + offset_);
+  box1 = Aabb(box1.min() + offset_, box1.max() + offset_);
+  return true;
+}
+
+bool MotionTranslate::intersect(Ray const &ray, double tmin, double tmax,
+                                HitInfo &info) const
+{
+  RT_STATS_INC(STATS_INSTANCE_TESTS);
+  Ray moved_ray(ray.origin() - track_.at(ray.time()), ray.direction(),
+                ray.time());
+
+  if (!shape_->intersect(moved_ray, tmin, tmax, info)) return false;
+  info.push_instance(this);
+  return true;
+}
+
+void MotionTranslate::compute_surface_interaction(Ray const &ray,
+                                                  HitInfo const &info,
+                                                  HitRecord &record) const
+{
+  const auto offset = track_.at(ray.time());
+  Ray moved_ray(ray.origin() - offset, ray.direction(), ray.time());
+  auto inner_info = info.pop_instance();
+  inner_info.shape->compute_surface_interaction(moved_ray, inner_info, record);
+
+  record.p += offset;
+  record.set_face_normal(moved_ray, record.normal);
+}
+
+bool MotionTranslate::get_bounding_box(Aabb &bbox) const
+{
+  if (!shape_->get_bounding_box(bbox)) return false;
+
+  gm::Vec3F min, max;
+  track_.bounds(min, max);
+  bbox = Aabb(bbox.min() + min, bbox.max() + max);
+  return true;
+}
+
+bool MotionTranslate::get_motion_bounds(double time0, double time1,
+                                        Aabb &box0, Aabb &box1) const
+{
+  // The motion of the inner shape is added to the motion of the offset
+  if (!shape_->get_motion_bounds(time0, time1, box0, box1)) return false;
+
+  gm::Vec3F offset0, offset1, pad;
+  track_.linear_bounds(time0, time1, offset0, offset1, pad);
+  box0 = Aabb(box0.min() + offset0 - pad, box0.max() + offset0 + pad);
+  box1 = Aabb(box1.min() + offset1 - pad, box1.max() + offset1 + pad);
+  return true;
+}
@@ -2,6 +2,7 @@
 #define RT_SHAPE_TRANSLATE_HH__
 
 #include "shape.hh"
+#include "keyframe_track.hh"
 
 #include "../gm/vec.hh"
 
@@ -15,13 +16,67 @@ class Translate : public Shape {
   {
   }
 
-  bool hit(Ray const &ray, double tmin, double tmax, HitRecord &record) const override;
+  bool intersect(Ray const &ray, double tmin, double tmax, HitInfo &info) const override;
+  void compute_surface_interaction(Ray const &ray, HitInfo const &info,
+                                   HitRecord &record) const override;
   bool get_bounding_box(Aabb &bbox) const override;
+  bool get_motion_bounds(double time0, double time1, Aabb &box0,
+                         Aabb &box1) const override;
+
+  double pdf_value(gm::Point3F const &origin,
+                   gm::Vec3F const &direction) const override
+  {
+    return shape_->pdf_value(origin - offset_, direction);
+  }
+  gm::Vec3F random_direction(gm::Point3F const &origin) const override
+  {
+    return shape_->random_direction(origin - offset_);
+  }
+
+  Material const *material() const noexcept override
+  {
+    return shape_->material();
+  }
+  double area() const noexcept override { return shape_->area(); }
+  bool normal_bounds(gm::Vec3F &axis, double &cos_theta) const override
+  {
+    return shape_->normal_bounds(axis, cos_theta);
+  }
  private:
   ShapeSPtr shape_;
   gm::Vec3F offset_;
 };
 
+/**
+ * The translation animated by the keyframes, the offset is taken at the
+ * time of ray.
+ * It is not sampled as a light(see MovingSphere).
+ */
+class MotionTranslate : public Shape {
+ public:
+  MotionTranslate(ShapeSPtr shape, KeyframeTrack track)
+    : shape_(std::move(shape))
+    , track_(std::move(track))
+  {
+  }
+
+  bool intersect(Ray const &ray, double tmin, double tmax, HitInfo &info) const override;
+  void compute_surface_interaction(Ray const &ray, HitInfo const &info,
+                                   HitRecord &record) const override;
+  bool get_bounding_box(Aabb &bbox) const override;
+  bool get_motion_bounds(double time0, double time1, Aabb &box0,
+                         Aabb &box1) const override;
+
+  Material const *material() const noexcept override
+  {
+    return shape_->material();
+  }
+  double area() const noexcept override { return shape_->area(); }
+ private:
+  ShapeSPtr shape_;
+  KeyframeTrack track_;
+};
+
 }
 
 #endif
@@ -0,0 +1,74 @@
+#include "cached_image_texture.hh"
+
+#include <stdexcept>
+#include <sys/stat.h>
+
+#include "../util/string_util.h"
+#include "image_texture.hh"
+
+using namespace rt;
+using namespace util;
+
+CachedImageTexture::CachedImageTexture(TextureCacheSPtr cache,
+                                       char const *path)
+  : cache_(std::move(cache))
+  , file_(cache_->open(path))
+{
+  if (file_ < 0) {
+    throw std::runtime_error(StrCat("Failed to open tiled texture: ", path));
+  }
+}
+
+Color CachedImageTexture::bilinear(int level, double u, double v) const
+{
+  return bilinear_filter(
+    [this, level](int x, int y) { return cache_->texel(file_, level, x, y); },
+    cache_->width(file_, level), cache_->height(file_, level), u, v);
+}
+
+Color CachedImageTexture::value(double u, double v, Point3F const &p) const
+{
+  return bilinear(0, u, v);
+}
+
+Color CachedImageTexture::filtered_value(double u, double v, Point3F const &p,
+                                         double width) const
+{
+  int level;
+  double t;
+  trilinear_levels(
+    width, std::max(cache_->width(file_), cache_->height(file_)),
+    cache_->levels(file_), level, t);
+  if (t <= 0) return bilinear(level, u, v);
+  return bilinear(level, u, v) * (1 - t) + bilinear(level + 1, u, v) * t;
+}
+
+TextureSPtr rt::make_image_texture(char const *path, bool srgb,
+                                   TextureCacheSPtr const &cache)
+{
+  if (!cache) return std::make_shared<ImageTexture>(path, srgb);
+
+  struct stat st;
+  if (::stat(path, &st) != 0) {
+    throw std::runtime_error(StrCat("Failed to stat image: ", path));
+  }
+  TiledTextureSource source;
+  source.size = (uint64_t)st.st_size;
+  source.mtime_ns = (int64_t)st.st_mtim.tv_sec * 1000000000 +
+                    (int64_t)st.st_mtim.tv_nsec;
+  source.srgb = srgb ? 1 : 0;
+
+  // The decodes of sRGB and linear are kept both
+  const auto tiled_path = StrCat(path, srgb ? ".srgb.rtt" : ".linear.rtt");
+  TiledTextureSource tiled_source;
+  if (!read_tiled_texture_source(tiled_path.c_str(), tiled_source) ||
+      !(tiled_source == source))
+  {
+    ImageTexture image(path, srgb);
+    if (!write_tiled_texture(tiled_path.c_str(), image.mipmap(), source)) {
+      throw std::runtime_error(
+        StrCat("Failed to write tiled texture: ", tiled_path));
+    }
+  }
+  return std::make_shared<CachedImageTexture>(cache, tiled_path.c_str());
+}
@@ -0,0 +1,44 @@
+#ifndef TEXTURE_CACHED_IMAGE_TEXTURE_HH__
+#define TEXTURE_CACHED_IMAGE_TEXTURE_HH__
+
+#include "texture.hh"
+#include "texture_cache.hh"
+
+namespace rt {
+
+/**
+ * The image texture whose mip pyramid is paged in by a TextureCache,
+ * only the touched tiles are in memory.
+ * The filtering is the same as ImageTexture.
+ */
+class CachedImageTexture : public Texture {
+ public:
+  /**
+   * \param path The tiled texture file(see write_tiled_texture())
+   * \exception std::runtime_error The file can't be opened
+   */
+  CachedImageTexture(TextureCacheSPtr cache, char const *path);
+
+  Color value(double u, double v, Point3F const &p) const override;
+  Color filtered_value(double u, double v, Point3F const &p,
+                       double width) const override;
+
+ private:
+  Color bilinear(int level, double u, double v) const;
+
+  TextureCacheSPtr cache_;
+  int file_;
+};
+
+/**
+ * Load the image texture, through the cache if it is not null.
+ * The tiled file is path + ".srgb.rtt"(or ".linear.rtt"), it is converted
+ * from the image if it doesn't exist or it is stale(the image is changed
+ * after the conversion).
+ */
+TextureSPtr make_image_texture(char const *path, bool srgb,
+                               TextureCacheSPtr const &cache);
+
+} // namespace rt
+
+#endif
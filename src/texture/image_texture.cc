@@ -10,39 +10,27 @@ using namespace rt;
 using namespace util;
 using namespace gm;
 
-ImageTexture::ImageTexture(char const *path)
+ImageTexture::ImageTexture(char const *path, bool srgb)
 {
-  data_ = stbi_load(path, &width_, &height_, &bytes_per_pixel_, 3);
-  if (!data_) {
+  int width, height;
+  auto data = stbi_load(path, &width, &height, &bytes_per_pixel_, 3);
+  if (!data) {
     throw std::runtime_error(StrCat("Failed to load image file: ", path));
   }
+  // The channels of data is 3 whatever the file is
+  mipmap_ = MipMap(data, width, height, 3, srgb);
+  stbi_image_free(data);
 }
 
-ImageTexture::~ImageTexture() noexcept
+Color ImageTexture::value(double u, double v, Point3F const &p) const
 {
-  if (data_) stbi_image_free(data_);
+  return mipmap_.bilinear(0, u, v);
 }
 
-Color ImageTexture::value(double u, double v, Point3F const &p) const
+Color ImageTexture::filtered_value(double u, double v, Point3F const &p,
+                                   double width) const
 {
-  assert(data_);
-
-  u = clamp(u, 0, 1);
-  v = 1. - clamp(v, 0, 1);
-
-  int x = u * width_;
-  x = x >= width_ ? (width_ - 1) : x;
-  int y = v * height_;
-  y = y >= height_ ? (height_ - 1) : y;
-
-  int index = y * bytes_per_pixel_ * width_ + x * bytes_per_pixel_;
-  auto color_scale = 1. / 255.;
-
-  return {
-      data_[index] * color_scale,
-      data_[index + 1] * color_scale,
-      data_[index + 2] * color_scale,
-  };
+  return mipmap_.trilinear(u, v, width);
 }
 
 namespace rt {
@@ -50,9 +38,10 @@ namespace rt {
 std::ostream &operator<<(std::ostream &os, rt::ImageTexture const &tex)
 {
   return os << "===== Image Texture Info(start) =====\n"
-            << "width = " << tex.width_ << '\n'
-            << "height = " << tex.height_ << '\n'
+            << "width = " << tex.mipmap_.width() << '\n'
+            << "height = " << tex.mipmap_.height() << '\n'
             << "bytes_per_pixel = " << tex.bytes_per_pixel_ << '\n'
+            << "mip_levels = " << tex.mipmap_.levels() << '\n'
             << "===== Image Texture Info(end) =====";
 }
 
@@ -3,6 +3,7 @@
 
 #include <iosfwd>
 
+#include "mipmap.hh"
 #include "texture.hh"
 
 namespace rt {
@@ -11,19 +12,29 @@ namespace rt {
 
 // std::ostream &operator<<(std::ostream &os, ImageTexture const &tex);
 
+/**
+ * The image is decoded and converted to a tiled MipMap when it is loaded,
+ * the file buffer is not kept.
+ */
 class ImageTexture : public Texture {
  public:
-  explicit ImageTexture(char const *path);
-  ~ImageTexture() noexcept;
+  /**
+   * \param srgb The image is encoded by sRGB transfer function(e.g. photos)
+   */
+  explicit ImageTexture(char const *path, bool srgb = false);
 
+  // Bilinear filtering of the finest level
   Color value(double u, double v, Point3F const &p) const override;
+  // Trilinear filtering
+  Color filtered_value(double u, double v, Point3F const &p,
+                       double width) const override;
+
+  MipMap const &mipmap() const noexcept { return mipmap_; }
 
   friend std::ostream &operator<<(std::ostream &os, ImageTexture const &tex);
  private:
-  int width_ = 0;
-  int height_ = 0;
   int bytes_per_pixel_ = -1;
-  unsigned char *data_ = nullptr;
+  MipMap mipmap_;
 };
 
 } // namespace rt
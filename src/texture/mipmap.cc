@@ -0,0 +1,120 @@
+#include "mipmap.hh"
+
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+
+#include "../gm/util.hh"
+
+using namespace rt;
+
+namespace {
+
+struct DecodeLut {
+  float srgb[256];
+  float unorm[256];
+
+  DecodeLut() noexcept
+  {
+    for (int i = 0; i < 256; ++i) {
+      const double c = i / 255.;
+      unorm[i] = (float)c;
+      srgb[i] = (float)(c <= 0.04045 ? c / 12.92
+                                     : std::pow((c + 0.055) / 1.055, 2.4));
+    }
+  }
+};
+
+const DecodeLut s_lut;
+
+} // namespace
+
+float MipMap::srgb_to_linear(uint8_t code) noexcept { return s_lut.srgb[code]; }
+
+float MipMap::unorm_to_float(uint8_t code) noexcept
+{
+  return s_lut.unorm[code];
+}
+
+void MipMap::Level::resize(int w, int h)
+{
+  width = w;
+  height = h;
+  tiles_x = (w + MIPMAP_TILE_SIZE - 1) >> MIPMAP_TILE_SHIFT;
+  const int tiles_y = (h + MIPMAP_TILE_SIZE - 1) >> MIPMAP_TILE_SHIFT;
+  texels.assign((size_t)tiles_x * tiles_y * MIPMAP_TILE_SIZE * MIPMAP_TILE_SIZE,
+                Texel{0, 0, 0});
+}
+
+MipMap::MipMap(unsigned char const *data, int width, int height, int channels,
+               bool srgb)
+{
+  assert(data && width > 0 && height > 0 && channels > 0);
+  float const *lut = srgb ? s_lut.srgb : s_lut.unorm;
+
+  Level base;
+  base.resize(width, height);
+  for (int y = 0; y < height; ++y) {
+    auto row = data + (size_t)y * width * channels;
+    for (int x = 0; x < width; ++x) {
+      auto pixel = row + (size_t)x * channels;
+      auto &t = base.at(x, y);
+      t.r = lut[pixel[0]];
+      t.g = lut[pixel[channels >= 3 ? 1 : 0]];
+      t.b = lut[pixel[channels >= 3 ? 2 : 0]];
+    }
+  }
+  levels_.push_back(std::move(base));
+
+  // Box filter, the odd texel of the edge is merged into the last one
+  while (levels_.back().width > 1 || levels_.back().height > 1) {
+    auto const &src = levels_.back();
+    Level dst;
+    dst.resize(std::max(1, src.width / 2), std::max(1, src.height / 2));
+    for (int y = 0; y < dst.height; ++y) {
+      const int y0 = std::min(2 * y, src.height - 1);
+      const int y1 = std::min(2 * y + 1, src.height - 1);
+      for (int x = 0; x < dst.width; ++x) {
+        const int x0 = std::min(2 * x, src.width - 1);
+        const int x1 = std::min(2 * x + 1, src.width - 1);
+        auto const &a = src.at(x0, y0);
+        auto const &b = src.at(x1, y0);
+        auto const &c = src.at(x0, y1);
+        auto const &d = src.at(x1, y1);
+        dst.at(x, y) = {(a.r + b.r + c.r + d.r) / 4,
+                        (a.g + b.g + c.g + d.g) / 4,
+                        (a.b + b.b + c.b + d.b) / 4};
+      }
+    }
+    levels_.push_back(std::move(dst));
+  }
+}
+
+Color MipMap::nearest(double u, double v) const noexcept
+{
+  auto const &level = levels_[0];
+  u = gm::clamp(u, 0, 1);
+  v = 1. - gm::clamp(v, 0, 1);
+  const int x = std::min((int)(u * level.width), level.width - 1);
+  const int y = std::min((int)(v * level.height), level.height - 1);
+  auto const &t = level.at(x, y);
+  return {t.r, t.g, t.b};
+}
+
+Color MipMap::bilinear(int level_index, double u, double v) const noexcept
+{
+  auto const &level = levels_[level_index];
+  return bilinear_filter(
+    [&level](int x, int y) -> Texel const & { return level.at(x, y); },
+    level.width, level.height, u, v);
+}
+
+Color MipMap::trilinear(double u, double v, double width) const noexcept
+{
+  int level;
+  double t;
+  trilinear_levels(width, std::max(levels_[0].width, levels_[0].height),
+                   levels(), level, t);
+  if (t <= 0) return bilinear(level, u, v);
+  return bilinear(level, u, v) * (1 - t) + bilinear(level + 1, u, v) * t;
+}
@@ -0,0 +1,166 @@
+#ifndef TEXTURE_MIPMAP_HH__
+#define TEXTURE_MIPMAP_HH__
+
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+#include <vector>
+
+#include "../rt/color.hh"
+
+// The texels of a level are stored in tiles of
+// MIPMAP_TILE_SIZE x MIPMAP_TILE_SIZE(row-major in a tile and among tiles),
+// the texels of a bilinear lookup are in the same tile mostly
+#define MIPMAP_TILE_SHIFT 3
+#define MIPMAP_TILE_SIZE (1 << MIPMAP_TILE_SHIFT)
+
+namespace rt {
+
+/**
+ * Bilinear filtering of a level whose texels are fetched by
+ * fetch(x, y) -> {r, g, b}, the coordinates are clamped to the edge
+ * (shared by MipMap and the out-of-core textures)
+ */
+template <typename Fetch>
+Color bilinear_filter(Fetch const &fetch, int width, int height, double u,
+                      double v)
+{
+  // The centers of texels are at half-integer coordinates
+  const double x = (u < 0 ? 0 : u > 1 ? 1 : u) * width - 0.5;
+  const double y = (1. - (v < 0 ? 0 : v > 1 ? 1 : v)) * height - 0.5;
+  const double fx = std::floor(x);
+  const double fy = std::floor(y);
+  const float dx = (float)(x - fx);
+  const float dy = (float)(y - fy);
+
+  const int x0 = std::max((int)fx, 0);
+  const int y0 = std::max((int)fy, 0);
+  const int x1 = std::min((int)fx + 1, width - 1);
+  const int y1 = std::min((int)fy + 1, height - 1);
+
+  auto const a = fetch(x0, y0);
+  auto const b = fetch(x1, y0);
+  auto const c = fetch(x0, y1);
+  auto const d = fetch(x1, y1);
+  const float wa = (1 - dx) * (1 - dy);
+  const float wb = dx * (1 - dy);
+  const float wc = (1 - dx) * dy;
+  const float wd = dx * dy;
+  return {wa * a.r + wb * b.r + wc * c.r + wd * d.r,
+          wa * a.g + wb * b.g + wc * c.g + wd * d.g,
+          wa * a.b + wb * b.b + wc * c.b + wd * d.b};
+}
+
+/**
+ * Choose the levels of trilinear filtering
+ * \param width The width of footprint in texture space
+ * \param resolution The max of width and height of level 0
+ * \param level The finer level
+ * \param t The weight of the coarser level(level + 1), 0 if the finer level
+ *          is used only
+ */
+inline void trilinear_levels(double width, int resolution, int levels,
+                             int &level, double &t) noexcept
+{
+  const double texels = width * resolution;
+  level = 0;
+  t = 0;
+  if (!(texels > 1)) return;
+
+  const double lod = std::log2(texels);
+  if (lod >= levels - 1) {
+    level = levels - 1;
+    return;
+  }
+  level = (int)lod;
+  t = lod - level;
+}
+
+/**
+ * The image pyramid of a texture
+ *
+ * The 8-bit texels are decoded once by a LUT(sRGB or linear) into floats,
+ * each level is half of the former one(box filter), the last one is 1x1.
+ * The coordinates are clamped to the edge.
+ */
+class MipMap {
+ public:
+  struct Texel {
+    float r, g, b;
+  };
+
+  MipMap() = default;
+
+  /**
+   * \param data Row-major 8-bit texels, the first row is the top one
+   * \param channels The bytes per texel, the first 3 are RGB(gray if 1)
+   * \param srgb Decode the sRGB transfer function, otherwise divide by 255
+   */
+  MipMap(unsigned char const *data, int width, int height, int channels,
+         bool srgb);
+
+  /**
+   * The texel at level 0 nearest to (u, v), v = 0 is the bottom
+   */
+  Color nearest(double u, double v) const noexcept;
+
+  /**
+   * Bilinear filtering of a level
+   */
+  Color bilinear(int level, double u, double v) const noexcept;
+
+  /**
+   * Trilinear filtering
+   * \param width The width of the footprint in texture space([0, 1]),
+   *              the level of detail is log2(width * resolution).
+   *              0 is the bilinear filtering of level 0.
+   */
+  Color trilinear(double u, double v, double width) const noexcept;
+
+  int levels() const noexcept { return (int)levels_.size(); }
+  int width(int level = 0) const noexcept { return levels_[level].width; }
+  int height(int level = 0) const noexcept { return levels_[level].height; }
+  Texel const &texel(int level, int x, int y) const noexcept
+  {
+    return levels_[level].at(x, y);
+  }
+
+  /**
+   * The decoded values of 8-bit codes
+   */
+  static float srgb_to_linear(uint8_t code) noexcept;
+  static float unorm_to_float(uint8_t code) noexcept;
+
+ private:
+  struct Level {
+    int width = 0;
+    int height = 0;
+    int tiles_x = 0;
+    std::vector<Texel> texels;
+
+    void resize(int w, int h);
+
+    Texel &at(int x, int y) noexcept
+    {
+      return texels[index(x, y)];
+    }
+    Texel const &at(int x, int y) const noexcept
+    {
+      return texels[index(x, y)];
+    }
+    size_t index(int x, int y) const noexcept
+    {
+      const int tile = (y >> MIPMAP_TILE_SHIFT) * tiles_x +
+                       (x >> MIPMAP_TILE_SHIFT);
+      return ((size_t)tile << (2 * MIPMAP_TILE_SHIFT)) +
+             ((y & (MIPMAP_TILE_SIZE - 1)) << MIPMAP_TILE_SHIFT) +
+             (x & (MIPMAP_TILE_SIZE - 1));
+    }
+  };
+
+  std::vector<Level> levels_;
+};
+
+} // namespace rt
+
+#endif
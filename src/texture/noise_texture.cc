@@ -0,0 +1,85 @@
+#include "noise_texture.hh"
+
+#include <cmath>
+
+using namespace rt;
+
+NoiseTexture::NoiseTexture(NoisePattern pattern, double scale, Color const &c0,
+                           Color const &c1, uint64_t seed, int octaves)
+  : perlin_(seed)
+  , pattern_(pattern)
+  , scale_(scale)
+  , c0_(c0)
+  , c1_(c1)
+  , octaves_(octaves)
+{
+}
+
+template <int N>
+void NoiseTexture::evaluate(Point3F const *p, Color *out) const noexcept
+{
+  const float s = (float)scale_;
+  float x[N], y[N], z[N], t[N];
+  for (int i = 0; i < N; ++i) {
+    x[i] = (float)p[i].x;
+    y[i] = (float)p[i].y;
+    z[i] = (float)p[i].z;
+  }
+
+  // The marble and the wood perturb the stripes by the unscaled noise
+  switch (pattern_) {
+    case NOISE_PLAIN:
+    case NOISE_FBM:
+    case NOISE_TURBULENCE: {
+      float sx[N], sy[N], sz[N];
+      for (int i = 0; i < N; ++i) {
+        sx[i] = s * x[i];
+        sy[i] = s * y[i];
+        sz[i] = s * z[i];
+      }
+      if (pattern_ == NOISE_PLAIN) {
+        perlin_.noise<N>(sx, sy, sz, t);
+        for (int i = 0; i < N; ++i) t[i] = 0.5f * (1 + t[i]);
+      } else if (pattern_ == NOISE_FBM) {
+        perlin_.fbm<N>(sx, sy, sz, octaves_, t);
+        for (int i = 0; i < N; ++i) t[i] = 0.5f * (1 + t[i]);
+      } else {
+        perlin_.turbulence<N>(sx, sy, sz, octaves_, t);
+      }
+    } break;
+    case NOISE_MARBLE: {
+      perlin_.turbulence<N>(x, y, z, octaves_, t);
+      for (int i = 0; i < N; ++i)
+        t[i] = 0.5f * (1 + std::sin(s * z[i] + 10 * t[i]));
+    } break;
+    case NOISE_WOOD: {
+      perlin_.fbm<N>(x, y, z, octaves_, t);
+      for (int i = 0; i < N; ++i) {
+        const float r = s * std::sqrt(x[i] * x[i] + z[i] * z[i]) + 2 * t[i];
+        t[i] = r - std::floor(r);
+      }
+    } break;
+  }
+
+  for (int i = 0; i < N; ++i) {
+    const double w = t[i] < 0 ? 0 : t[i] > 1 ? 1 : t[i];
+    out[i] = c0_ + (c1_ - c0_) * w;
+  }
+}
+
+Color NoiseTexture::value(double u, double v, Point3F const &p) const
+{
+  Color ret;
+  evaluate<1>(&p, &ret);
+  return ret;
+}
+
+void NoiseTexture::values(int n, double const *u, double const *v,
+                          Point3F const *p, Color *out) const
+{
+  int i = 0;
+  for (; i + PERLIN_MAX_LANES <= n; i += PERLIN_MAX_LANES)
+    evaluate<PERLIN_MAX_LANES>(p + i, out + i);
+  for (; i + 4 <= n; i += 4) evaluate<4>(p + i, out + i);
+  for (; i < n; ++i) evaluate<1>(p + i, out + i);
+}
@@ -0,0 +1,54 @@
+#ifndef TEXTURE_NOISE_TEXTURE_HH__
+#define TEXTURE_NOISE_TEXTURE_HH__
+
+#include "perlin.hh"
+#include "texture.hh"
+
+#define NOISE_DEFAULT_OCTAVES 7
+
+namespace rt {
+
+enum NoisePattern {
+  NOISE_PLAIN,      // 0.5 * (1 + noise(s * p))
+  NOISE_FBM,        // 0.5 * (1 + fbm(s * p))
+  NOISE_TURBULENCE, // turbulence(s * p)
+  NOISE_MARBLE,     // 0.5 * (1 + sin(s * p.z + 10 * turbulence(p)))
+  NOISE_WOOD,       // fract(s * distance to y axis + 2 * fbm(p))
+};
+
+/**
+ * The procedural solid texture interpolating two colors by the noise
+ * pattern at the point, the UV is not used
+ */
+class NoiseTexture : public Texture {
+ public:
+  /**
+   * \param scale The frequency of the pattern
+   * \param c0 The color of pattern 0
+   * \param c1 The color of pattern 1
+   */
+  NoiseTexture(NoisePattern pattern, double scale, Color const &c0 = {0, 0, 0},
+               Color const &c1 = {1, 1, 1}, uint64_t seed = 0,
+               int octaves = NOISE_DEFAULT_OCTAVES);
+
+  Color value(double u, double v, Point3F const &p) const override;
+  void values(int n, double const *u, double const *v, Point3F const *p,
+              Color *out) const override;
+
+  Perlin const &perlin() const noexcept { return perlin_; }
+
+ private:
+  template <int N>
+  void evaluate(Point3F const *p, Color *out) const noexcept;
+
+  Perlin perlin_;
+  NoisePattern pattern_;
+  double scale_;
+  Color c0_;
+  Color c1_;
+  int octaves_;
+};
+
+} // namespace rt
+
+#endif
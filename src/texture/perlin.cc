@@ -0,0 +1,185 @@
+#include "perlin.hh"
+
+#include <cmath>
+
+#include "../util/random.hh"
+
+using namespace rt;
+
+#define PERLIN_LACUNARITY 2.f
+#define PERLIN_GAIN 0.5f
+
+static inline float fade(float t) noexcept
+{
+  return t * t * t * (t * (t * 6 - 15) + 10);
+}
+
+static inline float lerp(float t, float a, float b) noexcept
+{
+  return a + t * (b - a);
+}
+
+/**
+ * The dot of (x, y, z) and one of the 12 edge directions of cube
+ * (4 of them are repeated to use 16 hashes)
+ */
+static inline float grad(int hash, float x, float y, float z) noexcept
+{
+  const int h = hash & 15;
+  const float u = h < 8 ? x : y;
+  const float v = h < 4 ? y : (h == 12 || h == 14 ? x : z);
+  return ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
+}
+
+Perlin::Perlin(uint64_t seed)
+{
+  // Fisher-Yates shuffle, independent of the generator of thread
+  for (int i = 0; i < PERLIN_TABLE_SIZE; ++i) perm_[i] = (uint8_t)i;
+  for (int i = PERLIN_TABLE_SIZE - 1; i > 0; --i) {
+    const int j = (int)(util::mix_seed(seed, (uint64_t)i) % (uint64_t)(i + 1));
+    const auto tmp = perm_[i];
+    perm_[i] = perm_[j];
+    perm_[j] = tmp;
+  }
+  for (int i = 0; i < PERLIN_TABLE_SIZE; ++i)
+    perm_[PERLIN_TABLE_SIZE + i] = perm_[i];
+}
+
+template <int N>
+void Perlin::noise(float const *x, float const *y, float const *z,
+                   float *out) const noexcept
+{
+  static_assert(N >= 1 && N <= PERLIN_MAX_LANES, "Invalid number of lanes");
+  int xi[N], yi[N], zi[N];
+  float fx[N], fy[N], fz[N];
+  float u[N], v[N], w[N];
+
+  for (int i = 0; i < N; ++i) {
+    const float x0 = std::floor(x[i]);
+    const float y0 = std::floor(y[i]);
+    const float z0 = std::floor(z[i]);
+    xi[i] = (int)x0 & (PERLIN_TABLE_SIZE - 1);
+    yi[i] = (int)y0 & (PERLIN_TABLE_SIZE - 1);
+    zi[i] = (int)z0 & (PERLIN_TABLE_SIZE - 1);
+    fx[i] = x[i] - x0;
+    fy[i] = y[i] - y0;
+    fz[i] = z[i] - z0;
+    u[i] = fade(fx[i]);
+    v[i] = fade(fy[i]);
+    w[i] = fade(fz[i]);
+  }
+
+  // The hashes of the 8 corners
+  int h[8][N];
+  for (int i = 0; i < N; ++i) {
+    const int a = perm_[xi[i]] + yi[i];
+    const int aa = perm_[a] + zi[i];
+    const int ab = perm_[a + 1] + zi[i];
+    const int b = perm_[xi[i] + 1] + yi[i];
+    const int ba = perm_[b] + zi[i];
+    const int bb = perm_[b + 1] + zi[i];
+    h[0][i] = perm_[aa];
+    h[1][i] = perm_[ba];
+    h[2][i] = perm_[ab];
+    h[3][i] = perm_[bb];
+    h[4][i] = perm_[aa + 1];
+    h[5][i] = perm_[ba + 1];
+    h[6][i] = perm_[ab + 1];
+    h[7][i] = perm_[bb + 1];
+  }
+
+  for (int i = 0; i < N; ++i) {
+    const float g0 = grad(h[0][i], fx[i], fy[i], fz[i]);
+    const float g1 = grad(h[1][i], fx[i] - 1, fy[i], fz[i]);
+    const float g2 = grad(h[2][i], fx[i], fy[i] - 1, fz[i]);
+    const float g3 = grad(h[3][i], fx[i] - 1, fy[i] - 1, fz[i]);
+    const float g4 = grad(h[4][i], fx[i], fy[i], fz[i] - 1);
+    const float g5 = grad(h[5][i], fx[i] - 1, fy[i], fz[i] - 1);
+    const float g6 = grad(h[6][i], fx[i], fy[i] - 1, fz[i] - 1);
+    const float g7 = grad(h[7][i], fx[i] - 1, fy[i] - 1, fz[i] - 1);
+    out[i] = lerp(w[i], lerp(v[i], lerp(u[i], g0, g1), lerp(u[i], g2, g3)),
+                  lerp(v[i], lerp(u[i], g4, g5), lerp(u[i], g6, g7)));
+  }
+}
+
+template <int N, bool Absolute>
+void Perlin::octaves(float const *x, float const *y, float const *z,
+                     int octaves, float *out) const noexcept
+{
+  float px[N], py[N], pz[N], n[N];
+  for (int i = 0; i < N; ++i) {
+    px[i] = x[i];
+    py[i] = y[i];
+    pz[i] = z[i];
+    out[i] = 0;
+  }
+
+  float amplitude = 1;
+  for (int octave = 0; octave < octaves; ++octave) {
+    noise<N>(px, py, pz, n);
+    for (int i = 0; i < N; ++i) {
+      out[i] += amplitude * (Absolute ? std::fabs(n[i]) : n[i]);
+      px[i] *= PERLIN_LACUNARITY;
+      py[i] *= PERLIN_LACUNARITY;
+      pz[i] *= PERLIN_LACUNARITY;
+    }
+    amplitude *= PERLIN_GAIN;
+  }
+}
+
+template <int N>
+void Perlin::fbm(float const *x, float const *y, float const *z, int octaves,
+                 float *out) const noexcept
+{
+  this->octaves<N, false>(x, y, z, octaves, out);
+}
+
+template <int N>
+void Perlin::turbulence(float const *x, float const *y, float const *z,
+                        int octaves, float *out) const noexcept
+{
+  this->octaves<N, true>(x, y, z, octaves, out);
+}
+
+double Perlin::noise(Point3F const &p) const noexcept
+{
+  const float x = (float)p.x, y = (float)p.y, z = (float)p.z;
+  float out;
+  noise<1>(&x, &y, &z, &out);
+  return out;
+}
+
+double Perlin::fbm(Point3F const &p, int octaves) const noexcept
+{
+  const float x = (float)p.x, y = (float)p.y, z = (float)p.z;
+  float out;
+  fbm<1>(&x, &y, &z, octaves, &out);
+  return out;
+}
+
+double Perlin::turbulence(Point3F const &p, int octaves) const noexcept
+{
+  const float x = (float)p.x, y = (float)p.y, z = (float)p.z;
+  float out;
+  turbulence<1>(&x, &y, &z, octaves, &out);
+  return out;
+}
+
+namespace rt {
+
+#define PERLIN_INSTANTIATE(N)                                                  \
+  template void Perlin::noise<N>(float const *, float const *, float const *, \
+                                 float *) const noexcept;                      \
+  template void Perlin::fbm<N>(float const *, float const *, float const *,   \
+                               int, float *) const noexcept;                   \
+  template void Perlin::turbulence<N>(float const *, float const *,           \
+                                      float const *, int, float *)            \
+    const noexcept;
+
+PERLIN_INSTANTIATE(1)
+PERLIN_INSTANTIATE(4)
+PERLIN_INSTANTIATE(8)
+
+#undef PERLIN_INSTANTIATE
+
+} // namespace rt
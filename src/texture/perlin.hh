@@ -0,0 +1,71 @@
+#ifndef TEXTURE_PERLIN_HH__
+#define TEXTURE_PERLIN_HH__
+
+#include <stdint.h>
+
+#include "../gm/point.hh"
+
+// The period of the lattice
+#define PERLIN_TABLE_SIZE 256
+// The max lookups evaluated together
+#define PERLIN_MAX_LANES 8
+
+namespace rt {
+
+/**
+ * Gradient noise(Perlin's improved noise, 2002)
+ *
+ * The permutation is stored twice in 512 bytes(8 cache lines), so the
+ * nested hashes perm[perm[x] + y] need no wrapping.
+ * The gradient is selected by the hash arithmetically instead of a table
+ * lookup, the batched functions evaluate the lanes stage by stage in
+ * branch-free loops which are vectorized by the compiler, only the hashes
+ * are gathered lane by lane.
+ *
+ * The values are in about [-1, 1], and 0 at the lattice points.
+ */
+class Perlin {
+ public:
+  /**
+   * \param seed The permutation is shuffled by it
+   */
+  explicit Perlin(uint64_t seed = 0);
+
+  double noise(Point3F const &p) const noexcept;
+
+  /**
+   * Fractional Brownian motion: sum(gain^i * noise(lacunarity^i * p))
+   */
+  double fbm(Point3F const &p, int octaves) const noexcept;
+
+  /**
+   * Like fbm() but sum the absolute values, in [0, 2)
+   */
+  double turbulence(Point3F const &p, int octaves) const noexcept;
+
+  /**
+   * Evaluate N lookups together
+   * \tparam N 1, 4 or 8(PERLIN_MAX_LANES)
+   * \param x, y, z The coordinates of the lookups(structure of arrays)
+   */
+  template <int N>
+  void noise(float const *x, float const *y, float const *z,
+             float *out) const noexcept;
+  template <int N>
+  void fbm(float const *x, float const *y, float const *z, int octaves,
+           float *out) const noexcept;
+  template <int N>
+  void turbulence(float const *x, float const *y, float const *z, int octaves,
+                  float *out) const noexcept;
+
+ private:
+  template <int N, bool Absolute>
+  void octaves(float const *x, float const *y, float const *z, int octaves,
+               float *out) const noexcept;
+
+  alignas(64) uint8_t perm_[PERLIN_TABLE_SIZE * 2];
+};
+
+} // namespace rt
+
+#endif
@@ -17,6 +17,8 @@ class SolidTexture : public Texture {
   {
     return color_;
   }
+
+  rt::Color const &color() const noexcept { return color_; }
  private:
   rt::Color color_;
 };
@@ -11,6 +11,26 @@ namespace rt {
 class Texture {
  public:
   virtual rt::Color value(double u, double v, Point3F const &p) const = 0;
+
+  /**
+   * The average over the footprint of the ray cone
+   * \param width The width of the footprint in UV space, 0 if unknown
+   */
+  virtual rt::Color filtered_value(double u, double v, Point3F const &p,
+                                   double width) const
+  {
+    return value(u, v, p);
+  }
+
+  /**
+   * Evaluate \p n lookups together(e.g. the hits of a batch of rays),
+   * the procedural textures evaluate them in SIMD lanes
+   */
+  virtual void values(int n, double const *u, double const *v,
+                      Point3F const *p, rt::Color *out) const
+  {
+    for (int i = 0; i < n; ++i) out[i] = value(u[i], v[i], p[i]);
+  }
 };
 
 using TextureSPtr = std::shared_ptr<Texture>;
@@ -0,0 +1,380 @@
+#include "texture_cache.hh"
+
+#include <assert.h>
+#include <chrono>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace rt;
+
+#define TILE_TEXELS (TEXTURE_CACHE_TILE_SIZE * TEXTURE_CACHE_TILE_SIZE)
+#define TILE_BYTES (TILE_TEXELS * sizeof(MipMap::Texel))
+
+static constexpr char tiled_texture_magic[4] = {'R', 'T', 'T', '2'};
+
+namespace {
+
+struct FileHeader {
+  char magic[4];
+  uint32_t levels;
+  uint32_t tile_size;
+  uint32_t srgb;
+  uint64_t source_size;
+  int64_t source_mtime_ns;
+};
+
+static_assert(sizeof(FileHeader) == 32, "The header of RTT2 is 32 bytes");
+
+struct LevelHeader {
+  uint32_t width;
+  uint32_t height;
+  uint64_t offset;
+};
+
+inline int tile_count(int n) noexcept
+{
+  return (n + TEXTURE_CACHE_TILE_SIZE - 1) / TEXTURE_CACHE_TILE_SIZE;
+}
+
+/**
+ * The key of tile:
+ * file(16 bits) | level(8 bits) | ty(20 bits) | tx(20 bits)
+ */
+inline uint64_t tile_key(int file, int level, int tx, int ty) noexcept
+{
+  return ((uint64_t)file << 48) | ((uint64_t)level << 40) |
+         ((uint64_t)ty << 20) | (uint64_t)tx;
+}
+
+inline uint64_t hash_key(uint64_t key) noexcept
+{
+  // splitmix64 finalizer
+  key ^= key >> 30;
+  key *= 0xbf58476d1ce4e5b9ULL;
+  key ^= key >> 27;
+  key *= 0x94d049bb133111ebULL;
+  key ^= key >> 31;
+  return key;
+}
+
+struct MicroEntry {
+  uint64_t key = 0;
+  TextureCache::TileSPtr tile;
+};
+
+/**
+ * The micro-cache of current thread, it serves one cache at a time
+ * (its entries and counters are dropped if another cache is used)
+ */
+struct MicroCache {
+  uint64_t owner = 0;
+  MicroEntry entries[TEXTURE_CACHE_MICRO_SIZE];
+  uint64_t lookups = 0;
+  uint64_t micro_hits = 0;
+
+  void reset(uint64_t id) noexcept
+  {
+    owner = id;
+    for (auto &entry : entries) entry = MicroEntry{};
+    lookups = 0;
+    micro_hits = 0;
+  }
+};
+
+thread_local MicroCache tls_micro_cache;
+
+std::atomic<uint64_t> s_cache_id{1};
+std::atomic<uint64_t> s_temp_id{0};
+
+} // namespace
+
+bool rt::write_tiled_texture(char const *path, MipMap const &mipmap,
+                             TiledTextureSource const &source)
+{
+  // The other processes(or threads) may convert the same image at the
+  // same time, every writer has its temporary file
+  std::string temp_path(path);
+  temp_path += ".tmp.";
+  temp_path += std::to_string(::getpid());
+  temp_path += ".";
+  temp_path +=
+    std::to_string(s_temp_id.fetch_add(1, std::memory_order_relaxed));
+
+  auto fp = fopen(temp_path.c_str(), "wb");
+  if (!fp) return false;
+
+  const int levels = mipmap.levels();
+  FileHeader header;
+  memset(&header, 0, sizeof header);
+  memcpy(header.magic, tiled_texture_magic, sizeof header.magic);
+  header.levels = (uint32_t)levels;
+  header.tile_size = TEXTURE_CACHE_TILE_SIZE;
+  header.srgb = source.srgb;
+  header.source_size = source.size;
+  header.source_mtime_ns = source.mtime_ns;
+  bool ok = fwrite(&header, sizeof header, 1, fp) == 1;
+
+  uint64_t offset = sizeof(FileHeader) + sizeof(LevelHeader) * levels;
+  for (int i = 0; i < levels && ok; ++i) {
+    LevelHeader level{(uint32_t)mipmap.width(i), (uint32_t)mipmap.height(i),
+                      offset};
+    ok = fwrite(&level, sizeof level, 1, fp) == 1;
+    offset += (uint64_t)tile_count(mipmap.width(i)) *
+              tile_count(mipmap.height(i)) * TILE_BYTES;
+  }
+
+  std::vector<MipMap::Texel> tile(TILE_TEXELS);
+  for (int i = 0; i < levels && ok; ++i) {
+    const int w = mipmap.width(i);
+    const int h = mipmap.height(i);
+    for (int ty = 0; ty < tile_count(h) && ok; ++ty) {
+      for (int tx = 0; tx < tile_count(w) && ok; ++tx) {
+        for (int y = 0; y < TEXTURE_CACHE_TILE_SIZE; ++y) {
+          for (int x = 0; x < TEXTURE_CACHE_TILE_SIZE; ++x) {
+            const int sx = tx * TEXTURE_CACHE_TILE_SIZE + x;
+            const int sy = ty * TEXTURE_CACHE_TILE_SIZE + y;
+            tile[y * TEXTURE_CACHE_TILE_SIZE + x] =
+              sx < w && sy < h ? mipmap.texel(i, sx, sy) : MipMap::Texel{};
+          }
+        }
+        ok = fwrite(tile.data(), TILE_BYTES, 1, fp) == 1;
+      }
+    }
+  }
+
+  ok = fclose(fp) == 0 && ok;
+  if (ok) ok = ::rename(temp_path.c_str(), path) == 0;
+  if (!ok) ::unlink(temp_path.c_str());
+  return ok;
+}
+
+bool rt::read_tiled_texture_source(char const *path,
+                                   TiledTextureSource &source)
+{
+  auto fp = fopen(path, "rb");
+  if (!fp) return false;
+
+  FileHeader header;
+  const bool ok = fread(&header, sizeof header, 1, fp) == 1 &&
+                  memcmp(header.magic, tiled_texture_magic,
+                         sizeof header.magic) == 0;
+  fclose(fp);
+  if (!ok) return false;
+
+  source.size = header.source_size;
+  source.mtime_ns = header.source_mtime_ns;
+  source.srgb = header.srgb;
+  return true;
+}
+
+TextureCache::TextureCache(size_t budget_bytes)
+  : id_(s_cache_id.fetch_add(1, std::memory_order_relaxed))
+{
+  capacity_ = std::max<size_t>(1, budget_bytes / TILE_BYTES /
+                                    TEXTURE_CACHE_SHARD_NUM);
+  for (auto &shard : shards_) {
+    shard.slots.reserve(capacity_);
+    shard.index.reserve(capacity_);
+  }
+}
+
+TextureCache::~TextureCache() noexcept
+{
+  for (auto &file : files_) {
+    if (file.fd >= 0) ::close(file.fd);
+  }
+}
+
+int TextureCache::open(char const *path)
+{
+  if (files_.size() >= (1 << 16)) return -1;
+
+  File file;
+  file.path = path;
+  file.fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  if (file.fd < 0) return -1;
+
+  struct stat st;
+  FileHeader header;
+  const bool valid =
+    ::fstat(file.fd, &st) == 0 &&
+    ::pread(file.fd, &header, sizeof header, 0) == sizeof header &&
+    memcmp(header.magic, tiled_texture_magic, sizeof header.magic) == 0 &&
+    header.tile_size == TEXTURE_CACHE_TILE_SIZE && header.levels > 0 &&
+    header.levels <= 32;
+  if (!valid) {
+    ::close(file.fd);
+    return -1;
+  }
+
+  std::vector<LevelHeader> levels(header.levels);
+  const auto bytes = sizeof(LevelHeader) * levels.size();
+  if (::pread(file.fd, levels.data(), bytes, sizeof header) != (ssize_t)bytes) {
+    ::close(file.fd);
+    return -1;
+  }
+
+  // The tiles must be in the file, so a lookup never fails
+  for (auto const &level : levels) {
+    const int tiles_x = tile_count(level.width);
+    const uint64_t end =
+      level.offset + (uint64_t)tiles_x * tile_count(level.height) * TILE_BYTES;
+    if (level.width == 0 || level.height == 0 || level.width >= (1 << 25) ||
+        level.height >= (1 << 25) || end > (uint64_t)st.st_size) {
+      ::close(file.fd);
+      return -1;
+    }
+    file.levels.push_back(
+      {(int)level.width, (int)level.height, tiles_x, level.offset});
+  }
+
+  files_.push_back(std::move(file));
+  return (int)files_.size() - 1;
+}
+
+auto TextureCache::read_tile(uint64_t key) const -> TileSPtr
+{
+  auto const &file = files_[key >> 48];
+  auto const &level = file.levels[(key >> 40) & 0xff];
+  const uint64_t ty = (key >> 20) & 0xfffff;
+  const uint64_t tx = key & 0xfffff;
+  const uint64_t offset =
+    level.offset + (ty * level.tiles_x + tx) * TILE_BYTES;
+
+  TileSPtr tile(new MipMap::Texel[TILE_TEXELS]);
+  const auto start = std::chrono::steady_clock::now();
+  auto n = ::pread(file.fd, const_cast<MipMap::Texel *>(tile.get()),
+                   TILE_BYTES, offset);
+  const auto cost = std::chrono::steady_clock::now() - start;
+  // open() has checked the tiles are in the file, a short read means the
+  // file is changed or broken under the render threads
+  if (n != (ssize_t)TILE_BYTES) {
+    fprintf(stderr, "Failed to read the tile of texture: %s\n",
+            file.path.c_str());
+    abort();
+  }
+
+  misses_.fetch_add(1, std::memory_order_relaxed);
+  bytes_read_.fetch_add(TILE_BYTES, std::memory_order_relaxed);
+  read_nanoseconds_.fetch_add(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(cost).count(),
+    std::memory_order_relaxed);
+  return tile;
+}
+
+auto TextureCache::tile(uint64_t key) const -> TileSPtr
+{
+  auto &shard = shards_[hash_key(key) % TEXTURE_CACHE_SHARD_NUM];
+  {
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    auto iter = shard.index.find(key);
+    if (iter != shard.index.end()) {
+      auto &slot = shard.slots[iter->second];
+      slot.referenced = true;
+      shared_hits_.fetch_add(1, std::memory_order_relaxed);
+      return slot.tile;
+    }
+  }
+
+  // Don't block the other lookups of the shard while reading
+  auto tile = read_tile(key);
+
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  // Another thread has loaded it
+  auto iter = shard.index.find(key);
+  if (iter != shard.index.end()) return shard.slots[iter->second].tile;
+
+  if (shard.slots.size() < capacity_) {
+    shard.index.emplace(key, (int)shard.slots.size());
+    shard.slots.push_back({key, tile, true});
+    return tile;
+  }
+
+  // CLOCK: give a second chance to the referenced slots
+  for (;;) {
+    auto &slot = shard.slots[shard.hand];
+    const int victim = (int)shard.hand;
+    shard.hand = (shard.hand + 1) % shard.slots.size();
+    if (slot.referenced) {
+      slot.referenced = false;
+      continue;
+    }
+
+    shard.index.erase(slot.key);
+    shard.index.emplace(key, victim);
+    slot = {key, tile, true};
+    evictions_.fetch_add(1, std::memory_order_relaxed);
+    return tile;
+  }
+}
+
+MipMap::Texel TextureCache::texel(int file, int level, int x, int y) const
+{
+  assert(file >= 0 && (size_t)file < files_.size());
+  assert(x >= 0 && x < width(file, level) && y >= 0 && y < height(file, level));
+
+  auto &micro = tls_micro_cache;
+  if (micro.owner != id_) micro.reset(id_);
+  ++micro.lookups;
+
+  const int tx = x / TEXTURE_CACHE_TILE_SIZE;
+  const int ty = y / TEXTURE_CACHE_TILE_SIZE;
+  const uint64_t key = tile_key(file, level, tx, ty);
+  const int texel_index = (y % TEXTURE_CACHE_TILE_SIZE) *
+                            TEXTURE_CACHE_TILE_SIZE +
+                          x % TEXTURE_CACHE_TILE_SIZE;
+
+  // The neighboring tiles are mapped to different entries
+  auto &entry = micro.entries[(tx + ty * 3 + level * 7) %
+                              TEXTURE_CACHE_MICRO_SIZE];
+  if (entry.tile && entry.key == key) {
+    ++micro.micro_hits;
+    return entry.tile[texel_index];
+  }
+
+  entry.tile = tile(key);
+  entry.key = key;
+  return entry.tile[texel_index];
+}
+
+void TextureCache::flush_thread_stats() const noexcept
+{
+  auto &micro = tls_micro_cache;
+  if (micro.owner != id_) return;
+  lookups_.fetch_add(micro.lookups, std::memory_order_relaxed);
+  micro_hits_.fetch_add(micro.micro_hits, std::memory_order_relaxed);
+  micro.lookups = 0;
+  micro.micro_hits = 0;
+}
+
+auto TextureCache::stats() const noexcept -> Stats
+{
+  Stats ret;
+  ret.lookups = lookups_.load(std::memory_order_relaxed);
+  ret.micro_hits = micro_hits_.load(std::memory_order_relaxed);
+  ret.shared_hits = shared_hits_.load(std::memory_order_relaxed);
+  ret.misses = misses_.load(std::memory_order_relaxed);
+  ret.evictions = evictions_.load(std::memory_order_relaxed);
+  ret.bytes_read = bytes_read_.load(std::memory_order_relaxed);
+  ret.read_seconds =
+    (double)read_nanoseconds_.load(std::memory_order_relaxed) * 1e-9;
+  return ret;
+}
+
+void TextureCache::Stats::Print(FILE *fp) const
+{
+  fprintf(fp, "===== Texture cache statistics =====\n");
+  fprintf(fp, "%-20s %20llu\n", "lookups", (unsigned long long)lookups);
+  fprintf(fp, "%-20s %20llu\n", "micro_hits", (unsigned long long)micro_hits);
+  fprintf(fp, "%-20s %20llu\n", "shared_hits", (unsigned long long)shared_hits);
+  fprintf(fp, "%-20s %20llu\n", "misses", (unsigned long long)misses);
+  fprintf(fp, "%-20s %20llu\n", "evictions", (unsigned long long)evictions);
+  fprintf(fp, "%-20s %20.3lf\n", "hit_rate", hit_rate());
+  fprintf(fp, "%-20s %20.3lf\n", "mbytes_read",
+          (double)bytes_read / 1048576.);
+  fprintf(fp, "%-20s %20.3lf\n", "read_seconds", read_seconds);
+}
@@ -0,0 +1,188 @@
+#ifndef TEXTURE_TEXTURE_CACHE_HH__
+#define TEXTURE_TEXTURE_CACHE_HH__
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../util/noncopyable.hh"
+#include "mipmap.hh"
+
+// The tiles of the file and the cache(in texels)
+#define TEXTURE_CACHE_TILE_SIZE 32
+// The shards of the cache, each one has its lock and CLOCK hand
+#define TEXTURE_CACHE_SHARD_NUM 16
+// The entries of the per-thread micro-cache(direct-mapped)
+#define TEXTURE_CACHE_MICRO_SIZE 16
+
+namespace rt {
+
+/**
+ * The image a tiled texture is converted from.
+ * The tiled texture is stale if the image is changed after the conversion
+ * or it is decoded by another transfer function.
+ */
+struct TiledTextureSource {
+  uint64_t size = 0;     // The size of the image file
+  int64_t mtime_ns = 0;  // The modification time of the image file
+  uint32_t srgb = 0;     // 1 if the image is decoded as sRGB
+};
+
+inline bool operator==(TiledTextureSource const &a,
+                       TiledTextureSource const &b) noexcept
+{
+  return a.size == b.size && a.mtime_ns == b.mtime_ns && a.srgb == b.srgb;
+}
+
+/**
+ * Write the mip pyramid in the tiled format read by TextureCache:
+ *   header: "RTT2", level count, tile size, sRGB(uint32_t),
+ *           source size(uint64_t), source mtime(int64_t)
+ *   levels: width, height(uint32_t), the offset of the first tile(uint64_t)
+ *   tiles:  TILE_SIZE x TILE_SIZE MipMap::Texel, row-major among the tiles
+ *           of a level and in a tile, the edge tiles are padded
+ * The file is written to a temporary file and renamed to the \p path, so
+ * an interrupted write never leaves a truncated file.
+ */
+bool write_tiled_texture(char const *path, MipMap const &mipmap,
+                         TiledTextureSource const &source = {});
+
+/**
+ * Read the source recorded in the tiled texture file
+ * \return false -- The file can't be read or it is not a tiled texture
+ */
+bool read_tiled_texture_source(char const *path, TiledTextureSource &source);
+
+/**
+ * The cache of the texture tiles with a fixed memory budget
+ *
+ * The tiles are read on demand(pread) from the files written by
+ * write_tiled_texture(), and evicted by the CLOCK policy. The cache is
+ * split into shards by the hash of tile, every lookup of the shared cache
+ * locks only one shard.
+ * Every thread keeps the last tiles it used in a micro-cache, most lookups
+ * are resolved there without any lock or atomic operation.
+ *
+ * The tiles are reference counted, a tile evicted from the shared cache is
+ * released once no micro-cache holds it. The memory is bounded by
+ * budget + threads * TEXTURE_CACHE_MICRO_SIZE tiles.
+ */
+class TextureCache : kanon::noncopyable {
+ public:
+  struct Stats {
+    uint64_t lookups = 0;
+    uint64_t micro_hits = 0;  // Resolved by the per-thread micro-cache
+    uint64_t shared_hits = 0; // Resolved by the shared cache
+    uint64_t misses = 0;      // Read from the file
+    uint64_t evictions = 0;
+    uint64_t bytes_read = 0;
+    double read_seconds = 0;
+
+    double hit_rate() const noexcept
+    {
+      return lookups ? double(lookups - misses) / double(lookups) : 0;
+    }
+
+    void Print(FILE *fp) const;
+  };
+
+  /**
+   * \param budget_bytes The memory of the shared cache, one tile per shard
+   *                     at least
+   */
+  explicit TextureCache(size_t budget_bytes);
+  ~TextureCache() noexcept;
+
+  /**
+   * Open a tiled texture file(before the lookups of the render threads)
+   * \return The id of the file, -1 if it can't be opened or the format is
+   *         invalid
+   */
+  int open(char const *path);
+
+  int levels(int file) const noexcept { return (int)files_[file].levels.size(); }
+  int width(int file, int level = 0) const noexcept
+  {
+    return files_[file].levels[level].width;
+  }
+  int height(int file, int level = 0) const noexcept
+  {
+    return files_[file].levels[level].height;
+  }
+
+  /**
+   * The texel(x, y) of the level, it is read from the file if the tile is
+   * not cached
+   */
+  MipMap::Texel texel(int file, int level, int x, int y) const;
+
+  size_t capacity() const noexcept { return capacity_; }
+
+  /**
+   * Flush the counters of the micro-cache of current thread.
+   * Must be called by the render threads before they exit.
+   */
+  void flush_thread_stats() const noexcept;
+
+  /**
+   * The stats of the flushed threads and the shared cache
+   */
+  Stats stats() const noexcept;
+
+  using TileSPtr = std::shared_ptr<MipMap::Texel const[]>;
+
+ private:
+  struct Level {
+    int width;
+    int height;
+    int tiles_x;
+    uint64_t offset;
+  };
+
+  struct File {
+    std::string path;
+    int fd = -1;
+    std::vector<Level> levels;
+  };
+
+  struct Slot {
+    uint64_t key = 0;
+    TileSPtr tile;
+    bool referenced = false;
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, int> index;
+    std::vector<Slot> slots;
+    size_t hand = 0;
+  };
+
+  TileSPtr tile(uint64_t key) const;
+  TileSPtr read_tile(uint64_t key) const;
+
+  // Distinguish the caches in the micro-caches
+  const uint64_t id_;
+  std::vector<File> files_;
+  size_t capacity_; // tiles per shard
+  mutable Shard shards_[TEXTURE_CACHE_SHARD_NUM];
+
+  mutable std::atomic<uint64_t> lookups_{0};
+  mutable std::atomic<uint64_t> micro_hits_{0};
+  mutable std::atomic<uint64_t> shared_hits_{0};
+  mutable std::atomic<uint64_t> misses_{0};
+  mutable std::atomic<uint64_t> evictions_{0};
+  mutable std::atomic<uint64_t> bytes_read_{0};
+  mutable std::atomic<uint64_t> read_nanoseconds_{0};
+};
+
+using TextureCacheSPtr = std::shared_ptr<TextureCache>;
+
+} // namespace rt
+
+#endif
@@ -0,0 +1,72 @@
+#include "checksum.hh"
+
+#include <array>
+
+namespace util {
+
+static std::array<uint32_t, 256> make_crc_table() noexcept
+{
+  std::array<uint32_t, 256> table;
+  for (uint32_t i = 0; i < 256; ++i) {
+    uint32_t c = i;
+    for (int k = 0; k < 8; ++k) {
+      c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+    }
+    table[i] = c;
+  }
+  return table;
+}
+
+uint32_t crc32(uint32_t crc, void const *data, size_t n) noexcept
+{
+  static const auto table = make_crc_table();
+
+  auto buf = static_cast<uint8_t const *>(data);
+  crc = ~crc;
+  for (size_t i = 0; i < n; ++i) {
+    crc = table[(crc ^ buf[i]) & 0xff] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+// The largest prime smaller than 65536
+static constexpr uint32_t ADLER_BASE = 65521;
+// The max n such that 255n(n+1)/2 + (n+1)(BASE-1) <= 2^32-1
+static constexpr size_t ADLER_NMAX = 5552;
+
+uint32_t adler32(uint32_t adler, void const *data, size_t n) noexcept
+{
+  auto buf = static_cast<uint8_t const *>(data);
+  uint32_t a = adler & 0xffff;
+  uint32_t b = adler >> 16;
+
+  while (n > 0) {
+    // Delay the modulo until the sum may overflow
+    auto len = n < ADLER_NMAX ? n : ADLER_NMAX;
+    n -= len;
+    while (len--) {
+      a += *buf++;
+      b += a;
+    }
+    a %= ADLER_BASE;
+    b %= ADLER_BASE;
+  }
+  return (b << 16) | a;
+}
+
+uint32_t adler32_combine(uint32_t adler1, uint32_t adler2, size_t len2) noexcept
+{
+  // a = a1 + a2 - 1
+  // b = b1 + b2 + len2 * (a1 - 1)
+  const uint64_t rem = len2 % ADLER_BASE;
+  const uint64_t a1 = adler1 & 0xffff;
+  const uint64_t b1 = adler1 >> 16;
+  const uint64_t a2 = adler2 & 0xffff;
+  const uint64_t b2 = adler2 >> 16;
+
+  uint64_t a = (a1 + a2 + ADLER_BASE - 1) % ADLER_BASE;
+  uint64_t b = (b1 + b2 + rem * a1 + ADLER_BASE - rem) % ADLER_BASE;
+  return uint32_t((b << 16) | a);
+}
+
+} // namespace util
@@ -0,0 +1,32 @@
+#ifndef UTIL_CHECKSUM_HH__
+#define UTIL_CHECKSUM_HH__
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace util {
+
+/**
+ * CRC-32(ISO 3309, used by PNG/zip)
+ * The \p crc is the crc of the previous data(0 at first), so the data can be
+ * computed in pieces.
+ */
+uint32_t crc32(uint32_t crc, void const *data, size_t n) noexcept;
+
+/**
+ * Adler-32(RFC 1950, the checksum of zlib stream)
+ * The \p adler is the checksum of the previous data(1 at first).
+ */
+uint32_t adler32(uint32_t adler, void const *data, size_t n) noexcept;
+
+/**
+ * Combine the checksums of two consecutive pieces computed independently
+ * (e.g. in different threads).
+ *
+ * \param len2 The length of the second piece
+ */
+uint32_t adler32_combine(uint32_t adler1, uint32_t adler2, size_t len2) noexcept;
+
+} // namespace util
+
+#endif
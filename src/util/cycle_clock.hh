@@ -0,0 +1,34 @@
+#ifndef UTIL_CYCLE_CLOCK_HH__
+#define UTIL_CYCLE_CLOCK_HH__
+
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+namespace util {
+
+/**
+ * Read the time stamp counter(rdtsc on x86, cntvct_el0 on AArch64),
+ * it is cheap enough to measure the cost of a pixel.
+ * The unit is platform dependent, only the relative values are meaningful.
+ */
+inline uint64_t read_cycle_counter() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#elif defined(__aarch64__)
+  uint64_t v;
+  asm volatile("mrs %0, cntvct_el0" : "=r"(v));
+  return v;
+#else
+  return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+} // namespace util
+
+#endif
@@ -4,12 +4,11 @@
 
 namespace util {
 
-static std::random_device rd;
-static std::mt19937 generator(rd());
+static thread_local std::mt19937 generator(std::random_device{}());
 
 double random_double()
 {
-  static std::uniform_real_distribution<> dist(0., 1.);
+  std::uniform_real_distribution<> dist(0., 1.);
   return dist(generator);
 }
 
@@ -25,4 +24,19 @@ int random_int(int rmin, int rmax)
   return int(random_double(rmin, rmax+1));
 }
 
+void seed_random(uint64_t seed)
+{
+  std::seed_seq seq{uint32_t(seed), uint32_t(seed >> 32)};
+  generator.seed(seq);
+}
+
+uint64_t mix_seed(uint64_t seed, uint64_t value) noexcept
+{
+  // splitmix64
+  uint64_t z = seed + 0x9e3779b97f4a7c15ull * (value + 1);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
 } // namespace util
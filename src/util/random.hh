@@ -1,12 +1,28 @@
 #ifndef UTIL_RANDOM_HH__
 #define UTIL_RANDOM_HH__
 
+#include <stdint.h>
+
 namespace util {
 
+/**
+ * Every thread has its own generator(seeded by std::random_device)
+ */
 double random_double();
 double random_double(double rmin, double rmax);
 int random_int(int imin, int imax);
 
+/**
+ * Reseed the generator of current thread
+ */
+void seed_random(uint64_t seed);
+
+/**
+ * Mix the \p value into the \p seed(e.g. derive the seed of a tile from
+ * the global seed)
+ */
+uint64_t mix_seed(uint64_t seed, uint64_t value) noexcept;
+
 } // namespace util
 
 #endif
@@ -0,0 +1,78 @@
+#include "worker_pool.hh"
+
+#include <assert.h>
+
+namespace util {
+
+WorkerPool::WorkerPool(int thread_num)
+{
+  assert(thread_num > 0);
+  threads_.reserve(thread_num);
+  for (int i = 0; i < thread_num; ++i) {
+    threads_.emplace_back([this, i]() { Loop(i); });
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  Wait();
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    quit_ = true;
+  }
+  work_cond_.notify_all();
+  for (auto &thr : threads_) thr.join();
+}
+
+void WorkerPool::Submit(size_t task_num, Task task)
+{
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    assert(busy_num_ == 0);
+    task_ = std::move(task);
+    task_num_ = task_num;
+    next_task_.store(0, std::memory_order_relaxed);
+    busy_num_ = (int)threads_.size();
+    ++job_id_;
+  }
+  work_cond_.notify_all();
+}
+
+void WorkerPool::Wait()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cond_.wait(lock, [this]() { return busy_num_ == 0; });
+}
+
+void WorkerPool::Loop(int thread_index)
+{
+  uint64_t last_job = 0;
+  for (;;) {
+    size_t task_num;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_cond_.wait(lock, [this, last_job]() {
+        return quit_ || job_id_ != last_job;
+      });
+      if (quit_) return;
+      last_job = job_id_;
+      task_num = task_num_;
+    }
+
+    // The task_ is not changed until all threads complete the job
+    for (;;) {
+      auto index = next_task_.fetch_add(1, std::memory_order_relaxed);
+      if (index >= task_num) break;
+      task_(index, thread_index);
+    }
+
+    bool last = false;
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      last = --busy_num_ == 0;
+    }
+    if (last) done_cond_.notify_all();
+  }
+}
+
+} // namespace util
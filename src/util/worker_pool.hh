@@ -0,0 +1,72 @@
+#ifndef UTIL_WORKER_POOL_HH__
+#define UTIL_WORKER_POOL_HH__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "noncopyable.hh"
+
+namespace util {
+
+/**
+ * The threads created once and reused by the jobs(e.g. the frames of a
+ * sequence), instead of being created and joined for every job.
+ *
+ * A job is a number of tasks which are dispatched dynamically, the task
+ * function is called with the index of task and the index of thread
+ * (e.g. to find the per-thread state). Only one job runs at a time.
+ */
+class WorkerPool : kanon::noncopyable {
+ public:
+  using Task = std::function<void(size_t task_index, int thread_index)>;
+
+  explicit WorkerPool(int thread_num);
+  ~WorkerPool();
+
+  /**
+   * Start a job and return immediately
+   * (the previous one must be completed, see Wait())
+   */
+  void Submit(size_t task_num, Task task);
+
+  /**
+   * Wait for the current job to complete
+   */
+  void Wait();
+
+  void Run(size_t task_num, Task task)
+  {
+    Submit(task_num, std::move(task));
+    Wait();
+  }
+
+  int thread_num() const noexcept { return (int)threads_.size(); }
+
+ private:
+  void Loop(int thread_index);
+
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable work_cond_;
+  std::condition_variable done_cond_;
+
+  Task task_;
+  size_t task_num_ = 0;
+  std::atomic<size_t> next_task_{0};
+  // Increased by every job, the threads wait for the next one
+  uint64_t job_id_ = 0;
+  // The threads which don't complete the current job
+  int busy_num_ = 0;
+  bool quit_ = false;
+};
+
+} // namespace util
+
+#endif
@@ -0,0 +1,149 @@
+#include "density_grid.hh"
+
+#include <assert.h>
+
+using namespace rt;
+using namespace gm;
+
+#define BRICK_SIZE DENSITY_GRID_BRICK_SIZE
+#define BRICK_VOXELS (BRICK_SIZE * BRICK_SIZE * BRICK_SIZE)
+
+static inline int brick_num(int n) noexcept
+{
+  return (n + BRICK_SIZE - 1) / BRICK_SIZE;
+}
+
+DensityGrid::DensityGrid(Aabb const &bounds, int nx, int ny, int nz,
+                         std::vector<float> const &voxels)
+  : bounds_(bounds)
+  , nx_(nx)
+  , ny_(ny)
+  , nz_(nz)
+  , bx_(brick_num(nx))
+  , by_(brick_num(ny))
+  , bz_(brick_num(nz))
+{
+  assert(nx > 0 && ny > 0 && nz > 0);
+  assert(voxels.size() == (size_t)nx * ny * nz);
+
+  const auto extent = bounds.max() - bounds.min();
+  voxel_size_ = Vec3F(extent.x / nx, extent.y / ny, extent.z / nz);
+  cell_size_ = voxel_size_ * (double)BRICK_SIZE;
+
+  auto dense = [&](int x, int y, int z) {
+    return voxels[((size_t)z * ny + y) * nx + x];
+  };
+
+  const size_t total = (size_t)bx_ * by_ * bz_;
+  brick_offsets_.assign(total, -1);
+  majorants_.assign(total, 0.f);
+
+  for (int bz = 0; bz < bz_; ++bz) {
+    for (int by = 0; by < by_; ++by) {
+      for (int bx = 0; bx < bx_; ++bx) {
+        const size_t brick = ((size_t)bz * by_ + by) * bx_ + bx;
+        const int x0 = bx * BRICK_SIZE;
+        const int y0 = by * BRICK_SIZE;
+        const int z0 = bz * BRICK_SIZE;
+
+        // The trilinear interpolation in the brick also reads the voxels
+        // next to it
+        const int x1 = std::min(x0 + BRICK_SIZE, nx - 1);
+        const int y1 = std::min(y0 + BRICK_SIZE, ny - 1);
+        const int z1 = std::min(z0 + BRICK_SIZE, nz - 1);
+        float majorant = 0;
+        for (int z = std::max(z0 - 1, 0); z <= z1; ++z)
+          for (int y = std::max(y0 - 1, 0); y <= y1; ++y)
+            for (int x = std::max(x0 - 1, 0); x <= x1; ++x)
+              majorant = std::max(majorant, dense(x, y, z));
+        majorants_[brick] = majorant;
+        max_density_ = std::max(max_density_, (double)majorant);
+
+        bool is_empty = true;
+        for (int z = z0; z < std::min(z0 + BRICK_SIZE, nz) && is_empty; ++z)
+          for (int y = y0; y < std::min(y0 + BRICK_SIZE, ny) && is_empty; ++y)
+            for (int x = x0; x < std::min(x0 + BRICK_SIZE, nx); ++x)
+              if (dense(x, y, z) != 0) {
+                is_empty = false;
+                break;
+              }
+        if (is_empty) continue;
+
+        brick_offsets_[brick] = (int32_t)data_.size();
+        data_.resize(data_.size() + BRICK_VOXELS, 0.f);
+        float *data = &data_[brick_offsets_[brick]];
+        for (int z = z0; z < std::min(z0 + BRICK_SIZE, nz); ++z)
+          for (int y = y0; y < std::min(y0 + BRICK_SIZE, ny); ++y)
+            for (int x = x0; x < std::min(x0 + BRICK_SIZE, nx); ++x)
+              data[((z - z0) * BRICK_SIZE + (y - y0)) * BRICK_SIZE + (x - x0)] =
+                dense(x, y, z);
+        ++brick_count_;
+      }
+    }
+  }
+}
+
+DensityGrid DensityGrid::from_function(
+  Aabb const &bounds, int nx, int ny, int nz,
+  std::function<double(Point3F const &)> const &func)
+{
+  const auto extent = bounds.max() - bounds.min();
+  std::vector<float> voxels((size_t)nx * ny * nz);
+  for (int z = 0; z < nz; ++z) {
+    for (int y = 0; y < ny; ++y) {
+      for (int x = 0; x < nx; ++x) {
+        const Point3F p(bounds.min().x + (x + 0.5) * extent.x / nx,
+                        bounds.min().y + (y + 0.5) * extent.y / ny,
+                        bounds.min().z + (z + 0.5) * extent.z / nz);
+        voxels[((size_t)z * ny + y) * nx + x] = (float)std::max(0., func(p));
+      }
+    }
+  }
+  return DensityGrid(bounds, nx, ny, nz, voxels);
+}
+
+float DensityGrid::voxel(int x, int y, int z) const noexcept
+{
+  const size_t brick = ((size_t)(z / BRICK_SIZE) * by_ + y / BRICK_SIZE) * bx_ +
+                       x / BRICK_SIZE;
+  const auto offset = brick_offsets_[brick];
+  if (offset < 0) return 0;
+  return data_[offset + ((z % BRICK_SIZE) * BRICK_SIZE + y % BRICK_SIZE) *
+                          BRICK_SIZE +
+               x % BRICK_SIZE];
+}
+
+double DensityGrid::density(Point3F const &p) const noexcept
+{
+  const int dims[3] = {nx_, ny_, nz_};
+  int i0[3];
+  int i1[3];
+  double f[3];
+  for (int i = 0; i < 3; ++i) {
+    if (p[i] < bounds_.min()[i] || p[i] > bounds_.max()[i]) return 0;
+    // The voxels are sampled at their centers
+    const double g = (p[i] - bounds_.min()[i]) / voxel_size_[i] - 0.5;
+    const double fl = std::floor(g);
+    f[i] = g - fl;
+    i0[i] = std::clamp((int)fl, 0, dims[i] - 1);
+    i1[i] = std::clamp((int)fl + 1, 0, dims[i] - 1);
+  }
+
+  auto lerp = [](double a, double b, double t) { return a + (b - a) * t; };
+  const double c00 = lerp(voxel(i0[0], i0[1], i0[2]),
+                          voxel(i1[0], i0[1], i0[2]), f[0]);
+  const double c10 = lerp(voxel(i0[0], i1[1], i0[2]),
+                          voxel(i1[0], i1[1], i0[2]), f[0]);
+  const double c01 = lerp(voxel(i0[0], i0[1], i1[2]),
+                          voxel(i1[0], i0[1], i1[2]), f[0]);
+  const double c11 = lerp(voxel(i0[0], i1[1], i1[2]),
+                          voxel(i1[0], i1[1], i1[2]), f[0]);
+  return lerp(lerp(c00, c10, f[1]), lerp(c01, c11, f[1]), f[2]);
+}
+
+size_t DensityGrid::memory_bytes() const noexcept
+{
+  return data_.size() * sizeof(float) +
+         brick_offsets_.size() * sizeof(int32_t) +
+         majorants_.size() * sizeof(float);
+}
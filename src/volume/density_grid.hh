@@ -0,0 +1,139 @@
+#ifndef RT_VOLUME_DENSITY_GRID_HH__
+#define RT_VOLUME_DENSITY_GRID_HH__
+
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+#include "../accelerate/aabb.hh"
+#include "../gm/point.hh"
+#include "../gm/util.hh"
+
+namespace rt {
+
+// The edge length of a brick(in voxels), it is also the cell of majorant grid
+#define DENSITY_GRID_BRICK_SIZE 8
+
+/**
+ * The voxels of density stored in sparse bricks(8^3 voxels)
+ *
+ * The bricks whose voxels are all zero are not stored, so the memory is
+ * proportional to the occupied space instead of the bounds.
+ * A voxel is the sample at its center, density() interpolates them
+ * trilinearly.
+ *
+ * Each brick has a majorant(the upper bound of density() in it), they
+ * form a coarse grid used by the free-flight sampling of the medium
+ * (the empty bricks are skipped).
+ */
+class DensityGrid {
+ public:
+  /**
+   * \param voxels nx * ny * nz values, x is the fastest dimension
+   */
+  DensityGrid(Aabb const &bounds, int nx, int ny, int nz,
+              std::vector<float> const &voxels);
+
+  /**
+   * Sample the \p func at the center of voxels
+   */
+  static DensityGrid
+  from_function(Aabb const &bounds, int nx, int ny, int nz,
+                std::function<double(gm::Point3F const &)> const &func);
+
+  /**
+   * Trilinear interpolation, 0 outside the bounds
+   */
+  double density(gm::Point3F const &p) const noexcept;
+
+  /**
+   * Visit the majorant cells overlapped by the ray in [tmin, tmax]
+   * in front-to-back order(3D DDA)
+   * \param visitor bool(double t0, double t1, double majorant), the
+   *        traversal stops if it returns false
+   * \return false if the visitor stops the traversal
+   */
+  template <typename Visitor>
+  bool traverse(gm::Point3F const &origin, gm::Vec3F const &direction,
+                double tmin, double tmax, Visitor &&visitor) const;
+
+  Aabb const &bounds() const noexcept { return bounds_; }
+  double max_density() const noexcept { return max_density_; }
+  size_t brick_count() const noexcept { return brick_count_; }
+  // The number of bricks of the dense grid
+  size_t total_brick_count() const noexcept { return majorants_.size(); }
+  size_t memory_bytes() const noexcept;
+
+ private:
+  float voxel(int x, int y, int z) const noexcept;
+
+  Aabb bounds_;
+  int nx_, ny_, nz_;
+  // The number of bricks in each dimension
+  int bx_, by_, bz_;
+  gm::Vec3F voxel_size_;
+  gm::Vec3F cell_size_;
+
+  // The offset of the brick in data_, -1 if it is empty
+  std::vector<int32_t> brick_offsets_;
+  std::vector<float> data_;
+  std::vector<float> majorants_;
+  size_t brick_count_ = 0;
+  double max_density_ = 0;
+};
+
+template <typename Visitor>
+bool DensityGrid::traverse(gm::Point3F const &origin,
+                           gm::Vec3F const &direction, double tmin, double tmax,
+                           Visitor &&visitor) const
+{
+  if (!(tmin < tmax)) return true;
+
+  // The grid coordinates of the entry point
+  const auto entry = origin + direction * tmin;
+  int cell[3];
+  int step[3];
+  double t_next[3];
+  double t_delta[3];
+  const int dims[3] = {bx_, by_, bz_};
+  for (int i = 0; i < 3; ++i) {
+    const double g = (entry[i] - bounds_.min()[i]) / cell_size_[i];
+    cell[i] = std::clamp((int)std::floor(g), 0, dims[i] - 1);
+    if (direction[i] > 0) {
+      step[i] = 1;
+      t_delta[i] = cell_size_[i] / direction[i];
+      t_next[i] = tmin + (cell[i] + 1 - g) * t_delta[i];
+    } else if (direction[i] < 0) {
+      step[i] = -1;
+      t_delta[i] = -cell_size_[i] / direction[i];
+      t_next[i] = tmin + (g - cell[i]) * t_delta[i];
+    } else {
+      step[i] = 0;
+      t_delta[i] = gm::inf;
+      t_next[i] = gm::inf;
+    }
+  }
+
+  double t = tmin;
+  for (;;) {
+    const int axis = t_next[0] < t_next[1]
+                       ? (t_next[0] < t_next[2] ? 0 : 2)
+                       : (t_next[1] < t_next[2] ? 1 : 2);
+    const double t_exit = std::min(t_next[axis], tmax);
+    const auto majorant =
+      majorants_[((size_t)cell[2] * by_ + cell[1]) * bx_ + cell[0]];
+    if (t_exit > t && !visitor(t, t_exit, (double)majorant)) return false;
+    if (t_exit >= tmax) return true;
+
+    t = t_exit;
+    cell[axis] += step[axis];
+    if (cell[axis] < 0 || cell[axis] >= dims[axis]) return true;
+    t_next[axis] += t_delta[axis];
+  }
+}
+
+} // namespace rt
+
+#endif
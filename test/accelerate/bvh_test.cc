@@ -0,0 +1,144 @@
+#include "accelerate/bvh_node.hh"
+#include "material/lambertian.hh"
+#include "rt/hit_record.hh"
+#include "shape/moving_sphere.hh"
+#include "shape/rect.hh"
+#include "shape/shape_list.hh"
+#include "shape/sphere.hh"
+#include "shape/translate.hh"
+#include "util/random.hh"
+
+#include <gtest/gtest.h>
+
+using namespace rt;
+using namespace gm;
+using namespace util;
+
+TEST (bvh_test, keyframe_track) {
+  KeyframeTrack track({{1., {0, 2, 0}}, {0., {0, 0, 0}}, {2., {4, 0, 0}}});
+  // The keys are sorted
+  EXPECT_EQ(track.keys().front().time, 0);
+
+  EXPECT_EQ(track.at(-1).y, 0);
+  EXPECT_DOUBLE_EQ(track.at(0.5).y, 1);
+  EXPECT_DOUBLE_EQ(track.at(1.5).x, 2);
+  EXPECT_DOUBLE_EQ(track.at(1.5).y, 1);
+  EXPECT_EQ(track.at(3).x, 4);
+
+  // The middle key deviates from the line between the ends
+  Vec3F offset0, offset1, pad;
+  track.linear_bounds(0, 2, offset0, offset1, pad);
+  EXPECT_EQ(offset1.x, 4);
+  EXPECT_DOUBLE_EQ(pad.x, 2);
+  EXPECT_DOUBLE_EQ(pad.y, 2);
+  EXPECT_EQ(pad.z, 0);
+
+  // The interpolated bounds contain the motion
+  for (int i = 0; i <= 100; ++i) {
+    const double t = i / 50.;
+    const auto offset = track.at(t);
+    const auto line = offset0 + (offset1 - offset0) * (t / 2);
+    for (int c = 0; c < 3; ++c)
+      EXPECT_LE(std::fabs(offset[c] - line[c]), pad[c] + 1e-12) << t;
+  }
+}
+
+TEST (bvh_test, moving_sphere) {
+  auto material = std::make_shared<Lambertian>(Color(.5, .5, .5));
+  MovingSphere sphere(Point3F(0, 0, 0), 0., Point3F(0, 4, 0), 1., 1, material);
+
+  HitInfo info;
+  Ray down(Point3F(0, 0, 5), Vec3F(0, 0, -1), 0);
+  EXPECT_TRUE(sphere.intersect(down, 0.001, inf, info));
+  EXPECT_DOUBLE_EQ(info.t, 4);
+  // The sphere has moved away
+  EXPECT_FALSE(
+    sphere.intersect(Ray(Point3F(0, 0, 5), Vec3F(0, 0, -1), 1), 0.001, inf, info));
+  EXPECT_TRUE(
+    sphere.intersect(Ray(Point3F(0, 4, 5), Vec3F(0, 0, -1), 1), 0.001, inf, info));
+
+  HitRecord record;
+  ASSERT_TRUE(sphere.hit(Ray(Point3F(0, 2, 5), Vec3F(0, 0, -1), 0.5), 0.001,
+                         inf, record));
+  EXPECT_NEAR(record.normal.z, 1, 1e-12);
+
+  Aabb box;
+  ASSERT_TRUE(sphere.get_bounding_box(box));
+  EXPECT_EQ(box.min().y, -1);
+  EXPECT_EQ(box.max().y, 5);
+  Aabb box0, box1;
+  ASSERT_TRUE(sphere.get_motion_bounds(0, 1, box0, box1));
+  EXPECT_EQ(box0.max().y, 1);
+  EXPECT_EQ(box1.min().y, 3);
+}
+
+// The closest hit of BVH is the one of linear traversal
+static void check_against_list(std::vector<ShapeSPtr> const &shapes,
+                               double time0, double time1)
+{
+  ShapeList list;
+  for (auto const &shape : shapes) list.add(shape);
+  BvhTree tree(shapes, time0, time1);
+
+  seed_random(2);
+  for (int i = 0; i < 2000; ++i) {
+    Point3F origin(random_double(-6, 6), random_double(-6, 6), 8);
+    Point3F target(random_double(-6, 6), random_double(-6, 6), -8);
+    Ray ray(origin, target - origin, random_double(time0, time1));
+
+    HitInfo expected, actual;
+    const bool expected_hit = list.intersect(ray, 0.001, inf, expected);
+    ASSERT_EQ(tree.intersect(ray, 0.001, inf, actual), expected_hit) << i;
+    if (!expected_hit) continue;
+    EXPECT_EQ(actual.t, expected.t) << i;
+    EXPECT_EQ(actual.shape, expected.shape) << i;
+  }
+}
+
+TEST (bvh_test, static_tree) {
+  seed_random(1);
+  auto material = std::make_shared<Lambertian>(Color(.5, .5, .5));
+  std::vector<ShapeSPtr> shapes;
+  for (int i = 0; i < 300; ++i) {
+    Point3F center(random_double(-5, 5), random_double(-5, 5),
+                   random_double(-5, 5));
+    shapes.push_back(std::make_shared<Sphere>(center, 0.3, material));
+  }
+  shapes.push_back(std::make_shared<XyRect>(-5, 5, -5, 5, -6, material));
+
+  BvhTree tree(shapes);
+  EXPECT_FALSE(tree.has_motion());
+  check_against_list(shapes, 0, 0);
+}
+
+TEST (bvh_test, motion_tree) {
+  seed_random(1);
+  auto material = std::make_shared<Lambertian>(Color(.5, .5, .5));
+  std::vector<ShapeSPtr> shapes;
+  for (int i = 0; i < 300; ++i) {
+    Point3F center(random_double(-5, 5), random_double(-5, 5),
+                   random_double(-5, 5));
+    switch (i % 3) {
+      case 0:
+        shapes.push_back(std::make_shared<Sphere>(center, 0.3, material));
+        break;
+      case 1:
+        shapes.push_back(std::make_shared<MovingSphere>(
+          center, 0., center + Vec3F::random(-1, 1), 1., 0.3, material));
+        break;
+      case 2: {
+        // The keyframes between the shutter bend the motion
+        KeyframeTrack track({{0., {0, 0, 0}},
+                             {0.3, Vec3F::random(-2, 2)},
+                             {0.6, Vec3F::random(-2, 2)},
+                             {1., {0, 0, 0}}});
+        shapes.push_back(std::make_shared<MotionTranslate>(
+          std::make_shared<Sphere>(center, 0.3, material), std::move(track)));
+      } break;
+    }
+  }
+
+  BvhTree tree(shapes, 0, 1);
+  EXPECT_TRUE(tree.has_motion());
+  check_against_list(shapes, 0, 1);
+}
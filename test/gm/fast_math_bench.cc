@@ -0,0 +1,74 @@
+#include "gm/fast_math.hh"
+
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <vector>
+
+using namespace benchmark;
+using namespace gm;
+
+#define N 4096
+
+// The arguments in the ranges of the renderer
+static std::vector<double> make_input(double lo, double hi)
+{
+  std::vector<double> ret(N);
+  for (int i = 0; i < N; ++i) ret[i] = lo + (hi - lo) * (i + 0.5) / N;
+  return ret;
+}
+
+static void libm_sincos(State &state)
+{
+  auto x = make_input(0, 2 * M_PI);
+  std::vector<double> s(N), c(N);
+  for (auto _ : state) {
+    for (int i = 0; i < N; ++i) {
+      s[i] = sin(x[i]);
+      c[i] = cos(x[i]);
+    }
+    DoNotOptimize(s.data());
+    DoNotOptimize(c.data());
+  }
+  state.SetItemsProcessed(state.iterations() * N);
+}
+
+static void fast_sincos(State &state)
+{
+  auto x = make_input(0, 2 * M_PI);
+  std::vector<double> s(N), c(N);
+  for (auto _ : state) {
+    for (int i = 0; i < N; ++i) fast_sincos(x[i], s[i], c[i]);
+    DoNotOptimize(s.data());
+    DoNotOptimize(c.data());
+  }
+  state.SetItemsProcessed(state.iterations() * N);
+}
+
+#define UNARY_BENCH(name, expr, lo, hi)                                        \
+  static void name(State &state)                                               \
+  {                                                                            \
+    auto input = make_input(lo, hi);                                           \
+    std::vector<double> output(N);                                             \
+    for (auto _ : state) {                                                     \
+      for (int i = 0; i < N; ++i) {                                            \
+        const double x = input[i];                                             \
+        output[i] = expr;                                                      \
+      }                                                                        \
+      DoNotOptimize(output.data());                                            \
+    }                                                                          \
+    state.SetItemsProcessed(state.iterations() * N);                           \
+  }                                                                            \
+  BENCHMARK(name)
+
+// The y of atan2 is the sin of the angle, as Sphere::get_uv()
+UNARY_BENCH(libm_atan2, atan2(x - 0.5, 1 - x), 0, 1);
+UNARY_BENCH(fast_atan2, fast_atan2(x - 0.5, 1 - x), 0, 1);
+UNARY_BENCH(libm_acos, acos(x), -1, 1);
+UNARY_BENCH(fast_acos, fast_acos(x), -1, 1);
+UNARY_BENCH(libm_log, log(x), 1e-6, 1);
+UNARY_BENCH(fast_log, fast_log(x), 1e-6, 1);
+UNARY_BENCH(libm_pow5, pow(x, 5), 0, 1);
+UNARY_BENCH(pow5, pow5(x), 0, 1);
+
+BENCHMARK(libm_sincos);
+BENCHMARK(fast_sincos);
@@ -0,0 +1,99 @@
+#include "gm/fast_math.hh"
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace gm;
+
+// The error bounds documented in fast_math.hh
+#define SINCOS_MAX_ERROR 1e-13
+#define ATAN2_MAX_ERROR 2e-14
+#define ACOS_MAX_ERROR 1e-13
+#define LOG_MAX_ERROR 5e-14
+
+#define SAMPLE_NUM 1000000
+
+static std::string to_string(double x)
+{
+  char buf[32];
+  snprintf(buf, sizeof buf, "%g", x);
+  return buf;
+}
+
+TEST (fast_math_test, sincos) {
+  double max_error = 0;
+  for (int i = 0; i <= SAMPLE_NUM; ++i) {
+    // Dense in the range of sampling([0, 2pi]) and sparse up to 1e5
+    for (double range : {2 * M_PI, 1e5}) {
+      const double x = -range + 2 * range * i / SAMPLE_NUM;
+      double s, c;
+      fast_sincos(x, s, c);
+      max_error = std::max(max_error, fabs(s - sin(x)));
+      max_error = std::max(max_error, fabs(c - cos(x)));
+    }
+  }
+  RecordProperty("max_error", to_string(max_error));
+  EXPECT_LT(max_error, SINCOS_MAX_ERROR);
+
+  EXPECT_EQ(fast_sin(0), 0);
+  EXPECT_NEAR(fast_cos(M_PI), -1, SINCOS_MAX_ERROR);
+}
+
+TEST (fast_math_test, atan2) {
+  double max_error = 0;
+  for (int i = 0; i < SAMPLE_NUM; ++i) {
+    const double angle = -M_PI + 2 * M_PI * (i + 0.5) / SAMPLE_NUM;
+    for (double r : {1e-3, 1., 1e3}) {
+      const double x = r * cos(angle);
+      const double y = r * sin(angle);
+      max_error = std::max(max_error, fabs(fast_atan2(y, x) - atan2(y, x)));
+    }
+  }
+  RecordProperty("max_error", to_string(max_error));
+  EXPECT_LT(max_error, ATAN2_MAX_ERROR);
+
+  EXPECT_EQ(fast_atan2(0, 0), 0);
+  EXPECT_NEAR(fast_atan2(0, -1), M_PI, ATAN2_MAX_ERROR);
+  EXPECT_NEAR(fast_atan2(-1, 0), -M_PI / 2, ATAN2_MAX_ERROR);
+  EXPECT_NEAR(fast_atan2(1, 1), M_PI / 4, ATAN2_MAX_ERROR);
+}
+
+TEST (fast_math_test, acos) {
+  double max_error = 0;
+  for (int i = 0; i <= SAMPLE_NUM; ++i) {
+    const double x = -1 + 2. * i / SAMPLE_NUM;
+    max_error = std::max(max_error, fabs(fast_acos(x) - acos(x)));
+  }
+  RecordProperty("max_error", to_string(max_error));
+  EXPECT_LT(max_error, ACOS_MAX_ERROR);
+
+  EXPECT_NEAR(fast_acos(1), 0, ACOS_MAX_ERROR);
+  EXPECT_NEAR(fast_acos(-1), M_PI, ACOS_MAX_ERROR);
+  // Clamped
+  EXPECT_NEAR(fast_acos(1 + 1e-12), 0, ACOS_MAX_ERROR);
+}
+
+TEST (fast_math_test, log) {
+  double max_error = 0;
+  for (int i = 1; i <= SAMPLE_NUM; ++i) {
+    // The uniform random numbers of free path sampling and the wide range
+    const double u = double(i) / SAMPLE_NUM;
+    const double x = pow(10., -300 + 600. * i / SAMPLE_NUM);
+    max_error = std::max(max_error, fabs(fast_log(u) - log(u)));
+    max_error = std::max(max_error, fabs(fast_log(x) - log(x)) / fabs(log(x)));
+  }
+  RecordProperty("max_error", to_string(max_error));
+  EXPECT_LT(max_error, LOG_MAX_ERROR);
+
+  EXPECT_EQ(fast_log(1), 0);
+  EXPECT_NEAR(fast_log(DBL_MIN), log(DBL_MIN), 1e-12);
+}
+
+TEST (fast_math_test, pow5) {
+  EXPECT_DOUBLE_EQ(pow5(0.3), pow(0.3, 5));
+  EXPECT_EQ(pow5(0), 0);
+  EXPECT_EQ(pow5(1), 1);
+}
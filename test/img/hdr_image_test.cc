@@ -0,0 +1,133 @@
+#include "img/half.hh"
+#include "img/hdr_image.hh"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <gtest/gtest.h>
+
+using namespace img;
+
+TEST (hdr_image_test, half_round_trip) {
+  // Representable values must be exact
+  for (float f : {0.f, 1.f, -2.f, 0.5f, 65504.f, 6.103515625e-05f /* min normal */,
+                  5.9604645e-08f /* min denormal */}) {
+    EXPECT_EQ(half_to_float(float_to_half(f)), f);
+  }
+
+  EXPECT_EQ(float_to_half(1e6f), 0x7c00);
+  EXPECT_TRUE(std::isinf(half_to_float(float_to_half(INFINITY))));
+  EXPECT_TRUE(std::isnan(half_to_float(float_to_half(NAN))));
+
+  // Relative error of normal range is bounded by 2^-11
+  for (float f = 1e-4f; f < 6e4f; f *= 1.37f) {
+    EXPECT_NEAR(half_to_float(float_to_half(f)), f, f * (1.f / 2048));
+  }
+}
+
+TEST (hdr_image_test, pfm) {
+  const int w = 5;
+  const int h = 3;
+  HdrImage image(w, h);
+  for (int y = 0; y < h; ++y) {
+    for (int x = 0; x < w; ++x) {
+      image.SetPixel(x, y, {x * 10. + y, 0.5, 1e3});
+    }
+  }
+  ASSERT_TRUE(image.WritePfm("hdr_image_test.pfm"));
+
+  auto fp = fopen("hdr_image_test.pfm", "rb");
+  ASSERT_NE(fp, nullptr);
+  char magic[3] = {0};
+  int fw = 0;
+  int fh = 0;
+  float scale = 0;
+  ASSERT_EQ(fscanf(fp, "%2s %d %d %f", magic, &fw, &fh, &scale), 4);
+  fgetc(fp);
+  EXPECT_STREQ(magic, "PF");
+  EXPECT_EQ(fw, w);
+  EXPECT_EQ(fh, h);
+  EXPECT_LT(scale, 0); // little endian
+
+  // Bottom-to-top as the image
+  float pixels[w * h * 3];
+  ASSERT_EQ(fread(pixels, sizeof pixels, 1, fp), 1u);
+  EXPECT_EQ(fgetc(fp), EOF);
+  fclose(fp);
+  for (int y = 0; y < h; ++y) {
+    for (int x = 0; x < w; ++x) {
+      EXPECT_EQ(pixels[(y * w + x) * 3], (float)(x * 10 + y));
+      EXPECT_EQ(pixels[(y * w + x) * 3 + 2], 1e3f);
+    }
+  }
+}
+
+TEST (hdr_image_test, exr_header) {
+  HdrImage image(64, 4, HdrImage::ALL_AUX);
+  for (int y = 0; y < 4; ++y) {
+    for (int x = 0; x < 64; ++x) {
+      image.SetPixel(x, y, {0.25, 0.25, 0.25});
+      image.SetDepth(x, y, 1.f);
+      image.SetSampleCount(x, y, 16);
+    }
+  }
+
+  for (bool rle : {false, true}) {
+    ASSERT_TRUE(image.WriteExr("hdr_image_test.exr", rle));
+    auto fp = fopen("hdr_image_test.exr", "rb");
+    ASSERT_NE(fp, nullptr);
+    std::vector<char> buffer(1 << 16);
+    auto n = fread(buffer.data(), 1, buffer.size(), fp);
+    fclose(fp);
+
+    uint32_t magic;
+    memcpy(&magic, buffer.data(), 4);
+    EXPECT_EQ(magic, 20000630u);
+    EXPECT_EQ(buffer[4], 2);
+
+    std::string content(buffer.data(), n);
+    for (auto attr : {"channels", "compression", "dataWindow", "displayWindow",
+                      "lineOrder", "pixelAspectRatio", "screenWindowCenter",
+                      "screenWindowWidth", "albedo.R", "normal.Z", "sampleCount"}) {
+      EXPECT_NE(content.find(attr), std::string::npos) << attr;
+    }
+  }
+}
+
+TEST (hdr_image_test, hdr_round_trip) {
+  // Width < 8 is always flat
+  for (int w : {5, 64}) {
+    const int h = 3;
+    HdrImage image(w, h);
+    for (int y = 0; y < h; ++y) {
+      for (int x = 0; x < w; ++x) {
+        // Runs(constant rows) and literal bytes
+        image.SetPixel(x, y, {y == 0 ? 1. : x * 0.37 + y, 1e-3 * x, 250.});
+      }
+    }
+
+    for (bool rle : {false, true}) {
+      ASSERT_TRUE(image.WriteHdr("hdr_image_test.hdr", rle));
+      HdrImage decoded;
+      ASSERT_TRUE(decoded.ReadHdr("hdr_image_test.hdr"));
+      ASSERT_EQ(decoded.width(), w);
+      ASSERT_EQ(decoded.height(), h);
+      for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+          auto expected = image.GetPixel(x, y);
+          auto actual = decoded.GetPixel(x, y);
+          // Half of the quantization step of the max component
+          int e;
+          frexp(std::max(expected.x, std::max(expected.y, expected.z)), &e);
+          const double step = ldexp(1., e - 8);
+          EXPECT_NEAR(actual.x, expected.x, step / 2);
+          EXPECT_NEAR(actual.y, expected.y, step / 2);
+          EXPECT_NEAR(actual.z, expected.z, step / 2);
+        }
+      }
+    }
+  }
+
+  HdrImage image;
+  EXPECT_FALSE(image.ReadHdr("hdr_image_test.pfm"));
+}
@@ -0,0 +1,28 @@
+#include "img/heatmap.hh"
+
+#include <gtest/gtest.h>
+
+using namespace img;
+
+TEST (heatmap_test, map_color) {
+  EXPECT_EQ(Heatmap::MapColor(0), Color(0, 0, 0));
+  EXPECT_EQ(Heatmap::MapColor(1), Color(255, 255, 255));
+  EXPECT_EQ(Heatmap::MapColor(2), Color(255, 255, 255));
+  EXPECT_EQ(Heatmap::MapColor(0.5), Color(255, 0, 0));
+}
+
+TEST (heatmap_test, outlier) {
+  Heatmap heatmap(100, 2);
+  for (int y = 0; y < 2; ++y) {
+    for (int x = 0; x < 100; ++x) {
+      heatmap.Add(x, y, 10);
+    }
+  }
+  // Don't affect the scale
+  heatmap.Add(0, 0, 100000);
+
+  auto image = heatmap.ToImage();
+  EXPECT_EQ(image.GetPixel(0, 0), Color(255, 255, 255));
+  EXPECT_EQ(image.GetPixel(1, 0), Color(255, 255, 255));
+  EXPECT_EQ(heatmap.Get(0, 0), 100010u);
+}
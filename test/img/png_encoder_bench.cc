@@ -0,0 +1,39 @@
+#include "img/png_encoder.hh"
+
+#include <benchmark/benchmark.h>
+#include <thread>
+
+using namespace benchmark;
+using namespace img;
+
+// 1080p, the noise of path tracing is simulated by a random pattern
+static TgaImage make_image()
+{
+  TgaImage image(1920, 1080);
+  uint32_t seed = 1;
+  for (int y = 0; y < image.height(); ++y) {
+    for (int x = 0; x < image.width(); ++x) {
+      seed = seed * 1664525u + 1013904223u;
+      auto noise = uint8_t((seed >> 24) & 0xf);
+      image.SetPixel(x, y, Color(uint8_t(x / 8 + noise), uint8_t(y / 5 + noise), 128));
+    }
+  }
+  return image;
+}
+
+static void png_encode(State &state)
+{
+  static const auto image = make_image();
+  PngEncoder encoder((int)state.range(0));
+  std::vector<uint8_t> out;
+  for (auto _ : state) {
+    encoder.Encode(image.data(), image.width(), image.height(),
+                   image.bytes_per_pixel(), out);
+    DoNotOptimize(out.data());
+  }
+  state.counters["bytes"] = (double)out.size();
+}
+
+BENCHMARK(png_encode)
+    ->Arg(1)->Arg(2)->Arg(4)->Arg(8)
+    ->Unit(kMillisecond)->UseRealTime();
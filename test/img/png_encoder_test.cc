@@ -0,0 +1,215 @@
+#include "img/png_encoder.hh"
+#include "util/checksum.hh"
+
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace img;
+
+/**
+ * Minimal zlib decoder which only accepts the stored and fixed Huffman
+ * blocks(i.e. the output of PngEncoder)
+ */
+class FixedInflater {
+ public:
+  explicit FixedInflater(std::vector<uint8_t> const &in)
+    : in_(in)
+  {}
+
+  bool Inflate(std::vector<uint8_t> &out)
+  {
+    if (in_.size() < 6 || ((in_[0] << 8) | in_[1]) % 31 != 0) return false;
+    pos_ = 2;
+
+    bool final;
+    do {
+      final = Bits(1);
+      const int type = Bits(2);
+      if (type == 0) {
+        bit_count_ = 0; // align
+        if (pos_ + 4 > in_.size()) return false;
+        const int len = in_[pos_] | (in_[pos_ + 1] << 8);
+        const int nlen = in_[pos_ + 2] | (in_[pos_ + 3] << 8);
+        if ((len ^ 0xffff) != nlen) return false;
+        pos_ += 4;
+        out.insert(out.end(), in_.begin() + pos_, in_.begin() + pos_ + len);
+        pos_ += len;
+      } else if (type == 1) {
+        if (!InflateFixed(out)) return false;
+      } else {
+        return false;
+      }
+    } while (!final);
+
+    bit_count_ = 0;
+    if (pos_ + 4 != in_.size()) return false;
+    uint32_t adler = (in_[pos_] << 24) | (in_[pos_ + 1] << 16) |
+                     (in_[pos_ + 2] << 8) | in_[pos_ + 3];
+    return adler == util::adler32(1, out.data(), out.size());
+  }
+
+ private:
+  int Bits(int n)
+  {
+    int v = 0;
+    for (int i = 0; i < n; ++i) {
+      if (bit_count_ == 0) {
+        cur_ = in_.at(pos_++);
+        bit_count_ = 8;
+      }
+      v |= (cur_ & 1) << i;
+      cur_ >>= 1;
+      --bit_count_;
+    }
+    return v;
+  }
+
+  // Huffman codes are packed from MSB
+  int Code(int n)
+  {
+    int v = 0;
+    for (int i = 0; i < n; ++i) v = (v << 1) | Bits(1);
+    return v;
+  }
+
+  int LiteralSymbol()
+  {
+    int code = Code(7);
+    if (code <= 0x17) return code + 256;
+    code = (code << 1) | Bits(1);
+    if (code >= 0x30 && code <= 0xbf) return code - 0x30;
+    if (code >= 0xc0 && code <= 0xc7) return code - 0xc0 + 280;
+    code = (code << 1) | Bits(1);
+    return code - 0x190 + 144;
+  }
+
+  bool InflateFixed(std::vector<uint8_t> &out)
+  {
+    static const int length_base[] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17,
+      19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    static const int length_extra[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2,
+      2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    static const int dist_base[] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49,
+      65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+      6145, 8193, 12289, 16385, 24577};
+    static const int dist_extra[] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5,
+      6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+    while (true) {
+      const int sym = LiteralSymbol();
+      if (sym < 256) {
+        out.push_back((uint8_t)sym);
+      } else if (sym == 256) {
+        return true;
+      } else {
+        const int li = sym - 257;
+        if (li >= 29) return false;
+        const int len = length_base[li] + Bits(length_extra[li]);
+        const int ds = Code(5);
+        if (ds >= 30) return false;
+        const int dist = dist_base[ds] + Bits(dist_extra[ds]);
+        if (dist > (int)out.size()) return false;
+        for (int i = 0; i < len; ++i) {
+          out.push_back(out[out.size() - dist]);
+        }
+      }
+    }
+  }
+
+  std::vector<uint8_t> const &in_;
+  size_t pos_ = 0;
+  uint8_t cur_ = 0;
+  int bit_count_ = 0;
+};
+
+static uint32_t read_be32(uint8_t const *p)
+{
+  return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static uint8_t unfilter_predictor(int filter, int a, int b, int c)
+{
+  switch (filter) {
+    case 1: return (uint8_t)a;
+    case 2: return (uint8_t)b;
+    case 3: return uint8_t((a + b) >> 1);
+    case 4: {
+      int p = a + b - c;
+      int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+      return uint8_t((pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c));
+    }
+  }
+  return 0;
+}
+
+static void check_round_trip(int w, int h, int bpp, int thread_num, int segment_rows)
+{
+  std::vector<uint8_t> pixels((size_t)w * h * bpp);
+  for (size_t i = 0; i < pixels.size(); ++i) {
+    // Flat areas and gradients
+    auto x = (i / bpp) % w;
+    pixels[i] = x < (size_t)w / 3 ? 77 : uint8_t(i * 7 + (i / w) * 3);
+  }
+
+  PngEncoder encoder(thread_num);
+  encoder.set_segment_rows(segment_rows);
+  std::vector<uint8_t> png;
+  ASSERT_TRUE(encoder.Encode(pixels.data(), w, h, bpp, png));
+
+  ASSERT_EQ(std::string((char const*)png.data() + 1, 3), "PNG");
+
+  // Walk the chunks and check CRC
+  std::vector<uint8_t> zlib;
+  size_t pos = 8;
+  std::string last_type;
+  while (pos < png.size()) {
+    const auto len = read_be32(&png[pos]);
+    std::string type((char const *)&png[pos + 4], 4);
+    ASSERT_EQ(util::crc32(0, &png[pos + 4], len + 4),
+              read_be32(&png[pos + 8 + len])) << type;
+    if (type == "IHDR") {
+      EXPECT_EQ(read_be32(&png[pos + 8]), (uint32_t)w);
+      EXPECT_EQ(read_be32(&png[pos + 12]), (uint32_t)h);
+    } else if (type == "IDAT") {
+      zlib.insert(zlib.end(), &png[pos + 8], &png[pos + 8] + len);
+    }
+    last_type = type;
+    pos += 12 + len;
+  }
+  EXPECT_EQ(last_type, "IEND");
+
+  std::vector<uint8_t> raw;
+  ASSERT_TRUE(FixedInflater(zlib).Inflate(raw));
+  const int stride = w * bpp;
+  ASSERT_EQ(raw.size(), size_t(stride + 1) * h);
+
+  // Unfilter and compare with the pixels(top to bottom, RGB order)
+  std::vector<uint8_t> prev(stride, 0);
+  std::vector<uint8_t> cur(stride);
+  for (int y = 0; y < h; ++y) {
+    const uint8_t *line = &raw[(size_t)y * (stride + 1)];
+    for (int x = 0; x < stride; ++x) {
+      int a = x >= bpp ? cur[x - bpp] : 0;
+      int c = x >= bpp ? prev[x - bpp] : 0;
+      cur[x] = uint8_t(line[1 + x] + unfilter_predictor(line[0], a, prev[x], c));
+    }
+    auto src = &pixels[size_t(h - 1 - y) * stride];
+    for (int x = 0; x < stride; x += bpp) {
+      for (int k = 0; k < bpp; ++k) {
+        int sk = (bpp >= 3 && k < 3) ? 2 - k : k;
+        ASSERT_EQ(cur[x + k], src[x + sk]) << x << " " << y;
+      }
+    }
+    std::swap(prev, cur);
+  }
+}
+
+TEST (png_encoder_test, serial) {
+  check_round_trip(123, 45, TgaImage::RGB, 1, 0);
+}
+
+TEST (png_encoder_test, parallel_segments) {
+  check_round_trip(123, 45, TgaImage::RGB, 4, 4);
+  check_round_trip(64, 33, TgaImage::RGBA, 3, 1);
+  check_round_trip(300, 20, TgaImage::GRAYSCALE, 8, 7);
+}
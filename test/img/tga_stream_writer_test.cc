@@ -0,0 +1,48 @@
+#include "img/tga_stream_writer.hh"
+
+#include <gtest/gtest.h>
+
+using namespace img;
+
+static Color pattern_color(int x, int y)
+{
+  // Runs and different pixels are both included
+  return (x < 40) ? Color(10, 20, 30) : Color(x, y, (x + y) & 0xff);
+}
+
+TEST (tga_stream_writer_test, rle_out_of_order) {
+  const int w = 300;
+  const int h = 37;
+  const int block = 8;
+
+  TgaStreamWriter writer(w, h, block, TgaImage::RGB, true);
+  ASSERT_TRUE(writer.Open("tga_stream_writer_test.tga"));
+
+  auto tiles = writer.SplitTiles();
+  ASSERT_EQ(tiles.size(), 5u);
+
+  // Submit in reverse order, all blocks must be cached until the last one
+  for (auto iter = tiles.rbegin(); iter != tiles.rend(); ++iter) {
+    std::vector<uint8_t> data;
+    for (int y = iter->y; y < iter->y + iter->h; ++y) {
+      for (int x = 0; x < w; ++x) {
+        auto c = pattern_color(x, y);
+        data.insert(data.end(), c.data(), c.data() + TgaImage::RGB);
+      }
+    }
+    ASSERT_TRUE(writer.WriteTile(iter->x, iter->y, iter->w, iter->h,
+                                 data.data()));
+  }
+  ASSERT_TRUE(writer.Close());
+  EXPECT_GT(writer.peak_pending_bytes(), 0u);
+
+  TgaImage image;
+  ASSERT_TRUE(image.ReadFrom("tga_stream_writer_test.tga"));
+  ASSERT_EQ(image.width(), w);
+  ASSERT_EQ(image.height(), h);
+  for (int y = 0; y < h; ++y) {
+    for (int x = 0; x < w; ++x) {
+      EXPECT_EQ(image.GetPixel(x, y), pattern_color(x, y));
+    }
+  }
+}
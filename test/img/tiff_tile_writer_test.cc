@@ -0,0 +1,141 @@
+#include "img/tiff_tile_writer.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <map>
+
+using namespace img;
+
+// The BGR of the pixel, y is from the bottom like TgaImage
+static void pattern_pixel(int x, int y, uint8_t *bgr)
+{
+  bgr[0] = (uint8_t)x;
+  bgr[1] = (uint8_t)y;
+  bgr[2] = 7;
+}
+
+static uint16_t read16(std::vector<uint8_t> const &buf, size_t offset)
+{
+  return (uint16_t)(buf[offset] | buf[offset + 1] << 8);
+}
+
+static uint32_t read32(std::vector<uint8_t> const &buf, size_t offset)
+{
+  return (uint32_t)read16(buf, offset) |
+         (uint32_t)read16(buf, offset + 2) << 16;
+}
+
+TEST (tiff_tile_writer_test, round_trip) {
+  const int w = 100;
+  const int h = 70;
+  const int tile_size = 32;
+  const int tiles_across = 4;
+  const int tiles_down = 3;
+
+  TiffTileWriter writer(w, h, tile_size);
+  ASSERT_TRUE(writer.Open("tiff_tile_writer_test.tif"));
+
+  auto tiles = writer.SplitTiles();
+  ASSERT_EQ(tiles.size(), (size_t)(tiles_across * tiles_down));
+
+  // The tiles are written in the order of completion, i.e. any order
+  for (auto iter = tiles.rbegin(); iter != tiles.rend(); ++iter) {
+    std::vector<uint8_t> data((size_t)iter->w * iter->h * 3);
+    for (int y = 0; y < iter->h; ++y) {
+      for (int x = 0; x < iter->w; ++x) {
+        pattern_pixel(iter->x + x, iter->y + y,
+                      &data[((size_t)y * iter->w + x) * 3]);
+      }
+    }
+    ASSERT_TRUE(writer.WriteTile(iter->x, iter->y, iter->w, iter->h,
+                                 data.data()));
+  }
+  ASSERT_TRUE(writer.Close());
+
+  std::ifstream in("tiff_tile_writer_test.tif", std::ios::binary);
+  std::vector<uint8_t> buf((std::istreambuf_iterator<char>(in)),
+                           std::istreambuf_iterator<char>());
+  ASSERT_GE(buf.size(), 8u);
+
+  // Header: little endian, 42, IFD offset(word boundary)
+  EXPECT_EQ(buf[0], 'I');
+  EXPECT_EQ(buf[1], 'I');
+  EXPECT_EQ(read16(buf, 2), 42);
+  const uint32_t ifd_offset = read32(buf, 4);
+  EXPECT_EQ(ifd_offset % 2, 0u);
+  ASSERT_LT(ifd_offset + 2u, buf.size());
+
+  // IFD: the tags are in ascending order
+  const int entry_num = read16(buf, ifd_offset);
+  ASSERT_EQ(entry_num, 11);
+  ASSERT_LE(ifd_offset + 2u + entry_num * 12u + 4u, buf.size());
+  std::map<uint16_t, std::pair<uint32_t, uint32_t>> entries;
+  uint16_t last_tag = 0;
+  for (int i = 0; i < entry_num; ++i) {
+    const size_t entry = ifd_offset + 2 + (size_t)i * 12;
+    const uint16_t tag = read16(buf, entry);
+    EXPECT_GT(tag, last_tag);
+    last_tag = tag;
+    entries[tag] = {read32(buf, entry + 4), read32(buf, entry + 8)};
+  }
+  EXPECT_EQ(read32(buf, ifd_offset + 2 + entry_num * 12u), 0u);
+
+  EXPECT_EQ(entries[256].second, (uint32_t)w);  // ImageWidth
+  EXPECT_EQ(entries[257].second, (uint32_t)h);  // ImageLength
+  EXPECT_EQ(entries[258].first, 3u);            // BitsPerSample
+  EXPECT_EQ(entries[259].second, 1u);           // Compression: none
+  EXPECT_EQ(entries[262].second, 2u);           // Photometric: RGB
+  EXPECT_EQ(entries[277].second, 3u);           // SamplesPerPixel
+  EXPECT_EQ(entries[322].second, (uint32_t)tile_size); // TileWidth
+  EXPECT_EQ(entries[323].second, (uint32_t)tile_size); // TileLength
+  ASSERT_EQ(entries[324].first, (uint32_t)tiles.size()); // TileOffsets
+  ASSERT_EQ(entries[325].first, (uint32_t)tiles.size()); // TileByteCounts
+
+  const uint32_t bits_offset = entries[258].second;
+  for (int i = 0; i < 3; ++i) EXPECT_EQ(read16(buf, bits_offset + i * 2u), 8);
+
+  // The tiles are padded to the whole tile size and don't overlap
+  const uint32_t tile_bytes = tile_size * tile_size * 3;
+  const uint32_t offsets_offset = entries[324].second;
+  const uint32_t counts_offset = entries[325].second;
+  std::vector<uint32_t> offsets;
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    offsets.push_back(read32(buf, offsets_offset + i * 4));
+    EXPECT_EQ(read32(buf, counts_offset + i * 4), tile_bytes);
+    EXPECT_GE(offsets.back(), 8u);
+    EXPECT_LE(offsets.back() + tile_bytes, ifd_offset);
+  }
+  auto sorted = offsets;
+  std::sort(sorted.begin(), sorted.end());
+  for (size_t i = 1; i < sorted.size(); ++i) {
+    EXPECT_EQ(sorted[i] - sorted[i - 1], tile_bytes);
+  }
+
+  // The tiles are RGB from the top left corner
+  for (int ty = 0; ty < tiles_down; ++ty) {
+    for (int tx = 0; tx < tiles_across; ++tx) {
+      const uint32_t tile = offsets[ty * tiles_across + tx];
+      for (int row = 0; row < tile_size; ++row) {
+        const int top = ty * tile_size + row;
+        for (int col = 0; col < tile_size; ++col) {
+          const int x = tx * tile_size + col;
+          auto rgb = &buf[tile + ((size_t)row * tile_size + col) * 3];
+          uint8_t bgr[3] = {0, 0, 0};
+          if (x < w && top < h) pattern_pixel(x, h - 1 - top, bgr);
+          ASSERT_EQ(rgb[0], bgr[2]) << x << ", " << top;
+          ASSERT_EQ(rgb[1], bgr[1]) << x << ", " << top;
+          ASSERT_EQ(rgb[2], bgr[0]) << x << ", " << top;
+        }
+      }
+    }
+  }
+}
+
+TEST (tiff_tile_writer_test, too_large) {
+  // About 4.3GB, the 32-bit offsets would wrap
+  TiffTileWriter writer(37888, 37888, 64);
+  EXPECT_FALSE(writer.Open("tiff_tile_writer_test_large.tif"));
+}
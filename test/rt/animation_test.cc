@@ -0,0 +1,63 @@
+#include "rt/animation.hh"
+#include "material/lambertian.hh"
+#include "shape/sphere.hh"
+
+#include <gtest/gtest.h>
+
+using namespace rt;
+using namespace gm;
+
+TEST (animation_test, apply) {
+  Scene scene;
+  auto white = scene.resources->lambertian(Color(.5, .5, .5));
+  scene.world.add(std::make_shared<Sphere>(Point3F(0, 0, 0), 1, white));
+  scene.world.add(std::make_shared<Sphere>(Point3F(5, 0, 0), 1, white));
+  SceneEditor editor(scene);
+
+  Animation animation;
+  EXPECT_TRUE(animation.empty());
+  animation.set_camera(
+    KeyframeTrack({{0, Vec3F(0, 0, 10)}, {10, Vec3F(10, 0, 10)}}),
+    KeyframeTrack({{0, Vec3F(0, 0, 0)}}));
+  animation.add_object(
+    1, KeyframeTrack({{0, Vec3F(0, 0, 0)}, {4, Vec3F(0, 90, 0)}}),
+    KeyframeTrack({{0, Vec3F(0, 0, 0)}, {4, Vec3F(0, 4, 0)}}));
+  EXPECT_FALSE(animation.empty());
+
+  animation.apply(2, scene, editor);
+  EXPECT_EQ(scene.lookfrom.x, 2);
+  EXPECT_EQ(scene.lookat.z, 0);
+  EXPECT_EQ(editor.object(1).rotation().y, 45);
+  EXPECT_EQ(editor.object(1).translation().y, 2);
+  // The object without keyframes stays
+  EXPECT_EQ(editor.object(0).translation().y, 0);
+
+  // The moved object is refit
+  auto stats = editor.update();
+  EXPECT_FALSE(stats.rebuilt);
+  EXPECT_GT(stats.refit_nodes, 0u);
+  Aabb box;
+  ASSERT_TRUE(scene.bvh->get_bounding_box(box));
+  EXPECT_NEAR(box.max().y, 3, 1e-9);
+}
+
+TEST (animation_test, builtin) {
+  for (int id = 0; id < BUILTIN_SCENE_NUM; ++id) {
+    if (id == 3) continue; // The image texture may not exist
+    Scene scene;
+    setup_builtin_scene(id, scene);
+    const auto lookat = scene.lookat;
+    const auto distance = (scene.lookfrom - lookat).length();
+    SceneEditor editor(scene);
+    auto animation = builtin_animation(id, scene, editor);
+    ASSERT_FALSE(animation.empty()) << id;
+
+    // The camera orbits around the lookat
+    for (int frame = 0; frame < BUILTIN_ANIMATION_FRAMES; frame += 5) {
+      animation.apply(frame, scene, editor);
+      editor.update();
+      EXPECT_NEAR((scene.lookfrom - scene.lookat).length(), distance, 1e-9);
+      EXPECT_EQ(scene.lookat.x, lookat.x);
+    }
+  }
+}
@@ -0,0 +1,252 @@
+#include "img/hdr_image.hh"
+#include "rt/camera.hh"
+#include "rt/integrator.hh"
+#include "rt/scene.hh"
+#include "util/random.hh"
+
+#include <cmath>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using namespace rt;
+using namespace gm;
+using namespace img;
+using namespace util;
+
+/**
+ * Render the builtin scenes and compare them with the references in
+ * test/rt/reference/.
+ *
+ * Monte Carlo renders never match exactly, so the tolerance is derived from
+ * the variance of the estimator which is measured during rendering:
+ *   E[(x - r)^2] = Var[x] / n + Var[r] / n_ref + (quantization error of r)
+ * Two checks:
+ * 1. relMSE = mean((x - r)^2 / (r^2 + eps)) is compared with its expectation
+ *    (catches noise increase and local artifacts)
+ * 2. The z-score of the summed difference in each tile and the whole image
+ *    (catches the bias, e.g. losing some energy)
+ *
+ * The RGBE quantization error of the reference is not random(e.g. the
+ * background is constant), so it is bounded by the half step instead of
+ * being treated as noise.
+ *
+ * Set RT_UPDATE_REFERENCE=1 to regenerate the references after an intended
+ * change of the result(e.g. a new scene).
+ */
+
+#define REGRESSION_IMAGE_HEIGHT 36
+#define REGRESSION_SAMPLE_PER_PIXEL 64
+#define REFERENCE_SAMPLE_PER_PIXEL 1024
+
+// The layout of random scene depends on it
+#define SCENE_SEED 1
+#define RENDER_SEED 2
+#define REFERENCE_SEED 3
+
+// relMSE <= expectation * RELMSE_FACTOR
+#define RELMSE_FACTOR 1.5
+#define RELMSE_EPS 1e-2
+// |z| of the whole image <= Z_SCORE_LIMIT
+#define Z_SCORE_LIMIT 5.
+// There are many tiles and the variance of some tiles are underestimated
+// (fireflies), the limit is looser
+#define TILE_SIZE 8
+#define TILE_Z_SCORE_LIMIT 6.
+
+static std::string reference_path(int id)
+{
+  std::string path = __FILE__;
+  path.resize(path.rfind('/') + 1);
+  return path + "reference/" + builtin_scene_name(id) + ".hdr";
+}
+
+struct RenderResult {
+  HdrImage mean;
+  std::vector<double> variance; // Of one sample, per channel
+};
+
+static RenderResult render(Scene const &scene, int spp, uint64_t seed)
+{
+  const int height = REGRESSION_IMAGE_HEIGHT;
+  const int width = (int)(height * scene.aspect_ratio);
+  Camera camera(scene.lookfrom, scene.lookat, scene.aspect_ratio, scene.fov, 1);
+  camera.set_aperture(0.0);
+  camera.set_shutter(scene.time0, scene.time1);
+
+  RenderResult result{HdrImage(width, height),
+                      std::vector<double>((size_t)width * height * 3)};
+  for (int j = 0; j < height; ++j) {
+    seed_random(mix_seed(seed, j));
+    for (int i = 0; i < width; ++i) {
+      Vec3F sum(0, 0, 0);
+      Vec3F sum2(0, 0, 0);
+      int n = 0;
+      for (int k = 0; k < spp; ++k) {
+        auto offset = double(k) / spp;
+        auto ray = camera.ray((i + offset) / (width - 1),
+                              (j + offset) / (height - 1));
+        auto sample = ray_color(ray, scene, MAX_DEPTH);
+        if (std::isnan(sample.x) || std::isnan(sample.y) ||
+            std::isnan(sample.z))
+          continue;
+        sum += sample;
+        sum2 += sample * sample;
+        ++n;
+      }
+
+      const Vec3F mean = n ? sum / n : sum;
+      result.mean.SetPixel(i, j, mean);
+      auto var = &result.variance[((size_t)j * width + i) * 3];
+      for (int c = 0; c < 3; ++c) {
+        var[c] = n > 1 ? std::max(0., (sum2[c] - n * mean[c] * mean[c]) / (n - 1))
+                       : 0.;
+      }
+    }
+  }
+  return result;
+}
+
+// The max error of the RGBE quantization(the decoder uses the center)
+static double rgbe_quantization_error(Vec3F const &rgb)
+{
+  const double v = std::max(rgb.x, std::max(rgb.y, rgb.z));
+  if (v < 1e-32) return 0;
+  int e;
+  frexp(v, &e);
+  return ldexp(1., e - 8) / 2;
+}
+
+/**
+ * Accumulate the difference of a region
+ */
+struct DiffSum {
+  double diff[3] = {0, 0, 0};
+  double var[3] = {0, 0, 0};
+  double quantization_error = 0;
+
+  void Add(double d, double v, int c) noexcept
+  {
+    diff[c] += d;
+    var[c] += v;
+  }
+
+  double ZScore() const noexcept
+  {
+    double z = 0;
+    for (int c = 0; c < 3; ++c) {
+      const double d = std::max(0., fabs(diff[c]) - quantization_error);
+      if (var[c] > 0) z = std::max(z, d / sqrt(var[c]));
+      else if (d > 0) z = gm::inf;
+    }
+    return z;
+  }
+};
+
+struct Comparison {
+  double relmse = 0;
+  double expected_relmse = 0;
+  double max_tile_z = 0;
+  double image_z = 0;
+};
+
+static Comparison compare(RenderResult const &result, HdrImage const &ref)
+{
+  const int w = result.mean.width();
+  const int h = result.mean.height();
+  Comparison cmp;
+  DiffSum image;
+
+  for (int ty = 0; ty < h; ty += TILE_SIZE) {
+    for (int tx = 0; tx < w; tx += TILE_SIZE) {
+      DiffSum tile;
+      for (int y = ty; y < std::min(h, ty + TILE_SIZE); ++y) {
+        for (int x = tx; x < std::min(w, tx + TILE_SIZE); ++x) {
+          auto xs = result.mean.GetPixel(x, y);
+          auto rs = ref.GetPixel(x, y);
+          auto sample_var = &result.variance[((size_t)y * w + x) * 3];
+          const double q = rgbe_quantization_error(rs);
+          tile.quantization_error += q;
+          image.quantization_error += q;
+          for (int c = 0; c < 3; ++c) {
+            // The variance of reference is estimated by the same estimator
+            const double v = sample_var[c] / REGRESSION_SAMPLE_PER_PIXEL +
+                             sample_var[c] / REFERENCE_SAMPLE_PER_PIXEL;
+            const double d = xs[c] - rs[c];
+            const double denom = rs[c] * rs[c] + RELMSE_EPS;
+            cmp.relmse += d * d / denom;
+            cmp.expected_relmse += (v + q * q / 3) / denom;
+            tile.Add(d, v, c);
+            image.Add(d, v, c);
+          }
+        }
+      }
+
+      cmp.max_tile_z = std::max(cmp.max_tile_z, tile.ZScore());
+    }
+  }
+  cmp.image_z = image.ZScore();
+
+  const double n = (double)w * h * 3;
+  cmp.relmse /= n;
+  cmp.expected_relmse /= n;
+  return cmp;
+}
+
+class RenderRegressionTest : public ::testing::TestWithParam<int> {
+ protected:
+  void SetUp() override
+  {
+    seed_random(SCENE_SEED);
+    setup_builtin_scene(GetParam(), scene_);
+  }
+
+  Scene scene_;
+};
+
+TEST_P (RenderRegressionTest, compare_with_reference) {
+  const int id = GetParam();
+  const auto path = reference_path(id);
+
+  if (getenv("RT_UPDATE_REFERENCE")) {
+    auto ref = render(scene_, REFERENCE_SAMPLE_PER_PIXEL, REFERENCE_SEED);
+    ASSERT_TRUE(ref.mean.WriteHdr(path.c_str()));
+    return;
+  }
+
+  HdrImage ref;
+  ASSERT_TRUE(ref.ReadHdr(path.c_str()))
+    << "Run with RT_UPDATE_REFERENCE=1 to generate " << path;
+
+  auto result = render(scene_, REGRESSION_SAMPLE_PER_PIXEL, RENDER_SEED);
+  ASSERT_EQ(result.mean.width(), ref.width());
+  ASSERT_EQ(result.mean.height(), ref.height());
+
+  auto cmp = compare(result, ref);
+  RecordProperty("relMSE", std::to_string(cmp.relmse));
+  RecordProperty("expected_relMSE", std::to_string(cmp.expected_relmse));
+  RecordProperty("max_tile_z", std::to_string(cmp.max_tile_z));
+  EXPECT_LE(cmp.relmse, cmp.expected_relmse * RELMSE_FACTOR)
+    << builtin_scene_name(id);
+  EXPECT_LE(cmp.max_tile_z, TILE_Z_SCORE_LIMIT) << builtin_scene_name(id);
+  EXPECT_LE(cmp.image_z, Z_SCORE_LIMIT) << builtin_scene_name(id);
+
+  // The harness must be able to detect a slight bias
+  for (int y = 0; y < result.mean.height(); ++y) {
+    for (int x = 0; x < result.mean.width(); ++x) {
+      result.mean.SetPixel(x, y, result.mean.GetPixel(x, y) * 0.9);
+    }
+  }
+  EXPECT_GT(compare(result, ref).image_z, Z_SCORE_LIMIT)
+    << builtin_scene_name(id);
+}
+
+// The first scene is black(no light and background) and the image scene
+// depends on the texture file, they are not included
+INSTANTIATE_TEST_SUITE_P(builtin_scenes, RenderRegressionTest,
+                         ::testing::Values(1, 2, 4, 5, 6, 7),
+                         [](::testing::TestParamInfo<int> const &param_info) {
+                           return std::string(
+                             builtin_scene_name(param_info.param));
+                         });
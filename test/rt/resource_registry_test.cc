@@ -0,0 +1,61 @@
+#include "rt/resource_registry.hh"
+#include "rt/scene.hh"
+#include "texture/solid_texture.hh"
+#include "util/random.hh"
+
+#include <gtest/gtest.h>
+
+using namespace rt;
+
+TEST (resource_registry_test, intern_materials) {
+  ResourceRegistry resources;
+
+  auto red = resources.lambertian(Color(1, 0, 0));
+  EXPECT_EQ(resources.lambertian(Color(1, 0, 0)), red);
+  EXPECT_NE(resources.lambertian(Color(0, 1, 0)), red);
+  // The same parameters of different types
+  EXPECT_NE(resources.diffuse_light(Color(1, 0, 0)), red);
+  EXPECT_NE(resources.isotropic(Color(1, 0, 0)), red);
+
+  // The solid texture is the constant color
+  auto solid = std::make_shared<SolidTexture>(Color(1, 0, 0));
+  EXPECT_EQ(resources.lambertian(solid), red);
+  EXPECT_EQ(red->record().texture, nullptr);
+
+  auto glass = resources.dielectric(1.5);
+  EXPECT_EQ(resources.dielectric(1.5), glass);
+  EXPECT_NE(resources.dielectric(1.33), glass);
+
+  // The fuzz is clamped by the material
+  EXPECT_EQ(resources.metal(Color(1, 1, 1), 2), resources.metal(Color(1, 1, 1), 1));
+  EXPECT_NE(resources.metal(Color(1, 1, 1), 0), resources.metal(Color(1, 1, 1), 1));
+
+  EXPECT_EQ(resources.material_count(), 8u);
+  EXPECT_EQ(resources.reused(), 5u);
+}
+
+TEST (resource_registry_test, intern_textures) {
+  ResourceRegistry resources;
+
+  auto checker = resources.checker_texture(Color(0, 0, 0), Color(1, 1, 1));
+  EXPECT_EQ(resources.checker_texture(Color(0, 0, 0), Color(1, 1, 1)), checker);
+  EXPECT_NE(resources.checker_texture(Color(1, 1, 1), Color(0, 0, 0)), checker);
+  // The colors of checkers are shared
+  EXPECT_EQ(resources.texture_count(), 4u);
+
+  // The material is keyed by the texture object
+  auto ground = resources.lambertian(checker);
+  EXPECT_EQ(ground->record().texture, checker.get());
+  EXPECT_EQ(resources.lambertian(checker), ground);
+  EXPECT_NE(resources.diffuse_light(checker), ground);
+}
+
+TEST (resource_registry_test, random_scene) {
+  util::seed_random(1);
+  Scene scene;
+  setup_builtin_scene(1, scene);
+
+  // The dielectrics are one material
+  EXPECT_LT(scene.resources->material_count(), scene.world.shape().size());
+  EXPECT_GT(scene.resources->reused(), 0u);
+}
@@ -0,0 +1,121 @@
+#include "rt/scene_arena.hh"
+#include "rt/hit_record.hh"
+#include "rt/scene.hh"
+#include "util/random.hh"
+
+#include <gtest/gtest.h>
+
+using namespace rt;
+
+namespace {
+
+struct Counted {
+  explicit Counted(int *destroyed)
+    : destroyed_(destroyed)
+  {
+  }
+  ~Counted() { ++*destroyed_; }
+
+  int *destroyed_;
+  double payload[3];
+};
+
+struct Throwing {
+  explicit Throwing(bool fail)
+  {
+    if (fail) throw std::runtime_error("fail");
+  }
+  double value = 1;
+};
+
+} // namespace
+
+TEST (scene_arena_test, make) {
+  int destroyed = 0;
+  {
+    auto arena = SceneArena::create();
+    std::vector<std::shared_ptr<Counted>> objects;
+    for (int i = 0; i < 1000; ++i)
+      objects.push_back(arena->make<Counted>(&destroyed));
+    auto value = arena->make<int>(42);
+    EXPECT_EQ(*value, 42);
+    EXPECT_EQ(objects[0].use_count(), 1);
+
+    // The objects of a type are contiguous(in a chunk)
+    const auto stride = (char *)objects[1].get() - (char *)objects[0].get();
+    EXPECT_GE(stride, (ptrdiff_t)sizeof(Counted));
+    EXPECT_EQ((char *)objects[2].get() - (char *)objects[1].get(), stride);
+
+    auto stats = arena->stats();
+    EXPECT_EQ(stats.object_num, 1001u);
+    EXPECT_EQ(stats.type_num, 2u);
+    EXPECT_GE(stats.used_bytes, 1000 * sizeof(Counted) + sizeof(int));
+    EXPECT_GE(stats.reserved_bytes, stats.used_bytes);
+    // Every object of make_shared costs a malloc header at least
+    EXPECT_GT(stats.shared_bytes, stats.used_bytes);
+
+    // The objects are owned by the shared_ptrs
+    objects.resize(10);
+    EXPECT_EQ(destroyed, 990);
+  }
+  EXPECT_EQ(destroyed, 1000);
+}
+
+TEST (scene_arena_test, outlive_creator) {
+  int destroyed = 0;
+  std::shared_ptr<Counted> object;
+  {
+    auto arena = SceneArena::create();
+    object = arena->make<Counted>(&destroyed);
+  }
+  // The object keeps the arena alive
+  EXPECT_EQ(destroyed, 0);
+  object->payload[0] = 1;
+  object.reset();
+  EXPECT_EQ(destroyed, 1);
+}
+
+TEST (scene_arena_test, constructor_throws) {
+  auto arena = SceneArena::create();
+  auto first = arena->make<Throwing>(false);
+  EXPECT_THROW(arena->make<Throwing>(true), std::runtime_error);
+  auto second = arena->make<Throwing>(false);
+  EXPECT_EQ(second->value, 1);
+}
+
+// The memory report of the random scene
+TEST (scene_arena_test, random_scene) {
+  util::seed_random(1);
+  Scene scene;
+  setup_builtin_scene(1, scene);
+  ASSERT_TRUE(scene.resources->arena());
+
+  auto stats = scene.resources->arena()->stats();
+  stats.Print(stdout);
+  // The shapes, materials and textures
+  EXPECT_GE(stats.object_num, scene.world.shape().size() +
+                                scene.resources->material_count());
+  // The control blocks are in the arena too, but no malloc header
+  EXPECT_LE(stats.used_bytes, stats.shared_bytes);
+
+  // Without the arena
+  util::seed_random(1);
+  Scene shared_scene;
+  shared_scene.resources = std::make_shared<ResourceRegistry>(false);
+  setup_builtin_scene(1, shared_scene);
+  EXPECT_FALSE(shared_scene.resources->arena());
+  EXPECT_EQ(shared_scene.world.shape().size(), scene.world.shape().size());
+  EXPECT_GT(shared_scene.world.shape()[0].use_count(), 0);
+
+  // The shapes copied out of the scene outlive it
+  auto shapes = std::make_unique<Scene>();
+  util::seed_random(1);
+  setup_builtin_scene(1, *shapes);
+  ShapeList world = shapes->world;
+  shapes.reset();
+  HitInfo info;
+  EXPECT_TRUE(world.intersect(Ray(Point3F(13, 2, 3), Vec3F(-13, -2, -3)),
+                              0.001, gm::inf, info));
+  ASSERT_TRUE(world.shape()[0]->material());
+  EXPECT_FALSE(world.shape()[0]->material()->is_emissive());
+}
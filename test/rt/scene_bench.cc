@@ -0,0 +1,374 @@
+#include "rt/camera.hh"
+#include "rt/hit_record.hh"
+#include "rt/integrator.hh"
+#include "rt/scene.hh"
+#include "rt/scene_editor.hh"
+#include "accelerate/aabb.hh"
+#include "accelerate/bvh_node.hh"
+#include "gm/onb.hh"
+#include "material/lambertian.hh"
+#include "sample/cosine_pdf.hh"
+#include "shape/moving_sphere.hh"
+#include "shape/rect.hh"
+#include "shape/sphere.hh"
+#include "util/random.hh"
+
+#include <benchmark/benchmark.h>
+#include <exception>
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace benchmark;
+using namespace rt;
+using namespace gm;
+using namespace util;
+
+// Small but fixed workload, the results of different runs are comparable
+#define BENCH_IMAGE_HEIGHT 32
+#define BENCH_SAMPLE_PER_PIXEL 4
+#define BENCH_SEED 0x5eed
+
+/**
+ * Count the rays which are tested against the world
+ * (camera, bounce and shadow rays all go through it)
+ */
+class CountingShape : public Shape {
+ public:
+  explicit CountingShape(Shape const &shape)
+    : shape_(shape)
+  {
+  }
+
+  // The hit shape fills the HitRecord
+  bool intersect(Ray const &ray, double tmin, double tmax,
+                 HitInfo &info) const override
+  {
+    ++ray_num;
+    return shape_.intersect(ray, tmin, tmax, info);
+  }
+
+  bool get_bounding_box(Aabb &output_box) const override
+  {
+    return shape_.get_bounding_box(output_box);
+  }
+
+  bool get_motion_bounds(double time0, double time1, Aabb &box0,
+                         Aabb &box1) const override
+  {
+    return shape_.get_motion_bounds(time0, time1, box0, box1);
+  }
+
+  mutable uint64_t ray_num = 0;
+
+ private:
+  Shape const &shape_;
+};
+
+// The resident memory of the process in KB(Linux only, 0 if unknown)
+// The peak(ru_maxrss) never decreases, so it can't tell the memory of the
+// later and smaller scenes
+static double resident_kb()
+{
+  auto fp = fopen("/proc/self/statm", "r");
+  if (!fp) return 0;
+  unsigned long long size = 0;
+  unsigned long long resident = 0;
+  const int n = fscanf(fp, "%llu %llu", &size, &resident);
+  fclose(fp);
+  if (n != 2) return 0;
+  return (double)resident * (double)sysconf(_SC_PAGESIZE) / 1024.;
+}
+
+static void render_scene(State &state)
+{
+  const int id = (int)state.range(0);
+  state.SetLabel(builtin_scene_name(id));
+
+  seed_random(BENCH_SEED);
+  const double resident_before = resident_kb();
+  Scene scene;
+  try {
+    setup_builtin_scene(id, scene);
+  } catch (std::exception const &ex) {
+    // e.g. The texture of the image scene is missing
+    state.SkipWithError(ex.what());
+    return;
+  }
+  // The memory of the objects, BVH and textures of this scene
+  const double scene_kb = resident_kb() - resident_before;
+
+  const int height = BENCH_IMAGE_HEIGHT;
+  const int width = (int)(height * scene.aspect_ratio);
+  Camera camera(scene.lookfrom, scene.lookat, scene.aspect_ratio, scene.fov, 1);
+  camera.set_shutter(scene.time0, scene.time1);
+  // The integrator tests the rays against scene.bvh(or scene.world)
+  auto world = std::make_shared<CountingShape>(
+    scene.bvh ? (Shape const &)*scene.bvh : (Shape const &)scene.world);
+  Scene counted = scene;
+  counted.world = ShapeList();
+  counted.world.add(world);
+  counted.bvh = nullptr;
+
+  uint64_t sample_num = 0;
+  for (auto _ : state) {
+    seed_random(BENCH_SEED);
+    for (int j = 0; j < height; ++j) {
+      for (int i = 0; i < width; ++i) {
+        Vec3F color(0, 0, 0);
+        for (int k = 0; k < BENCH_SAMPLE_PER_PIXEL; ++k) {
+          auto offset = double(k) / BENCH_SAMPLE_PER_PIXEL;
+          auto ray = camera.ray((i + offset) / (width - 1),
+                                (j + offset) / (height - 1));
+          color += ray_color(ray, counted, MAX_DEPTH);
+        }
+        DoNotOptimize(color);
+      }
+    }
+    sample_num += (uint64_t)width * height * BENCH_SAMPLE_PER_PIXEL;
+  }
+
+  state.counters["samples/s"] = Counter((double)sample_num, Counter::kIsRate);
+  state.counters["rays/s"] = Counter((double)world->ray_num, Counter::kIsRate);
+  state.counters["rays/sample"] =
+    Counter(sample_num ? (double)world->ray_num / (double)sample_num : 0.);
+  state.counters["scene_rss_kb"] = scene_kb;
+}
+
+BENCHMARK(render_scene)
+    ->DenseRange(0, BUILTIN_SCENE_NUM - 1)
+    ->Unit(kMillisecond);
+
+/*******************************************/
+/* Hot kernels                             */
+/*******************************************/
+static std::vector<Ray> make_rays(size_t n)
+{
+  seed_random(BENCH_SEED);
+  std::vector<Ray> rays;
+  rays.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    Point3F origin(random_double(-1, 1), random_double(-1, 1), 5);
+    Point3F target(random_double(-2, 2), random_double(-2, 2), -5);
+    // Spread in the shutter [0, 1] of the motion benchmarks
+    rays.emplace_back(origin, target - origin, double(i) / double(n));
+  }
+  return rays;
+}
+
+#define BENCH_RAY_NUM 1024
+
+static void aabb_hit(State &state)
+{
+  const auto rays = make_rays(BENCH_RAY_NUM);
+  Aabb box(Point3F(-1, -1, -1), Point3F(1, 1, 1));
+  for (auto _ : state) {
+    int hit_num = 0;
+    for (auto const &ray : rays)
+      hit_num += box.hit(ray, 0.001, gm::inf);
+    DoNotOptimize(hit_num);
+  }
+  state.SetItemsProcessed(state.iterations() * rays.size());
+}
+
+BENCHMARK(aabb_hit);
+
+template <typename S>
+static void shape_hit(State &state, S const &shape)
+{
+  const auto rays = make_rays(BENCH_RAY_NUM);
+  for (auto _ : state) {
+    int hit_num = 0;
+    HitRecord record;
+    for (auto const &ray : rays)
+      hit_num += shape.hit(ray, 0.001, gm::inf, record);
+    DoNotOptimize(hit_num);
+    DoNotOptimize(record.t);
+  }
+  state.SetItemsProcessed(state.iterations() * rays.size());
+}
+
+static void sphere_hit(State &state)
+{
+  auto material = std::make_shared<Lambertian>(Color(.5, .5, .5));
+  shape_hit(state, Sphere(Point3F(0, 0, 0), 1, material));
+}
+
+static void xy_rect_hit(State &state)
+{
+  auto material = std::make_shared<Lambertian>(Color(.5, .5, .5));
+  shape_hit(state, XyRect(-1, 1, -1, 1, 0, material));
+}
+
+static void xz_rect_hit(State &state)
+{
+  auto material = std::make_shared<Lambertian>(Color(.5, .5, .5));
+  shape_hit(state, XzRect(-1, 1, -1, 1, 0, material));
+}
+
+static void yz_rect_hit(State &state)
+{
+  auto material = std::make_shared<Lambertian>(Color(.5, .5, .5));
+  shape_hit(state, YzRect(-1, 1, -1, 1, 0, material));
+}
+
+BENCHMARK(sphere_hit);
+BENCHMARK(xy_rect_hit);
+BENCHMARK(xz_rect_hit);
+BENCHMARK(yz_rect_hit);
+
+static void bvh_hit(State &state)
+{
+  seed_random(BENCH_SEED);
+  auto material = std::make_shared<Lambertian>(Color(.5, .5, .5));
+  std::vector<ShapeSPtr> spheres;
+  for (int i = 0; i < state.range(0); ++i) {
+    Point3F center(random_double(-2, 2), random_double(-2, 2),
+                   random_double(-2, 2));
+    spheres.push_back(std::make_shared<Sphere>(center, 0.1, material));
+  }
+
+  BvhTree tree(spheres);
+  shape_hit(state, tree);
+}
+
+BENCHMARK(bvh_hit)->Arg(64)->Arg(1024);
+
+// Half of the spheres move in the shutter [0, 1]
+static void motion_bvh_hit(State &state)
+{
+  seed_random(BENCH_SEED);
+  auto material = std::make_shared<Lambertian>(Color(.5, .5, .5));
+  std::vector<ShapeSPtr> spheres;
+  for (int i = 0; i < state.range(0); ++i) {
+    Point3F center(random_double(-2, 2), random_double(-2, 2),
+                   random_double(-2, 2));
+    if (i % 2) {
+      spheres.push_back(std::make_shared<MovingSphere>(
+        center, 0., center + Vec3F(0, 0.2, 0), 1., 0.1, material));
+    } else {
+      spheres.push_back(std::make_shared<Sphere>(center, 0.1, material));
+    }
+  }
+
+  BvhTree tree(spheres, 0, 1);
+  shape_hit(state, tree);
+}
+
+BENCHMARK(motion_bvh_hit)->Arg(64)->Arg(1024);
+
+/*******************************************/
+/* Scene editing                           */
+/*******************************************/
+
+// Move range(0) objects of the random scene and update
+static void scene_edit_refit(State &state)
+{
+  seed_random(BENCH_SEED);
+  Scene scene;
+  setup_random_scene(scene.world, *scene.resources);
+  SceneEditor editor(scene);
+
+  const int n = (int)state.range(0);
+  size_t nodes = 0;
+  double y = 0;
+  for (auto _ : state) {
+    // Bounce up and down, the refit tree doesn't degrade
+    y = y > 0 ? 0 : 0.1;
+    for (int i = 0; i < n; ++i)
+      editor.set_transform(1 + i * 7, {}, Vec3F(0, y, 0));
+    auto stats = editor.update();
+    if (stats.rebuilt) state.SkipWithError("rebuilt");
+    nodes += stats.refit_nodes;
+  }
+  state.counters["nodes/update"] =
+    Counter((double)nodes /
+            (double)std::max<int64_t>(state.iterations(), 1));
+}
+
+BENCHMARK(scene_edit_refit)->Arg(1)->Arg(16)->Unit(kMicrosecond);
+
+// The cost of building the BVH from scratch for comparison
+static void scene_edit_rebuild(State &state)
+{
+  seed_random(BENCH_SEED);
+  Scene scene;
+  setup_random_scene(scene.world, *scene.resources);
+  for (auto _ : state) {
+    build_bvh(scene);
+    DoNotOptimize(scene.bvh.get());
+  }
+}
+
+BENCHMARK(scene_edit_rebuild)->Unit(kMicrosecond);
+
+/*******************************************/
+/* Scene arena                             */
+/*******************************************/
+
+// Set up and destroy the random scene, range(0) is 1 if the arena is used
+static void scene_arena_setup(State &state)
+{
+  const bool use_arena = state.range(0) != 0;
+  state.SetLabel(use_arena ? "arena" : "make_shared");
+  for (auto _ : state) {
+    seed_random(BENCH_SEED);
+    Scene scene;
+    scene.resources = std::make_shared<ResourceRegistry>(use_arena);
+    setup_random_scene(scene.world, *scene.resources);
+    DoNotOptimize(scene.world.shape().data());
+  }
+}
+
+BENCHMARK(scene_arena_setup)->Arg(0)->Arg(1)->Unit(kMicrosecond);
+
+// The random rays through the BVH of the random scene
+static void scene_arena_hit(State &state)
+{
+  const bool use_arena = state.range(0) != 0;
+  state.SetLabel(use_arena ? "arena" : "make_shared");
+  seed_random(BENCH_SEED);
+  Scene scene;
+  scene.resources = std::make_shared<ResourceRegistry>(use_arena);
+  setup_random_scene(scene.world, *scene.resources);
+  build_bvh(scene);
+
+  std::vector<Ray> rays;
+  for (int i = 0; i < 1024; ++i) {
+    Point3F origin(random_double(-12, 12), random_double(0.1, 2), 15);
+    Point3F target(random_double(-12, 12), random_double(0, 0.5), -15);
+    rays.emplace_back(origin, target - origin);
+  }
+  for (auto _ : state) {
+    HitInfo info;
+    for (auto const &ray : rays) {
+      DoNotOptimize(scene.bvh->intersect(ray, 0.001, inf, info));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * rays.size());
+}
+
+BENCHMARK(scene_arena_hit)->Arg(0)->Arg(1);
+
+static void cosine_pdf_generate(State &state)
+{
+  seed_random(BENCH_SEED);
+  CosinePdf pdf(Vec3F(0, 1, 0));
+  for (auto _ : state) {
+    DoNotOptimize(pdf.generate());
+  }
+}
+
+BENCHMARK(cosine_pdf_generate);
+
+static void onb_local(State &state)
+{
+  Vec3F normal(0.3, 0.9, 0.1);
+  Vec3F dir(0.2, 0.4, 0.8);
+  for (auto _ : state) {
+    DoNotOptimize(normal);
+    Onb onb(normal);
+    DoNotOptimize(onb.local(dir));
+  }
+}
+
+BENCHMARK(onb_local);
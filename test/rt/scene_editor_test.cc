@@ -0,0 +1,129 @@
+#include "rt/scene_editor.hh"
+#include "material/diffuse_light.hh"
+#include "material/lambertian.hh"
+#include "rt/hit_record.hh"
+#include "shape/sphere.hh"
+#include "util/random.hh"
+
+#include <gtest/gtest.h>
+
+using namespace rt;
+using namespace gm;
+using namespace util;
+
+// The closest hit of the BVH is the one of linear traversal
+static void check_bvh(Scene const &scene)
+{
+  ASSERT_TRUE(scene.bvh);
+  seed_random(2);
+  for (int i = 0; i < 1000; ++i) {
+    Point3F origin(random_double(-12, 12), random_double(-2, 4), 15);
+    Point3F target(random_double(-12, 12), random_double(-2, 4), -15);
+    Ray ray(origin, target - origin);
+
+    HitInfo expected, actual;
+    const bool expected_hit = scene.world.intersect(ray, 0.001, inf, expected);
+    ASSERT_EQ(scene.bvh->intersect(ray, 0.001, inf, actual), expected_hit);
+    if (!expected_hit) continue;
+    EXPECT_EQ(actual.t, expected.t) << i;
+    EXPECT_EQ(actual.shape, expected.shape) << i;
+  }
+}
+
+class SceneEditorTest : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    seed_random(1);
+    setup_random_scene(scene_.world, *scene_.resources);
+  }
+
+  Scene scene_;
+};
+
+TEST_F (SceneEditorTest, refit) {
+  SceneEditor editor(scene_);
+  ASSERT_EQ(editor.size(), scene_.world.shape().size());
+  check_bvh(scene_);
+
+  // Small moves are refit
+  for (ObjectHandle h = 1; h < 200; h += 10)
+    editor.set_transform(h, Degree{.y = 30}, Vec3F(0, 0.5, 0));
+  auto stats = editor.update();
+  EXPECT_FALSE(stats.rebuilt);
+  EXPECT_GT(stats.refit_nodes, 0u);
+  EXPECT_LT(stats.sah_ratio, 1.5);
+  EXPECT_EQ(editor.object(11).translation().y, 0.5);
+  check_bvh(scene_);
+
+  // Nothing to do
+  stats = editor.update();
+  EXPECT_EQ(stats.refit_nodes, 0u);
+  EXPECT_FALSE(stats.rebuilt);
+}
+
+TEST (scene_editor_test, rebuild) {
+  // The small spheres only(the ground of the random scene dominates the
+  // SAH cost)
+  seed_random(1);
+  Scene scene;
+  auto material = std::make_shared<Lambertian>(Color(.5, .5, .5));
+  for (int i = 0; i < 500; ++i) {
+    Point3F center(random_double(-5, 5), random_double(0, 3),
+                   random_double(-5, 5));
+    scene.world.add(std::make_shared<Sphere>(center, 0.2, material));
+  }
+  SceneEditor editor(scene);
+
+  // Scatter many objects far away, the refit tree degrades
+  for (ObjectHandle h = 1; h < (int)editor.size(); h += 2)
+    editor.set_transform(h, {}, Vec3F(random_double(-5, 5), 0, 0));
+  auto stats = editor.update();
+  EXPECT_TRUE(stats.rebuilt);
+  EXPECT_DOUBLE_EQ(scene.bvh->sah_cost(), scene.bvh->build_cost());
+  check_bvh(scene);
+
+  auto handle = editor.add(std::make_shared<Sphere>(
+    Point3F(0, 3, 0), 0.5, std::make_shared<Lambertian>(Color(1, 1, 1))));
+  stats = editor.update();
+  EXPECT_TRUE(stats.rebuilt);
+  EXPECT_EQ(scene.bvh->size(), editor.size());
+
+  HitRecord record;
+  ASSERT_TRUE(scene.bvh->hit(Ray(Point3F(0, 10, 0), Vec3F(0, -1, 0)), 0.001,
+                              inf, record));
+  EXPECT_NEAR(record.p.y, 3.5, 1e-9);
+  EXPECT_EQ(record.material, editor.object(handle).material());
+}
+
+TEST_F (SceneEditorTest, material) {
+  SceneEditor editor(scene_);
+  const auto nodes = scene_.bvh->nodes();
+  ASSERT_FALSE(scene_.lights);
+
+  // The big metal sphere at (4, 1, 0) is the last one
+  const ObjectHandle handle = (ObjectHandle)editor.size() - 1;
+  auto light = std::make_shared<DiffuseLight>(Color(4, 4, 4));
+  editor.set_material(handle, light);
+  auto stats = editor.update();
+  EXPECT_FALSE(stats.rebuilt);
+  EXPECT_EQ(stats.refit_nodes, 0u);
+  EXPECT_TRUE(stats.lights_collected);
+  ASSERT_TRUE(scene_.lights);
+
+  HitRecord record;
+  ASSERT_TRUE(scene_.bvh->hit(Ray(Point3F(4, 5, 0), Vec3F(0, -1, 0)), 0.001,
+                              inf, record));
+  EXPECT_EQ(record.material, light.get());
+  // The BVH is not touched
+  ASSERT_EQ(scene_.bvh->nodes().size(), nodes.size());
+
+  // Restore the material
+  editor.set_material(handle, nullptr);
+  stats = editor.update();
+  EXPECT_TRUE(stats.lights_collected);
+  EXPECT_FALSE(scene_.lights);
+  ASSERT_TRUE(scene_.bvh->hit(Ray(Point3F(4, 5, 0), Vec3F(0, -1, 0)), 0.001,
+                              inf, record));
+  EXPECT_NE(record.material, light.get());
+}
@@ -0,0 +1,69 @@
+#include "sample/light_sampler.hh"
+#include "material/diffuse_light.hh"
+#include "shape/flip_face.hh"
+#include "shape/rect.hh"
+#include "shape/shape_list.hh"
+#include "util/random.hh"
+
+#include <benchmark/benchmark.h>
+
+using namespace benchmark;
+using namespace rt;
+using namespace gm;
+using namespace util;
+
+// A grid of small lights with random power on the ceiling(y = 10)
+static std::vector<ShapeSPtr> make_lights(int n)
+{
+  seed_random(1);
+  std::vector<ShapeSPtr> lights;
+  const int row = (int)std::sqrt(n);
+  for (int i = 0; i < n; ++i) {
+    const double x = (i % row) * 4.;
+    const double z = (i / row) * 4.;
+    auto material = std::make_shared<DiffuseLight>(
+        Color(1, 1, 1) * random_double(0.1, 10));
+    lights.push_back(std::make_shared<FlipFace>(
+        std::make_shared<XzRect>(x, x + 1, z, z + 1, 10, material)));
+  }
+  return lights;
+}
+
+// One light sample and the pdf of a BSDF sample(as the integrator)
+template <typename L>
+static void sample_light(State &state, L const &lights)
+{
+  seed_random(2);
+  const double extent = std::sqrt(state.range(0)) * 4.;
+  for (auto _ : state) {
+    Point3F p(random_double(0, extent), 0, random_double(0, extent));
+    auto dir = lights.random_direction(p);
+    DoNotOptimize(lights.pdf_value(p, dir));
+    DoNotOptimize(lights.pdf_value(p, Vec3F(0, 1, 0)));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void shape_list_sample(State &state)
+{
+  ShapeList lights;
+  for (auto const &light : make_lights((int)state.range(0))) lights.add(light);
+  sample_light(state, lights);
+}
+
+static void power_sample(State &state)
+{
+  LightSampler lights(make_lights((int)state.range(0)), LightSampler::POWER);
+  sample_light(state, lights);
+}
+
+static void light_bvh_sample(State &state)
+{
+  LightSampler lights(make_lights((int)state.range(0)),
+                      LightSampler::LIGHT_BVH);
+  sample_light(state, lights);
+}
+
+BENCHMARK(shape_list_sample)->Arg(16)->Arg(256)->Arg(1024);
+BENCHMARK(power_sample)->Arg(16)->Arg(256)->Arg(1024);
+BENCHMARK(light_bvh_sample)->Arg(16)->Arg(256)->Arg(1024);
@@ -0,0 +1,143 @@
+#include "sample/alias_table.hh"
+#include "sample/light_sampler.hh"
+#include "material/diffuse_light.hh"
+#include "material/lambertian.hh"
+#include "shape/flip_face.hh"
+#include "shape/rect.hh"
+#include "shape/sphere.hh"
+#include "util/random.hh"
+
+#include <gtest/gtest.h>
+
+using namespace rt;
+using namespace gm;
+
+TEST (light_sampler_test, alias_table) {
+  std::vector<double> weights{1, 2, 3, 0, 4};
+  AliasTable table(weights);
+  ASSERT_EQ(table.size(), weights.size());
+  for (size_t i = 0; i < weights.size(); ++i)
+    EXPECT_DOUBLE_EQ(table.pmf(i), weights[i] / 10);
+
+  // The frequencies of evenly spaced u are the probabilities
+  const int n = 100000;
+  std::vector<int> count(weights.size());
+  for (int i = 0; i < n; ++i)
+    count[table.sample((i + 0.5) / n)]++;
+  for (size_t i = 0; i < weights.size(); ++i)
+    EXPECT_NEAR(count[i], table.pmf(i) * n, 2) << i;
+  EXPECT_EQ(count[3], 0);
+
+  AliasTable uniform(std::vector<double>(4, 0.));
+  EXPECT_DOUBLE_EQ(uniform.pmf(2), 0.25);
+}
+
+// Some lights on the ceiling(y = 10) facing down
+static std::vector<ShapeSPtr> make_shapes()
+{
+  auto light = std::make_shared<DiffuseLight>(Color(4, 4, 4));
+  auto dim_light = std::make_shared<DiffuseLight>(Color(1, 1, 1));
+  auto white = std::make_shared<Lambertian>(Color(.5, .5, .5));
+
+  std::vector<ShapeSPtr> shapes;
+  shapes.push_back(std::make_shared<FlipFace>(
+      std::make_shared<XzRect>(-1, 1, -1, 1, 10, light)));
+  shapes.push_back(std::make_shared<FlipFace>(
+      std::make_shared<XzRect>(20, 22, -1, 1, 10, dim_light)));
+  // Facing up, it can't light the floor
+  shapes.push_back(std::make_shared<XzRect>(-11, -9, -1, 1, 10, light));
+  shapes.push_back(std::make_shared<Sphere>(Point3F(0, 5, 0), 1, white));
+  return shapes;
+}
+
+TEST (light_sampler_test, registry) {
+  LightSampler sampler(make_shapes());
+  // The lambertian sphere is not an emitter
+  ASSERT_EQ(sampler.size(), 3u);
+  EXPECT_NEAR(sampler.power(0) / sampler.power(1), 4, 1e-9);
+  EXPECT_NEAR(sampler.power(0), sampler.power(2), 1e-9);
+
+  // O(1) power sampling
+  const Point3F p(0, 0, 0);
+  EXPECT_NEAR(sampler.pmf(p, 0), 4. / 9, 1e-9);
+  EXPECT_NEAR(sampler.pmf(p, 1), 1. / 9, 1e-9);
+
+  // Only the light above p is intersected
+  Vec3F dir(0.1, 10, 0.2);
+  EXPECT_NEAR(sampler.pdf_value(p, dir),
+              sampler.pmf(p, 0) * sampler.emitter(0)->pdf_value(p, dir), 1e-12);
+  EXPECT_EQ(sampler.pdf_value(p, Vec3F(0, -1, 0)), 0);
+  EXPECT_EQ(sampler.pdf_value(p, Vec3F(0, 0, 0)), 0);
+}
+
+TEST (light_sampler_test, light_bvh) {
+  LightSampler sampler(make_shapes(), LightSampler::LIGHT_BVH);
+  ASSERT_EQ(sampler.size(), 3u);
+
+  const Point3F p(0, 0, 0);
+  double sum = 0;
+  for (int i = 0; i < 3; ++i) sum += sampler.pmf(p, i);
+  EXPECT_NEAR(sum, 1, 1e-9);
+
+  int near_light = -1;
+  int far_light = -1;
+  int back_light = -1;
+  for (int i = 0; i < 3; ++i) {
+    auto center = sampler.emitter(i)->get_bounding_box().min().x;
+    if (center == -1) near_light = i;
+    else if (center == 20) far_light = i;
+    else back_light = i;
+  }
+  // Distance and orientation are taken into account
+  EXPECT_GT(sampler.pmf(p, near_light), sampler.pmf(p, far_light));
+  EXPECT_EQ(sampler.pmf(p, back_light), 0);
+
+  // The sampling is consistent with pmf()
+  const int n = 100000;
+  std::vector<int> count(3);
+  for (int i = 0; i < n; ++i) {
+    auto index = sampler.sample(p, (i + 0.5) / n);
+    ASSERT_GE(index, 0);
+    count[index]++;
+  }
+  for (int i = 0; i < 3; ++i)
+    EXPECT_NEAR(count[i], sampler.pmf(p, i) * n, 2) << i;
+
+  // The generated directions have positive pdf
+  util::seed_random(1);
+  for (int i = 0; i < 100; ++i) {
+    auto dir = sampler.random_direction(p);
+    EXPECT_GT(sampler.pdf_value(p, dir), 0);
+  }
+}
+
+TEST (light_sampler_test, weighted) {
+  // Not emitters, e.g. the transmissive shapes sampled for the caustics
+  auto white = std::make_shared<Lambertian>(Color(.5, .5, .5));
+  std::vector<ShapeSPtr> shapes;
+  shapes.push_back(std::make_shared<Sphere>(Point3F(0, 5, 0), 1, white));
+  shapes.push_back(std::make_shared<Sphere>(Point3F(0, 50, 0), 1, white));
+  shapes.push_back(std::make_shared<Sphere>(Point3F(0, -5, 0), 2, white));
+  // Facing up, but it is seen from both sides
+  shapes.push_back(std::make_shared<XzRect>(-1, 1, -1, 1, 10, white));
+  const std::vector<double> weights{1, 1, 0, 1};
+
+  LightSampler sampler(shapes, weights, LightSampler::LIGHT_BVH);
+  // The shape of weight 0 is skipped
+  ASSERT_EQ(sampler.size(), 3u);
+  EXPECT_EQ(sampler.power(0), 1);
+
+  // The near one is preferred and the back of the rectangle is sampled
+  const Point3F p(0, 0, 0);
+  EXPECT_GT(sampler.pmf(p, 0), sampler.pmf(p, 1));
+  EXPECT_GT(sampler.pmf(p, 2), 0);
+  double sum = 0;
+  for (int i = 0; i < 3; ++i) sum += sampler.pmf(p, i);
+  EXPECT_NEAR(sum, 1, 1e-9);
+
+  util::seed_random(1);
+  for (int i = 0; i < 100; ++i) {
+    auto dir = sampler.random_direction(p);
+    EXPECT_GT(sampler.pdf_value(p, dir), 0);
+  }
+}
@@ -0,0 +1,121 @@
+#include "sample/blue_noise.hh"
+#include "sample/sampler.hh"
+#include "gm/util.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace rt;
+using namespace gm;
+
+#define SEED 0x5eed
+
+TEST (sampler_test, sobol_net) {
+  // The first 2^k points of a dimension pair are a (0, k, 2)-net:
+  // every elementary interval of area 2^-k contains exactly one point
+  SobolSampler sampler(SEED);
+  const int log_n = 6;
+  const int n = 1 << log_n;
+  for (int dimension : {0, 2, 7}) {
+    std::vector<double> us(n), vs(n);
+    for (int i = 0; i < n; ++i) {
+      sampler.start_pixel_sample(3, 5, i);
+      sampler.set_dimension(dimension);
+      sampler.get_2d(us[i], vs[i]);
+    }
+    for (int a = 0; a <= log_n; ++a) {
+      const int nx = 1 << a;
+      const int ny = n / nx;
+      std::vector<int> count(n);
+      for (int i = 0; i < n; ++i)
+        count[int(us[i] * nx) * ny + int(vs[i] * ny)]++;
+      EXPECT_EQ(*std::max_element(count.begin(), count.end()), 1)
+        << "dimension " << dimension << " interval " << nx << "x" << ny;
+    }
+  }
+}
+
+TEST (sampler_test, stratified) {
+  const int spp = 37;
+  StratifiedSampler sampler(spp, SEED);
+  std::vector<int> count(spp);
+  for (int i = 0; i < spp; ++i) {
+    sampler.start_pixel_sample(1, 2, i);
+    sampler.set_dimension(4);
+    count[int(sampler.get_1d() * spp)]++;
+  }
+  EXPECT_EQ(*std::max_element(count.begin(), count.end()), 1);
+
+  // 6x7 cells, the samples take different cells
+  std::vector<int> cells(42);
+  for (int i = 0; i < spp; ++i) {
+    sampler.start_pixel_sample(1, 2, i);
+    double u, v;
+    sampler.get_2d(u, v);
+    cells[int(u * 6) + 6 * int(v * 7)]++;
+  }
+  EXPECT_EQ(*std::max_element(cells.begin(), cells.end()), 1);
+}
+
+/**
+ * The RMSE of the estimates of a smooth 4D integral over many pixels
+ * (the dimension pairs are decorrelated by random padding, so only the
+ * variance of the functions of each pair is reduced)
+ */
+static double integration_error(Sampler &sampler, int spp)
+{
+  // Integrate to 1
+  auto f = [](double x, double y, double z, double w) {
+    return (2 * x) * (3 * y * y) / 2 + (pi / 2 * sin(pi * z)) * (2 * w) / 2;
+  };
+
+  const int pixel_num = 256;
+  double error = 0;
+  for (int p = 0; p < pixel_num; ++p) {
+    double sum = 0;
+    for (int i = 0; i < spp; ++i) {
+      sampler.start_pixel_sample(p % 16, p / 16, i);
+      double x, y, z, w;
+      sampler.get_2d(x, y);
+      sampler.get_2d(z, w);
+      sum += f(x, y, z, w);
+    }
+    const double d = sum / spp - 1;
+    error += d * d;
+  }
+  return sqrt(error / pixel_num);
+}
+
+TEST (sampler_test, convergence) {
+  const int spp = 64;
+  auto independent = make_sampler(SAMPLER_INDEPENDENT, spp, SEED);
+  const double error = integration_error(*independent, spp);
+
+  // The estimates are unbiased and converge faster than the independent ones
+  for (auto type : {SAMPLER_STRATIFIED, SAMPLER_SOBOL, SAMPLER_BLUE_NOISE}) {
+    auto sampler = make_sampler(type, spp, SEED);
+    EXPECT_LT(integration_error(*sampler, spp), error / 2) << type;
+  }
+}
+
+TEST (sampler_test, blue_noise_mask) {
+  const int n = BLUE_NOISE_MASK_SIZE * BLUE_NOISE_MASK_SIZE;
+  std::vector<int> count(n);
+  for (int y = 0; y < BLUE_NOISE_MASK_SIZE; ++y)
+    for (int x = 0; x < BLUE_NOISE_MASK_SIZE; ++x)
+      count[int(blue_noise(x, y) * n)]++;
+  EXPECT_EQ(*std::min_element(count.begin(), count.end()), 1);
+  EXPECT_EQ(*std::max_element(count.begin(), count.end()), 1);
+
+  // Tileable
+  EXPECT_EQ(blue_noise(-1, 3), blue_noise(BLUE_NOISE_MASK_SIZE - 1, 3));
+
+  // No low frequency: the neighbours differ more than white noise(1/3)
+  double diff = 0;
+  for (int y = 0; y < BLUE_NOISE_MASK_SIZE; ++y)
+    for (int x = 0; x < BLUE_NOISE_MASK_SIZE; ++x)
+      diff += fabs(blue_noise(x, y) - blue_noise(x + 1, y));
+  EXPECT_GT(diff / n, 0.4);
+}
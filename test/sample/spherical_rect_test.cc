@@ -0,0 +1,129 @@
+#include "sample/sample.hh"
+#include "sample/spherical_rect.hh"
+#include "accelerate/aabb.hh"
+#include "gm/onb.hh"
+#include "material/lambertian.hh"
+#include "shape/box.hh"
+#include "shape/rect.hh"
+#include "shape/rotate.hh"
+#include "shape/sphere.hh"
+#include "shape/translate.hh"
+#include "util/random.hh"
+
+#include <gtest/gtest.h>
+
+using namespace rt;
+using namespace gm;
+
+#define SAMPLE_NUM 200000
+
+/**
+ * Two necessary conditions of a correct pdf_value()/random_direction() pair:
+ * 1. The pdf integrates to 1: E_cone[solid angle of cone * pdf] = 1, the
+ *    directions are uniform in the cone bounding the shape
+ * 2. E_pdf[1 / pdf] is the solid angle of the support
+ * \return The estimated solid angle of the support
+ */
+static double check_sampling(Shape const &shape, Point3F const &origin)
+{
+  Aabb box;
+  EXPECT_TRUE(shape.get_bounding_box(box));
+  const auto center = box.min() + (box.max() - box.min()) / 2.;
+  const auto radius = (box.max() - box.min()).length() / 2;
+  const auto to_center = center - origin;
+  const auto distance_squared = to_center.length_squared();
+  const bool inside = distance_squared <= radius * radius;
+  const auto cone = inside ? 4 * pi
+                           : 2 * pi * (1 - sqrt(1 - radius * radius /
+                                                        distance_squared));
+
+  util::seed_random(1);
+  double integral = 0;
+  for (int i = 0; i < SAMPLE_NUM; ++i) {
+    auto dir = inside ? uniform_sphere_sample()
+                      : Onb(to_center).local(
+                            sphere_direction_sample(radius, distance_squared));
+    integral += cone * shape.pdf_value(origin, dir);
+  }
+  EXPECT_NEAR(integral / SAMPLE_NUM, 1, 0.01);
+
+  double support = 0;
+  for (int i = 0; i < SAMPLE_NUM; ++i) {
+    auto dir = shape.random_direction(origin);
+    auto pdf = shape.pdf_value(origin, dir);
+    EXPECT_GT(pdf, 0);
+    if (pdf > 0) support += 1 / pdf;
+  }
+  return support / SAMPLE_NUM;
+}
+
+TEST (spherical_rect_test, solid_angle) {
+  // A face of the cube seen from the center
+  SphericalRect face(Point3F(0, 0, 0), Point3F(-1, -1, 1), Vec3F(2, 0, 0),
+                     Vec3F(0, 2, 0));
+  EXPECT_NEAR(face.solid_angle(), 4 * pi / 6, 1e-6);
+  EXPECT_NEAR(face.pdf(Point3F(0, 0, 1)), 6 / (4 * pi), 1e-6);
+
+  // The samples are on the rectangle
+  util::seed_random(1);
+  for (int i = 0; i < 1000; ++i) {
+    auto p = face.sample(util::random_double(), util::random_double());
+    EXPECT_NEAR(p.z, 1, 1e-9);
+    EXPECT_LE(fabs(p.x), 1 + 1e-9);
+    EXPECT_LE(fabs(p.y), 1 + 1e-9);
+  }
+
+  // Seen edge-on
+  SphericalRect edge(Point3F(0, 0, 1), Point3F(-1, -1, 1), Vec3F(2, 0, 0),
+                     Vec3F(0, 2, 0));
+  EXPECT_EQ(edge.solid_angle(), 0);
+}
+
+TEST (spherical_rect_test, rects) {
+  auto white = std::make_shared<Lambertian>(Color(.5, .5, .5));
+  XyRect xy(-1, 1, -1, 1, 1, white);
+  YzRect yz(-1, 1, -1, 1, 1, white);
+  XzRect xz(-1, 1, -1, 1, 1, white);
+  const Point3F center(0, 0, 0);
+  EXPECT_NEAR(check_sampling(xy, center), 4 * pi / 6, 0.01);
+  EXPECT_NEAR(check_sampling(yz, center), 4 * pi / 6, 0.01);
+  EXPECT_NEAR(check_sampling(xz, center), 4 * pi / 6, 0.01);
+
+  // Grazing angle and far away(area sampling)
+  check_sampling(xz, Point3F(5, 1.01, 0));
+  check_sampling(xz, Point3F(300, 300, 0));
+}
+
+TEST (spherical_rect_test, box) {
+  auto white = std::make_shared<Lambertian>(Color(.5, .5, .5));
+  Box box(Point3F(-1, -1, -1), Point3F(1, 1, 1), white);
+  EXPECT_DOUBLE_EQ(box.area(), 24);
+
+  EXPECT_NEAR(check_sampling(box, Point3F(0, 0, 0)), 4 * pi, 0.05);
+  // Three faces are visible
+  SphericalRect front(Point3F(3, 4, 5), Point3F(-1, -1, 1), Vec3F(2, 0, 0),
+                      Vec3F(0, 2, 0));
+  SphericalRect right(Point3F(3, 4, 5), Point3F(1, -1, -1), Vec3F(0, 2, 0),
+                      Vec3F(0, 0, 2));
+  SphericalRect top(Point3F(3, 4, 5), Point3F(-1, 1, -1), Vec3F(2, 0, 0),
+                    Vec3F(0, 0, 2));
+  const auto silhouette =
+    front.solid_angle() + right.solid_angle() + top.solid_angle();
+  EXPECT_NEAR(check_sampling(box, Point3F(3, 4, 5)), silhouette,
+              silhouette * 0.01);
+}
+
+TEST (spherical_rect_test, instances) {
+  auto white = std::make_shared<Lambertian>(Color(.5, .5, .5));
+  auto box = std::make_shared<Box>(Point3F(0, 0, 0), Point3F(165, 330, 165),
+                                   white);
+  auto rotated = std::make_shared<Rotate>(box, Degree{0, 15, 0});
+  Translate translated(rotated, Vec3F(265, 0, 295));
+  check_sampling(translated, Point3F(278, 554, -100));
+
+  // The origin inside a sphere(used to be NaN)
+  Sphere sphere(Point3F(0, 0, 0), 1, white);
+  EXPECT_NEAR(check_sampling(sphere, Point3F(0.5, 0, 0)), 4 * pi, 1e-6);
+  EXPECT_NEAR(check_sampling(sphere, Point3F(0, 3, 0)),
+              2 * pi * (1 - sqrt(1 - 1. / 9)), 1e-6);
+}
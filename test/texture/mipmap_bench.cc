@@ -0,0 +1,110 @@
+#include "texture/mipmap.hh"
+#include "util/random.hh"
+
+#include <benchmark/benchmark.h>
+#include <vector>
+
+using namespace benchmark;
+using namespace rt;
+using namespace util;
+
+#define BENCH_TEXTURE_SIZE 4096
+#define BENCH_LOOKUP_NUM 4096
+
+static std::vector<unsigned char> const &texture_data()
+{
+  static const auto data = [] {
+    std::vector<unsigned char> ret((size_t)BENCH_TEXTURE_SIZE *
+                                   BENCH_TEXTURE_SIZE * 3);
+    uint32_t seed = 1;
+    for (auto &c : ret) {
+      seed = seed * 1664525u + 1013904223u;
+      c = (unsigned char)(seed >> 24);
+    }
+    return ret;
+  }();
+  return data;
+}
+
+static MipMap const &texture_mipmap()
+{
+  static const MipMap mipmap(texture_data().data(), BENCH_TEXTURE_SIZE,
+                             BENCH_TEXTURE_SIZE, 3, true);
+  return mipmap;
+}
+
+// The lookups of neighbour pixels on a surface slanted in the texture
+// (the footprints move along the diagonal)
+static std::vector<std::pair<double, double>> make_uvs()
+{
+  seed_random(1);
+  std::vector<std::pair<double, double>> uvs;
+  double u = random_double(), v = random_double();
+  for (int i = 0; i < BENCH_LOOKUP_NUM; ++i) {
+    u += 0.003;
+    v += 0.001;
+    if (u > 1) u -= 1;
+    if (v > 1) v -= 1;
+    uvs.emplace_back(u, v);
+  }
+  return uvs;
+}
+
+// The former implementation: point sampling of row-major bytes
+static void row_major_nearest(State &state)
+{
+  auto const &data = texture_data();
+  auto uvs = make_uvs();
+  const int w = BENCH_TEXTURE_SIZE, h = BENCH_TEXTURE_SIZE;
+  for (auto _ : state) {
+    for (auto const &uv : uvs) {
+      int x = std::min((int)(uv.first * w), w - 1);
+      int y = std::min((int)((1 - uv.second) * h), h - 1);
+      auto index = ((size_t)y * w + x) * 3;
+      const auto scale = 1. / 255.;
+      Color c(data[index] * scale, data[index + 1] * scale,
+              data[index + 2] * scale);
+      DoNotOptimize(c);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * uvs.size());
+}
+
+static void mipmap_nearest(State &state)
+{
+  auto const &mipmap = texture_mipmap();
+  auto uvs = make_uvs();
+  for (auto _ : state) {
+    for (auto const &uv : uvs) DoNotOptimize(mipmap.nearest(uv.first, uv.second));
+  }
+  state.SetItemsProcessed(state.iterations() * uvs.size());
+}
+
+static void mipmap_bilinear(State &state)
+{
+  auto const &mipmap = texture_mipmap();
+  auto uvs = make_uvs();
+  for (auto _ : state) {
+    for (auto const &uv : uvs)
+      DoNotOptimize(mipmap.bilinear(0, uv.first, uv.second));
+  }
+  state.SetItemsProcessed(state.iterations() * uvs.size());
+}
+
+// The footprint is range(0) texels
+static void mipmap_trilinear(State &state)
+{
+  auto const &mipmap = texture_mipmap();
+  auto uvs = make_uvs();
+  const double width = (double)state.range(0) / BENCH_TEXTURE_SIZE;
+  for (auto _ : state) {
+    for (auto const &uv : uvs)
+      DoNotOptimize(mipmap.trilinear(uv.first, uv.second, width));
+  }
+  state.SetItemsProcessed(state.iterations() * uvs.size());
+}
+
+BENCHMARK(row_major_nearest);
+BENCHMARK(mipmap_nearest);
+BENCHMARK(mipmap_bilinear);
+BENCHMARK(mipmap_trilinear)->Arg(3)->Arg(12);
@@ -0,0 +1,105 @@
+#include "texture/mipmap.hh"
+
+#include <cmath>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace rt;
+
+// RGB gradient, the first row is the top one
+static std::vector<unsigned char> make_image(int width, int height)
+{
+  std::vector<unsigned char> data((size_t)width * height * 3);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      auto pixel = &data[((size_t)y * width + x) * 3];
+      pixel[0] = (unsigned char)(x * 255 / (width - 1));
+      pixel[1] = (unsigned char)(y * 255 / (height - 1));
+      pixel[2] = (unsigned char)((x + y) % 256);
+    }
+  }
+  return data;
+}
+
+TEST (mipmap_test, decode_lut) {
+  EXPECT_FLOAT_EQ(MipMap::unorm_to_float(0), 0);
+  EXPECT_FLOAT_EQ(MipMap::unorm_to_float(255), 1);
+  EXPECT_FLOAT_EQ(MipMap::srgb_to_linear(0), 0);
+  EXPECT_FLOAT_EQ(MipMap::srgb_to_linear(255), 1);
+  // The mid gray of sRGB is darker in linear space
+  EXPECT_NEAR(MipMap::srgb_to_linear(188), 0.5, 0.01);
+  for (int i = 1; i < 256; ++i)
+    EXPECT_GT(MipMap::srgb_to_linear((uint8_t)i),
+              MipMap::srgb_to_linear((uint8_t)(i - 1)));
+}
+
+TEST (mipmap_test, pyramid) {
+  const int w = 37, h = 20;
+  auto data = make_image(w, h);
+  MipMap mipmap(data.data(), w, h, 3, false);
+
+  // 37x20 -> 18x10 -> 9x5 -> 4x2 -> 2x1 -> 1x1
+  ASSERT_EQ(mipmap.levels(), 6);
+  EXPECT_EQ(mipmap.width(1), 18);
+  EXPECT_EQ(mipmap.height(1), 10);
+  EXPECT_EQ(mipmap.width(5), 1);
+  EXPECT_EQ(mipmap.height(5), 1);
+
+  // The tiled layout keeps the texels
+  for (int y = 0; y < h; ++y) {
+    for (int x = 0; x < w; ++x) {
+      auto pixel = &data[((size_t)y * w + x) * 3];
+      auto const &t = mipmap.texel(0, x, y);
+      ASSERT_FLOAT_EQ(t.r, pixel[0] / 255.f);
+      ASSERT_FLOAT_EQ(t.g, pixel[1] / 255.f);
+      ASSERT_FLOAT_EQ(t.b, pixel[2] / 255.f);
+    }
+  }
+
+  // Box filter
+  auto const &a = mipmap.texel(0, 2, 4);
+  auto const &b = mipmap.texel(0, 3, 4);
+  auto const &c = mipmap.texel(0, 2, 5);
+  auto const &d = mipmap.texel(0, 3, 5);
+  EXPECT_FLOAT_EQ(mipmap.texel(1, 1, 2).r, (a.r + b.r + c.r + d.r) / 4);
+}
+
+TEST (mipmap_test, filtering) {
+  const int w = 64, h = 32;
+  auto data = make_image(w, h);
+  MipMap mipmap(data.data(), w, h, 3, false);
+
+  // The center of texel(x, y), v = 0 is the bottom
+  auto center = [&](int x, int y, double &u, double &v) {
+    u = (x + 0.5) / w;
+    v = 1 - (y + 0.5) / h;
+  };
+
+  double u, v;
+  center(10, 7, u, v);
+  auto const &t = mipmap.texel(0, 10, 7);
+  auto nearest = mipmap.nearest(u, v);
+  auto bilinear = mipmap.bilinear(0, u, v);
+  EXPECT_NEAR(nearest.x, t.r, 1e-6);
+  EXPECT_NEAR(bilinear.x, t.r, 1e-6);
+  EXPECT_NEAR(bilinear.y, t.g, 1e-6);
+
+  // Halfway between two texels
+  const double u_mid = (10 + 1.) / w;
+  auto const &t1 = mipmap.texel(0, 11, 7);
+  EXPECT_NEAR(mipmap.bilinear(0, u_mid, v).x, (t.r + t1.r) / 2, 1e-6);
+
+  // The footprint of one texel is the finest level, the whole texture is
+  // the average
+  EXPECT_NEAR(mipmap.trilinear(u, v, 1. / w).x, bilinear.x, 1e-6);
+  EXPECT_NEAR(mipmap.trilinear(u, v, 0).x, bilinear.x, 1e-6);
+  auto const &top = mipmap.texel(mipmap.levels() - 1, 0, 0);
+  EXPECT_NEAR(mipmap.trilinear(u, v, 1).x, top.r, 1e-6);
+  EXPECT_NEAR(top.r, 0.5, 0.01);
+
+  // Between level 1 and 2
+  const double width = std::pow(2., 1.5) / w;
+  auto l1 = mipmap.bilinear(1, u, v);
+  auto l2 = mipmap.bilinear(2, u, v);
+  EXPECT_NEAR(mipmap.trilinear(u, v, width).y, (l1.y + l2.y) / 2, 1e-6);
+}
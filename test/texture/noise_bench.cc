@@ -0,0 +1,124 @@
+#include "texture/noise_texture.hh"
+#include "texture/perlin.hh"
+#include "util/random.hh"
+
+#include <benchmark/benchmark.h>
+#include <vector>
+
+using namespace benchmark;
+using namespace rt;
+using namespace util;
+
+#define BENCH_POINT_NUM 4096
+
+struct Points {
+  std::vector<float> x, y, z;
+  std::vector<Point3F> p;
+
+  Points()
+    : x(BENCH_POINT_NUM)
+    , y(BENCH_POINT_NUM)
+    , z(BENCH_POINT_NUM)
+    , p(BENCH_POINT_NUM)
+  {
+    seed_random(1);
+    for (int i = 0; i < BENCH_POINT_NUM; ++i) {
+      x[i] = (float)random_double(-100, 100);
+      y[i] = (float)random_double(-100, 100);
+      z[i] = (float)random_double(-100, 100);
+      p[i] = Point3F(x[i], y[i], z[i]);
+    }
+  }
+};
+
+static Points const &points()
+{
+  static Points s_points;
+  return s_points;
+}
+
+static void perlin_scalar(State &state)
+{
+  Perlin perlin(1);
+  auto const &pts = points();
+  for (auto _ : state) {
+    for (int i = 0; i < BENCH_POINT_NUM; ++i)
+      DoNotOptimize(perlin.noise(pts.p[i]));
+  }
+  state.SetItemsProcessed(state.iterations() * BENCH_POINT_NUM);
+}
+
+template <int N>
+static void perlin_batch(State &state)
+{
+  Perlin perlin(1);
+  auto const &pts = points();
+  float out[N];
+  for (auto _ : state) {
+    for (int i = 0; i < BENCH_POINT_NUM; i += N) {
+      perlin.noise<N>(&pts.x[i], &pts.y[i], &pts.z[i], out);
+      DoNotOptimize(out);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * BENCH_POINT_NUM);
+}
+
+static void fbm_scalar(State &state)
+{
+  Perlin perlin(1);
+  auto const &pts = points();
+  for (auto _ : state) {
+    for (int i = 0; i < BENCH_POINT_NUM; ++i)
+      DoNotOptimize(perlin.fbm(pts.p[i], NOISE_DEFAULT_OCTAVES));
+  }
+  state.SetItemsProcessed(state.iterations() * BENCH_POINT_NUM);
+}
+
+static void fbm_batch(State &state)
+{
+  Perlin perlin(1);
+  auto const &pts = points();
+  float out[PERLIN_MAX_LANES];
+  for (auto _ : state) {
+    for (int i = 0; i < BENCH_POINT_NUM; i += PERLIN_MAX_LANES) {
+      perlin.fbm<PERLIN_MAX_LANES>(&pts.x[i], &pts.y[i], &pts.z[i],
+                                   NOISE_DEFAULT_OCTAVES, out);
+      DoNotOptimize(out);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * BENCH_POINT_NUM);
+}
+
+// Texture::value() per hit vs Texture::values() for all the hits
+static void marble_value(State &state)
+{
+  NoiseTexture texture(NOISE_MARBLE, 4);
+  auto const &pts = points();
+  for (auto _ : state) {
+    for (int i = 0; i < BENCH_POINT_NUM; ++i)
+      DoNotOptimize(texture.value(0, 0, pts.p[i]));
+  }
+  state.SetItemsProcessed(state.iterations() * BENCH_POINT_NUM);
+}
+
+static void marble_values(State &state)
+{
+  NoiseTexture texture(NOISE_MARBLE, 4);
+  auto const &pts = points();
+  std::vector<double> uv(BENCH_POINT_NUM);
+  std::vector<Color> out(BENCH_POINT_NUM);
+  for (auto _ : state) {
+    texture.values(BENCH_POINT_NUM, uv.data(), uv.data(), pts.p.data(),
+                   out.data());
+    DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * BENCH_POINT_NUM);
+}
+
+BENCHMARK(perlin_scalar);
+BENCHMARK_TEMPLATE(perlin_batch, 4);
+BENCHMARK_TEMPLATE(perlin_batch, 8);
+BENCHMARK(fbm_scalar);
+BENCHMARK(fbm_batch);
+BENCHMARK(marble_value);
+BENCHMARK(marble_values);
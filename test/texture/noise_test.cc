@@ -0,0 +1,114 @@
+#include "texture/noise_texture.hh"
+#include "texture/perlin.hh"
+#include "util/random.hh"
+
+#include <cmath>
+#include <gtest/gtest.h>
+
+using namespace rt;
+using namespace util;
+
+TEST (noise_test, perlin) {
+  Perlin perlin(1);
+  seed_random(1);
+
+  double min = 0, max = 0, sum = 0;
+  const int n = 100000;
+  for (int i = 0; i < n; ++i) {
+    Point3F p(random_double(-100, 100), random_double(-100, 100),
+              random_double(-100, 100));
+    const auto value = perlin.noise(p);
+    min = std::min(min, value);
+    max = std::max(max, value);
+    sum += value;
+
+    // Continuous
+    EXPECT_NEAR(perlin.noise(p + Vec3F(1e-4, 1e-4, 1e-4)), value, 1e-2);
+  }
+  EXPECT_GE(min, -1.1);
+  EXPECT_LE(max, 1.1);
+  EXPECT_LT(min, -0.5);
+  EXPECT_GT(max, 0.5);
+  EXPECT_NEAR(sum / n, 0, 0.02);
+
+  // 0 at the lattice points, periodic in the table size
+  EXPECT_EQ(perlin.noise(Point3F(3, -7, 12)), 0);
+  EXPECT_NEAR(perlin.noise(Point3F(0.3, 1.7, 2.2)),
+              perlin.noise(Point3F(0.3 + PERLIN_TABLE_SIZE, 1.7, 2.2)), 1e-4);
+
+  // The seed changes the permutation
+  Perlin other(2);
+  EXPECT_NE(perlin.noise(Point3F(0.3, 1.7, 2.2)),
+            other.noise(Point3F(0.3, 1.7, 2.2)));
+  EXPECT_EQ(Perlin(1).noise(Point3F(0.3, 1.7, 2.2)),
+            perlin.noise(Point3F(0.3, 1.7, 2.2)));
+}
+
+TEST (noise_test, batch) {
+  Perlin perlin(3);
+  seed_random(2);
+
+  for (int k = 0; k < 1000; ++k) {
+    float x[8], y[8], z[8], out8[8], out4[4];
+    for (int i = 0; i < 8; ++i) {
+      x[i] = (float)random_double(-50, 50);
+      y[i] = (float)random_double(-50, 50);
+      z[i] = (float)random_double(-50, 50);
+    }
+
+    // The lanes are the same as the scalar evaluation
+    perlin.noise<8>(x, y, z, out8);
+    perlin.noise<4>(x, y, z, out4);
+    for (int i = 0; i < 8; ++i) {
+      Point3F p(x[i], y[i], z[i]);
+      EXPECT_EQ(out8[i], (float)perlin.noise(p));
+      if (i < 4) {
+        EXPECT_EQ(out4[i], out8[i]);
+      }
+    }
+
+    perlin.fbm<8>(x, y, z, 5, out8);
+    for (int i = 0; i < 8; ++i)
+      EXPECT_EQ(out8[i], (float)perlin.fbm(Point3F(x[i], y[i], z[i]), 5));
+
+    perlin.turbulence<8>(x, y, z, 5, out8);
+    for (int i = 0; i < 8; ++i) {
+      EXPECT_EQ(out8[i],
+                (float)perlin.turbulence(Point3F(x[i], y[i], z[i]), 5));
+      EXPECT_GE(out8[i], 0);
+    }
+  }
+}
+
+TEST (noise_test, texture) {
+  const Color c0(0.1, 0.2, 0.3);
+  const Color c1(0.9, 0.8, 0.7);
+  seed_random(3);
+
+  for (auto pattern : {NOISE_PLAIN, NOISE_FBM, NOISE_TURBULENCE, NOISE_MARBLE,
+                       NOISE_WOOD}) {
+    NoiseTexture texture(pattern, 4, c0, c1, 5);
+
+    // Not a multiple of lanes
+    const int n = 29;
+    double u[n] = {}, v[n] = {};
+    Point3F p[n];
+    Color out[n];
+    for (int i = 0; i < n; ++i)
+      p[i] = Point3F(random_double(-5, 5), random_double(-5, 5),
+                     random_double(-5, 5));
+    texture.values(n, u, v, p, out);
+
+    for (int i = 0; i < n; ++i) {
+      auto const value = texture.value(0, 0, p[i]);
+      EXPECT_EQ(out[i].x, value.x) << pattern;
+      EXPECT_EQ(out[i].y, value.y) << pattern;
+      EXPECT_EQ(out[i].z, value.z) << pattern;
+      // Between the two colors
+      for (int c = 0; c < 3; ++c) {
+        EXPECT_GE(value[c], std::min(c0[c], c1[c]) - 1e-12) << pattern;
+        EXPECT_LE(value[c], std::max(c0[c], c1[c]) + 1e-12) << pattern;
+      }
+    }
+  }
+}
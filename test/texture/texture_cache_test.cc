@@ -0,0 +1,150 @@
+#include "texture/cached_image_texture.hh"
+#include "texture/texture_cache.hh"
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace rt;
+
+// RGB noise, every texel is distinct mostly
+static MipMap make_mipmap(int width, int height)
+{
+  std::vector<unsigned char> data((size_t)width * height * 3);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = (unsigned char)((i * 2654435761u) >> 13);
+  return MipMap(data.data(), width, height, 3, false);
+}
+
+static std::string temp_path(char const *name)
+{
+  return std::string("/tmp/") + name + "_" + std::to_string(getpid()) + ".rtt";
+}
+
+static bool texel_equal(MipMap::Texel const &a, MipMap::Texel const &b)
+{
+  return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+TEST (texture_cache_test, paging) {
+  // Not a multiple of tile size
+  auto mipmap = make_mipmap(100, 70);
+  const auto path = temp_path("texture_cache_paging");
+  ASSERT_TRUE(write_tiled_texture(path.c_str(), mipmap));
+
+  // One tile per shard, the tiles of level 0 don't fit
+  TextureCache cache(TEXTURE_CACHE_SHARD_NUM * TEXTURE_CACHE_TILE_SIZE *
+                     TEXTURE_CACHE_TILE_SIZE * sizeof(MipMap::Texel));
+  EXPECT_EQ(cache.capacity(), 1u);
+  const int file = cache.open(path.c_str());
+  ASSERT_GE(file, 0);
+  ASSERT_EQ(cache.levels(file), mipmap.levels());
+
+  for (int pass = 0; pass < 2; ++pass) {
+    for (int level = 0; level < mipmap.levels(); ++level) {
+      ASSERT_EQ(cache.width(file, level), mipmap.width(level));
+      ASSERT_EQ(cache.height(file, level), mipmap.height(level));
+      for (int y = 0; y < mipmap.height(level); ++y) {
+        for (int x = 0; x < mipmap.width(level); ++x) {
+          ASSERT_TRUE(texel_equal(cache.texel(file, level, x, y),
+                                  mipmap.texel(level, x, y)))
+            << level << " " << x << " " << y;
+        }
+      }
+    }
+  }
+  cache.flush_thread_stats();
+
+  auto stats = cache.stats();
+  const uint64_t texels = 2 * (100 * 70 + 50 * 35 + 25 * 17 + 12 * 8 + 6 * 4 +
+                               3 * 2 + 1 * 1);
+  EXPECT_EQ(stats.lookups, texels);
+  EXPECT_EQ(stats.lookups,
+            stats.micro_hits + stats.shared_hits + stats.misses);
+  // Level 0 has 4x3 tiles and the others have one
+  EXPECT_GE(stats.misses, 4 * 3 + 6u);
+  EXPECT_GT(stats.evictions, 0u);
+  EXPECT_EQ(stats.bytes_read, stats.misses * TEXTURE_CACHE_TILE_SIZE *
+                                TEXTURE_CACHE_TILE_SIZE * sizeof(MipMap::Texel));
+  EXPECT_GT(stats.hit_rate(), 0.99);
+
+  unlink(path.c_str());
+}
+
+TEST (texture_cache_test, invalid_file) {
+  TextureCache cache(1 << 20);
+  EXPECT_LT(cache.open("/tmp/texture_cache_test_nonexistent.rtt"), 0);
+
+  // Truncated file
+  auto mipmap = make_mipmap(64, 64);
+  const auto path = temp_path("texture_cache_truncated");
+  ASSERT_TRUE(write_tiled_texture(path.c_str(), mipmap));
+  ASSERT_EQ(truncate(path.c_str(), 1000), 0);
+  EXPECT_LT(cache.open(path.c_str()), 0);
+  unlink(path.c_str());
+}
+
+TEST (texture_cache_test, concurrent_filtering) {
+  auto mipmap = make_mipmap(256, 128);
+  const auto path = temp_path("texture_cache_concurrent");
+  ASSERT_TRUE(write_tiled_texture(path.c_str(), mipmap));
+
+  auto cache = std::make_shared<TextureCache>(64 << 10);
+  CachedImageTexture texture(cache, path.c_str());
+
+  // The cached texture is filtered as the MipMap
+  std::vector<std::thread> threads;
+  std::atomic<int> mismatches{0};
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < 20000; ++i) {
+        const double u = ((i * 7 + t * 13) % 1000) / 1000.;
+        const double v = ((i * 11 + t * 17) % 997) / 997.;
+        const double width = (i % 9) / 64.;
+        const auto a = texture.filtered_value(u, v, Point3F(0, 0, 0), width);
+        const auto b = mipmap.trilinear(u, v, width);
+        if (a.x != b.x || a.y != b.y || a.z != b.z) ++mismatches;
+      }
+      cache->flush_thread_stats();
+    });
+  }
+  for (auto &thr : threads) thr.join();
+  EXPECT_EQ(mismatches.load(), 0);
+
+  auto stats = cache->stats();
+  EXPECT_EQ(stats.lookups,
+            stats.micro_hits + stats.shared_hits + stats.misses);
+  EXPECT_GT(stats.evictions, 0u);
+
+  unlink(path.c_str());
+}
+
+TEST (texture_cache_test, source) {
+  auto mipmap = make_mipmap(40, 40);
+  const auto path = temp_path("texture_cache_source");
+  TiledTextureSource source;
+  source.size = 12345;
+  source.mtime_ns = 1700000000123456789;
+  source.srgb = 1;
+  ASSERT_TRUE(write_tiled_texture(path.c_str(), mipmap, source));
+
+  TiledTextureSource read_source;
+  ASSERT_TRUE(read_tiled_texture_source(path.c_str(), read_source));
+  EXPECT_TRUE(read_source == source);
+  read_source.srgb = 0;
+  EXPECT_FALSE(read_source == source);
+
+  // The temporary file is renamed, the file is complete
+  TextureCache cache(1 << 20);
+  EXPECT_GE(cache.open(path.c_str()), 0);
+  unlink(path.c_str());
+
+  // Nothing is left if the file can't be written
+  EXPECT_FALSE(write_tiled_texture("/tmp/texture_cache_test_nonexistent/a.rtt",
+                                   mipmap, source));
+  EXPECT_FALSE(read_tiled_texture_source(
+      "/tmp/texture_cache_test_nonexistent.rtt", read_source));
+}
@@ -0,0 +1,29 @@
+#include "util/checksum.hh"
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+using namespace util;
+
+TEST (checksum_test, crc32) {
+  char const *str = "123456789";
+  EXPECT_EQ(crc32(0, str, strlen(str)), 0xcbf43926u);
+  EXPECT_EQ(crc32(crc32(0, str, 4), str + 4, 5), 0xcbf43926u);
+}
+
+TEST (checksum_test, adler32) {
+  char const *str = "Wikipedia";
+  EXPECT_EQ(adler32(1, str, strlen(str)), 0x11e60398u);
+
+  // The pieces are longer than the modulus
+  std::string data(200000, '\0');
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = char(i * 31 + (i >> 8));
+  }
+  const auto whole = adler32(1, data.data(), data.size());
+  for (size_t split : {0, 1, 65521, 100000, 199999}) {
+    auto a1 = adler32(1, data.data(), split);
+    auto a2 = adler32(1, data.data() + split, data.size() - split);
+    EXPECT_EQ(adler32_combine(a1, a2, data.size() - split), whole) << split;
+  }
+}
@@ -0,0 +1,46 @@
+#include "util/worker_pool.hh"
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace util;
+
+TEST (worker_pool_test, run) {
+  WorkerPool pool(4);
+  ASSERT_EQ(pool.thread_num(), 4);
+
+  // The threads are reused by the jobs, every task runs once
+  for (int job = 0; job < 100; ++job) {
+    const size_t task_num = job % 7 * 10;
+    std::vector<std::atomic<int>> counts(task_num);
+    std::atomic<int> bad_thread(0);
+    pool.Run(task_num, [&](size_t task_index, int thread_index) {
+      counts[task_index]++;
+      if (thread_index < 0 || thread_index >= 4) bad_thread++;
+    });
+    for (size_t i = 0; i < task_num; ++i) ASSERT_EQ(counts[i].load(), 1) << i;
+    EXPECT_EQ(bad_thread.load(), 0);
+  }
+}
+
+TEST (worker_pool_test, submit) {
+  WorkerPool pool(1);
+  std::atomic<bool> started(false);
+  std::atomic<bool> release(false);
+  pool.Submit(1, [&](size_t, int) {
+    started = true;
+    while (!release) std::this_thread::yield();
+  });
+
+  // Submit() doesn't block the caller
+  while (!started) std::this_thread::yield();
+  release = true;
+  pool.Wait();
+
+  int sum = 0;
+  pool.Submit(3, [&](size_t task_index, int) { sum += (int)task_index; });
+  // The destructor waits for the job
+  pool.Wait();
+  EXPECT_EQ(sum, 3);
+}
@@ -0,0 +1,73 @@
+#include "volume/density_grid.hh"
+#include "material/iostropic.hh"
+#include "rt/hit_record.hh"
+#include "shape/grid_medium.hh"
+#include "util/random.hh"
+
+#include <cmath>
+#include <gtest/gtest.h>
+
+using namespace rt;
+using namespace gm;
+using namespace util;
+
+TEST (grid_medium_test, sparse_bricks) {
+  // Only a corner of the 32^3 grid is occupied
+  auto grid = DensityGrid::from_function(
+    Aabb(Point3F(0, 0, 0), Point3F(32, 32, 32)), 32, 32, 32,
+    [](Point3F const &p) { return p.x < 4 && p.y < 4 && p.z < 4 ? 2. : 0.; });
+  EXPECT_EQ(grid.total_brick_count(), 64u);
+  EXPECT_EQ(grid.brick_count(), 1u);
+  EXPECT_EQ(grid.max_density(), 2);
+
+  EXPECT_DOUBLE_EQ(grid.density(Point3F(1, 1, 1)), 2);
+  // Halfway between the voxel centers 3.5 and 4.5
+  EXPECT_DOUBLE_EQ(grid.density(Point3F(4, 1, 1)), 1);
+  EXPECT_EQ(grid.density(Point3F(20, 20, 20)), 0);
+  EXPECT_EQ(grid.density(Point3F(-1, 1, 1)), 0);
+
+  // The empty cells are skipped, the others bound the density
+  int visited = 0;
+  grid.traverse(Point3F(-1, 1, 1), Vec3F(1, 0, 0), 1, 33,
+                [&](double t0, double t1, double majorant) {
+                  EXPECT_LT(t0, t1);
+                  if (t1 <= 9) {
+                    EXPECT_EQ(majorant, 2);
+                  } else if (t0 >= 10) {
+                    EXPECT_EQ(majorant, 0);
+                  }
+                  ++visited;
+                  return true;
+                });
+  EXPECT_EQ(visited, 4);
+}
+
+// The fraction of rays passing through the medium is the transmittance
+TEST (grid_medium_test, delta_tracking) {
+  const Aabb bounds(Point3F(0, 0, 0), Point3F(1, 1, 1));
+  auto grid = std::make_shared<DensityGrid>(DensityGrid::from_function(
+    bounds, 16, 16, 16, [](Point3F const &p) { return p.x; }));
+  GridMedium medium(grid, 2, std::make_shared<Iostropic>(Color(1, 1, 1)));
+
+  seed_random(1);
+  const int n = 20000;
+  // The optical depth along y is 2 * x
+  const Ray ray(Point3F(0.75, -1, 0.5), Vec3F(0, 1, 0));
+  const double expected = std::exp(-2 * grid->density(Point3F(0.75, 0.5, 0.5)));
+  int escaped = 0;
+  double ratio_tracking = 0;
+  for (int i = 0; i < n; ++i) {
+    HitInfo info;
+    if (!medium.intersect(ray, 0.001, inf, info)) ++escaped;
+    else EXPECT_TRUE(info.t > 1 && info.t < 2);
+    ratio_tracking += medium.transmittance(ray, 0.001, inf);
+  }
+  const double sigma = std::sqrt(expected * (1 - expected) / n);
+  EXPECT_NEAR((double)escaped / n, expected, 5 * sigma);
+  EXPECT_NEAR(ratio_tracking / n, expected, 5 * sigma);
+
+  // The hit is cut by tmax(occluded by the other shape)
+  HitInfo info;
+  for (int i = 0; i < 100; ++i)
+    EXPECT_FALSE(medium.intersect(ray, 0.001, 1, info));
+}